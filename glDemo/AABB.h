@@ -0,0 +1,87 @@
+#pragma once
+
+#include "core.h"
+#include <float.h>
+
+// Axis-aligned bounding box.  A default constructed box is empty (min > max) so it can be grown with expand()
+
+struct AABB {
+
+	glm::vec3 min;
+	glm::vec3 max;
+
+	AABB() {
+
+		min = glm::vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+		max = glm::vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	}
+
+	AABB(glm::vec3 min, glm::vec3 max) {
+
+		this->min = min;
+		this->max = max;
+	}
+
+	bool isEmpty() const {
+
+		return (min.x > max.x) || (min.y > max.y) || (min.z > max.z);
+	}
+
+	glm::vec3 centre() const {
+
+		return (min + max) * 0.5f;
+	}
+
+	glm::vec3 extents() const {
+
+		return (max - min) * 0.5f;
+	}
+
+	void expand(const glm::vec3& p) {
+
+		min = glm::min(min, p);
+		max = glm::max(max, p);
+	}
+
+	void expand(const AABB& b) {
+
+		min = glm::min(min, b.min);
+		max = glm::max(max, b.max);
+	}
+
+	// Boxes that only touch on a face are not considered overlapping, so objects can rest flush against each other
+	bool overlaps(const AABB& b) const {
+
+		return	(min.x < b.max.x && max.x > b.min.x) &&
+				(min.y < b.max.y && max.y > b.min.y) &&
+				(min.z < b.max.z && max.z > b.min.z);
+	}
+
+	bool contains(const glm::vec3& p) const {
+
+		return	(p.x >= min.x && p.x <= max.x) &&
+				(p.y >= min.y && p.y <= max.y) &&
+				(p.z >= min.z && p.z <= max.z);
+	}
+
+	// Return the box enclosing this box after transformation by M (Arvo's method - avoids transforming all 8 corners)
+	AABB transformed(const glm::mat4& M) const {
+
+		glm::vec3 newMin = glm::vec3(M[3]);
+		glm::vec3 newMax = newMin;
+
+		for (int j = 0; j < 3; ++j) {
+
+			for (int i = 0; i < 3; ++i) {
+
+				float a = M[j][i] * min[j];
+				float b = M[j][i] * max[j];
+
+				newMin[i] += (a < b) ? a : b;
+				newMax[i] += (a < b) ? b : a;
+			}
+		}
+
+		return AABB(newMin, newMax);
+	}
+};
@@ -1,6 +1,8 @@
 
 #include "AIMesh.h"
 #include "TextureLoader.h"
+#include "MeshSimplifier.h"
+#include "RenderStats.h"
 
 using namespace std;
 using namespace glm;
@@ -9,6 +11,13 @@ using namespace glm;
 // Private functions
 void AIMesh::setupGLStuff(aiMesh* mesh) {
 
+	// Record model space bounds for collision and culling
+	bounds = AABB();
+	for (unsigned int v = 0; v < mesh->mNumVertices; ++v) {
+
+		bounds.expand(vec3(mesh->mVertices[v].x, mesh->mVertices[v].y, mesh->mVertices[v].z));
+	}
+
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 
@@ -49,39 +58,101 @@ void AIMesh::setupGLStuff(aiMesh* mesh) {
 		glEnableVertexAttribArray(2);
 	}
 
+	GURenderStats::countBufferUpload((uint64_t)mesh->mNumVertices * sizeof(aiVector3D) * ((meshTexCoordBuffer != 0) ? 5 : 4));
+
 	// Setup VBO for mesh index buffer (face index array)
 
 	numFaces = mesh->mNumFaces;
 
-	// Setup contiguous array
-	const GLuint numBytes = numFaces * 3 * sizeof(GLuint);
-	GLuint* faceIndexArray = (GLuint*)malloc(numBytes);
+	// Setup contiguous array - LOD 0 is the full detail mesh and simplified levels are appended after it in the same index buffer
+	vector<GLuint> faceIndexArray(numFaces * 3);
 
-	GLuint* dstPtr = faceIndexArray;
+	GLuint* dstPtr = faceIndexArray.data();
 	for (unsigned int f = 0; f < numFaces; ++f, dstPtr += 3) {
 
 		memcpy_s(dstPtr, 3 * sizeof(GLuint), mesh->mFaces[f].mIndices, 3 * sizeof(GLuint));
 	}
 
+	// Reorder LOD 0 into meshlets before the simplified levels are appended
+	{
+		vector<vec3> positions(mesh->mNumVertices);
+
+		for (unsigned int v = 0; v < mesh->mNumVertices; ++v)
+			positions[v] = vec3(mesh->mVertices[v].x, mesh->mVertices[v].y, mesh->mVertices[v].z);
+
+		meshlets.build(positions, faceIndexArray);
+	}
+
+	generateLODs(mesh, faceIndexArray);
+
 	glGenBuffers(1, &meshFaceIndexBuffer);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshFaceIndexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, numBytes, faceIndexArray, GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, faceIndexArray.size() * sizeof(GLuint), faceIndexArray.data(), GL_STATIC_DRAW);
+	GURenderStats::countBufferUpload(faceIndexArray.size() * sizeof(GLuint));
 
 	glBindVertexArray(0);
 }
 
 
 
+// Build simplified LOD levels from the LOD 0 indices at the start of faceIndexArray and append them to it.  Each level targets half the triangles of the previous one.  Simplification stops early if a level would save less than 10% over its predecessor
+void AIMesh::generateLODs(aiMesh* mesh, vector<GLuint>& faceIndexArray) {
+
+	const GLuint lod0IndexCount = (GLuint)faceIndexArray.size();
+
+	lods.clear();
+	lods.push_back(MeshLOD{ 0, lod0IndexCount, 0.0f });
+
+	vector<vec3> positions(mesh->mNumVertices);
+
+	for (unsigned int v = 0; v < mesh->mNumVertices; ++v)
+		positions[v] = vec3(mesh->mVertices[v].x, mesh->mVertices[v].y, mesh->mVertices[v].z);
+
+	vector<GLuint> lod0Indices(faceIndexArray.begin(), faceIndexArray.end());
+	size_t targetIndexCount = lod0IndexCount;
+
+	for (int level = 1; level < maxLODLevels; ++level) {
+
+		targetIndexCount = (targetIndexCount / 6) * 3;
+
+		if (targetIndexCount == 0)
+			break;
+
+		// Simplify from the full detail mesh each time so quadrics are not built on already simplified geometry
+		float error = 0.0f;
+		vector<GLuint> lodIndices = simplifyMesh(positions, lod0Indices, targetIndexCount, &error);
+
+		const MeshLOD& prev = lods.back();
+
+		if (lodIndices.empty() || lodIndices.size() * 10 > (size_t)prev.indexCount * 9)
+			break;
+
+		lods.push_back(MeshLOD{ (GLuint)faceIndexArray.size(), (GLuint)lodIndices.size(), std::max<float>(error, prev.error) });
+		faceIndexArray.insert(faceIndexArray.end(), lodIndices.begin(), lodIndices.end());
+	}
+}
+
+
+
 // Public functions
 
-AIMesh::AIMesh(std::string filename, GLuint meshIndex) {
+const struct aiScene* AIMesh::importFile(const std::string& filename) {
 
-	const struct aiScene* scene = aiImportFile(filename.c_str(),
+	return aiImportFile(filename.c_str(),
 		aiProcess_GenSmoothNormals |
 		aiProcess_CalcTangentSpace |
 		aiProcess_Triangulate |
 		aiProcess_JoinIdenticalVertices |
 		aiProcess_SortByPType);
+}
+
+
+AIMesh::AIMesh(std::string filename, GLuint meshIndex) {
+
+	sourceFilename = filename;
+	sourceMeshIndex = meshIndex;
+
+	const struct aiScene* scene = importFile(filename);
 
 	if (scene != nullptr) {
 
@@ -99,6 +170,25 @@ AIMesh::AIMesh(const struct aiScene* scene, GLuint meshIndex) {
 }
 
 
+AIMesh::AIMesh(std::string filename, const struct aiScene* scene, GLuint meshIndex) {
+
+	sourceFilename = filename;
+	sourceMeshIndex = meshIndex;
+
+	if (scene != nullptr)
+		setupGLStuff(scene->mMeshes[meshIndex]);
+}
+
+
+AIMesh::~AIMesh() {
+
+	GLuint buffers[6] = { meshVertexPosBuffer, meshTexCoordBuffer, meshNormalBuffer, meshTangentBuffer, meshBiTangentBuffer, meshFaceIndexBuffer };
+
+	glDeleteBuffers(6, buffers); // zero names are ignored
+	glDeleteVertexArrays(1, &vao);
+}
+
+
 // Texture setup methods
 
 void AIMesh::addTexture(GLuint textureID) {
@@ -109,6 +199,9 @@ void AIMesh::addTexture(GLuint textureID) {
 void AIMesh::addTexture(std::string filename, FREE_IMAGE_FORMAT format) {
 
 	textureID = loadTexture(filename, format);
+
+	textureFilename = filename;
+	textureFormat = format;
 }
 
 // ***normal mapping*** - helper functions at add normal map image to the object
@@ -123,6 +216,42 @@ void AIMesh::addNormalMap(std::string filename, FREE_IMAGE_FORMAT format) {
 }
 
 
+AABB AIMesh::getBoundingBox() const {
+
+	return bounds;
+}
+
+
+const std::string& AIMesh::getSourceFilename() const {
+
+	return sourceFilename;
+}
+
+
+GLuint AIMesh::getSourceMeshIndex() const {
+
+	return sourceMeshIndex;
+}
+
+
+const std::string& AIMesh::getTextureFilename() const {
+
+	return textureFilename;
+}
+
+
+FREE_IMAGE_FORMAT AIMesh::getTextureFormat() const {
+
+	return textureFormat;
+}
+
+
+GLuint AIMesh::getTextureID() const {
+
+	return textureID;
+}
+
+
 // Rendering functions
 
 void AIMesh::setupTextures() {
@@ -133,12 +262,14 @@ void AIMesh::setupTextures() {
 			
 			glActiveTexture(GL_TEXTURE0);
 			glBindTexture(GL_TEXTURE_2D, textureID);
+			GURenderStats::countTextureBind();
 
 			//  *** normal mapping ***  check if normal map added - if so bind to texture unit 1 (as noted in  slides)
 			if (normalMapID != 0) {
 
 				glActiveTexture(GL_TEXTURE1);
 				glBindTexture(GL_TEXTURE_2D, normalMapID);
+				GURenderStats::countTextureBind();
 
 				// Restore default
 				glActiveTexture(GL_TEXTURE0);
@@ -148,9 +279,104 @@ void AIMesh::setupTextures() {
 }
 
 
+int AIMesh::lodCount() const {
+
+	return (int)lods.size();
+}
+
+
+float AIMesh::lodError(int lod) const {
+
+	return (lod >= 0 && lod < (int)lods.size()) ? lods[lod].error : 0.0f;
+}
+
+
+// Pick the coarsest level whose error, projected to the screen, is within maxPixelError.  Levels coarser than currentLOD must meet the tighter threshold maxPixelError * hysteresis, so an object sitting near a switching distance does not flicker between levels
+int AIMesh::selectLOD(float pixelsPerUnit, float distance, int currentLOD, float maxPixelError, float hysteresis) const {
+
+	const float d = std::max<float>(distance, 1.0e-3f);
+
+	for (int lod = (int)lods.size() - 1; lod > 0; --lod) {
+
+		float threshold = (lod > currentLOD) ? maxPixelError * hysteresis : maxPixelError;
+
+		if (lods[lod].error * pixelsPerUnit / d <= threshold)
+			return lod;
+	}
+
+	return 0;
+}
+
+
 void AIMesh::render() {
 
+	render(0);
+}
+
+
+void AIMesh::render(int lod) {
+
+	lod = glm::clamp<int>(lod, 0, std::max<int>((int)lods.size() - 1, 0));
+
+	GLuint indexCount = (lods.empty()) ? numFaces * 3 : lods[lod].indexCount;
+	GLuint indexOffset = (lods.empty()) ? 0 : lods[lod].indexOffset;
+
+	glBindVertexArray(vao);
+	glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (const GLvoid*)(indexOffset * sizeof(GLuint)));
+
+	GURenderStats::countVAOBind();
+	GURenderStats::countDraw(indexCount);
+}
+
+
+size_t AIMesh::meshletCount() const {
+
+	return meshlets.count();
+}
+
+
+void AIMesh::cullMeshlets(const mat4& modelTransform, const mat4& viewProjection, const vec3& cameraPos, MeshletDrawList& drawList) const {
+
+	meshlets.cull(modelTransform, viewProjection, cameraPos, drawList);
+}
+
+
+void AIMesh::render(const MeshletDrawList& drawList) {
+
+	if (drawList.counts.empty())
+		return;
+
 	glBindVertexArray(vao);
-	glDrawElements(GL_TRIANGLES, numFaces * 3, GL_UNSIGNED_INT, (const GLvoid*)0);
+	glMultiDrawElements(GL_TRIANGLES, drawList.counts.data(), GL_UNSIGNED_INT, drawList.offsets.data(), (GLsizei)drawList.counts.size());
+
+	GURenderStats::countVAOBind();
+	GURenderStats::countMultiDraw((uint64_t)drawList.visibleTriangles * 3);
 }
 
+
+GUDrawCommand AIMesh::drawCommand(const mat4& modelTransform, int lod) const {
+
+	lod = glm::clamp<int>(lod, 0, std::max<int>((int)lods.size() - 1, 0));
+
+	GUDrawCommand command;
+
+	command.modelTransform = modelTransform;
+	command.vertexArray = vao;
+	command.texture = (meshTexCoordBuffer != 0) ? textureID : 0;
+	command.normalMap = normalMapID;
+	command.indexOffset = (lods.empty()) ? 0 : lods[lod].indexOffset;
+	command.indexCount = (lods.empty()) ? numFaces * 3 : lods[lod].indexCount;
+	command.meshlets = nullptr;
+
+	return command;
+}
+
+
+GUDrawCommand AIMesh::drawCommand(const mat4& modelTransform, const MeshletDrawList& drawList) const {
+
+	GUDrawCommand command = drawCommand(modelTransform, 0);
+
+	command.meshlets = &drawList;
+
+	return command;
+}
@@ -1,9 +1,22 @@
 #pragma once
 
 #include "core.h"
+#include "AABB.h"
+#include "Meshlet.h"
+#include "CommandBuffer.h"
+
+// Level of detail range within the mesh index buffer.  error is the geometric error of the level in model units
+struct MeshLOD {
+
+	GLuint				indexOffset;
+	GLuint				indexCount;
+	float				error;
+};
 
 class AIMesh {
 
+	static const int	maxLODLevels = 4;
+
 	GLuint				numFaces = 0;
 
 	GLuint				vao = 0;
@@ -20,20 +33,75 @@ class AIMesh {
 	GLuint				textureID = 0;
 	GLuint				normalMapID = 0;
 
+	// Source files - kept so offline / load-time build steps (eg. HLOD) can re-import the mesh data
+	std::string			sourceFilename;
+	GLuint				sourceMeshIndex = 0;
+	std::string			textureFilename;
+	FREE_IMAGE_FORMAT	textureFormat = FIF_UNKNOWN;
+
+	// Model coordinate space bounds of the mesh vertices
+	AABB				bounds;
+
+	// LOD levels stored back to back in meshFaceIndexBuffer - level 0 is the full detail mesh
+	std::vector<MeshLOD>	lods;
+
+	// Meshlets partition LOD 0 - its indices are stored in meshlet order so each meshlet is a contiguous index range
+	MeshletSet			meshlets;
+
 	// Private functions
 	void setupGLStuff(aiMesh* mesh);
+	void generateLODs(aiMesh* mesh, std::vector<GLuint>& faceIndexArray);
 
 public:
 
+	// Import a model file with the post-processing used by all AIMeshes.  Release the result with aiReleaseImport
+	static const struct aiScene* importFile(const std::string& filename);
+
 	AIMesh(std::string filename, GLuint meshIndex = 0);
 	AIMesh(const struct aiScene* scene, GLuint meshIndex = 0);
 
+	// Build from a scene already imported from filename (with importFile), which is not released.  filename is recorded as the source for scene export.  A null scene (failed import) leaves the mesh empty
+	AIMesh(std::string filename, const struct aiScene* scene, GLuint meshIndex = 0);
+
+	// Releases the vertex array and buffers.  Textures are not released as they may be shared (see addTexture(GLuint))
+	~AIMesh();
+
+	AIMesh(const AIMesh&) = delete;
+	AIMesh& operator=(const AIMesh&) = delete;
+
 	void addTexture(GLuint textureID);
 	void addTexture(std::string filename, FREE_IMAGE_FORMAT format);
 
 	void addNormalMap(GLuint normalMapID);
 	void addNormalMap(std::string filename, FREE_IMAGE_FORMAT format);
 
+	AABB getBoundingBox() const;
+
+	const std::string& getSourceFilename() const;
+	GLuint getSourceMeshIndex() const;
+	const std::string& getTextureFilename() const;
+	FREE_IMAGE_FORMAT getTextureFormat() const;
+	GLuint getTextureID() const;
+
+	int lodCount() const;
+	float lodError(int lod) const;
+
+	// Select a LOD level for an instance.  pixelsPerUnit is the screen height in pixels of one model unit at distance 1 (viewport height / (2 * tan(fovY / 2)) scaled by the instance's model scale) and distance is the view distance to the instance in world units
+	int selectLOD(float pixelsPerUnit, float distance, int currentLOD, float maxPixelError = 1.0f, float hysteresis = 0.75f) const;
+
+	size_t meshletCount() const;
+
+	// Cull the LOD 0 meshlets for an instance with the given model transform - see MeshletSet::cull
+	void cullMeshlets(const glm::mat4& modelTransform, const glm::mat4& viewProjection, const glm::vec3& cameraPos, MeshletDrawList& drawList) const;
+
 	void setupTextures();
 	void render();
+	void render(int lod);
+
+	// Draw the visible LOD 0 meshlets in drawList with a single glMultiDrawElements call
+	void render(const MeshletDrawList& drawList);
+
+	// Draw commands equivalent to setupTextures followed by render(lod) or render(drawList), for recording into a GUCommandBuffer.  drawList is referenced by the command, not copied
+	GUDrawCommand drawCommand(const glm::mat4& modelTransform, int lod) const;
+	GUDrawCommand drawCommand(const glm::mat4& modelTransform, const MeshletDrawList& drawList) const;
 };
\ No newline at end of file
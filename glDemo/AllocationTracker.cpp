@@ -0,0 +1,613 @@
+#include "AllocationTracker.h"
+#include "Profiler.h"
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <algorithm>
+
+#if defined(_WIN32)
+#include <DbgHelp.h>
+#include <crtdbg.h>
+#pragma comment(lib, "dbghelp.lib")
+#elif defined(__GLIBC__)
+#include <execinfo.h>
+#endif
+
+#if defined(_MSC_VER)
+#define TRACKER_NOINLINE __declspec(noinline)
+#else
+#define TRACKER_NOINLINE __attribute__((noinline))
+#endif
+
+using namespace std;
+
+
+static std::atomic<bool>			enabled(false);
+
+// Non-zero while the thread is inside the tracker, an allocation function that calls malloc, or a GUUntrackedScope - allocations it makes then are not recorded
+static thread_local int				untrackedDepth = 0;
+
+// Current frame - any thread adds, endFrame takes
+static std::atomic<uint64_t>		frameAllocations(0);
+static std::atomic<uint64_t>		frameBytes(0);
+static std::atomic<uint64_t>		frameFrees(0);
+
+// Closed frames since the last reset - written by endFrame only
+static uint64_t						frames = 0;
+static uint64_t						allocatingFrames = 0;
+static GUAllocationCounts			totalCounts;
+static GUAllocationCounts			lastFrameCounts;
+static GUAllocationCounts			peakFrameCounts;
+
+
+// Zone and call site tables - open addressing in fixed arrays so recording never allocates.  Once a table is full further zones or sites are only counted in the frame totals
+struct ZoneEntry {
+
+	const char*						name; // nullptr if the slot is empty
+	uint64_t						allocations;
+	uint64_t						bytes;
+};
+
+static const int					siteDepth = 8; // return addresses kept per call site
+
+struct SiteEntry {
+
+	uint64_t						hash;
+	int								depth; // 0 if the slot is empty
+	void*							frames[siteDepth];
+	const char*						zone; // zone of the first allocation from the site
+	uint64_t						allocations;
+	uint64_t						bytes;
+};
+
+static const uint32_t				maxZones = 256; // powers of two
+static const uint32_t				maxSites = 4096;
+
+static std::mutex					tableLock;
+static ZoneEntry					zones[maxZones];
+static SiteEntry					sites[maxSites];
+
+static const char* const			noZone = "(no zone)";
+
+#if GU_ALLOCATION_TRACKER && defined(_MSC_VER) && defined(_DEBUG)
+static int crtAllocHook(int allocType, void* userData, size_t size, int blockType, long requestNumber, const unsigned char* filename, int lineNumber);
+#endif
+
+
+
+// Private functions
+
+static ZoneEntry* findZone(const char* name) {
+
+	uint32_t slot = (uint32_t)(((uintptr_t)name >> 3) * 2654435761u) & (maxZones - 1);
+
+	for (uint32_t probe = 0; probe < maxZones; ++probe, slot = (slot + 1) & (maxZones - 1)) {
+
+		if (zones[slot].name == name)
+			return &zones[slot];
+
+		if (zones[slot].name == nullptr) {
+
+			zones[slot].name = name;
+			return &zones[slot];
+		}
+	}
+
+	return nullptr;
+}
+
+
+static SiteEntry* findSite(uint64_t hash, void* const* stack, int depth, const char* zone) {
+
+	uint32_t slot = (uint32_t)hash & (maxSites - 1);
+
+	for (uint32_t probe = 0; probe < maxSites; ++probe, slot = (slot + 1) & (maxSites - 1)) {
+
+		SiteEntry& site = sites[slot];
+
+		if (site.depth == depth && site.hash == hash && equal(stack, stack + depth, site.frames))
+			return &site;
+
+		if (site.depth == 0) {
+
+			site.hash = hash;
+			site.depth = depth;
+			site.zone = zone;
+			copy(stack, stack + depth, site.frames);
+
+			return &site;
+		}
+	}
+
+	return nullptr;
+}
+
+
+// Return addresses of the calling stack, starting from the allocation function (operator new, malloc or the CRT hook's caller)
+TRACKER_NOINLINE static int captureStack(void** stack) {
+
+	const int skip = 2; // captureStack and recordAllocation
+
+#if defined(_WIN32)
+
+	return (int)CaptureStackBackTrace(skip, siteDepth, stack, nullptr);
+
+#elif defined(__GLIBC__)
+
+	void* all[siteDepth + skip];
+	int depth = backtrace(all, siteDepth + skip) - skip;
+
+	for (int i = 0; i < depth; ++i)
+		stack[i] = all[i + skip];
+
+	return std::max<int>(depth, 0);
+
+#else
+
+	return 0;
+
+#endif
+}
+
+
+// Symbol (and source line where available) of a return address
+static string describeAddress(void* address) {
+
+	char buffer[512];
+
+#if defined(_WIN32)
+
+	HANDLE process = GetCurrentProcess();
+
+	char symbolBuffer[sizeof(SYMBOL_INFO) + 256];
+	SYMBOL_INFO* symbol = (SYMBOL_INFO*)symbolBuffer;
+
+	symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+	symbol->MaxNameLen = 255;
+
+	DWORD64 displacement = 0;
+	DWORD lineDisplacement = 0;
+	IMAGEHLP_LINE64 line = {};
+
+	line.SizeOfStruct = sizeof(line);
+
+	if (!SymFromAddr(process, (DWORD64)address, &displacement, symbol))
+		snprintf(buffer, sizeof(buffer), "%p", address);
+	else if (SymGetLineFromAddr64(process, (DWORD64)address, &lineDisplacement, &line))
+		snprintf(buffer, sizeof(buffer), "%s (%s:%lu)", symbol->Name, line.FileName, (unsigned long)line.LineNumber);
+	else
+		snprintf(buffer, sizeof(buffer), "%s", symbol->Name);
+
+#elif defined(__GLIBC__)
+
+	char** names = backtrace_symbols(&address, 1);
+
+	snprintf(buffer, sizeof(buffer), "%s", (names) ? names[0] : "?");
+	free(names);
+
+#else
+
+	snprintf(buffer, sizeof(buffer), "%p", address);
+
+#endif
+
+	return string(buffer);
+}
+
+
+
+//
+// GUAllocationTracker
+//
+
+void GUAllocationTracker::setEnabled(bool enable) {
+
+#if GU_ALLOCATION_TRACKER
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+	if (enable)
+		_CrtSetAllocHook(crtAllocHook);
+#endif
+
+	enabled.store(enable, std::memory_order_relaxed);
+
+#endif
+}
+
+
+bool GUAllocationTracker::isEnabled() {
+
+	return enabled.load(std::memory_order_relaxed);
+}
+
+
+void GUAllocationTracker::endFrame() {
+
+	if (!isEnabled())
+		return;
+
+	GUAllocationCounts frame;
+
+	frame.allocations = frameAllocations.exchange(0, std::memory_order_relaxed);
+	frame.bytes = frameBytes.exchange(0, std::memory_order_relaxed);
+	frame.frees = frameFrees.exchange(0, std::memory_order_relaxed);
+
+	frames++;
+
+	if (frame.allocations > 0)
+		allocatingFrames++;
+
+	totalCounts.allocations += frame.allocations;
+	totalCounts.bytes += frame.bytes;
+	totalCounts.frees += frame.frees;
+
+	peakFrameCounts.allocations = std::max<uint64_t>(peakFrameCounts.allocations, frame.allocations);
+	peakFrameCounts.bytes = std::max<uint64_t>(peakFrameCounts.bytes, frame.bytes);
+	peakFrameCounts.frees = std::max<uint64_t>(peakFrameCounts.frees, frame.frees);
+
+	lastFrameCounts = frame;
+}
+
+
+void GUAllocationTracker::resetStatistics() {
+
+	lock_guard<mutex> lock(tableLock);
+
+	fill(zones, zones + maxZones, ZoneEntry{});
+	fill(sites, sites + maxSites, SiteEntry{});
+
+	frameAllocations = 0;
+	frameBytes = 0;
+	frameFrees = 0;
+
+	frames = 0;
+	allocatingFrames = 0;
+	totalCounts = GUAllocationCounts();
+	lastFrameCounts = GUAllocationCounts();
+	peakFrameCounts = GUAllocationCounts();
+}
+
+
+uint64_t GUAllocationTracker::frameCount() {
+
+	return frames;
+}
+
+
+uint64_t GUAllocationTracker::allocatingFrameCount() {
+
+	return allocatingFrames;
+}
+
+
+GUAllocationCounts GUAllocationTracker::total() {
+
+	return totalCounts;
+}
+
+
+GUAllocationCounts GUAllocationTracker::lastFrame() {
+
+	return lastFrameCounts;
+}
+
+
+GUAllocationCounts GUAllocationTracker::peakFrame() {
+
+	return peakFrameCounts;
+}
+
+
+void GUAllocationTracker::printReport(int topSites) {
+
+	GUUntrackedScope untracked;
+
+	vector<ZoneEntry> zoneList;
+	vector<SiteEntry> siteList;
+
+	{
+		lock_guard<mutex> lock(tableLock);
+
+		for (const ZoneEntry& zone : zones) {
+
+			if (zone.name)
+				zoneList.push_back(zone);
+		}
+
+		for (const SiteEntry& site : sites) {
+
+			if (site.depth > 0)
+				siteList.push_back(site);
+		}
+	}
+
+	sort(zoneList.begin(), zoneList.end(), [](const ZoneEntry& a, const ZoneEntry& b) { return a.allocations > b.allocations; });
+	sort(siteList.begin(), siteList.end(), [](const SiteEntry& a, const SiteEntry& b) { return a.allocations > b.allocations; });
+
+	cout << "Heap allocations: " << frames << " frames, " << allocatingFrames << " of them allocated.  " << totalCounts.allocations << " allocations (" << totalCounts.bytes << " bytes) and " << totalCounts.frees << " frees in total";
+
+	if (frames > 0)
+		cout << ", " << (double)totalCounts.allocations / (double)frames << " allocations per frame (peak " << peakFrameCounts.allocations << ")";
+
+	cout << endl;
+
+	if (zoneList.empty())
+		return;
+
+	cout << "  By profiler zone:" << endl;
+
+	for (const ZoneEntry& zone : zoneList)
+		cout << "    " << zone.name << ": " << zone.allocations << " allocations, " << zone.bytes << " bytes" << endl;
+
+#if defined(_WIN32)
+	HANDLE process = GetCurrentProcess();
+
+	SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS | SYMOPT_LOAD_LINES);
+	SymInitialize(process, nullptr, TRUE);
+#endif
+
+	cout << "  Top call sites:" << endl;
+
+	for (int s = 0; s < (int)siteList.size() && s < topSites; ++s) {
+
+		const SiteEntry& site = siteList[s];
+
+		cout << "    " << site.allocations << " allocations, " << site.bytes << " bytes in " << site.zone << endl;
+
+		for (int i = 0; i < site.depth; ++i)
+			cout << "      " << describeAddress(site.frames[i]) << endl;
+	}
+
+#if defined(_WIN32)
+	SymCleanup(process);
+#endif
+}
+
+
+TRACKER_NOINLINE void GUAllocationTracker::recordAllocation(size_t bytes) {
+
+	if (!enabled.load(std::memory_order_relaxed) || untrackedDepth > 0)
+		return;
+
+	// The stack walk may allocate the first time it is used
+	GUUntrackedScope untracked;
+
+	frameAllocations.fetch_add(1, std::memory_order_relaxed);
+	frameBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+	const char* zone = GUProfiler::activeZoneName();
+
+	if (!zone)
+		zone = noZone;
+
+	void* stack[siteDepth];
+	int depth = captureStack(stack);
+
+	// FNV-1a over the return addresses
+	uint64_t hash = 14695981039346656037ull;
+
+	for (int i = 0; i < depth; ++i)
+		hash = (hash ^ (uint64_t)(uintptr_t)stack[i]) * 1099511628211ull;
+
+	lock_guard<mutex> lock(tableLock);
+
+	ZoneEntry* zoneEntry = findZone(zone);
+
+	if (zoneEntry) {
+
+		zoneEntry->allocations++;
+		zoneEntry->bytes += bytes;
+	}
+
+	SiteEntry* site = (depth > 0) ? findSite(hash, stack, depth, zone) : nullptr;
+
+	if (site) {
+
+		site->allocations++;
+		site->bytes += bytes;
+	}
+}
+
+
+void GUAllocationTracker::recordFree() {
+
+	if (!enabled.load(std::memory_order_relaxed) || untrackedDepth > 0)
+		return;
+
+	frameFrees.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+
+//
+// GUUntrackedScope
+//
+
+GUUntrackedScope::GUUntrackedScope() {
+
+	untrackedDepth++;
+}
+
+
+GUUntrackedScope::~GUUntrackedScope() {
+
+	untrackedDepth--;
+}
+
+
+
+#if GU_ALLOCATION_TRACKER
+
+//
+// Replacement allocation functions.  operator new allocates with malloc, so the C library hooks below are told to ignore the call
+//
+
+static void* trackedAllocate(size_t size) {
+
+	if (size == 0)
+		size = 1;
+
+	untrackedDepth++;
+	void* p = malloc(size);
+	untrackedDepth--;
+
+	if (p && enabled.load(std::memory_order_relaxed))
+		GUAllocationTracker::recordAllocation(size);
+
+	return p;
+}
+
+
+static void trackedFree(void* p) {
+
+	if (!p)
+		return;
+
+	if (enabled.load(std::memory_order_relaxed))
+		GUAllocationTracker::recordFree();
+
+	untrackedDepth++;
+	free(p);
+	untrackedDepth--;
+}
+
+
+void* operator new(size_t size) {
+
+	void* p = trackedAllocate(size);
+
+	if (!p)
+		throw std::bad_alloc();
+
+	return p;
+}
+
+
+void* operator new[](size_t size) {
+
+	void* p = trackedAllocate(size);
+
+	if (!p)
+		throw std::bad_alloc();
+
+	return p;
+}
+
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+
+	return trackedAllocate(size);
+}
+
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+
+	return trackedAllocate(size);
+}
+
+
+void operator delete(void* p) noexcept {
+
+	trackedFree(p);
+}
+
+
+void operator delete[](void* p) noexcept {
+
+	trackedFree(p);
+}
+
+
+void operator delete(void* p, size_t) noexcept {
+
+	trackedFree(p);
+}
+
+
+void operator delete[](void* p, size_t) noexcept {
+
+	trackedFree(p);
+}
+
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+
+	trackedFree(p);
+}
+
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+
+	trackedFree(p);
+}
+
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+
+// Debug CRT allocation hook - sees malloc, calloc, realloc and free from any code using the CRT heap.  Installed by setEnabled(true)
+static int crtAllocHook(int allocType, void* userData, size_t size, int blockType, long requestNumber, const unsigned char* filename, int lineNumber) {
+
+	// The CRT's own bookkeeping blocks, and allocations operator new has already counted
+	if (blockType == _CRT_BLOCK || untrackedDepth > 0)
+		return TRUE;
+
+	if (allocType == _HOOK_FREE)
+		GUAllocationTracker::recordFree();
+	else
+		GUAllocationTracker::recordAllocation(size);
+
+	return TRUE;
+}
+
+#elif defined(__GLIBC__)
+
+// glibc lets a program define malloc and friends - these forward to the C library's own versions
+extern "C" {
+
+	void* __libc_malloc(size_t size);
+	void* __libc_calloc(size_t count, size_t size);
+	void* __libc_realloc(void* p, size_t size);
+	void __libc_free(void* p);
+
+	void* malloc(size_t size) noexcept {
+
+		void* p = __libc_malloc(size);
+
+		if (p && enabled.load(std::memory_order_relaxed))
+			GUAllocationTracker::recordAllocation(size);
+
+		return p;
+	}
+
+	void* calloc(size_t count, size_t size) noexcept {
+
+		void* p = __libc_calloc(count, size);
+
+		if (p && enabled.load(std::memory_order_relaxed))
+			GUAllocationTracker::recordAllocation(count * size);
+
+		return p;
+	}
+
+	void* realloc(void* p, size_t size) noexcept {
+
+		void* q = __libc_realloc(p, size);
+
+		if (q && enabled.load(std::memory_order_relaxed))
+			GUAllocationTracker::recordAllocation(size);
+
+		return q;
+	}
+
+	void free(void* p) noexcept {
+
+		if (p && enabled.load(std::memory_order_relaxed))
+			GUAllocationTracker::recordFree();
+
+		__libc_free(p);
+	}
+}
+
+#endif
+
+#endif
@@ -0,0 +1,68 @@
+#pragma once
+
+//
+// Heap allocation tracker for finding allocations in the frame loop.  When compiled in (GU_ALLOCATION_TRACKER, on by default) the global operator new and delete are replaced, and so is malloc where the C library allows it (glibc, and the MSVC debug CRT through its allocation hook - the release CRT's malloc cannot be hooked).  Each allocation costs one flag test until tracking is switched on with GUAllocationTracker::setEnabled(true).
+//
+// While tracking, every allocation on any thread is counted against the current frame (frames end with GUAllocationTracker::endFrame), against the profiler zone open on the allocating thread (GU_PROFILE_ZONE) and against its call site - the return addresses of the allocating call stack.  Tracking takes a lock and a stack walk per allocation, so frame times measured while tracking are not representative.
+//
+// Bookkeeping is in fixed-size tables so recording never allocates.  Allocations made inside a GUUntrackedScope (eg. the profiler's own event buffers) are not counted.
+//
+
+#include "core.h"
+
+#ifndef GU_ALLOCATION_TRACKER
+#define GU_ALLOCATION_TRACKER 1
+#endif
+
+
+struct GUAllocationCounts {
+
+	uint64_t				allocations = 0;
+	uint64_t				bytes = 0; // requested - frees are counted but not sized
+	uint64_t				frees = 0;
+};
+
+
+class GUAllocationTracker {
+
+public:
+
+	// Start or stop counting.  Has no effect if GU_ALLOCATION_TRACKER is 0
+	static void setEnabled(bool enable);
+	static bool isEnabled();
+
+	// Close the current frame.  Call once per frame (on the render thread after the frame is presented)
+	static void endFrame();
+
+	// Forget the frame, zone and call site statistics - eg. once benchmark warm-up frames have run, so the statistics cover the steady state
+	static void resetStatistics();
+
+	// Frames closed since the last reset, and how many of them allocated
+	static uint64_t frameCount();
+	static uint64_t allocatingFrameCount();
+
+	// Totals since the last reset, counts of the last closed frame and the most allocations and bytes in any one frame
+	static GUAllocationCounts total();
+	static GUAllocationCounts lastFrame();
+	static GUAllocationCounts peakFrame();
+
+	// Print the per frame statistics, allocations by profiler zone and the topSites call sites with the most allocations since the last reset
+	static void printReport(int topSites = 10);
+
+	// Called by the replaced allocation functions
+	static void recordAllocation(size_t bytes);
+	static void recordFree();
+};
+
+
+// Allocations and frees made by the calling thread while a GUUntrackedScope exists are not recorded
+class GUUntrackedScope {
+
+public:
+
+	GUUntrackedScope();
+	~GUUntrackedScope();
+
+	GUUntrackedScope(const GUUntrackedScope&) = delete;
+	GUUntrackedScope& operator=(const GUUntrackedScope&) = delete;
+};
@@ -169,6 +169,15 @@ void ArcballCamera::resetCamera(float aspect)
 	calculateDerivedValues();
 }
 
+void ArcballCamera::setCamera(float theta, float phi, float radius) {
+
+	this->theta = theta;
+	this->phi = phi;
+	this->radius = std::max<float>(radius, 0.0f);
+
+	calculateDerivedValues();
+}
+
 #pragma endregion
 
 
@@ -83,6 +83,9 @@ public:
 	void setFarPlaneDistance(float farPlaneDistance);
 
 	void resetCamera(float aspect);
+
+	// set <theta, phi> (in degrees) and radius directly - used to replay recorded camera paths
+	void setCamera(float theta, float phi, float radius);
 	
 	
 	// Accessor methods for derived values
@@ -0,0 +1,25 @@
+#version 410
+
+// Impostor atlas bake - albedo with coverage in alpha, and model space normal packed into [0, 1]
+
+uniform sampler2D texture;
+
+
+in SimplePacket {
+
+	vec3 surfaceNormal;
+	vec2 texCoord;
+
+} inputFragment;
+
+
+layout (location=0) out vec4 albedoColour;
+layout (location=1) out vec4 normalColour;
+
+void main(void) {
+
+	vec3 N = normalize(inputFragment.surfaceNormal);
+
+	albedoColour = vec4(texture2D(texture, inputFragment.texCoord).rgb, 1.0);
+	normalColour = vec4(N * 0.5 + 0.5, 1.0);
+}
@@ -0,0 +1,29 @@
+#version 410
+
+// Impostor atlas bake - one orthographic view of the mesh per atlas frame
+
+uniform mat4 modelMatrix;
+uniform mat4 viewMatrix;
+uniform mat4 projMatrix;
+
+layout (location=0) in vec3 vertexPos;
+layout (location=2) in vec3 vertexTexCoord;
+layout (location=3) in vec3 vertexNormal;
+
+out SimplePacket {
+
+	vec3 surfaceNormal;
+	vec2 texCoord;
+
+} outputVertex;
+
+
+void main(void) {
+
+	outputVertex.texCoord = vertexTexCoord.st;
+
+	// Normals are stored in model coordinates so the impostor can be lit with any instance orientation
+	outputVertex.surfaceNormal = (transpose(inverse(modelMatrix)) * vec4(vertexNormal, 0.0)).xyz;
+
+	gl_Position = projMatrix * viewMatrix * modelMatrix * vec4(vertexPos, 1.0);
+}
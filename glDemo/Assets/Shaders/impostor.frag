@@ -0,0 +1,88 @@
+#version 410
+
+// Octahedral impostor - blends the albedo and normal atlases and lights with the directional and point lights in a single pass
+
+const int maxPointLights = 4;
+
+uniform sampler2D albedoAtlas;
+uniform sampler2D normalAtlas;
+uniform float framesPerSide;
+
+// Directional light model
+uniform vec3 lightDirection;
+uniform vec3 lightColour;
+
+// Point light model
+uniform int numPointLights;
+uniform vec3 pointLightPosition[maxPointLights];
+uniform vec3 pointLightColour[maxPointLights];
+uniform vec3 pointLightAttenuation[maxPointLights]; // x=constant, y=linear, z=quadratic
+
+
+in ImpostorPacket {
+
+	vec3 surfaceWorldPos;
+	vec2 frameUV[4];
+	flat vec2 frameOrigin[4];
+	flat vec4 frameWeights;
+	flat vec4 orientation;
+
+} inputFragment;
+
+
+layout (location=0) out vec4 fragColour;
+
+
+vec3 rotate(vec4 q, vec3 v) {
+
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+
+void main(void) {
+
+	vec4 albedo = vec4(0.0);
+	vec3 normal = vec3(0.0);
+
+	for (int k = 0; k < 4; ++k) {
+
+		vec2 uv = inputFragment.frameUV[k];
+
+		// Parts of the quad that project outside a frame would otherwise sample the neighbouring frame
+		if (any(lessThan(uv, vec2(0.0))) || any(greaterThan(uv, vec2(1.0))))
+			continue;
+
+		vec2 atlasUV = (inputFragment.frameOrigin[k] + uv) / framesPerSide;
+
+		vec4 a = texture(albedoAtlas, atlasUV);
+		vec3 n = texture(normalAtlas, atlasUV).xyz * 2.0 - 1.0;
+
+		albedo += a * inputFragment.frameWeights[k];
+		normal += n * a.a * inputFragment.frameWeights[k];
+	}
+
+	if (albedo.a < 0.5)
+		discard;
+
+	albedo.rgb /= albedo.a;
+
+	vec3 N = normalize(rotate(inputFragment.orientation, normal));
+
+	// Each light is clamped to zero as the additive per-light passes are
+	vec3 diffuseColour = albedo.rgb * lightColour * max(dot(N, lightDirection), 0.0);
+
+	for (int i = 0; i < numPointLights; ++i) {
+
+		vec3 surfaceToLightVec = pointLightPosition[i] - inputFragment.surfaceWorldPos;
+
+		float l = max(dot(N, normalize(surfaceToLightVec)), 0.0);
+		float d = length(surfaceToLightVec);
+
+		vec3 k = pointLightAttenuation[i];
+		float a = 1.0 / (k.x + (k.y * d) + (k.z * d * d));
+
+		diffuseColour += albedo.rgb * pointLightColour[i] * l * a;
+	}
+
+	fragColour = vec4(diffuseColour, 1.0);
+}
@@ -0,0 +1,100 @@
+#version 410
+
+// Octahedral impostor - camera-facing quad that reprojects onto the four atlas frames nearest the view direction
+
+uniform mat4 viewMatrix;
+uniform mat4 projMatrix;
+uniform vec3 cameraPos;
+uniform float framesPerSide;
+
+layout (location=0) in vec2 vertexPos; // quad corner in [-1, 1]
+layout (location=6) in vec4 instancePositionSize; // xyz = world centre, w = world radius
+layout (location=7) in vec4 instanceOrientation; // model to world rotation quaternion (x, y, z, w)
+
+out ImpostorPacket {
+
+	vec3 surfaceWorldPos;
+	vec2 frameUV[4]; // quad position projected onto each frame, in [0, 1] inside the frame
+	flat vec2 frameOrigin[4]; // frame position in the atlas grid
+	flat vec4 frameWeights;
+	flat vec4 orientation;
+
+} outputVertex;
+
+
+vec3 rotate(vec4 q, vec3 v) {
+
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+vec2 signNotZero(vec2 v) {
+
+	return vec2((v.x >= 0.0) ? 1.0 : -1.0, (v.y >= 0.0) ? 1.0 : -1.0);
+}
+
+vec2 octEncode(vec3 d) {
+
+	d /= abs(d.x) + abs(d.y) + abs(d.z);
+
+	vec2 e = (d.y >= 0.0) ? d.xz : (1.0 - abs(d.zx)) * signNotZero(d.xz);
+
+	return e * 0.5 + 0.5;
+}
+
+// Must match OctahedralImpostor::octahedralDirection
+vec3 octDecode(vec2 uv) {
+
+	vec2 e = uv * 2.0 - 1.0;
+	vec3 d = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+
+	if (d.y < 0.0)
+		d.xz = (1.0 - abs(d.zx)) * signNotZero(d.xz);
+
+	return normalize(d);
+}
+
+
+void main(void) {
+
+	vec3 centre = instancePositionSize.xyz;
+	float radius = instancePositionSize.w;
+	vec4 inverseOrientation = vec4(-instanceOrientation.xyz, instanceOrientation.w);
+
+	// Billboard facing the camera
+	vec3 toCamera = normalize(cameraPos - centre);
+	vec3 upRef = (abs(toCamera.y) > 0.999) ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+	vec3 right = normalize(cross(upRef, toCamera));
+	vec3 up = cross(toCamera, right);
+
+	vec3 offset = (right * vertexPos.x + up * vertexPos.y) * radius;
+
+	// Bilinear blend of the four frames around the model space view direction
+	vec2 grid = octEncode(rotate(inverseOrientation, toCamera)) * framesPerSide - 0.5;
+	vec2 base = floor(grid);
+	vec2 f = grid - base;
+
+	outputVertex.frameWeights = vec4((1.0 - f.x) * (1.0 - f.y), f.x * (1.0 - f.y), (1.0 - f.x) * f.y, f.x * f.y);
+
+	// Project the quad corner onto each frame's view plane (the same basis glm::lookAt builds when baking)
+	vec3 offsetModel = rotate(inverseOrientation, offset);
+
+	for (int k = 0; k < 4; ++k) {
+
+		vec2 frame = clamp(base + vec2(k & 1, k >> 1), vec2(0.0), vec2(framesPerSide - 1.0));
+		vec3 d = octDecode((frame + 0.5) / framesPerSide);
+
+		vec3 frameUp = (abs(d.y) > 0.999) ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+		vec3 frameRight = normalize(cross(-d, frameUp));
+		frameUp = cross(frameRight, -d);
+
+		outputVertex.frameUV[k] = vec2(dot(offsetModel, frameRight), dot(offsetModel, frameUp)) / (2.0 * radius) + 0.5;
+		outputVertex.frameOrigin[k] = frame;
+	}
+
+	outputVertex.orientation = instanceOrientation;
+
+	vec4 worldCoord = vec4(centre + offset, 1.0);
+	outputVertex.surfaceWorldPos = worldCoord.xyz;
+
+	gl_Position = projMatrix * viewMatrix * worldCoord;
+}
@@ -0,0 +1,22 @@
+#version 410
+
+// Font atlas coverage (red channel) scales the quad colour's alpha - panels and graph bars sample the atlas's solid cell
+
+uniform sampler2D fontAtlas;
+
+in HUDPacket {
+
+	vec2 texCoord;
+	vec4 colour;
+
+} inputFragment;
+
+
+layout (location=0) out vec4 fragColour;
+
+void main(void) {
+
+	float coverage = texture(fontAtlas, inputFragment.texCoord).r;
+
+	fragColour = vec4(inputFragment.colour.rgb, inputFragment.colour.a * coverage);
+}
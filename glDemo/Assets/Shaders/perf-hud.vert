@@ -0,0 +1,29 @@
+#version 410
+
+// Performance HUD - each instance is one screen-space quad (glyph, graph bar or panel), expanded from the vertex index of a 4 vertex triangle strip
+
+uniform vec2 viewportSize;
+
+layout (location=0) in vec4 quadRect; // x, y, width, height in pixels from the top left
+layout (location=1) in vec4 quadTexRect; // min uv, max uv in the font atlas
+layout (location=2) in vec4 quadColour;
+
+
+out HUDPacket {
+
+	vec2 texCoord;
+	vec4 colour;
+
+} outputVertex;
+
+
+void main(void) {
+
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	vec2 pos = quadRect.xy + corner * quadRect.zw;
+
+	outputVertex.texCoord = mix(quadTexRect.xy, quadTexRect.zw, corner);
+	outputVertex.colour = quadColour;
+
+	gl_Position = vec4(pos.x / viewportSize.x * 2.0 - 1.0, 1.0 - pos.y / viewportSize.y * 2.0, 0.0, 1.0);
+}
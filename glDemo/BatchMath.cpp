@@ -0,0 +1,770 @@
+// No fused multiply-adds anywhere in this file, including the glm operators the scalar versions use - they round differently from separate multiplies and adds, so levels would not match.  AVX-512 implies FMA, as does -mfma or -march on the command line.  Set before any include so inline functions from headers are covered too
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include "BatchMath.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BATCH_MATH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVC compiles any intrinsic in any function.  GCC and clang only allow intrinsics above the command line's target in functions marked for that instruction set
+#if defined(BATCH_MATH_X86) && !defined(_MSC_VER)
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define TARGET_SSE41
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+using namespace std;
+using namespace glm;
+
+
+// Query the CPU and OS for the highest usable level.  AVX state must also be enabled by the OS (XCR0), not just reported by cpuid
+static GUSimdLevel detectLevel() {
+
+#ifdef BATCH_MATH_X86
+
+	unsigned int leaf1[4] = { 0, 0, 0, 0 };
+	unsigned int leaf7[4] = { 0, 0, 0, 0 };
+	unsigned long long xcr0 = 0;
+
+#ifdef _MSC_VER
+
+	int info[4];
+
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuidex(info, 1, 0);
+	for (int k = 0; k < 4; ++k)
+		leaf1[k] = (unsigned int)info[k];
+
+	if (maxLeaf >= 7) {
+
+		__cpuidex(info, 7, 0);
+		for (int k = 0; k < 4; ++k)
+			leaf7[k] = (unsigned int)info[k];
+	}
+
+	if (leaf1[2] & (1u << 27))
+		xcr0 = _xgetbv(0);
+
+#else
+
+	unsigned int maxLeaf = __get_cpuid_max(0, nullptr);
+
+	__cpuid_count(1, 0, leaf1[0], leaf1[1], leaf1[2], leaf1[3]);
+
+	if (maxLeaf >= 7)
+		__cpuid_count(7, 0, leaf7[0], leaf7[1], leaf7[2], leaf7[3]);
+
+	if (leaf1[2] & (1u << 27)) {
+
+		unsigned int lo, hi;
+
+		__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		xcr0 = ((unsigned long long)hi << 32) | lo;
+	}
+
+#endif
+
+	bool sse41 = (leaf1[2] & (1u << 19)) != 0;
+	bool avxState = (xcr0 & 0x06) == 0x06; // XMM and YMM
+	bool avx512State = (xcr0 & 0xE6) == 0xE6; // plus opmask and ZMM
+	bool avx2 = avxState && (leaf1[2] & (1u << 28)) && (leaf7[1] & (1u << 5));
+	bool avx512 = avx2 && avx512State && (leaf7[1] & (1u << 16));
+
+	if (avx512)
+		return GUSimdLevel::AVX512;
+	else if (avx2)
+		return GUSimdLevel::AVX2;
+	else if (sse41)
+		return GUSimdLevel::SSE41;
+
+#endif
+
+	return GUSimdLevel::Scalar;
+}
+
+
+// Static member definitions
+GUSimdLevel GUBatchMath::supported = detectLevel();
+GUSimdLevel GUBatchMath::current = GUBatchMath::supported;
+
+
+
+//
+// Scalar kernels (the reference for the others)
+//
+
+static void multiplyMatricesScalar(const mat4* parents, const mat4* locals, mat4* out, size_t count) {
+
+	for (size_t i = 0; i < count; ++i)
+		out[i] = parents[i] * locals[i];
+}
+
+
+static void transformAABBsScalar(const mat4* transforms, const AABB* localBounds, AABB* worldBounds, size_t count) {
+
+	for (size_t i = 0; i < count; ++i)
+		worldBounds[i] = localBounds[i].transformed(transforms[i]);
+}
+
+
+static void testSpheresScalar(const vec4 planes[6], const float* centreX, const float* centreY, const float* centreZ, const float* radius, uint8_t* visible, size_t count) {
+
+	for (size_t i = 0; i < count; ++i) {
+
+		vec3 centre = vec3(centreX[i], centreY[i], centreZ[i]);
+		bool inside = true;
+
+		for (int p = 0; p < 6; ++p)
+			inside = inside && (dot(vec3(planes[p]), centre) + planes[p].w >= -radius[i]);
+
+		visible[i] = inside ? 1 : 0;
+	}
+}
+
+
+static void testAABBsScalar(const vec4 planes[6], const float* minX, const float* minY, const float* minZ, const float* maxX, const float* maxY, const float* maxZ, uint8_t* visible, size_t count) {
+
+	for (size_t i = 0; i < count; ++i) {
+
+		bool inside = true;
+
+		for (int p = 0; p < 6; ++p) {
+
+			vec3 corner = vec3(
+				(planes[p].x >= 0.0f) ? maxX[i] : minX[i],
+				(planes[p].y >= 0.0f) ? maxY[i] : minY[i],
+				(planes[p].z >= 0.0f) ? maxZ[i] : minZ[i]);
+
+			inside = inside && (dot(vec3(planes[p]), corner) + planes[p].w >= 0.0f);
+		}
+
+		visible[i] = inside ? 1 : 0;
+	}
+}
+
+
+
+#ifdef BATCH_MATH_X86
+
+//
+// SSE4.1 kernels - one matrix or box per register, 4 objects per plane test
+//
+
+TARGET_SSE41 static void multiplyMatricesSSE41(const mat4* parents, const mat4* locals, mat4* out, size_t count) {
+
+	for (size_t i = 0; i < count; ++i) {
+
+		const float* a = &parents[i][0][0];
+		const float* b = &locals[i][0][0];
+
+		__m128 a0 = _mm_loadu_ps(a);
+		__m128 a1 = _mm_loadu_ps(a + 4);
+		__m128 a2 = _mm_loadu_ps(a + 8);
+		__m128 a3 = _mm_loadu_ps(a + 12);
+
+		__m128 result[4];
+
+		// Column c is ((a0 * b[c][0] + a1 * b[c][1]) + a2 * b[c][2]) + a3 * b[c][3] - glm's order
+		for (int c = 0; c < 4; ++c) {
+
+			__m128 bc = _mm_loadu_ps(b + c * 4);
+
+			result[c] = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(a0, _mm_shuffle_ps(bc, bc, 0x00)),
+				_mm_mul_ps(a1, _mm_shuffle_ps(bc, bc, 0x55))),
+				_mm_mul_ps(a2, _mm_shuffle_ps(bc, bc, 0xAA))),
+				_mm_mul_ps(a3, _mm_shuffle_ps(bc, bc, 0xFF)));
+		}
+
+		float* r = &out[i][0][0];
+
+		for (int c = 0; c < 4; ++c)
+			_mm_storeu_ps(r + c * 4, result[c]);
+	}
+}
+
+
+TARGET_SSE41 static void transformAABBsSSE41(const mat4* transforms, const AABB* localBounds, AABB* worldBounds, size_t count) {
+
+	for (size_t i = 0; i < count; ++i) {
+
+		const float* m = &transforms[i][0][0];
+		const AABB& box = localBounds[i];
+
+		__m128 newMin = _mm_loadu_ps(m + 12);
+		__m128 newMax = newMin;
+
+		// Lanes are the output axes i of AABB::transformed.  min(a, b) and max(b, a) pick the same operand as (a < b) ? a : b and (a < b) ? b : a
+		for (int j = 0; j < 3; ++j) {
+
+			__m128 column = _mm_loadu_ps(m + j * 4);
+			__m128 a = _mm_mul_ps(column, _mm_set1_ps(box.min[j]));
+			__m128 b = _mm_mul_ps(column, _mm_set1_ps(box.max[j]));
+
+			newMin = _mm_add_ps(newMin, _mm_min_ps(a, b));
+			newMax = _mm_add_ps(newMax, _mm_max_ps(b, a));
+		}
+
+		float lo[4], hi[4];
+
+		_mm_storeu_ps(lo, newMin);
+		_mm_storeu_ps(hi, newMax);
+
+		worldBounds[i] = AABB(vec3(lo[0], lo[1], lo[2]), vec3(hi[0], hi[1], hi[2]));
+	}
+}
+
+
+TARGET_SSE41 static void testSpheresSSE41(const vec4 planes[6], const float* centreX, const float* centreY, const float* centreZ, const float* radius, uint8_t* visible, size_t count) {
+
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+
+		__m128 cx = _mm_loadu_ps(centreX + i);
+		__m128 cy = _mm_loadu_ps(centreY + i);
+		__m128 cz = _mm_loadu_ps(centreZ + i);
+		__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+
+		__m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps()); // all bits set
+
+		for (int p = 0; p < 6; ++p) {
+
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_set1_ps(planes[p].x), cx),
+				_mm_mul_ps(_mm_set1_ps(planes[p].y), cy)),
+				_mm_mul_ps(_mm_set1_ps(planes[p].z), cz)),
+				_mm_set1_ps(planes[p].w));
+
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, negRadius));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+
+		for (int k = 0; k < 4; ++k)
+			visible[i + k] = (uint8_t)((mask >> k) & 1);
+	}
+
+	testSpheresScalar(planes, centreX + i, centreY + i, centreZ + i, radius + i, visible + i, count - i);
+}
+
+
+TARGET_SSE41 static void testAABBsSSE41(const vec4 planes[6], const float* minX, const float* minY, const float* minZ, const float* maxX, const float* maxY, const float* maxZ, uint8_t* visible, size_t count) {
+
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+
+		__m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+
+		// The normal is the same for every lane, so the furthest corner is chosen per plane rather than per box
+		for (int p = 0; p < 6; ++p) {
+
+			__m128 x = _mm_loadu_ps(((planes[p].x >= 0.0f) ? maxX : minX) + i);
+			__m128 y = _mm_loadu_ps(((planes[p].y >= 0.0f) ? maxY : minY) + i);
+			__m128 z = _mm_loadu_ps(((planes[p].z >= 0.0f) ? maxZ : minZ) + i);
+
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_set1_ps(planes[p].x), x),
+				_mm_mul_ps(_mm_set1_ps(planes[p].y), y)),
+				_mm_mul_ps(_mm_set1_ps(planes[p].z), z)),
+				_mm_set1_ps(planes[p].w));
+
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, _mm_setzero_ps()));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+
+		for (int k = 0; k < 4; ++k)
+			visible[i + k] = (uint8_t)((mask >> k) & 1);
+	}
+
+	testAABBsScalar(planes, minX + i, minY + i, minZ + i, maxX + i, maxY + i, maxZ + i, visible + i, count - i);
+}
+
+
+
+//
+// AVX2 kernels - two matrix columns or two boxes per register, 8 objects per plane test
+//
+
+TARGET_AVX2 static void multiplyMatricesAVX2(const mat4* parents, const mat4* locals, mat4* out, size_t count) {
+
+	for (size_t i = 0; i < count; ++i) {
+
+		const float* a = &parents[i][0][0];
+		const float* b = &locals[i][0][0];
+
+		// Each column of the parent in both halves, so one register computes two result columns
+		__m256 a0 = _mm256_broadcast_ps((const __m128*)a);
+		__m256 a1 = _mm256_broadcast_ps((const __m128*)(a + 4));
+		__m256 a2 = _mm256_broadcast_ps((const __m128*)(a + 8));
+		__m256 a3 = _mm256_broadcast_ps((const __m128*)(a + 12));
+
+		__m256 b01 = _mm256_loadu_ps(b);
+		__m256 b23 = _mm256_loadu_ps(b + 8);
+
+		__m256 r01 = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, 0x00)),
+			_mm256_mul_ps(a1, _mm256_shuffle_ps(b01, b01, 0x55))),
+			_mm256_mul_ps(a2, _mm256_shuffle_ps(b01, b01, 0xAA))),
+			_mm256_mul_ps(a3, _mm256_shuffle_ps(b01, b01, 0xFF)));
+
+		__m256 r23 = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(a0, _mm256_shuffle_ps(b23, b23, 0x00)),
+			_mm256_mul_ps(a1, _mm256_shuffle_ps(b23, b23, 0x55))),
+			_mm256_mul_ps(a2, _mm256_shuffle_ps(b23, b23, 0xAA))),
+			_mm256_mul_ps(a3, _mm256_shuffle_ps(b23, b23, 0xFF)));
+
+		float* r = &out[i][0][0];
+
+		_mm256_storeu_ps(r, r01);
+		_mm256_storeu_ps(r + 8, r23);
+	}
+}
+
+
+TARGET_AVX2 static void transformAABBsAVX2(const mat4* transforms, const AABB* localBounds, AABB* worldBounds, size_t count) {
+
+	size_t i = 0;
+
+	// Box i in the low half and box i + 1 in the high half
+	for (; i + 2 <= count; i += 2) {
+
+		const float* m0 = &transforms[i][0][0];
+		const float* m1 = &transforms[i + 1][0][0];
+		const AABB& box0 = localBounds[i];
+		const AABB& box1 = localBounds[i + 1];
+
+		__m256 newMin = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(m0 + 12)), _mm_loadu_ps(m1 + 12), 1);
+		__m256 newMax = newMin;
+
+		for (int j = 0; j < 3; ++j) {
+
+			__m256 column = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(m0 + j * 4)), _mm_loadu_ps(m1 + j * 4), 1);
+			__m256 boxMin = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(box0.min[j])), _mm_set1_ps(box1.min[j]), 1);
+			__m256 boxMax = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(box0.max[j])), _mm_set1_ps(box1.max[j]), 1);
+
+			__m256 a = _mm256_mul_ps(column, boxMin);
+			__m256 b = _mm256_mul_ps(column, boxMax);
+
+			newMin = _mm256_add_ps(newMin, _mm256_min_ps(a, b));
+			newMax = _mm256_add_ps(newMax, _mm256_max_ps(b, a));
+		}
+
+		float lo[8], hi[8];
+
+		_mm256_storeu_ps(lo, newMin);
+		_mm256_storeu_ps(hi, newMax);
+
+		worldBounds[i] = AABB(vec3(lo[0], lo[1], lo[2]), vec3(hi[0], hi[1], hi[2]));
+		worldBounds[i + 1] = AABB(vec3(lo[4], lo[5], lo[6]), vec3(hi[4], hi[5], hi[6]));
+	}
+
+	transformAABBsSSE41(transforms + i, localBounds + i, worldBounds + i, count - i);
+}
+
+
+TARGET_AVX2 static void testSpheresAVX2(const vec4 planes[6], const float* centreX, const float* centreY, const float* centreZ, const float* radius, uint8_t* visible, size_t count) {
+
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+
+		__m256 cx = _mm256_loadu_ps(centreX + i);
+		__m256 cy = _mm256_loadu_ps(centreY + i);
+		__m256 cz = _mm256_loadu_ps(centreZ + i);
+		__m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+		for (int p = 0; p < 6; ++p) {
+
+			__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(_mm256_set1_ps(planes[p].x), cx),
+				_mm256_mul_ps(_mm256_set1_ps(planes[p].y), cy)),
+				_mm256_mul_ps(_mm256_set1_ps(planes[p].z), cz)),
+				_mm256_set1_ps(planes[p].w));
+
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, negRadius, _CMP_GE_OQ));
+		}
+
+		int mask = _mm256_movemask_ps(inside);
+
+		for (int k = 0; k < 8; ++k)
+			visible[i + k] = (uint8_t)((mask >> k) & 1);
+	}
+
+	testSpheresSSE41(planes, centreX + i, centreY + i, centreZ + i, radius + i, visible + i, count - i);
+}
+
+
+TARGET_AVX2 static void testAABBsAVX2(const vec4 planes[6], const float* minX, const float* minY, const float* minZ, const float* maxX, const float* maxY, const float* maxZ, uint8_t* visible, size_t count) {
+
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+		for (int p = 0; p < 6; ++p) {
+
+			__m256 x = _mm256_loadu_ps(((planes[p].x >= 0.0f) ? maxX : minX) + i);
+			__m256 y = _mm256_loadu_ps(((planes[p].y >= 0.0f) ? maxY : minY) + i);
+			__m256 z = _mm256_loadu_ps(((planes[p].z >= 0.0f) ? maxZ : minZ) + i);
+
+			__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(_mm256_set1_ps(planes[p].x), x),
+				_mm256_mul_ps(_mm256_set1_ps(planes[p].y), y)),
+				_mm256_mul_ps(_mm256_set1_ps(planes[p].z), z)),
+				_mm256_set1_ps(planes[p].w));
+
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, _mm256_setzero_ps(), _CMP_GE_OQ));
+		}
+
+		int mask = _mm256_movemask_ps(inside);
+
+		for (int k = 0; k < 8; ++k)
+			visible[i + k] = (uint8_t)((mask >> k) & 1);
+	}
+
+	testAABBsSSE41(planes, minX + i, minY + i, minZ + i, maxX + i, maxY + i, maxZ + i, visible + i, count - i);
+}
+
+
+
+//
+// AVX-512 kernels - a whole matrix or four boxes per register, 16 objects per plane test
+//
+
+TARGET_AVX512 static void multiplyMatricesAVX512(const mat4* parents, const mat4* locals, mat4* out, size_t count) {
+
+	for (size_t i = 0; i < count; ++i) {
+
+		const float* a = &parents[i][0][0];
+
+		__m512 a0 = _mm512_broadcast_f32x4(_mm_loadu_ps(a));
+		__m512 a1 = _mm512_broadcast_f32x4(_mm_loadu_ps(a + 4));
+		__m512 a2 = _mm512_broadcast_f32x4(_mm_loadu_ps(a + 8));
+		__m512 a3 = _mm512_broadcast_f32x4(_mm_loadu_ps(a + 12));
+
+		__m512 b = _mm512_loadu_ps(&locals[i][0][0]);
+
+		__m512 r = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(
+			_mm512_mul_ps(a0, _mm512_permute_ps(b, 0x00)),
+			_mm512_mul_ps(a1, _mm512_permute_ps(b, 0x55))),
+			_mm512_mul_ps(a2, _mm512_permute_ps(b, 0xAA))),
+			_mm512_mul_ps(a3, _mm512_permute_ps(b, 0xFF)));
+
+		_mm512_storeu_ps(&out[i][0][0], r);
+	}
+}
+
+
+TARGET_AVX512 static void transformAABBsAVX512(const mat4* transforms, const AABB* localBounds, AABB* worldBounds, size_t count) {
+
+	size_t i = 0;
+
+	// Box i + k in 128 bit lane k
+	for (; i + 4 <= count; i += 4) {
+
+		const float* m[4];
+
+		for (int k = 0; k < 4; ++k)
+			m[k] = &transforms[i + k][0][0];
+
+		__m512 newMin = _mm512_castps128_ps512(_mm_loadu_ps(m[0] + 12));
+		newMin = _mm512_insertf32x4(newMin, _mm_loadu_ps(m[1] + 12), 1);
+		newMin = _mm512_insertf32x4(newMin, _mm_loadu_ps(m[2] + 12), 2);
+		newMin = _mm512_insertf32x4(newMin, _mm_loadu_ps(m[3] + 12), 3);
+
+		__m512 newMax = newMin;
+
+		for (int j = 0; j < 3; ++j) {
+
+			__m512 column = _mm512_castps128_ps512(_mm_loadu_ps(m[0] + j * 4));
+			column = _mm512_insertf32x4(column, _mm_loadu_ps(m[1] + j * 4), 1);
+			column = _mm512_insertf32x4(column, _mm_loadu_ps(m[2] + j * 4), 2);
+			column = _mm512_insertf32x4(column, _mm_loadu_ps(m[3] + j * 4), 3);
+
+			__m512 boxMin = _mm512_castps128_ps512(_mm_set1_ps(localBounds[i].min[j]));
+			boxMin = _mm512_insertf32x4(boxMin, _mm_set1_ps(localBounds[i + 1].min[j]), 1);
+			boxMin = _mm512_insertf32x4(boxMin, _mm_set1_ps(localBounds[i + 2].min[j]), 2);
+			boxMin = _mm512_insertf32x4(boxMin, _mm_set1_ps(localBounds[i + 3].min[j]), 3);
+
+			__m512 boxMax = _mm512_castps128_ps512(_mm_set1_ps(localBounds[i].max[j]));
+			boxMax = _mm512_insertf32x4(boxMax, _mm_set1_ps(localBounds[i + 1].max[j]), 1);
+			boxMax = _mm512_insertf32x4(boxMax, _mm_set1_ps(localBounds[i + 2].max[j]), 2);
+			boxMax = _mm512_insertf32x4(boxMax, _mm_set1_ps(localBounds[i + 3].max[j]), 3);
+
+			__m512 a = _mm512_mul_ps(column, boxMin);
+			__m512 b = _mm512_mul_ps(column, boxMax);
+
+			newMin = _mm512_add_ps(newMin, _mm512_min_ps(a, b));
+			newMax = _mm512_add_ps(newMax, _mm512_max_ps(b, a));
+		}
+
+		float lo[16], hi[16];
+
+		_mm512_storeu_ps(lo, newMin);
+		_mm512_storeu_ps(hi, newMax);
+
+		for (int k = 0; k < 4; ++k)
+			worldBounds[i + k] = AABB(vec3(lo[k * 4], lo[k * 4 + 1], lo[k * 4 + 2]), vec3(hi[k * 4], hi[k * 4 + 1], hi[k * 4 + 2]));
+	}
+
+	transformAABBsSSE41(transforms + i, localBounds + i, worldBounds + i, count - i);
+}
+
+
+TARGET_AVX512 static void testSpheresAVX512(const vec4 planes[6], const float* centreX, const float* centreY, const float* centreZ, const float* radius, uint8_t* visible, size_t count) {
+
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+
+		__m512 cx = _mm512_loadu_ps(centreX + i);
+		__m512 cy = _mm512_loadu_ps(centreY + i);
+		__m512 cz = _mm512_loadu_ps(centreZ + i);
+		__m512 negRadius = _mm512_sub_ps(_mm512_setzero_ps(), _mm512_loadu_ps(radius + i));
+
+		__mmask16 inside = 0xFFFF;
+
+		for (int p = 0; p < 6; ++p) {
+
+			__m512 dist = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(
+				_mm512_mul_ps(_mm512_set1_ps(planes[p].x), cx),
+				_mm512_mul_ps(_mm512_set1_ps(planes[p].y), cy)),
+				_mm512_mul_ps(_mm512_set1_ps(planes[p].z), cz)),
+				_mm512_set1_ps(planes[p].w));
+
+			inside = _mm512_mask_cmp_ps_mask(inside, dist, negRadius, _CMP_GE_OQ);
+		}
+
+		for (int k = 0; k < 16; ++k)
+			visible[i + k] = (uint8_t)((inside >> k) & 1);
+	}
+
+	testSpheresAVX2(planes, centreX + i, centreY + i, centreZ + i, radius + i, visible + i, count - i);
+}
+
+
+TARGET_AVX512 static void testAABBsAVX512(const vec4 planes[6], const float* minX, const float* minY, const float* minZ, const float* maxX, const float* maxY, const float* maxZ, uint8_t* visible, size_t count) {
+
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+
+		__mmask16 inside = 0xFFFF;
+
+		for (int p = 0; p < 6; ++p) {
+
+			__m512 x = _mm512_loadu_ps(((planes[p].x >= 0.0f) ? maxX : minX) + i);
+			__m512 y = _mm512_loadu_ps(((planes[p].y >= 0.0f) ? maxY : minY) + i);
+			__m512 z = _mm512_loadu_ps(((planes[p].z >= 0.0f) ? maxZ : minZ) + i);
+
+			__m512 dist = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(
+				_mm512_mul_ps(_mm512_set1_ps(planes[p].x), x),
+				_mm512_mul_ps(_mm512_set1_ps(planes[p].y), y)),
+				_mm512_mul_ps(_mm512_set1_ps(planes[p].z), z)),
+				_mm512_set1_ps(planes[p].w));
+
+			inside = _mm512_mask_cmp_ps_mask(inside, dist, _mm512_setzero_ps(), _CMP_GE_OQ);
+		}
+
+		for (int k = 0; k < 16; ++k)
+			visible[i + k] = (uint8_t)((inside >> k) & 1);
+	}
+
+	testAABBsAVX2(planes, minX + i, minY + i, minZ + i, maxX + i, maxY + i, maxZ + i, visible + i, count - i);
+}
+
+#endif
+
+
+
+//
+// GUBatchMath
+//
+
+GUSimdLevel GUBatchMath::supportedLevel() {
+
+	return supported;
+}
+
+
+GUSimdLevel GUBatchMath::level() {
+
+	return current;
+}
+
+
+void GUBatchMath::setLevel(GUSimdLevel level) {
+
+	current = ((int)level <= (int)supported) ? level : supported;
+}
+
+
+const char* GUBatchMath::levelName(GUSimdLevel level) {
+
+	switch (level) {
+
+	case GUSimdLevel::SSE41:
+		return "sse4.1";
+
+	case GUSimdLevel::AVX2:
+		return "avx2";
+
+	case GUSimdLevel::AVX512:
+		return "avx512";
+
+	default:
+		return "scalar";
+	}
+}
+
+
+void GUBatchMath::multiplyMatrices(const mat4* parents, const mat4* locals, mat4* out, size_t count) {
+
+	switch (current) {
+
+#ifdef BATCH_MATH_X86
+
+	case GUSimdLevel::AVX512:
+		multiplyMatricesAVX512(parents, locals, out, count);
+		break;
+
+	case GUSimdLevel::AVX2:
+		multiplyMatricesAVX2(parents, locals, out, count);
+		break;
+
+	case GUSimdLevel::SSE41:
+		multiplyMatricesSSE41(parents, locals, out, count);
+		break;
+
+#endif
+
+	default:
+		multiplyMatricesScalar(parents, locals, out, count);
+		break;
+	}
+}
+
+
+void GUBatchMath::transformAABBs(const mat4* transforms, const AABB* localBounds, AABB* worldBounds, size_t count) {
+
+	switch (current) {
+
+#ifdef BATCH_MATH_X86
+
+	case GUSimdLevel::AVX512:
+		transformAABBsAVX512(transforms, localBounds, worldBounds, count);
+		break;
+
+	case GUSimdLevel::AVX2:
+		transformAABBsAVX2(transforms, localBounds, worldBounds, count);
+		break;
+
+	case GUSimdLevel::SSE41:
+		transformAABBsSSE41(transforms, localBounds, worldBounds, count);
+		break;
+
+#endif
+
+	default:
+		transformAABBsScalar(transforms, localBounds, worldBounds, count);
+		break;
+	}
+}
+
+
+void GUBatchMath::frustumPlanes(const mat4& viewProjection, vec4 planes[6]) {
+
+	const mat4& M = viewProjection;
+
+	vec4 row0 = vec4(M[0][0], M[1][0], M[2][0], M[3][0]);
+	vec4 row1 = vec4(M[0][1], M[1][1], M[2][1], M[3][1]);
+	vec4 row2 = vec4(M[0][2], M[1][2], M[2][2], M[3][2]);
+	vec4 row3 = vec4(M[0][3], M[1][3], M[2][3], M[3][3]);
+
+	planes[0] = row3 + row0;
+	planes[1] = row3 - row0;
+	planes[2] = row3 + row1;
+	planes[3] = row3 - row1;
+	planes[4] = row3 + row2;
+	planes[5] = row3 - row2;
+
+	for (int p = 0; p < 6; ++p)
+		planes[p] /= glm::length(vec3(planes[p]));
+}
+
+
+void GUBatchMath::testSpheres(const vec4 planes[6], const float* centreX, const float* centreY, const float* centreZ, const float* radius, uint8_t* visible, size_t count) {
+
+	switch (current) {
+
+#ifdef BATCH_MATH_X86
+
+	case GUSimdLevel::AVX512:
+		testSpheresAVX512(planes, centreX, centreY, centreZ, radius, visible, count);
+		break;
+
+	case GUSimdLevel::AVX2:
+		testSpheresAVX2(planes, centreX, centreY, centreZ, radius, visible, count);
+		break;
+
+	case GUSimdLevel::SSE41:
+		testSpheresSSE41(planes, centreX, centreY, centreZ, radius, visible, count);
+		break;
+
+#endif
+
+	default:
+		testSpheresScalar(planes, centreX, centreY, centreZ, radius, visible, count);
+		break;
+	}
+}
+
+
+void GUBatchMath::testAABBs(const vec4 planes[6], const float* minX, const float* minY, const float* minZ, const float* maxX, const float* maxY, const float* maxZ, uint8_t* visible, size_t count) {
+
+	switch (current) {
+
+#ifdef BATCH_MATH_X86
+
+	case GUSimdLevel::AVX512:
+		testAABBsAVX512(planes, minX, minY, minZ, maxX, maxY, maxZ, visible, count);
+		break;
+
+	case GUSimdLevel::AVX2:
+		testAABBsAVX2(planes, minX, minY, minZ, maxX, maxY, maxZ, visible, count);
+		break;
+
+	case GUSimdLevel::SSE41:
+		testAABBsSSE41(planes, minX, minY, minZ, maxX, maxY, maxZ, visible, count);
+		break;
+
+#endif
+
+	default:
+		testAABBsScalar(planes, minX, minY, minZ, maxX, maxY, maxZ, visible, count);
+		break;
+	}
+}
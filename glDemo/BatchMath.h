@@ -0,0 +1,52 @@
+#pragma once
+
+//
+// SIMD kernels for the per-instance maths done in bulk each frame - matrix products, bounding box transforms and frustum tests.  Each kernel has a scalar version written with glm (the reference) and SSE4.1, AVX2 and AVX-512 versions chosen at startup from what the CPU and OS support, so one executable runs on any x64 machine.  setLevel can force a lower level for comparison.
+//
+// The SIMD versions perform the same float operations in the same order as the scalar ones (no fused multiply-add, no reassociation), so every level gives bit-identical results - runBatchMathBenchmark checks this.
+//
+// Matrices stay in glm's column-major layout and are processed one (or a few) per register rather than transposed into per-element arrays, so callers pass the std::vector<mat4> they already have.  The plane tests read bounds in structure-of-arrays form (one array per coordinate) and test 4, 8 or 16 objects at once.
+//
+
+#include "core.h"
+#include "AABB.h"
+
+
+enum class GUSimdLevel { Scalar = 0, SSE41, AVX2, AVX512 };
+
+
+class GUBatchMath {
+
+private:
+
+	static GUSimdLevel			supported;
+	static GUSimdLevel			current;
+
+public:
+
+	// Highest level the CPU and OS support (Scalar on other architectures)
+	static GUSimdLevel supportedLevel();
+
+	// Level the kernels currently use - supportedLevel() unless setLevel has lowered it
+	static GUSimdLevel level();
+
+	// Use level, or supportedLevel() if level is higher
+	static void setLevel(GUSimdLevel level);
+
+	static const char* levelName(GUSimdLevel level);
+
+	// out[i] = parents[i] * locals[i].  out may be the same array as either input
+	static void multiplyMatrices(const glm::mat4* parents, const glm::mat4* locals, glm::mat4* out, size_t count);
+
+	// worldBounds[i] = localBounds[i].transformed(transforms[i]).  worldBounds may be the same array as localBounds
+	static void transformAABBs(const glm::mat4* transforms, const AABB* localBounds, AABB* worldBounds, size_t count);
+
+	// Normalised frustum planes of viewProjection (Gribb / Hartmann), inside where dot(n, p) + d >= 0.  Order is left, right, bottom, top, near, far
+	static void frustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
+	// visible[i] = 1 if sphere i is not entirely outside any of the 6 planes, 0 otherwise
+	static void testSpheres(const glm::vec4 planes[6], const float* centreX, const float* centreY, const float* centreZ, const float* radius, uint8_t* visible, size_t count);
+
+	// visible[i] = 1 if box i is not entirely outside any of the 6 planes (the corner furthest along each plane normal is inside), 0 otherwise
+	static void testAABBs(const glm::vec4 planes[6], const float* minX, const float* minY, const float* minZ, const float* maxX, const float* maxY, const float* maxZ, uint8_t* visible, size_t count);
+};
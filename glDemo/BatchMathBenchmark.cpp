@@ -0,0 +1,252 @@
+#include "BatchMathBenchmark.h"
+#include "BatchMath.h"
+#include <random>
+#include <cstring>
+
+using namespace std;
+using namespace glm;
+
+
+static const size_t batchSizes[] = { 16, 256, 4096, 65536 };
+
+
+// Inputs and outputs for every kernel - random transforms, boxes of the kind AIMesh produces and a camera looking across them so the plane tests give a mix of results
+struct BatchMathData {
+
+	vector<mat4>			parents, locals, products;
+	vector<AABB>			localBounds, worldBounds;
+
+	vector<float>			centreX, centreY, centreZ, radius;
+	vector<float>			minX, minY, minZ, maxX, maxY, maxZ;
+	vector<uint8_t>			visible;
+
+	vec4					planes[6];
+
+	BatchMathData(size_t count);
+};
+
+
+BatchMathData::BatchMathData(size_t count) :
+	parents(count), locals(count), products(count), localBounds(count), worldBounds(count),
+	centreX(count), centreY(count), centreZ(count), radius(count),
+	minX(count), minY(count), minZ(count), maxX(count), maxY(count), maxZ(count),
+	visible(count) {
+
+	mt19937 rng(1);
+	uniform_real_distribution<float> position(-100.0f, 100.0f);
+	uniform_real_distribution<float> angle(-180.0f, 180.0f);
+	uniform_real_distribution<float> size(0.1f, 10.0f);
+
+	for (size_t i = 0; i < count; ++i) {
+
+		vec3 p = vec3(position(rng), position(rng) * 0.1f, position(rng));
+
+		parents[i] = glm::rotate(glm::translate(identity<mat4>(), p), glm::radians(angle(rng)), vec3(0.0f, 1.0f, 0.0f));
+		locals[i] = glm::scale(glm::rotate(glm::translate(identity<mat4>(), vec3(size(rng))), glm::radians(angle(rng)), vec3(1.0f, 0.0f, 0.0f)), vec3(size(rng) * 0.1f));
+
+		vec3 extents = vec3(size(rng), size(rng), size(rng));
+
+		localBounds[i] = AABB(-extents, extents * 0.5f);
+
+		centreX[i] = p.x;
+		centreY[i] = p.y;
+		centreZ[i] = p.z;
+		radius[i] = glm::length(extents);
+
+		minX[i] = p.x - extents.x;
+		minY[i] = p.y - extents.y;
+		minZ[i] = p.z - extents.z;
+		maxX[i] = p.x + extents.x;
+		maxY[i] = p.y + extents.y;
+		maxZ[i] = p.z + extents.z;
+	}
+
+	mat4 viewProjection = glm::perspective(glm::radians(55.0f), 16.0f / 9.0f, 0.1f, 80.0f) * glm::lookAt(vec3(0.0f, 10.0f, -60.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+
+	GUBatchMath::frustumPlanes(viewProjection, planes);
+}
+
+
+
+//
+// Validation
+//
+
+struct BatchMathResults {
+
+	vector<mat4>			products;
+	vector<AABB>			worldBounds;
+	vector<uint8_t>			spheresVisible;
+	vector<uint8_t>			boxesVisible;
+};
+
+
+static BatchMathResults runKernels(const BatchMathData& data) {
+
+	size_t n = data.parents.size();
+	BatchMathResults results;
+
+	results.products.resize(n);
+	results.worldBounds.resize(n);
+	results.spheresVisible.resize(n);
+	results.boxesVisible.resize(n);
+
+	GUBatchMath::multiplyMatrices(data.parents.data(), data.locals.data(), results.products.data(), n);
+	GUBatchMath::transformAABBs(data.parents.data(), data.localBounds.data(), results.worldBounds.data(), n);
+	GUBatchMath::testSpheres(data.planes, data.centreX.data(), data.centreY.data(), data.centreZ.data(), data.radius.data(), results.spheresVisible.data(), n);
+	GUBatchMath::testAABBs(data.planes, data.minX.data(), data.minY.data(), data.minZ.data(), data.maxX.data(), data.maxY.data(), data.maxZ.data(), results.boxesVisible.data(), n);
+
+	return results;
+}
+
+
+static bool sameBits(const void* a, const void* b, size_t bytes) {
+
+	return (bytes == 0) || memcmp(a, b, bytes) == 0;
+}
+
+
+// Compare every level above Scalar with Scalar, for batch sizes that leave a remainder after each level's block size.  Returns the number of mismatches
+static int validateKernels() {
+
+	const size_t counts[] = { 1, 3, 7, 15, 33, 1001 };
+	int failures = 0;
+
+	for (size_t count : counts) {
+
+		BatchMathData data(count);
+
+		GUBatchMath::setLevel(GUSimdLevel::Scalar);
+		BatchMathResults reference = runKernels(data);
+
+		for (int l = (int)GUSimdLevel::SSE41; l <= (int)GUBatchMath::supportedLevel(); ++l) {
+
+			GUBatchMath::setLevel((GUSimdLevel)l);
+			BatchMathResults results = runKernels(data);
+
+			const char* level = GUBatchMath::levelName((GUSimdLevel)l);
+
+			bool matches[4] = {
+				sameBits(results.products.data(), reference.products.data(), count * sizeof(mat4)),
+				sameBits(results.worldBounds.data(), reference.worldBounds.data(), count * sizeof(AABB)),
+				results.spheresVisible == reference.spheresVisible,
+				results.boxesVisible == reference.boxesVisible
+			};
+
+			const char* kernels[4] = { "multiply matrices", "transform AABBs", "test spheres", "test AABBs" };
+
+			for (int k = 0; k < 4; ++k) {
+
+				if (!matches[k]) {
+
+					cout << "batch math: " << kernels[k] << " at " << level << " differs from scalar for " << count << " objects" << endl;
+					failures++;
+				}
+			}
+		}
+	}
+
+	GUBatchMath::setLevel(GUBatchMath::supportedLevel());
+
+	if (failures == 0)
+		cout << "batch math: every kernel at every level up to " << GUBatchMath::levelName(GUBatchMath::supportedLevel()) << " matches scalar bit for bit" << endl;
+
+	return failures;
+}
+
+
+
+//
+// Benchmarks
+//
+
+static void benchmarkMultiplyMatrices(GUBenchmarkState& state, GUSimdLevel level, size_t count) {
+
+	BatchMathData data(count);
+
+	GUBatchMath::setLevel(level);
+
+	while (state.keepRunning()) {
+
+		GUBatchMath::multiplyMatrices(data.parents.data(), data.locals.data(), data.products.data(), count);
+		guClobberMemory();
+	}
+
+	state.setItemsProcessed(state.iterations() * count);
+}
+
+
+static void benchmarkTransformAABBs(GUBenchmarkState& state, GUSimdLevel level, size_t count) {
+
+	BatchMathData data(count);
+
+	GUBatchMath::setLevel(level);
+
+	while (state.keepRunning()) {
+
+		GUBatchMath::transformAABBs(data.parents.data(), data.localBounds.data(), data.worldBounds.data(), count);
+		guClobberMemory();
+	}
+
+	state.setItemsProcessed(state.iterations() * count);
+}
+
+
+static void benchmarkTestSpheres(GUBenchmarkState& state, GUSimdLevel level, size_t count) {
+
+	BatchMathData data(count);
+
+	GUBatchMath::setLevel(level);
+
+	while (state.keepRunning()) {
+
+		GUBatchMath::testSpheres(data.planes, data.centreX.data(), data.centreY.data(), data.centreZ.data(), data.radius.data(), data.visible.data(), count);
+		guClobberMemory();
+	}
+
+	state.setItemsProcessed(state.iterations() * count);
+}
+
+
+static void benchmarkTestAABBs(GUBenchmarkState& state, GUSimdLevel level, size_t count) {
+
+	BatchMathData data(count);
+
+	GUBatchMath::setLevel(level);
+
+	while (state.keepRunning()) {
+
+		GUBatchMath::testAABBs(data.planes, data.minX.data(), data.minY.data(), data.minZ.data(), data.maxX.data(), data.maxY.data(), data.maxZ.data(), data.visible.data(), count);
+		guClobberMemory();
+	}
+
+	state.setItemsProcessed(state.iterations() * count);
+}
+
+
+int runBatchMathBenchmarks(const GUBenchmarkSettings& settings) {
+
+	int failures = validateKernels();
+
+	for (int l = (int)GUSimdLevel::Scalar; l <= (int)GUBatchMath::supportedLevel(); ++l) {
+
+		GUSimdLevel level = (GUSimdLevel)l;
+		string levelName = GUBatchMath::levelName(level);
+
+		for (size_t count : batchSizes) {
+
+			string suffix = "/" + levelName + "/" + to_string(count);
+
+			GUBenchmarkRegistry::add("batch math/multiply matrices" + suffix, [level, count](GUBenchmarkState& state) { benchmarkMultiplyMatrices(state, level, count); });
+			GUBenchmarkRegistry::add("batch math/transform AABBs" + suffix, [level, count](GUBenchmarkState& state) { benchmarkTransformAABBs(state, level, count); });
+			GUBenchmarkRegistry::add("batch math/test spheres" + suffix, [level, count](GUBenchmarkState& state) { benchmarkTestSpheres(state, level, count); });
+			GUBenchmarkRegistry::add("batch math/test AABBs" + suffix, [level, count](GUBenchmarkState& state) { benchmarkTestAABBs(state, level, count); });
+		}
+	}
+
+	failures += GUBenchmarkRegistry::run(settings);
+
+	GUBatchMath::setLevel(GUBatchMath::supportedLevel());
+
+	return failures;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+#include "Microbenchmark.h"
+
+// Checks every GUBatchMath kernel at each SIMD level the CPU supports against the scalar (glm) version for bit-identical results, then benchmarks each kernel at each level for batches of 16, 256, 4096 and 65536 objects (names are "batch math/<kernel>/<level>/<batch size>").  Returns the number of checks and benchmarks that failed
+int runBatchMathBenchmarks(const GUBenchmarkSettings& settings);
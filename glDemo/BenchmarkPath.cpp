@@ -0,0 +1,165 @@
+#include "BenchmarkPath.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <sstream>
+
+using namespace std;
+using namespace glm;
+
+
+BenchmarkPath BenchmarkPath::scriptedPath() {
+
+	const float pathDuration = 30.0f;
+	const float keySpacing = 0.25f;
+	const vec3 circleCentre = vec3(0.0f, 0.0f, 4.0f);
+	const float circleRadius = 4.0f;
+	const float laps = 3.0f;
+
+	BenchmarkPath path;
+
+	for (float t = 0.0f; t <= pathDuration + 0.5f * keySpacing; t += keySpacing) {
+
+		float u = std::min<float>(t / pathDuration, 1.0f);
+		float a = u * laps * two_pi<float>();
+
+		BenchmarkKey key;
+
+		key.time = t;
+
+		// Facing along the direction of travel - the character walks along its local +z axis
+		key.beastPos = circleCentre + vec3(cosf(a), 0.0f, sinf(a)) * circleRadius;
+		key.beastRotation = -degrees(a);
+
+		// One orbit, dipping towards the horizon half way round.  The radius follows a smooth rise and fall between 15 and 450 units
+		key.cameraTheta = -40.0f + 20.0f * sinf(u * two_pi<float>());
+		key.cameraPhi = 45.0f + u * 360.0f;
+		key.cameraRadius = 15.0f + 435.0f * (0.5f - 0.5f * cosf(u * two_pi<float>()));
+
+		path.addKey(key);
+	}
+
+	return path;
+}
+
+
+bool BenchmarkPath::load(const std::string& filename) {
+
+	ifstream in(filename);
+
+	if (!in.is_open()) {
+
+		cout << "Could not open benchmark path " << filename << endl;
+		return false;
+	}
+
+	keys.clear();
+
+	string line;
+	int lineNumber = 0;
+
+	while (getline(in, line)) {
+
+		lineNumber++;
+
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		istringstream fields(line);
+		BenchmarkKey key;
+
+		if (!(fields >> key.time >> key.beastPos.x >> key.beastPos.y >> key.beastPos.z >> key.beastRotation >> key.cameraTheta >> key.cameraPhi >> key.cameraRadius)) {
+
+			cout << "Benchmark path " << filename << " line " << lineNumber << ": expected 8 values" << endl;
+			keys.clear();
+			return false;
+		}
+
+		addKey(key);
+	}
+
+	if (keys.empty()) {
+
+		cout << "Benchmark path " << filename << " has no keys" << endl;
+		return false;
+	}
+
+	return true;
+}
+
+
+bool BenchmarkPath::save(const std::string& filename) const {
+
+	ofstream out(filename);
+
+	if (!out.is_open()) {
+
+		cout << "Could not write benchmark path " << filename << endl;
+		return false;
+	}
+
+	out << "# time beastX beastY beastZ beastRotation cameraTheta cameraPhi cameraRadius\n";
+
+	out.precision(9);
+
+	for (const BenchmarkKey& key : keys)
+		out << key.time << " " << key.beastPos.x << " " << key.beastPos.y << " " << key.beastPos.z << " " << key.beastRotation << " " << key.cameraTheta << " " << key.cameraPhi << " " << key.cameraRadius << "\n";
+
+	return true;
+}
+
+
+void BenchmarkPath::addKey(const BenchmarkKey& key) {
+
+	if (!keys.empty() && key.time < keys.back().time)
+		return;
+
+	keys.push_back(key);
+}
+
+
+size_t BenchmarkPath::keyCount() const {
+
+	return keys.size();
+}
+
+
+float BenchmarkPath::duration() const {
+
+	return (keys.empty()) ? 0.0f : keys.back().time - keys.front().time;
+}
+
+
+BenchmarkKey BenchmarkPath::sample(float t) const {
+
+	if (keys.empty())
+		return BenchmarkKey{ 0.0f, vec3(0.0f), 0.0f, -45.0f, 45.0f, 50.0f };
+
+	float length = duration();
+
+	t = (length > 0.0f) ? keys.front().time + fmodf(std::max<float>(t, 0.0f), length) : keys.front().time;
+
+	// First key after t
+	vector<BenchmarkKey>::const_iterator next = upper_bound(keys.begin(), keys.end(), t, [](float time, const BenchmarkKey& key) { return time < key.time; });
+
+	if (next == keys.begin())
+		return keys.front();
+
+	if (next == keys.end())
+		return keys.back();
+
+	const BenchmarkKey& k0 = *(next - 1);
+	const BenchmarkKey& k1 = *next;
+
+	float s = (k1.time > k0.time) ? (t - k0.time) / (k1.time - k0.time) : 0.0f;
+
+	BenchmarkKey result;
+
+	result.time = t;
+	result.beastPos = mix(k0.beastPos, k1.beastPos, s);
+	result.beastRotation = mix(k0.beastRotation, k1.beastRotation, s);
+	result.cameraTheta = mix(k0.cameraTheta, k1.cameraTheta, s);
+	result.cameraPhi = mix(k0.cameraPhi, k1.cameraPhi, s);
+	result.cameraRadius = mix(k0.cameraRadius, k1.cameraRadius, s);
+
+	return result;
+}
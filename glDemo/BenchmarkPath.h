@@ -0,0 +1,41 @@
+#pragma once
+
+#include "core.h"
+
+// One sample of a benchmark path - character placement and arcball camera orientation at a point in time
+struct BenchmarkKey {
+
+	float				time; // seconds from the start of the path
+	glm::vec3			beastPos;
+	float				beastRotation; // degrees
+	float				cameraTheta; // degrees
+	float				cameraPhi; // degrees
+	float				cameraRadius;
+};
+
+
+// Camera and character path replayed by --benchmark.  Paths are either scripted (scriptedPath) or recorded from an interactive run (--record-path) and stored as text - one key per line holding the BenchmarkKey fields in declaration order, with lines starting # ignored.  Keys must be in increasing time order.
+//
+// Angles are interpolated linearly without wrapping, so recorded angles must be continuous (beastRotation and the camera angles are accumulated rather than wrapped in the demo, so recordings are).
+
+class BenchmarkPath {
+
+	std::vector<BenchmarkKey>	keys;
+
+public:
+
+	// Built in path - the character circles the mausoleum three times while the camera orbits once and pulls back far enough to switch the city through its LOD, HLOD and impostor ranges before returning
+	static BenchmarkPath scriptedPath();
+
+	bool load(const std::string& filename);
+	bool save(const std::string& filename) const;
+
+	// Append a key.  Keys earlier than the last key are ignored
+	void addKey(const BenchmarkKey& key);
+
+	size_t keyCount() const;
+	float duration() const;
+
+	// Interpolate the path at time t.  The path repeats once t passes duration()
+	BenchmarkKey sample(float t) const;
+};
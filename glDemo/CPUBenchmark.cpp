@@ -0,0 +1,390 @@
+#include "CPUBenchmark.h"
+#include "AIMesh.h"
+#include "TextureLoader.h"
+#include "shader_setup.h"
+#include "ArcballCamera.h"
+#include "GLFWPlatform.h"
+#include "HeadlessPlatform.h"
+#include "ECS.h"
+
+using namespace std;
+using namespace glm;
+
+
+struct BenchmarkImage {
+
+	const char*				filename;
+	FREE_IMAGE_FORMAT		format;
+};
+
+static const char* const meshFiles[] = {
+
+	"Assets/MyAssets/Terrain/flatTerrain.obj",
+	"Assets/MyAssets/Character/Character.obj",
+	"Assets/MyAssets/City/Corner.obj",
+	"Assets/MyAssets/City/Wall.obj",
+	"Assets/MyAssets/City/Mausoleum.obj",
+	"Assets/MyAssets/Hut/Hut.obj"
+};
+
+static const BenchmarkImage imageFiles[] = {
+
+	{ "Assets/MyAssets/Terrain/flat terrain.png", FIF_PNG },
+	{ "Assets/MyAssets/Character/LavaPerson Texture.tif", FIF_TIFF },
+	{ "Assets/MyAssets/City/Wall Normal.tif", FIF_TIFF },
+	{ "Assets/MyAssets/City/mausoleum.png", FIF_PNG }
+};
+
+static const char* const textFiles[] = {
+
+	"Assets/Shaders/texture-point.frag",
+	"Assets/Shaders/nmap-directional.vert",
+	"Assets/Shaders/impostor.frag"
+};
+
+// Benchmarks that call OpenGL are skipped when no context could be created
+static bool glContextAvailable = false;
+
+
+// Benchmark name from the last component of a path
+static string shortName(const string& path) {
+
+	size_t slash = path.find_last_of("/\\");
+
+	return (slash == string::npos) ? path : path.substr(slash + 1);
+}
+
+
+static void benchmarkAssimpImport(GUBenchmarkState& state, const string& filename) {
+
+	while (state.keepRunning()) {
+
+		const struct aiScene* scene = AIMesh::importFile(filename);
+
+		if (!scene) {
+
+			state.skipWithError("could not import " + filename);
+			break;
+		}
+
+		guDoNotOptimize(scene->mMeshes[0]->mNumVertices);
+		aiReleaseImport(scene);
+	}
+}
+
+
+// Import, meshlet build, LOD simplification and buffer upload - everything new AIMesh(filename) does
+static void benchmarkAIMeshBuild(GUBenchmarkState& state, const string& filename) {
+
+	if (!glContextAvailable) {
+
+		state.skipWithError("no OpenGL context");
+		return;
+	}
+
+	while (state.keepRunning()) {
+
+		AIMesh* mesh = new AIMesh(filename);
+
+		guDoNotOptimize(mesh->getBoundingBox());
+		delete mesh;
+	}
+
+	glFinish();
+}
+
+
+// FreeImage decode and conversion to 32 bits per pixel - the CPU side of loadTexture
+static void benchmarkTextureDecode(GUBenchmarkState& state, const BenchmarkImage& image) {
+
+	uint64_t bytes = 0;
+
+	while (state.keepRunning()) {
+
+		FIBITMAP* loadedBitmap = FreeImage_Load(image.format, image.filename, BMP_DEFAULT);
+
+		if (!loadedBitmap) {
+
+			state.skipWithError(string("could not load ") + image.filename);
+			break;
+		}
+
+		FIBITMAP* bitmap32bpp = FreeImage_ConvertTo32Bits(loadedBitmap);
+		FreeImage_Unload(loadedBitmap);
+
+		bytes += (uint64_t)FreeImage_GetWidth(bitmap32bpp) * FreeImage_GetHeight(bitmap32bpp) * 4;
+
+		FreeImage_Unload(bitmap32bpp);
+	}
+
+	state.setBytesProcessed(bytes);
+}
+
+
+static void benchmarkLoadTexture(GUBenchmarkState& state, const BenchmarkImage& image) {
+
+	if (!glContextAvailable) {
+
+		state.skipWithError("no OpenGL context");
+		return;
+	}
+
+	while (state.keepRunning()) {
+
+		GLuint texture = loadTexture(image.filename, image.format);
+
+		if (texture == 0) {
+
+			state.skipWithError(string("could not load ") + image.filename);
+			break;
+		}
+
+		glDeleteTextures(1, &texture);
+	}
+
+	glFinish();
+}
+
+
+static void benchmarkLoadStringFromFile(GUBenchmarkState& state, const string& filename) {
+
+	uint64_t bytes = 0;
+
+	try {
+
+		while (state.keepRunning()) {
+
+			string s = StringUtility::loadStringFromFile(filename);
+
+			bytes += s.size();
+			guDoNotOptimize(s);
+		}
+	}
+	catch (StringUtility::StringResult) {
+
+		state.skipWithError("could not load " + filename);
+	}
+
+	state.setBytesProcessed(bytes);
+}
+
+
+static void benchmarkSplitPath(GUBenchmarkState& state) {
+
+	const string path = "Assets/MyAssets/Character/LavaPerson Texture.tif";
+	const set<char> delimiters = { '/', '\\' };
+
+	while (state.keepRunning()) {
+
+		vector<string> components = StringUtility::splitPath(path, delimiters);
+		guDoNotOptimize(components);
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+// setCamera recalculates the view and projection matrices (calculateDerivedValues) on every call
+static void benchmarkCameraDerivedValues(GUBenchmarkState& state) {
+
+	ArcballCamera camera(-45.0f, 45.0f, 50.0f, 40.0f, 4.0f / 3.0f, 0.1f, 10000.0f);
+
+	float phi = 0.0f;
+
+	while (state.keepRunning()) {
+
+		camera.setCamera(-45.0f, phi, 50.0f);
+		guDoNotOptimize(camera.viewTransform());
+
+		phi += 0.25f;
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+// translate * rotate about y * scale, as built for each character draw in renderWithMyLights.  Inputs cycle through a fixed random set so nothing is constant folded
+static void benchmarkModelMatrix(GUBenchmarkState& state) {
+
+	const int numInputs = 4096;
+
+	mt19937 rng(1);
+	uniform_real_distribution<float> posDist(-100.0f, 100.0f);
+	uniform_real_distribution<float> angleDist(0.0f, 360.0f);
+
+	vector<vec4> inputs(numInputs); // xyz position, w rotation in degrees
+
+	for (vec4& input : inputs)
+		input = vec4(posDist(rng), 0.0f, posDist(rng), angleDist(rng));
+
+	uint64_t i = 0;
+
+	while (state.keepRunning()) {
+
+		const vec4& input = inputs[i++ & (numInputs - 1)];
+
+		mat4 modelTransform = glm::translate(identity<mat4>(), vec3(input)) * eulerAngleY<float>(glm::radians<float>(input.w)) * glm::scale(identity<mat4>(), vec3(0.05f, 0.05f, 0.05f));
+		guDoNotOptimize(modelTransform);
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+// Scene object as a single struct, the layout the entity stores replace - position, rotation and velocity share cache lines with everything else an object carries
+struct BenchmarkObject {
+
+	mat4				modelTransform;
+	vec3				position;
+	float				rotation;
+	vec3				scale;
+	vec3				velocity;
+	float				angularVelocity;
+	AIMesh*				mesh;
+	int					lod;
+	bool				visible;
+};
+
+
+static const int numMovingEntities = 100000;
+
+
+// GUWorld::integrateVelocities over numMovingEntities entities
+static void benchmarkEntityMovement(GUBenchmarkState& state) {
+
+	mt19937 rng(1);
+	uniform_real_distribution<float> dist(-10.0f, 10.0f);
+
+	GUWorld world;
+
+	for (int i = 0; i < numMovingEntities; ++i) {
+
+		GUEntity entity = world.create();
+
+		world.addTransform(entity, vec3(dist(rng), 0.0f, dist(rng)), dist(rng));
+		world.addVelocity(entity, vec3(dist(rng), 0.0f, dist(rng)), dist(rng));
+	}
+
+	while (state.keepRunning()) {
+
+		world.integrateVelocities(1.0f / 120.0f);
+		guDoNotOptimize(world.transforms.positionX[0]);
+	}
+
+	state.setItemsProcessed(state.iterations() * numMovingEntities);
+}
+
+
+// The same update over an array of BenchmarkObject structs for comparison
+static void benchmarkObjectMovement(GUBenchmarkState& state) {
+
+	mt19937 rng(1);
+	uniform_real_distribution<float> dist(-10.0f, 10.0f);
+
+	vector<BenchmarkObject> objects(numMovingEntities);
+
+	for (BenchmarkObject& object : objects) {
+
+		object.position = vec3(dist(rng), 0.0f, dist(rng));
+		object.rotation = dist(rng);
+		object.velocity = vec3(dist(rng), 0.0f, dist(rng));
+		object.angularVelocity = dist(rng);
+	}
+
+	const float tDelta = 1.0f / 120.0f;
+
+	while (state.keepRunning()) {
+
+		for (BenchmarkObject& object : objects) {
+
+			object.position += object.velocity * tDelta;
+			object.rotation += object.angularVelocity * tDelta;
+		}
+
+		guDoNotOptimize(objects[0].position);
+	}
+
+	state.setItemsProcessed(state.iterations() * numMovingEntities);
+}
+
+
+// numMovingEntities nodes as roots with three children each (multi-part models).  When moveRoots is set every root's local transform changes each iteration, so every world transform is recomputed - otherwise update() only checks the dirty flags
+static void benchmarkTransformHierarchy(GUBenchmarkState& state, bool moveRoots) {
+
+	GUTransformHierarchy hierarchy;
+	vector<uint32_t> roots;
+
+	for (int i = 0; i < numMovingEntities / 4; ++i) {
+
+		uint32_t root = hierarchy.create(glm::translate(identity<mat4>(), vec3((float)i, 0.0f, 0.0f)));
+
+		for (int c = 0; c < 3; ++c)
+			hierarchy.create(glm::translate(identity<mat4>(), vec3(0.0f, (float)c, 0.0f)), root);
+
+		roots.push_back(root);
+	}
+
+	hierarchy.update();
+
+	float x = 0.0f;
+
+	while (state.keepRunning()) {
+
+		if (moveRoots) {
+
+			x += 0.01f;
+
+			for (uint32_t root : roots)
+				hierarchy.setLocalTransform(root, glm::translate(identity<mat4>(), vec3(x, 0.0f, 0.0f)));
+		}
+
+		hierarchy.update();
+		guDoNotOptimize(hierarchy.lastUpdateCount());
+	}
+
+	state.setItemsProcessed(state.iterations() * hierarchy.nodeCount());
+}
+
+
+int runCPUBenchmarks(const GUBenchmarkSettings& settings) {
+
+	// Context for the benchmarks that upload to OpenGL - nothing is drawn so it does not need a visible window
+	GUPlatform* platform = nullptr;
+
+	if (GUHeadlessPlatform::isBackendAvailable(GUHeadlessBackend::EGL))
+		platform = GUHeadlessPlatform::create(GUHeadlessBackend::EGL, 64, 64, false);
+
+	if (!platform)
+		platform = GUGLFWPlatform::create(64, 64, "CPU benchmarks", false, false);
+
+	glContextAvailable = (platform != nullptr);
+
+	for (const char* filename : meshFiles)
+		GUBenchmarkRegistry::add("assimp import/" + shortName(filename), [filename](GUBenchmarkState& state) { benchmarkAssimpImport(state, filename); });
+
+	for (const char* filename : meshFiles)
+		GUBenchmarkRegistry::add("AIMesh build/" + shortName(filename), [filename](GUBenchmarkState& state) { benchmarkAIMeshBuild(state, filename); });
+
+	for (const BenchmarkImage& image : imageFiles)
+		GUBenchmarkRegistry::add("texture decode/" + shortName(image.filename), [&image](GUBenchmarkState& state) { benchmarkTextureDecode(state, image); });
+
+	for (const BenchmarkImage& image : imageFiles)
+		GUBenchmarkRegistry::add("loadTexture/" + shortName(image.filename), [&image](GUBenchmarkState& state) { benchmarkLoadTexture(state, image); });
+
+	for (const char* filename : textFiles)
+		GUBenchmarkRegistry::add("loadStringFromFile/" + shortName(filename), [filename](GUBenchmarkState& state) { benchmarkLoadStringFromFile(state, filename); });
+
+	GUBenchmarkRegistry::add("splitPath", benchmarkSplitPath);
+	GUBenchmarkRegistry::add("ArcballCamera derived values", benchmarkCameraDerivedValues);
+	GUBenchmarkRegistry::add("model matrix", benchmarkModelMatrix);
+	GUBenchmarkRegistry::add("movement/entity stores", benchmarkEntityMovement);
+	GUBenchmarkRegistry::add("movement/object array", benchmarkObjectMovement);
+	GUBenchmarkRegistry::add("transform hierarchy/no changes", [](GUBenchmarkState& state) { benchmarkTransformHierarchy(state, false); });
+	GUBenchmarkRegistry::add("transform hierarchy/all roots moved", [](GUBenchmarkState& state) { benchmarkTransformHierarchy(state, true); });
+
+	int failures = GUBenchmarkRegistry::run(settings);
+
+	delete platform;
+
+	return failures;
+}
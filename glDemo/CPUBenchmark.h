@@ -0,0 +1,6 @@
+#pragma once
+
+#include "Microbenchmark.h"
+
+// CPU microbenchmarks for the loaders and per frame maths - AIMesh import and build per asset, texture decode and loadTexture per image, StringUtility file loading and path splitting, ArcballCamera derived value updates and model matrix building.  Mesh builds and loadTexture upload to OpenGL, so run in a context of their own (headless where available, otherwise a hidden window).  Returns the number of benchmarks that failed
+int runCPUBenchmarks(const GUBenchmarkSettings& settings);
@@ -0,0 +1,205 @@
+#include "CommandBuffer.h"
+#include "Meshlet.h"
+#include "RenderStats.h"
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+using namespace glm;
+
+
+// Key layout (most significant first): 20 bits texture, 20 bits vertex array, 24 bits distance
+static const int		textureShift = 44;
+static const int		vertexArrayShift = 24;
+static const uint64_t	nameMask = (1ull << 20) - 1;
+
+
+//
+// GUCommandBuffer
+//
+
+uint64_t GUCommandBuffer::sortKey(uint32_t texture, uint32_t vertexArray, float distance) {
+
+	// The bit pattern of a non-negative float orders the same way as its value, so the top 24 bits give a depth key without a fixed range
+	float d = std::max<float>(distance, 0.0f);
+	uint32_t bits;
+
+	memcpy(&bits, &d, sizeof(bits));
+
+	return ((uint64_t)(texture & nameMask) << textureShift) | ((uint64_t)(vertexArray & nameMask) << vertexArrayShift) | (uint64_t)(bits >> 8);
+}
+
+
+void GUCommandBuffer::clear() {
+
+	commands.clear();
+	order.clear();
+}
+
+
+void GUCommandBuffer::reset(std::pmr::memory_resource* resource, size_t expectedCommands) {
+
+	guResetVector(commands, resource);
+	guResetVector(order, resource);
+
+	commands.reserve(expectedCommands);
+	order.reserve(expectedCommands);
+}
+
+
+void GUCommandBuffer::draw(uint64_t sortKey, const GUDrawCommand& command) {
+
+	order.push_back(SortEntry{ sortKey, (uint32_t)commands.size() });
+	commands.push_back(command);
+}
+
+
+void GUCommandBuffer::sort() {
+
+	std::sort(order.begin(), order.end(), [](const SortEntry& a, const SortEntry& b) {
+
+		return (a.key < b.key) || (a.key == b.key && a.command < b.command);
+	});
+}
+
+
+size_t GUCommandBuffer::size() const {
+
+	return commands.size();
+}
+
+
+
+//
+// GUCommandQueue
+//
+
+void GUCommandQueue::clear() {
+
+	entries.clear();
+}
+
+
+void GUCommandQueue::reset(std::pmr::memory_resource* resource) {
+
+	guResetVector(entries, resource);
+	guResetVector(cursors, resource);
+}
+
+
+void GUCommandQueue::merge(const GUCommandBuffer* buffers, int count) {
+
+	entries.clear();
+	cursors.clear();
+
+	size_t total = 0;
+
+	for (int i = 0; i < count; ++i) {
+
+		total += buffers[i].order.size();
+
+		if (!buffers[i].order.empty())
+			cursors.push_back(MergeCursor{ buffers[i].order[0].key, (uint32_t)i, 0 });
+	}
+
+	entries.reserve(total);
+
+	// k-way merge with a min-heap of the cursors ordered by their next key
+	auto later = [](const MergeCursor& a, const MergeCursor& b) {
+
+		return (a.key > b.key) || (a.key == b.key && a.buffer > b.buffer);
+	};
+
+	make_heap(cursors.begin(), cursors.end(), later);
+
+	while (!cursors.empty()) {
+
+		pop_heap(cursors.begin(), cursors.end(), later);
+
+		MergeCursor& cursor = cursors.back();
+		const GUCommandBuffer& buffer = buffers[cursor.buffer];
+
+		entries.push_back(QueueEntry{ cursor.key, &buffer.commands[buffer.order[cursor.entry].command] });
+
+		if (++cursor.entry < buffer.order.size()) {
+
+			cursor.key = buffer.order[cursor.entry].key;
+			push_heap(cursors.begin(), cursors.end(), later);
+		}
+		else {
+
+			cursors.pop_back();
+		}
+	}
+}
+
+
+size_t GUCommandQueue::size() const {
+
+	return entries.size();
+}
+
+
+void GUCommandQueue::submitGL(GLint modelMatrixLocation) const {
+
+	// Nothing is known to be bound at the start - the first command binds everything it uses
+	const uint32_t unknown = 0xFFFFFFFF;
+
+	uint32_t boundVertexArray = unknown;
+	uint32_t boundTexture = unknown;
+	uint32_t boundNormalMap = unknown;
+
+	glActiveTexture(GL_TEXTURE0);
+
+	for (const QueueEntry& entry : entries) {
+
+		const GUDrawCommand& command = *entry.command;
+
+		glUniformMatrix4fv(modelMatrixLocation, 1, GL_FALSE, (const GLfloat*)&command.modelTransform);
+		GURenderStats::countUniformUpload();
+
+		if (command.texture != 0) {
+
+			if (command.texture != boundTexture) {
+
+				glBindTexture(GL_TEXTURE_2D, command.texture);
+				GURenderStats::countTextureBind();
+
+				boundTexture = command.texture;
+			}
+
+			if (command.normalMap != 0 && command.normalMap != boundNormalMap) {
+
+				glActiveTexture(GL_TEXTURE1);
+				glBindTexture(GL_TEXTURE_2D, command.normalMap);
+				glActiveTexture(GL_TEXTURE0);
+				GURenderStats::countTextureBind();
+
+				boundNormalMap = command.normalMap;
+			}
+		}
+
+		if (command.vertexArray != boundVertexArray) {
+
+			glBindVertexArray(command.vertexArray);
+			GURenderStats::countVAOBind();
+
+			boundVertexArray = command.vertexArray;
+		}
+
+		if (command.meshlets) {
+
+			if (!command.meshlets->counts.empty()) {
+
+				glMultiDrawElements(GL_TRIANGLES, command.meshlets->counts.data(), GL_UNSIGNED_INT, command.meshlets->offsets.data(), (GLsizei)command.meshlets->counts.size());
+				GURenderStats::countMultiDraw((uint64_t)command.meshlets->visibleTriangles * 3);
+			}
+		}
+		else {
+
+			glDrawElements(GL_TRIANGLES, command.indexCount, GL_UNSIGNED_INT, (const GLvoid*)((size_t)command.indexOffset * sizeof(GLuint)));
+			GURenderStats::countDraw(command.indexCount);
+		}
+	}
+}
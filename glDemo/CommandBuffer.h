@@ -0,0 +1,103 @@
+#pragma once
+
+//
+// Draw command recording.  A GUCommandBuffer holds draws as plain data - object names, index ranges, a model matrix and a 64 bit sort key - and makes no graphics API calls, so any thread can fill one.  Worker threads each record a disjoint slice of the scene into their own buffer and sort it, then GUCommandQueue::merge combines the sorted buffers into one submission order and GUCommandQueue::submitGL replays it on the thread that owns the OpenGL context, re-binding only the state that changes between consecutive draws.
+//
+// Sort keys put the most expensive state change in the highest bits (texture, then vertex array) and the view distance in the lowest, so draws sharing state are submitted together and front to back within each group.
+//
+
+#include "core.h"
+#include <memory_resource>
+
+struct MeshletDrawList;
+
+
+// One indexed triangle draw.  Object names are the backend's (OpenGL names here) with 0 meaning none
+struct GUDrawCommand {
+
+	glm::mat4					modelTransform;
+
+	uint32_t					vertexArray;
+	uint32_t					texture; // texture unit 0
+	uint32_t					normalMap; // texture unit 1 - only bound with a texture
+
+	// Index range drawn when meshlets is null
+	uint32_t					indexOffset;
+	uint32_t					indexCount;
+
+	// Visible meshlet ranges drawn with a single multi-draw instead.  Not owned - must stay valid until the command is submitted
+	const MeshletDrawList*		meshlets;
+};
+
+
+class GUCommandBuffer {
+
+private:
+
+	friend class GUCommandQueue;
+
+	struct SortEntry {
+
+		uint64_t				key;
+		uint32_t				command; // index into commands
+	};
+
+	std::pmr::vector<GUDrawCommand>	commands;
+	std::pmr::vector<SortEntry>		order;
+
+public:
+
+	// Key for a draw with the given texture and vertex array names at distance (world units, >= 0) from the camera
+	static uint64_t sortKey(uint32_t texture, uint32_t vertexArray, float distance);
+
+	// Remove every command (keeping the allocated storage for the next frame)
+	void clear();
+
+	// Remove every command and allocate from resource (normally the recording thread's frame arena) from now on, reserving space for expectedCommands
+	void reset(std::pmr::memory_resource* resource, size_t expectedCommands = 0);
+
+	void draw(uint64_t sortKey, const GUDrawCommand& command);
+
+	// Sort the recorded commands by key (keeping recording order for equal keys).  Called by the recording thread before the buffer is merged
+	void sort();
+
+	size_t size() const;
+};
+
+
+class GUCommandQueue {
+
+private:
+
+	struct QueueEntry {
+
+		uint64_t				key;
+		const GUDrawCommand*	command;
+	};
+
+	// Position in one buffer's sort order while merging
+	struct MergeCursor {
+
+		uint64_t				key;
+		uint32_t				buffer;
+		uint32_t				entry;
+	};
+
+	std::pmr::vector<QueueEntry>	entries;
+	std::pmr::vector<MergeCursor>	cursors;
+
+public:
+
+	void clear();
+
+	// Empty the queue and allocate from resource (normally the frame arena) from now on
+	void reset(std::pmr::memory_resource* resource);
+
+	// Replace the queue with the commands in buffers[0] to buffers[count - 1] in key order.  Each buffer must have been sorted.  Equal keys keep buffer order, so recording the same scene gives the same order whatever thread recorded each buffer.  The buffers must not change until the queue has been submitted
+	void merge(const GUCommandBuffer* buffers, int count);
+
+	size_t size() const;
+
+	// Replay every command with the current program, uploading each model matrix to modelMatrixLocation.  Must be called on the thread that owns the OpenGL context.  Leaves texture unit 0 active
+	void submitGL(GLint modelMatrixLocation) const;
+};
@@ -2,6 +2,7 @@
 #include "Cylinder.h"
 #include "TextureLoader.h"
 #include "shader_setup.h"
+#include "RenderStats.h"
 
 using namespace std;
 using namespace glm;
@@ -10,11 +11,11 @@ using namespace glm;
 Cylinder::Cylinder(std::string filename, GLuint meshIndex) : AIMesh(filename, meshIndex) {
 
 	// Load textures
-	wave1Texture = loadTexture("Assets\\cylinder\\waves1.png", FIF_PNG);
-	wave2Texture = loadTexture("Assets\\cylinder\\waves2.png", FIF_PNG);
+	wave1Texture = loadTexture("Assets/cylinder/waves1.png", FIF_PNG);
+	wave2Texture = loadTexture("Assets/cylinder/waves2.png", FIF_PNG);
 
 	// Load shader
-	shader = setupShaders(string("Assets\\cylinder\\cylinder.vert"), string("Assets\\cylinder\\cylinder.frag"));
+	shader = setupShaders(string("Assets/cylinder/cylinder.vert"), string("Assets/cylinder/cylinder.frag"));
 
 	// Get uniform locations
 	shader_mvpMatrix = glGetUniformLocation(shader, "mvpMatrix");
@@ -44,6 +45,7 @@ void Cylinder::setupTextures() {
 	// restore default
 	glActiveTexture(GL_TEXTURE0);
 
+	GURenderStats::countTextureBind(2);
 }
 
 void Cylinder::render(mat4 transform) {
@@ -54,6 +56,9 @@ void Cylinder::render(mat4 transform) {
 	glUniform1f(shader_wave1Phase, cosf(glm::radians<float>(wavePhase)));
 	glUniform1f(shader_wave2Phase, sinf(glm::radians<float>(wavePhase)));
 
+	GURenderStats::countProgramBind();
+	GURenderStats::countUniformUpload(3);
+
 	AIMesh::render();
 }
 
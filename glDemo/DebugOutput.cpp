@@ -0,0 +1,303 @@
+#include "DebugOutput.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+using namespace std;
+
+
+// Messages are deduplicated on everything but their text - drivers reuse an id for one message but may vary numbers (sizes, addresses) in the text
+struct GUDebugMessageKey {
+
+	GLenum					source;
+	GLenum					type;
+	GLenum					severity;
+	GLuint					id;
+	const char*				zone; // zone names are string literals (GU_PROFILE_ZONE), so the pointer identifies the zone without copying the name
+
+	bool operator<(const GUDebugMessageKey& k) const {
+
+		return tie(source, type, severity, id, zone) < tie(k.source, k.type, k.severity, k.id, k.zone);
+	}
+};
+
+
+static const GLenum messageTypes[] = {
+
+	GL_DEBUG_TYPE_ERROR,
+	GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR,
+	GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR,
+	GL_DEBUG_TYPE_PORTABILITY,
+	GL_DEBUG_TYPE_PERFORMANCE,
+	GL_DEBUG_TYPE_MARKER,
+	GL_DEBUG_TYPE_PUSH_GROUP,
+	GL_DEBUG_TYPE_POP_GROUP,
+	GL_DEBUG_TYPE_OTHER
+};
+
+static const int numMessageTypes = sizeof(messageTypes) / sizeof(GLenum);
+
+static const GLenum messageSeverities[] = {
+
+	GL_DEBUG_SEVERITY_HIGH,
+	GL_DEBUG_SEVERITY_MEDIUM,
+	GL_DEBUG_SEVERITY_LOW,
+	GL_DEBUG_SEVERITY_NOTIFICATION
+};
+
+static const int numMessageSeverities = sizeof(messageSeverities) / sizeof(GLenum);
+
+
+static mutex								messageMutex;
+static map<GUDebugMessageKey, size_t>		messageIndex;
+static vector<GUDebugMessage>				messageList;
+static uint64_t								typeCounts[numMessageTypes + 1] = {}; // last entry counts unrecognised types
+static uint64_t								severityCounts[numMessageSeverities + 1] = {};
+static uint64_t								totalCount = 0;
+
+static bool									installed = false;
+static bool									performanceWarningsFatal = false;
+static bool									fatalMessage = false;
+
+
+template <int N>
+static int enumIndex(const GLenum(&values)[N], GLenum value) {
+
+	for (int i = 0; i < N; ++i) {
+
+		if (values[i] == value)
+			return i;
+	}
+
+	return N;
+}
+
+
+static void printMessage(const char* prefix, const GUDebugMessage& m) {
+
+	cout << prefix << " [" << GUDebugOutput::typeName(m.type) << ", " << GUDebugOutput::severityName(m.severity) << ", " << GUDebugOutput::sourceName(m.source) << ", id " << m.id << "]";
+
+	if (!m.zone.empty())
+		cout << " in zone \"" << m.zone << "\"";
+
+	cout << ": " << m.text << endl;
+}
+
+
+static void GLAPIENTRY debugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void*) {
+
+	const char* zone = GUProfiler::activeZoneName();
+
+	GUDebugMessageKey key = { source, type, severity, id, zone };
+
+	lock_guard<mutex> lock(messageMutex);
+
+	totalCount++;
+	typeCounts[enumIndex(messageTypes, type)]++;
+	severityCounts[enumIndex(messageSeverities, severity)]++;
+
+	map<GUDebugMessageKey, size_t>::iterator i = messageIndex.find(key);
+
+	if (i != messageIndex.end()) {
+
+		messageList[i->second].count++;
+		return;
+	}
+
+	GUDebugMessage m;
+
+	m.source = source;
+	m.type = type;
+	m.severity = severity;
+	m.id = id;
+	m.zone = (zone) ? zone : "";
+	m.text = (length >= 0) ? string(message, length) : string(message);
+	m.count = 1;
+
+	// Report the first occurrence of anything above notification level straight away - repeats only appear in the summary
+	if (type == GL_DEBUG_TYPE_PERFORMANCE && performanceWarningsFatal) {
+
+		printMessage("FATAL OpenGL performance warning", m);
+		fatalMessage = true;
+	}
+	else if (severity != GL_DEBUG_SEVERITY_NOTIFICATION) {
+
+		printMessage("OpenGL debug", m);
+	}
+
+	messageIndex[key] = messageList.size();
+	messageList.push_back(m);
+}
+
+
+
+// Public method implementation
+
+bool GUDebugOutput::install() {
+
+	if (GLEW_KHR_debug || GLEW_VERSION_4_3) {
+
+		glEnable(GL_DEBUG_OUTPUT);
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		glDebugMessageCallback(debugMessageCallback, NULL);
+		glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_TRUE);
+	}
+	else if (GLEW_ARB_debug_output) {
+
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
+		glDebugMessageCallbackARB(debugMessageCallback, NULL);
+		glDebugMessageControlARB(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_TRUE);
+	}
+	else {
+
+		cout << "OpenGL debug output not supported - driver messages will not be captured" << endl;
+		return false;
+	}
+
+	installed = true;
+
+	return true;
+}
+
+
+bool GUDebugOutput::isInstalled() {
+
+	return installed;
+}
+
+
+void GUDebugOutput::setPerformanceWarningsFatal(bool fatal) {
+
+	lock_guard<mutex> lock(messageMutex);
+	performanceWarningsFatal = fatal;
+}
+
+
+bool GUDebugOutput::hasFatalMessage() {
+
+	lock_guard<mutex> lock(messageMutex);
+	return fatalMessage;
+}
+
+
+uint64_t GUDebugOutput::messageCount() {
+
+	lock_guard<mutex> lock(messageMutex);
+	return totalCount;
+}
+
+
+uint64_t GUDebugOutput::messageCount(GLenum type) {
+
+	lock_guard<mutex> lock(messageMutex);
+	return typeCounts[enumIndex(messageTypes, type)];
+}
+
+
+uint64_t GUDebugOutput::performanceWarningCount() {
+
+	return messageCount(GL_DEBUG_TYPE_PERFORMANCE);
+}
+
+
+std::vector<GUDebugMessage> GUDebugOutput::messages() {
+
+	vector<GUDebugMessage> result;
+
+	{
+		lock_guard<mutex> lock(messageMutex);
+		result = messageList;
+	}
+
+	stable_sort(result.begin(), result.end(), [](const GUDebugMessage& a, const GUDebugMessage& b) { return a.count > b.count; });
+
+	return result;
+}
+
+
+const char* GUDebugOutput::sourceName(GLenum source) {
+
+	switch (source) {
+
+		case GL_DEBUG_SOURCE_API: return "api";
+		case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+		case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+		case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+		case GL_DEBUG_SOURCE_APPLICATION: return "application";
+		case GL_DEBUG_SOURCE_OTHER: return "other";
+		default: return "unknown";
+	}
+}
+
+
+const char* GUDebugOutput::typeName(GLenum type) {
+
+	switch (type) {
+
+		case GL_DEBUG_TYPE_ERROR: return "error";
+		case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+		case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behaviour";
+		case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+		case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+		case GL_DEBUG_TYPE_MARKER: return "marker";
+		case GL_DEBUG_TYPE_PUSH_GROUP: return "push group";
+		case GL_DEBUG_TYPE_POP_GROUP: return "pop group";
+		case GL_DEBUG_TYPE_OTHER: return "other";
+		default: return "unknown";
+	}
+}
+
+
+const char* GUDebugOutput::severityName(GLenum severity) {
+
+	switch (severity) {
+
+		case GL_DEBUG_SEVERITY_HIGH: return "high";
+		case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+		case GL_DEBUG_SEVERITY_LOW: return "low";
+		case GL_DEBUG_SEVERITY_NOTIFICATION: return "notification";
+		default: return "unknown";
+	}
+}
+
+
+void GUDebugOutput::reportSummary() {
+
+	if (!installed)
+		return;
+
+	vector<GUDebugMessage> list = messages();
+
+	lock_guard<mutex> lock(messageMutex);
+
+	printf("OpenGL debug messages: %llu (%llu distinct)\n", (unsigned long long)totalCount, (unsigned long long)list.size());
+
+	if (totalCount == 0)
+		return;
+
+	printf("by type:");
+	for (int i = 0; i < numMessageTypes; ++i) {
+
+		if (typeCounts[i] > 0)
+			printf(" %s %llu;", typeName(messageTypes[i]), (unsigned long long)typeCounts[i]);
+	}
+	printf("\n");
+
+	printf("by severity:");
+	for (int i = 0; i < numMessageSeverities; ++i) {
+
+		if (severityCounts[i] > 0)
+			printf(" %s %llu;", severityName(messageSeverities[i]), (unsigned long long)severityCounts[i]);
+	}
+	printf("\n");
+
+	for (const GUDebugMessage& m : list) {
+
+		printf("%8llux [%s, %s, %s, id %u]%s%s%s %s\n",
+			(unsigned long long)m.count, typeName(m.type), severityName(m.severity), sourceName(m.source), m.id,
+			(m.zone.empty()) ? "" : " in zone \"", m.zone.c_str(), (m.zone.empty()) ? "" : "\"",
+			m.text.c_str());
+	}
+}
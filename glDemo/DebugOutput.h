@@ -0,0 +1,50 @@
+#pragma once
+
+//
+// OpenGL debug output (KHR_debug, or ARB_debug_output on older drivers).  GUDebugOutput::install registers a callback that classifies each driver message by type and severity and folds repeats of the same message into one entry with a counter.  Each entry records the profiler zone (GU_PROFILE_ZONE) that was open when it was first raised - output is made synchronous so the message arrives on the thread, and inside the zone, of the GL call that caused it.
+//
+// Requires a debug context (GLFW_OPENGL_DEBUG_CONTEXT) - most drivers only report performance warnings to debug contexts.
+//
+
+#include "core.h"
+
+
+struct GUDebugMessage {
+
+	GLenum					source;
+	GLenum					type;
+	GLenum					severity;
+	GLuint					id;
+	std::string				zone; // active profiler zone when first raised, empty outside any zone
+	std::string				text; // text of the first occurrence
+	uint64_t				count;
+};
+
+
+class GUDebugOutput {
+
+public:
+
+	// Install the debug callback in the current context.  Returns false if neither KHR_debug nor ARB_debug_output is available
+	static bool install();
+	static bool isInstalled();
+
+	// Treat performance warnings as fatal - the first one is reported immediately and hasFatalMessage() becomes true so the caller can end the run (eg. benchmark runs that must not hit driver slow paths)
+	static void setPerformanceWarningsFatal(bool fatal);
+	static bool hasFatalMessage();
+
+	// Totals including repeats
+	static uint64_t messageCount();
+	static uint64_t messageCount(GLenum type);
+	static uint64_t performanceWarningCount();
+
+	// One entry per distinct message (source, type, id, severity and zone), most frequent first
+	static std::vector<GUDebugMessage> messages();
+
+	static const char* sourceName(GLenum source);
+	static const char* typeName(GLenum type);
+	static const char* severityName(GLenum severity);
+
+	// Print totals by type and severity and each distinct message to the console
+	static void reportSummary();
+};
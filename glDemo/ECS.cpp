@@ -0,0 +1,562 @@
+#include "ECS.h"
+
+using namespace std;
+using namespace glm;
+
+
+// Exchange element a and b of each field array
+template <typename T>
+static void swapField(vector<T>& field, uint32_t a, uint32_t b) {
+
+	T t = field[a];
+
+	field[a] = field[b];
+	field[b] = t;
+}
+
+
+
+//
+// GUComponentSet
+//
+
+uint32_t GUComponentSet::insert(GUEntity entity) {
+
+	uint32_t index = guEntityIndex(entity);
+
+	if (index >= sparse.size())
+		sparse.resize(index + 1, 0);
+
+	dense.push_back(entity);
+	sparse[index] = (uint32_t)dense.size();
+
+	pushFields();
+
+	return (uint32_t)dense.size() - 1;
+}
+
+
+void GUComponentSet::remove(GUEntity entity) {
+
+	if (!contains(entity))
+		return;
+
+	uint32_t last = (uint32_t)dense.size() - 1;
+
+	swapElements(indexOf(entity), last);
+
+	sparse[guEntityIndex(entity)] = 0;
+	dense.pop_back();
+
+	popFields();
+}
+
+
+void GUComponentSet::swapElements(uint32_t a, uint32_t b) {
+
+	if (a == b)
+		return;
+
+	GUEntity entityA = dense[a];
+	GUEntity entityB = dense[b];
+
+	dense[a] = entityB;
+	dense[b] = entityA;
+
+	sparse[guEntityIndex(entityA)] = b + 1;
+	sparse[guEntityIndex(entityB)] = a + 1;
+
+	swapFields(a, b);
+}
+
+
+bool GUComponentSet::contains(GUEntity entity) const {
+
+	uint32_t index = guEntityIndex(entity);
+
+	return (index < sparse.size()) && (sparse[index] != 0) && (dense[sparse[index] - 1] == entity);
+}
+
+
+
+//
+// GUTransformStore
+//
+
+uint32_t GUTransformStore::add(GUEntity entity, const vec3& position, float rotation, const vec3& scale, uint32_t node) {
+
+	uint32_t i = insert(entity);
+
+	this->node[i] = node;
+	setPosition(i, position);
+	this->rotation[i] = rotation;
+	scaleX[i] = scale.x;
+	scaleY[i] = scale.y;
+	scaleZ[i] = scale.z;
+
+	return i;
+}
+
+
+void GUTransformStore::pushFields() {
+
+	positionX.push_back(0.0f);
+	positionY.push_back(0.0f);
+	positionZ.push_back(0.0f);
+	rotation.push_back(0.0f);
+	scaleX.push_back(1.0f);
+	scaleY.push_back(1.0f);
+	scaleZ.push_back(1.0f);
+	node.push_back(0);
+}
+
+
+void GUTransformStore::swapFields(uint32_t a, uint32_t b) {
+
+	swapField(positionX, a, b);
+	swapField(positionY, a, b);
+	swapField(positionZ, a, b);
+	swapField(rotation, a, b);
+	swapField(scaleX, a, b);
+	swapField(scaleY, a, b);
+	swapField(scaleZ, a, b);
+	swapField(node, a, b);
+}
+
+
+void GUTransformStore::popFields() {
+
+	positionX.pop_back();
+	positionY.pop_back();
+	positionZ.pop_back();
+	rotation.pop_back();
+	scaleX.pop_back();
+	scaleY.pop_back();
+	scaleZ.pop_back();
+	node.pop_back();
+}
+
+
+vec3 GUTransformStore::position(uint32_t i) const {
+
+	return vec3(positionX[i], positionY[i], positionZ[i]);
+}
+
+
+void GUTransformStore::setPosition(uint32_t i, const vec3& p) {
+
+	positionX[i] = p.x;
+	positionY[i] = p.y;
+	positionZ[i] = p.z;
+}
+
+
+mat4 GUTransformStore::modelTransform(uint32_t i) const {
+
+	return glm::translate(identity<mat4>(), position(i)) * eulerAngleY<float>(glm::radians<float>(rotation[i])) * glm::scale(identity<mat4>(), vec3(scaleX[i], scaleY[i], scaleZ[i]));
+}
+
+
+
+//
+// GUVelocityStore
+//
+
+uint32_t GUVelocityStore::add(GUEntity entity, const vec3& velocity, float angularVelocity) {
+
+	uint32_t i = insert(entity);
+
+	velocityX[i] = velocity.x;
+	velocityY[i] = velocity.y;
+	velocityZ[i] = velocity.z;
+	this->angularVelocity[i] = angularVelocity;
+
+	return i;
+}
+
+
+void GUVelocityStore::pushFields() {
+
+	velocityX.push_back(0.0f);
+	velocityY.push_back(0.0f);
+	velocityZ.push_back(0.0f);
+	angularVelocity.push_back(0.0f);
+}
+
+
+void GUVelocityStore::swapFields(uint32_t a, uint32_t b) {
+
+	swapField(velocityX, a, b);
+	swapField(velocityY, a, b);
+	swapField(velocityZ, a, b);
+	swapField(angularVelocity, a, b);
+}
+
+
+void GUVelocityStore::popFields() {
+
+	velocityX.pop_back();
+	velocityY.pop_back();
+	velocityZ.pop_back();
+	angularVelocity.pop_back();
+}
+
+
+
+//
+// GURenderableStore
+//
+
+uint32_t GURenderableStore::add(GUEntity entity, SceneMesh mesh) {
+
+	uint32_t i = insert(entity);
+
+	this->mesh[i] = mesh;
+
+	return i;
+}
+
+
+void GURenderableStore::pushFields() {
+
+	mesh.push_back(SceneMesh::Count);
+}
+
+
+void GURenderableStore::swapFields(uint32_t a, uint32_t b) {
+
+	swapField(mesh, a, b);
+}
+
+
+void GURenderableStore::popFields() {
+
+	mesh.pop_back();
+}
+
+
+
+//
+// GULightStore
+//
+
+uint32_t GULightStore::add(GUEntity entity, const vec3& colour, const vec3& attenuation) {
+
+	uint32_t i = insert(entity);
+
+	colourR[i] = colour.r;
+	colourG[i] = colour.g;
+	colourB[i] = colour.b;
+	attenuationConstant[i] = attenuation.x;
+	attenuationLinear[i] = attenuation.y;
+	attenuationQuadratic[i] = attenuation.z;
+
+	return i;
+}
+
+
+void GULightStore::pushFields() {
+
+	colourR.push_back(1.0f);
+	colourG.push_back(1.0f);
+	colourB.push_back(1.0f);
+	attenuationConstant.push_back(1.0f);
+	attenuationLinear.push_back(0.0f);
+	attenuationQuadratic.push_back(0.0f);
+}
+
+
+void GULightStore::swapFields(uint32_t a, uint32_t b) {
+
+	swapField(colourR, a, b);
+	swapField(colourG, a, b);
+	swapField(colourB, a, b);
+	swapField(attenuationConstant, a, b);
+	swapField(attenuationLinear, a, b);
+	swapField(attenuationQuadratic, a, b);
+}
+
+
+void GULightStore::popFields() {
+
+	colourR.pop_back();
+	colourG.pop_back();
+	colourB.pop_back();
+	attenuationConstant.pop_back();
+	attenuationLinear.pop_back();
+	attenuationQuadratic.pop_back();
+}
+
+
+vec3 GULightStore::colour(uint32_t i) const {
+
+	return vec3(colourR[i], colourG[i], colourB[i]);
+}
+
+
+vec3 GULightStore::attenuation(uint32_t i) const {
+
+	return vec3(attenuationConstant[i], attenuationLinear[i], attenuationQuadratic[i]);
+}
+
+
+
+//
+// GUWorld
+//
+
+// Private method implementation
+
+// Move entity (which has just gained a transform or velocity) into the moving group if it now has both
+void GUWorld::joinMovingGroup(GUEntity entity) {
+
+	if (!transforms.contains(entity) || !velocities.contains(entity))
+		return;
+
+	transforms.swapElements(transforms.indexOf(entity), movingCount);
+	velocities.swapElements(velocities.indexOf(entity), movingCount);
+
+	movingCount++;
+}
+
+
+// Move entity out of the moving group (if it is in it) before it loses its transform or velocity
+void GUWorld::leaveMovingGroup(GUEntity entity) {
+
+	if (!transforms.contains(entity) || !velocities.contains(entity))
+		return;
+
+	movingCount--;
+
+	transforms.swapElements(transforms.indexOf(entity), movingCount);
+	velocities.swapElements(velocities.indexOf(entity), movingCount);
+}
+
+
+// Public method implementation
+
+GUEntity GUWorld::create() {
+
+	uint32_t index;
+
+	if (!freeIndices.empty()) {
+
+		index = freeIndices.back();
+		freeIndices.pop_back();
+	}
+	else {
+
+		index = (uint32_t)handles.size();
+
+		handles.push_back(index); // generation 0
+		alive.push_back(0);
+	}
+
+	alive[index] = 1;
+	numEntities++;
+
+	return handles[index];
+}
+
+
+void GUWorld::destroy(GUEntity entity) {
+
+	if (!isAlive(entity))
+		return;
+
+	removeTransform(entity);
+	removeVelocity(entity);
+	removeRenderable(entity);
+	removeLight(entity);
+
+	uint32_t index = guEntityIndex(entity);
+
+	handles[index] = (((guEntityGeneration(entity) + 1) & 0xFF) << 24) | index;
+	alive[index] = 0;
+	freeIndices.push_back(index);
+	numEntities--;
+}
+
+
+bool GUWorld::isAlive(GUEntity entity) const {
+
+	uint32_t index = guEntityIndex(entity);
+
+	return (index < handles.size()) && alive[index] && (handles[index] == entity);
+}
+
+
+uint32_t GUWorld::entityCount() const {
+
+	return numEntities;
+}
+
+
+uint32_t GUWorld::addTransform(GUEntity entity, const vec3& position, float rotation, const vec3& scale) {
+
+	uint32_t i = transforms.add(entity, position, rotation, scale, 0);
+
+	transforms.node[i] = hierarchy.create(transforms.modelTransform(i));
+	joinMovingGroup(entity);
+
+	return transforms.indexOf(entity);
+}
+
+
+uint32_t GUWorld::addVelocity(GUEntity entity, const vec3& velocity, float angularVelocity) {
+
+	velocities.add(entity, velocity, angularVelocity);
+	joinMovingGroup(entity);
+
+	return velocities.indexOf(entity);
+}
+
+
+uint32_t GUWorld::addRenderable(GUEntity entity, SceneMesh mesh) {
+
+	return renderables.add(entity, mesh);
+}
+
+
+uint32_t GUWorld::addLight(GUEntity entity, const vec3& colour, const vec3& attenuation) {
+
+	return lights.add(entity, colour, attenuation);
+}
+
+
+void GUWorld::removeTransform(GUEntity entity) {
+
+	if (!transforms.contains(entity))
+		return;
+
+	leaveMovingGroup(entity);
+
+	hierarchy.destroy(transforms.node[transforms.indexOf(entity)]);
+	transforms.remove(entity);
+}
+
+
+void GUWorld::removeVelocity(GUEntity entity) {
+
+	leaveMovingGroup(entity);
+	velocities.remove(entity);
+}
+
+
+void GUWorld::removeRenderable(GUEntity entity) {
+
+	renderables.remove(entity);
+}
+
+
+void GUWorld::removeLight(GUEntity entity) {
+
+	lights.remove(entity);
+}
+
+
+void GUWorld::setTransform(GUEntity entity, const vec3& position, float rotation, const vec3& scale) {
+
+	uint32_t i = transforms.indexOf(entity);
+
+	transforms.scaleX[i] = scale.x;
+	transforms.scaleY[i] = scale.y;
+	transforms.scaleZ[i] = scale.z;
+
+	setTransform(entity, position, rotation);
+}
+
+
+void GUWorld::setTransform(GUEntity entity, const vec3& position, float rotation) {
+
+	uint32_t i = transforms.indexOf(entity);
+
+	transforms.setPosition(i, position);
+	transforms.rotation[i] = rotation;
+
+	hierarchy.setLocalTransform(transforms.node[i], transforms.modelTransform(i));
+}
+
+
+bool GUWorld::setParent(GUEntity entity, GUEntity parent) {
+
+	uint32_t parentNode = (parent != GUNullEntity) ? transforms.node[transforms.indexOf(parent)] : GUTransformHierarchy::noParent;
+
+	return hierarchy.setParent(transforms.node[transforms.indexOf(entity)], parentNode);
+}
+
+
+GUEntity GUWorld::parentOf(GUEntity entity) const {
+
+	uint32_t parentNode = hierarchy.parentOf(transforms.node[transforms.indexOf(entity)]);
+
+	if (parentNode == GUTransformHierarchy::noParent)
+		return GUNullEntity;
+
+	// Parents are rare, so the owning entity is found by search rather than kept per node
+	for (uint32_t i = 0; i < transforms.size(); ++i) {
+
+		if (transforms.node[i] == parentNode)
+			return transforms.entity(i);
+	}
+
+	return GUNullEntity;
+}
+
+
+void GUWorld::updateWorldTransforms() {
+
+	// Local matrices of the entities integrateVelocities moved are rebuilt here, once, however many steps were integrated
+	if (movedSinceUpdate) {
+
+		for (uint32_t i = 0; i < movingCount; ++i)
+			hierarchy.setLocalTransform(transforms.node[i], transforms.modelTransform(i));
+
+		movedSinceUpdate = false;
+	}
+
+	hierarchy.update();
+}
+
+
+const mat4& GUWorld::worldTransform(GUEntity entity) const {
+
+	return hierarchy.worldTransform(transforms.node[transforms.indexOf(entity)]);
+}
+
+
+uint32_t GUWorld::movingEntityCount() const {
+
+	return movingCount;
+}
+
+
+void GUWorld::integrateVelocities(float tDelta) {
+
+	// Separate restrict-qualified arrays with no lookups or branches, so the compiler vectorises each loop
+	float* __restrict px = transforms.positionX.data();
+	float* __restrict py = transforms.positionY.data();
+	float* __restrict pz = transforms.positionZ.data();
+	float* __restrict r = transforms.rotation.data();
+
+	const float* __restrict vx = velocities.velocityX.data();
+	const float* __restrict vy = velocities.velocityY.data();
+	const float* __restrict vz = velocities.velocityZ.data();
+	const float* __restrict w = velocities.angularVelocity.data();
+
+	const int n = (int)movingCount;
+
+	for (int i = 0; i < n; ++i)
+		px[i] += vx[i] * tDelta;
+
+	for (int i = 0; i < n; ++i)
+		py[i] += vy[i] * tDelta;
+
+	for (int i = 0; i < n; ++i)
+		pz[i] += vz[i] * tDelta;
+
+	for (int i = 0; i < n; ++i)
+		r[i] += w[i] * tDelta;
+
+	movedSinceUpdate = true;
+}
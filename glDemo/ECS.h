@@ -0,0 +1,247 @@
+#pragma once
+
+//
+// Entity-component storage for scene objects.  An entity is a 32 bit handle with no data of its own.  Each component type is a sparse set - the component fields are kept in dense structure-of-arrays form (one tightly packed std::vector per field) alongside a dense array of the owning entities, and a sparse array maps an entity's index to its dense position.  Adding and removing a component is O(1) (removal moves the last element into the hole) and systems iterate the dense arrays directly.
+//
+// Entities that have both a transform and a velocity are kept at the front of both stores in the same order (an owning group), so moving them is one linear sweep over packed floats with no lookups - see GUWorld::integrateVelocities.  Components are therefore added and removed through GUWorld, which maintains the group.  Other pairings (eg. a renderable's transform) are found with indexOf.
+//
+// Transforms are local to the entity's parent (set with GUWorld::setParent) and each has a node in GUWorld::hierarchy caching its world matrix.  Change transforms with GUWorld's setters (or integrateVelocities), which mark the node dirty - writing the store's fields directly does not - then call updateWorldTransforms once before reading worldTransform.
+//
+// Nothing here is thread safe.  Systems that only write fields of their own dense range can be split with GUJobSystem::parallelFor.
+//
+
+#include "core.h"
+#include "SceneDescription.h"
+#include "TransformHierarchy.h"
+
+typedef uint32_t GUEntity;
+
+const GUEntity GUNullEntity = 0xFFFFFFFF;
+
+// The low 24 bits of a handle index the sparse arrays and the high 8 bits count how many times the index has been reused, so a handle kept after its entity was destroyed is detected rather than referring to the entity that reused the index
+inline uint32_t guEntityIndex(GUEntity entity) {
+
+	return entity & 0x00FFFFFF;
+}
+
+inline uint32_t guEntityGeneration(GUEntity entity) {
+
+	return entity >> 24;
+}
+
+
+// Sparse set bookkeeping shared by the component stores.  Derived stores keep one std::vector per field in dense order and move their fields when the set does
+class GUComponentSet {
+
+private:
+
+	friend class GUWorld;
+
+	std::vector<uint32_t>		sparse; // entity index -> dense position + 1 (0 if absent)
+	std::vector<GUEntity>		dense;
+
+protected:
+
+	// Field storage hooks
+	virtual void pushFields() = 0; // append an element (set by the store's add)
+	virtual void swapFields(uint32_t a, uint32_t b) = 0;
+	virtual void popFields() = 0;
+
+	// Append entity (which must not be present) and return its dense position
+	uint32_t insert(GUEntity entity);
+
+	// Remove entity if present, moving the last element into its place
+	void remove(GUEntity entity);
+
+	// Exchange the elements at two dense positions
+	void swapElements(uint32_t a, uint32_t b);
+
+public:
+
+	virtual ~GUComponentSet() {}
+
+	bool contains(GUEntity entity) const;
+
+	// Dense position of entity's component, which must be present
+	uint32_t indexOf(GUEntity entity) const {
+
+		return sparse[guEntityIndex(entity)] - 1;
+	}
+
+	uint32_t size() const {
+
+		return (uint32_t)dense.size();
+	}
+
+	GUEntity entity(uint32_t i) const {
+
+		return dense[i];
+	}
+};
+
+
+// Position, rotation about y (degrees) and scale relative to the parent - the same placement as SceneInstance
+class GUTransformStore : public GUComponentSet {
+
+private:
+
+	friend class GUWorld;
+
+	uint32_t add(GUEntity entity, const glm::vec3& position, float rotation, const glm::vec3& scale, uint32_t node);
+	void setPosition(uint32_t i, const glm::vec3& p);
+
+protected:
+
+	void pushFields();
+	void swapFields(uint32_t a, uint32_t b);
+	void popFields();
+
+public:
+
+	std::vector<float>			positionX, positionY, positionZ;
+	std::vector<float>			rotation;
+	std::vector<float>			scaleX, scaleY, scaleZ;
+	std::vector<uint32_t>		node; // GUWorld::hierarchy node
+
+	glm::vec3 position(uint32_t i) const;
+
+	// translate(position) * rotate about y * scale - the local transform
+	glm::mat4 modelTransform(uint32_t i) const;
+};
+
+
+// Linear velocity (world units per second) and angular velocity about y (degrees per second)
+class GUVelocityStore : public GUComponentSet {
+
+private:
+
+	friend class GUWorld;
+
+	uint32_t add(GUEntity entity, const glm::vec3& velocity, float angularVelocity);
+
+protected:
+
+	void pushFields();
+	void swapFields(uint32_t a, uint32_t b);
+	void popFields();
+
+public:
+
+	std::vector<float>			velocityX, velocityY, velocityZ;
+	std::vector<float>			angularVelocity;
+};
+
+
+// The mesh an entity is drawn with.  Meshes are named by SceneMesh so the store does not depend on how the renderer loads them
+class GURenderableStore : public GUComponentSet {
+
+private:
+
+	friend class GUWorld;
+
+	uint32_t add(GUEntity entity, SceneMesh mesh);
+
+protected:
+
+	void pushFields();
+	void swapFields(uint32_t a, uint32_t b);
+	void popFields();
+
+public:
+
+	std::vector<SceneMesh>		mesh;
+};
+
+
+// Point light at the entity's transform position
+class GULightStore : public GUComponentSet {
+
+private:
+
+	friend class GUWorld;
+
+	uint32_t add(GUEntity entity, const glm::vec3& colour, const glm::vec3& attenuation);
+
+protected:
+
+	void pushFields();
+	void swapFields(uint32_t a, uint32_t b);
+	void popFields();
+
+public:
+
+	std::vector<float>			colourR, colourG, colourB;
+	std::vector<float>			attenuationConstant, attenuationLinear, attenuationQuadratic;
+
+	glm::vec3 colour(uint32_t i) const;
+	glm::vec3 attenuation(uint32_t i) const;
+};
+
+
+class GUWorld {
+
+private:
+
+	std::vector<GUEntity>		handles; // current handle for each entity index (its generation is one past the last destroyed)
+	std::vector<uint8_t>		alive;
+	std::vector<uint32_t>		freeIndices;
+	uint32_t					numEntities = 0;
+
+	// The first movingCount elements of transforms and velocities belong to the same entities in the same order
+	uint32_t					movingCount = 0;
+	bool						movedSinceUpdate = false;
+
+	// Private functions
+	void joinMovingGroup(GUEntity entity);
+	void leaveMovingGroup(GUEntity entity);
+
+public:
+
+	GUTransformStore			transforms;
+	GUVelocityStore				velocities;
+	GURenderableStore			renderables;
+	GULightStore				lights;
+
+	// World transforms of every entity with a transform
+	GUTransformHierarchy		hierarchy;
+
+	GUEntity create();
+
+	// Remove entity and all of its components.  Its handle (and any copy of it) is no longer alive
+	void destroy(GUEntity entity);
+
+	bool isAlive(GUEntity entity) const;
+	uint32_t entityCount() const;
+
+	// Add a component to a live entity that does not have one of that type, returning its dense position (which later adds and removes may change)
+	uint32_t addTransform(GUEntity entity, const glm::vec3& position, float rotation = 0.0f, const glm::vec3& scale = glm::vec3(1.0f));
+	uint32_t addVelocity(GUEntity entity, const glm::vec3& velocity, float angularVelocity = 0.0f);
+	uint32_t addRenderable(GUEntity entity, SceneMesh mesh);
+	uint32_t addLight(GUEntity entity, const glm::vec3& colour, const glm::vec3& attenuation);
+
+	// Remove the transform.  Children of entity are moved to its parent
+	void removeTransform(GUEntity entity);
+	void removeVelocity(GUEntity entity);
+	void removeRenderable(GUEntity entity);
+	void removeLight(GUEntity entity);
+
+	// Set the local transform of an entity with a transform (the second form keeps its scale)
+	void setTransform(GUEntity entity, const glm::vec3& position, float rotation, const glm::vec3& scale);
+	void setTransform(GUEntity entity, const glm::vec3& position, float rotation);
+
+	// Attach entity to parent (GUNullEntity to detach) so its transform is relative to parent's.  Both must have transforms.  Returns false if parent is entity or one of its descendants
+	bool setParent(GUEntity entity, GUEntity parent);
+	GUEntity parentOf(GUEntity entity) const;
+
+	// Recompute the world transforms of entities whose transform, or an ancestor's, has changed
+	void updateWorldTransforms();
+
+	// World transform of an entity with a transform as of the last updateWorldTransforms
+	const glm::mat4& worldTransform(GUEntity entity) const;
+
+	// Number of entities with both a transform and a velocity - they occupy dense positions 0 to movingEntityCount() - 1 in both stores
+	uint32_t movingEntityCount() const;
+
+	// Movement system - advance the position and rotation of every entity with a velocity by tDelta seconds (relative to its parent)
+	void integrateVelocities(float tDelta);
+};
@@ -0,0 +1,93 @@
+#include "FixedTimestep.h"
+
+using namespace std;
+
+
+// Frame times that are whole multiples of the step (eg. the benchmark's 1/60s frames with a 1/120s step) should always give the same step count - allow for rounding in the accumulator so they never alternate between n - 1 and n + 1 steps
+static const gu_seconds stepTolerance = 1.0e-9;
+
+
+GUFixedTimestep::GUFixedTimestep(gu_seconds stepLength, int maxStepsPerFrame) {
+
+	this->stepLength = stepLength;
+	this->maxStepsPerFrame = std::max<int>(maxStepsPerFrame, 1);
+}
+
+
+int GUFixedTimestep::advance(gu_seconds frameDelta) {
+
+	if (frameDelta > 0.0)
+		accumulator += frameDelta;
+
+	uint64_t steps = (uint64_t)floor(accumulator / stepLength + stepTolerance);
+
+	if (steps > (uint64_t)maxStepsPerFrame) {
+
+		// Catch-up cap - drop the whole steps that cannot be run but keep the fraction so interpolation stays smooth
+		droppedStepCount += steps - (uint64_t)maxStepsPerFrame;
+		cappedFrameCount++;
+
+		accumulator -= (gu_seconds)steps * stepLength;
+		steps = (uint64_t)maxStepsPerFrame;
+	}
+	else {
+
+		accumulator -= (gu_seconds)steps * stepLength;
+	}
+
+	accumulator = std::max<gu_seconds>(accumulator, 0.0);
+	stepCount += steps;
+
+	return (int)steps;
+}
+
+
+void GUFixedTimestep::reset() {
+
+	accumulator = 0.0;
+	stepCount = 0;
+	droppedStepCount = 0;
+	cappedFrameCount = 0;
+}
+
+
+float GUFixedTimestep::alpha() const {
+
+	return std::min<float>((float)(accumulator / stepLength), 1.0f);
+}
+
+
+gu_seconds GUFixedTimestep::step() const {
+
+	return stepLength;
+}
+
+
+int GUFixedTimestep::maxSteps() const {
+
+	return maxStepsPerFrame;
+}
+
+
+uint64_t GUFixedTimestep::totalSteps() const {
+
+	return stepCount;
+}
+
+
+gu_seconds GUFixedTimestep::simulationTime() const {
+
+	return (gu_seconds)stepCount * stepLength;
+}
+
+
+uint64_t GUFixedTimestep::droppedSteps() const {
+
+	return droppedStepCount;
+}
+
+
+uint64_t GUFixedTimestep::cappedFrames() const {
+
+	return cappedFrameCount;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "GUClock.h"
+
+// Fixed timestep accumulator.  Each frame's elapsed time is added with advance(), which returns how many simulation steps of stepLength to run.  Time left over (less than one step) carries into the next frame and alpha() gives the fraction of a step it represents, for interpolating between the last two simulated states when rendering.
+//
+// At most maxStepsPerFrame steps are run per frame - after a long stall the remaining time is dropped rather than simulated, so a slow frame cannot make the next one slower still (the "spiral of death").  Dropped steps are counted so runs that fell behind can be identified.
+
+class GUFixedTimestep {
+
+private:
+
+	gu_seconds				stepLength;
+	int						maxStepsPerFrame;
+
+	gu_seconds				accumulator = 0.0;
+	uint64_t				stepCount = 0;
+	uint64_t				droppedStepCount = 0;
+	uint64_t				cappedFrameCount = 0;
+
+public:
+
+	GUFixedTimestep(gu_seconds stepLength, int maxStepsPerFrame);
+
+	// Add frameDelta seconds of elapsed time and return the number of steps to simulate this frame (0 to maxStepsPerFrame)
+	int advance(gu_seconds frameDelta);
+
+	// Discard accumulated time and step counts
+	void reset();
+
+	// Fraction of a step accumulated but not yet simulated, in [0, 1)
+	float alpha() const;
+
+	gu_seconds step() const;
+	int maxSteps() const;
+
+	// Steps returned by advance() since construction or reset() - multiply by step() for simulated time
+	uint64_t totalSteps() const;
+	gu_seconds simulationTime() const;
+
+	// Steps discarded by the catch-up cap and the number of frames it was applied to
+	uint64_t droppedSteps() const;
+	uint64_t cappedFrames() const;
+};
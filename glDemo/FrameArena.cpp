@@ -0,0 +1,218 @@
+#include "FrameArena.h"
+#include "JobSystem.h"
+
+using namespace std;
+
+
+//
+// GUFrameArena
+//
+
+// Private method implementation
+
+void GUFrameArena::addBlock(size_t size) {
+
+	blocks.push_back(Block{ (char*)::operator new(size), size });
+}
+
+
+void GUFrameArena::releaseBlocks() {
+
+	for (Block& block : blocks)
+		::operator delete(block.data);
+
+	blocks.clear();
+}
+
+
+// Protected method implementation
+
+void* GUFrameArena::do_allocate(size_t bytes, size_t alignment) {
+
+	for (;;) {
+
+		Block& block = blocks[current];
+
+		uintptr_t start = (uintptr_t)(block.data + offset);
+		uintptr_t aligned = (start + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		size_t end = (size_t)(aligned - (uintptr_t)block.data) + bytes;
+
+		if (end <= block.size) {
+
+			used += end - offset;
+			offset = end;
+
+			return (void*)aligned;
+		}
+
+		// The rest of this block is left unused - move on to the next, adding one if this is the last
+		used += block.size - offset;
+
+		if (current + 1 == blocks.size()) {
+
+			addBlock(std::max<size_t>(bytes + alignment, blocks[0].size));
+			blocksAdded++;
+		}
+
+		current++;
+		offset = 0;
+	}
+}
+
+
+void GUFrameArena::do_deallocate(void*, size_t, size_t) {
+
+	// Memory is only reclaimed by reset
+}
+
+
+bool GUFrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+
+	return this == &other;
+}
+
+
+// Public method implementation
+
+GUFrameArena::GUFrameArena(size_t capacity) {
+
+	addBlock(std::max<size_t>(capacity, 64));
+}
+
+
+GUFrameArena::~GUFrameArena() {
+
+	releaseBlocks();
+}
+
+
+void GUFrameArena::reset() {
+
+	lastFrame = used;
+	highWater = std::max<size_t>(highWater, used);
+
+	// One block large enough for the largest frame so far, so frames like it need no more blocks
+	if (blocks.size() > 1) {
+
+		releaseBlocks();
+		addBlock(highWater + highWater / 4);
+	}
+
+	current = 0;
+	offset = 0;
+	used = 0;
+}
+
+
+size_t GUFrameArena::bytesUsed() const {
+
+	return used;
+}
+
+
+size_t GUFrameArena::capacity() const {
+
+	size_t total = 0;
+
+	for (const Block& block : blocks)
+		total += block.size;
+
+	return total;
+}
+
+
+size_t GUFrameArena::lastFrameBytes() const {
+
+	return lastFrame;
+}
+
+
+size_t GUFrameArena::highWaterMark() const {
+
+	return highWater;
+}
+
+
+uint64_t GUFrameArena::blocksAddedCount() const {
+
+	return blocksAdded;
+}
+
+
+
+//
+// GUFrameAllocator
+//
+
+// Static member definitions
+vector<GUFrameArena*>	GUFrameAllocator::arenas;
+size_t					GUFrameAllocator::lastFrame = 0;
+size_t					GUFrameAllocator::highWater = 0;
+
+
+void GUFrameAllocator::start(size_t initialBytes) {
+
+	stop();
+
+	for (int i = 0; i <= GUJobSystem::workerCount(); ++i)
+		arenas.push_back(new GUFrameArena(initialBytes));
+}
+
+
+void GUFrameAllocator::stop() {
+
+	for (GUFrameArena* arena : arenas)
+		delete arena;
+
+	arenas.clear();
+}
+
+
+bool GUFrameAllocator::isStarted() {
+
+	return !arenas.empty();
+}
+
+
+GUFrameArena& GUFrameAllocator::local() {
+
+	return *arenas[GUJobSystem::currentWorker() + 1];
+}
+
+
+void GUFrameAllocator::endFrame() {
+
+	size_t total = 0;
+
+	for (GUFrameArena* arena : arenas) {
+
+		total += arena->bytesUsed();
+		arena->reset();
+	}
+
+	lastFrame = total;
+	highWater = std::max<size_t>(highWater, total);
+}
+
+
+size_t GUFrameAllocator::lastFrameBytes() {
+
+	return lastFrame;
+}
+
+
+size_t GUFrameAllocator::highWaterMark() {
+
+	return highWater;
+}
+
+
+uint64_t GUFrameAllocator::blocksAddedCount() {
+
+	uint64_t total = 0;
+
+	for (const GUFrameArena* arena : arenas)
+		total += arena->blocksAddedCount();
+
+	return total;
+}
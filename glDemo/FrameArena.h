@@ -0,0 +1,108 @@
+#pragma once
+
+//
+// Frame-scoped linear allocation for transient per-frame data (visibility flags, draw commands, sort orders, instance batches).  A GUFrameArena hands out memory by advancing an offset through a block and frees nothing individually - reset() rewinds it once the frame's data is no longer needed.  Allocation is a few instructions with no locking and no fragmentation, and memory used together is contiguous.
+//
+// Arenas are std::pmr::memory_resources, so standard containers allocate from them with std::pmr::vector etc.  A container that outgrows its storage leaves the old storage in the arena until the reset, so reserve the expected size where it is known.
+//
+// GUFrameAllocator keeps one arena for the render thread and one for each job worker so per-frame jobs allocate without contention.  A frame that outgrows an arena's block takes another block from the heap, and the next reset replaces the blocks with a single one of the high-water size - after the first few frames the frame loop allocates nothing from the heap.
+//
+
+#include "core.h"
+#include <memory_resource>
+
+
+class GUFrameArena : public std::pmr::memory_resource {
+
+private:
+
+	struct Block {
+
+		char*					data;
+		size_t					size;
+	};
+
+	std::vector<Block>			blocks; // blocks[current] is being filled - any after it are free this frame
+	size_t						current = 0;
+	size_t						offset = 0; // into blocks[current]
+
+	size_t						used = 0; // bytes allocated since the last reset, including alignment padding
+	size_t						lastFrame = 0;
+	size_t						highWater = 0;
+	uint64_t					blocksAdded = 0;
+
+	// Private functions
+	void addBlock(size_t size);
+	void releaseBlocks();
+
+protected:
+
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+public:
+
+	GUFrameArena(size_t capacity);
+	~GUFrameArena();
+
+	GUFrameArena(const GUFrameArena&) = delete;
+	GUFrameArena& operator=(const GUFrameArena&) = delete;
+
+	// Make all memory allocated since the last reset available again.  If the frame needed more than one block they are replaced by one block large enough for it
+	void reset();
+
+	size_t bytesUsed() const;
+
+	// Total size of the blocks
+	size_t capacity() const;
+
+	// Bytes used by the frame before the last reset
+	size_t lastFrameBytes() const;
+
+	// Most bytes used by any frame
+	size_t highWaterMark() const;
+
+	// Blocks taken from the heap after the first because a frame did not fit
+	uint64_t blocksAddedCount() const;
+};
+
+
+class GUFrameAllocator {
+
+private:
+
+	static std::vector<GUFrameArena*>	arenas; // arenas[0] for the render thread, arenas[i + 1] for job worker i
+	static size_t						lastFrame;
+	static size_t						highWater;
+
+public:
+
+	// Create an arena of initialBytes for the render thread and each job worker.  Call after GUJobSystem::start, before the frame loop
+	static void start(size_t initialBytes);
+	static void stop();
+
+	static bool isStarted();
+
+	// Arena of the calling thread - the worker's own on a job worker, otherwise the render thread's.  Only the render thread and the jobs it runs may allocate from the frame arenas, and only between two calls to endFrame
+	static GUFrameArena& local();
+
+	// Reset every arena.  Call on the render thread once the frame has been submitted, when no job is using frame memory
+	static void endFrame();
+
+	// Bytes used over all arenas by the last frame, and the most used by any frame
+	static size_t lastFrameBytes();
+	static size_t highWaterMark();
+
+	// Blocks taken from the heap by all arenas after their first
+	static uint64_t blocksAddedCount();
+};
+
+
+// Empty v and have it allocate from resource from now on.  Used to move a per-frame container onto the current frame's arena - its old storage is returned to the previous resource, which for an arena does nothing
+template <typename T>
+void guResetVector(std::pmr::vector<T>& v, std::pmr::memory_resource* resource) {
+
+	v.~vector();
+	new (&v) std::pmr::vector<T>(resource);
+}
@@ -0,0 +1,122 @@
+#include "GLFWPlatform.h"
+
+using namespace std;
+
+
+GUGLFWPlatform* GUGLFWPlatform::create(int width, int height, const std::string& title, bool debugContext, bool visible) {
+
+	// Initialise glfw and setup window
+	if (!glfwInit()) {
+
+		cout << "Failed to initialise GLFW!\n";
+		return nullptr;
+	}
+
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, (debugContext) ? GLFW_TRUE : GLFW_FALSE);
+	glfwWindowHint(GLFW_OPENGL_COMPAT_PROFILE, GLFW_TRUE);
+	glfwWindowHint(GLFW_VISIBLE, (visible) ? GLFW_TRUE : GLFW_FALSE);
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 1);
+
+	GLFWwindow* window = glfwCreateWindow(width, height, title.c_str(), NULL, NULL);
+
+	// Check window was created successfully
+	if (window == NULL) {
+
+		cout << "Failed to create GLFW window!\n";
+		glfwTerminate();
+		return nullptr;
+	}
+
+	glfwMakeContextCurrent(window);
+
+	// Initialise glew
+	glewInit();
+
+	GUGLFWPlatform* platform = new GUGLFWPlatform();
+	platform->window = window;
+
+	return platform;
+}
+
+
+GUGLFWPlatform::~GUGLFWPlatform() {
+
+	glfwTerminate();
+}
+
+
+GLFWwindow* GUGLFWPlatform::getWindow() const {
+
+	return window;
+}
+
+
+bool GUGLFWPlatform::isHeadless() const {
+
+	return false;
+}
+
+
+bool GUGLFWPlatform::shouldClose() const {
+
+	return glfwWindowShouldClose(window) != 0;
+}
+
+
+void GUGLFWPlatform::requestClose() {
+
+	glfwSetWindowShouldClose(window, GLFW_TRUE);
+
+	// Wake the main thread if it is waiting for events (requestClose may be called from the render thread)
+	glfwPostEmptyEvent();
+}
+
+
+void GUGLFWPlatform::swapBuffers() {
+
+	glfwSwapBuffers(window);
+}
+
+
+void GUGLFWPlatform::pollEvents() {
+
+	glfwPollEvents();
+}
+
+
+void GUGLFWPlatform::waitEvents(double timeout) {
+
+	glfwWaitEventsTimeout(timeout);
+}
+
+
+void GUGLFWPlatform::makeContextCurrent(bool current) {
+
+	glfwMakeContextCurrent((current) ? window : NULL);
+}
+
+
+void GUGLFWPlatform::setTitle(const std::string& title) {
+
+	glfwSetWindowTitle(window, title.c_str());
+}
+
+
+void GUGLFWPlatform::setSwapInterval(int interval) {
+
+	glfwSwapInterval(interval);
+}
+
+
+void GUGLFWPlatform::framebufferSize(int& width, int& height) const {
+
+	glfwGetFramebufferSize(window, &width, &height);
+}
+
+
+GLuint GUGLFWPlatform::defaultFramebuffer() const {
+
+	return 0;
+}
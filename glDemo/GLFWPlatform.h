@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Platform.h"
+
+// Window and OpenGL 4.1 compatibility context created with GLFW.  Input callbacks are installed by the caller on getWindow()
+
+class GUGLFWPlatform : public GUPlatform {
+
+private:
+
+	GLFWwindow*			window = nullptr;
+
+	GUGLFWPlatform() {}
+
+public:
+
+	// Initialise GLFW, open a width x height window, make its context current and initialise GLEW.  A window that is not visible just provides a context (eg. for benchmarks).  Returns nullptr if the window could not be created
+	static GUGLFWPlatform* create(int width, int height, const std::string& title, bool debugContext, bool visible = true);
+
+	~GUGLFWPlatform();
+
+	GLFWwindow* getWindow() const;
+
+	bool isHeadless() const override;
+
+	bool shouldClose() const override;
+	void requestClose() override;
+
+	void swapBuffers() override;
+	void pollEvents() override;
+	void waitEvents(double timeout) override;
+	void makeContextCurrent(bool current) override;
+
+	void setTitle(const std::string& title) override;
+	void setSwapInterval(int interval) override;
+
+	void framebufferSize(int& width, int& height) const override;
+	GLuint defaultFramebuffer() const override;
+};
@@ -0,0 +1,191 @@
+#include "GPUPassTimer.h"
+
+using namespace std;
+
+
+// Static member definitions
+const int GPUPassTimer::ringSize;
+const int GPUPassTimer::maxPasses;
+
+
+// Private functions
+
+// Read back the queries issued in slot.  Nothing waits - if the last query of the frame is not yet available the whole frame is skipped
+void GPUPassTimer::readSlot(int slot) {
+
+	int lastIssued = -1;
+
+	for (int p = 0; p < (int)passes.size(); ++p) {
+
+		if (issued[slot][p])
+			lastIssued = p;
+	}
+
+	if (lastIssued < 0)
+		return;
+
+	GLint available = 0;
+	glGetQueryObjectiv(queries[slot][lastIssued * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+	if (available) {
+
+		for (int p = 0; p < (int)passes.size(); ++p) {
+
+			if (!issued[slot][p])
+				continue;
+
+			GLuint64 startTime = 0, endTime = 0;
+
+			glGetQueryObjectui64v(queries[slot][p * 2], GL_QUERY_RESULT, &startTime);
+			glGetQueryObjectui64v(queries[slot][p * 2 + 1], GL_QUERY_RESULT, &endTime);
+
+			passes[p]->lastGPUTime = (gu_seconds)(endTime - startTime) * 1.0e-9;
+			passes[p]->histogram.record(passes[p]->lastGPUTime);
+		}
+	}
+	else {
+
+		framesSkipped++;
+	}
+
+	for (int p = 0; p < maxPasses; ++p)
+		issued[slot][p] = false;
+}
+
+
+// Public functions
+
+GPUPassTimer::GPUPassTimer() {
+
+	for (int s = 0; s < ringSize; ++s) {
+
+		for (int p = 0; p < maxPasses; ++p)
+			issued[s][p] = false;
+	}
+
+	supported = (GLEW_ARB_timer_query || GLEW_VERSION_3_3);
+
+	if (!supported) {
+
+		cout << "GPUPassTimer: timer queries not supported - GPU pass timing disabled" << endl;
+		return;
+	}
+
+	glGenQueries(ringSize * maxPasses * 2, &queries[0][0]);
+}
+
+
+GPUPassTimer::~GPUPassTimer() {
+
+	if (supported)
+		glDeleteQueries(ringSize * maxPasses * 2, &queries[0][0]);
+
+	for (Pass* pass : passes)
+		delete pass;
+}
+
+
+bool GPUPassTimer::isSupported() const {
+
+	return supported;
+}
+
+
+int GPUPassTimer::addPass(const std::string& name) {
+
+	if ((int)passes.size() >= maxPasses)
+		return -1;
+
+	Pass* pass = new Pass();
+	pass->name = name;
+
+	passes.push_back(pass);
+
+	return (int)passes.size() - 1;
+}
+
+
+void GPUPassTimer::beginFrame() {
+
+	if (!supported)
+		return;
+
+	frameSlot = (frameSlot + 1) % ringSize;
+
+	// The slot about to be reused was issued ringSize frames ago
+	readSlot(frameSlot);
+}
+
+
+void GPUPassTimer::beginPass(int pass) {
+
+	if (pass < 0 || pass >= (int)passes.size())
+		return;
+
+	passes[pass]->cpuStart = GUClockSource::now();
+
+	if (!supported || frameSlot < 0)
+		return;
+
+	glQueryCounter(queries[frameSlot][pass * 2], GL_TIMESTAMP);
+}
+
+
+void GPUPassTimer::endPass(int pass) {
+
+	if (pass < 0 || pass >= (int)passes.size())
+		return;
+
+	passes[pass]->lastCPUTime = (gu_seconds)(GUClockSource::now() - passes[pass]->cpuStart) / (gu_seconds)GUClockSource::frequency();
+
+	if (!supported || frameSlot < 0)
+		return;
+
+	glQueryCounter(queries[frameSlot][pass * 2 + 1], GL_TIMESTAMP);
+	issued[frameSlot][pass] = true;
+}
+
+
+int GPUPassTimer::passCount() const {
+
+	return (int)passes.size();
+}
+
+
+const std::string& GPUPassTimer::passName(int pass) const {
+
+	return passes[pass]->name;
+}
+
+
+const GUTimeHistogram& GPUPassTimer::passHistogram(int pass) const {
+
+	return passes[pass]->histogram;
+}
+
+
+gu_seconds GPUPassTimer::lastGPUTime(int pass) const {
+
+	return passes[pass]->lastGPUTime;
+}
+
+
+gu_seconds GPUPassTimer::lastCPUTime(int pass) const {
+
+	return passes[pass]->lastCPUTime;
+}
+
+
+uint64_t GPUPassTimer::framesSkippedCount() const {
+
+	return framesSkipped;
+}
+
+
+void GPUPassTimer::resetHistograms() {
+
+	for (Pass* pass : passes)
+		pass->histogram.reset();
+
+	framesSkipped = 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "core.h"
+#include "GUTimeHistogram.h"
+
+// GPU time per render pass using GL_TIMESTAMP queries.  Each pass records a timestamp before and after its commands, and the queries for a frame are read back ringSize frames later when the GPU has long finished with them, so timing never stalls the pipeline.  If a frame's results are still not available when its queries are reused, that frame is skipped rather than waited for.
+//
+// Timestamps (rather than GL_TIME_ELAPSED) are used so passes can nest or overlap - only one GL_TIME_ELAPSED query can be active at a time.
+//
+// The CPU time spent issuing each pass (beginPass to endPass) is also kept for the last frame, whether or not timer queries are supported.
+
+class GPUPassTimer {
+
+private:
+
+	static const int				ringSize = 4; // frames between issuing and reading back queries
+	static const int				maxPasses = 16;
+
+	struct Pass {
+
+		std::string					name;
+		GUTimeHistogram				histogram;
+		gu_seconds					lastGPUTime = -1.0; // most recent frame read back, -1 until there is one
+		gu_seconds					lastCPUTime = 0.0;
+		int64_t						cpuStart = 0; // GUClockSource ticks
+	};
+
+	std::vector<Pass*>				passes;
+
+	GLuint							queries[ringSize][maxPasses * 2];
+	bool							issued[ringSize][maxPasses];
+
+	int								frameSlot = -1;
+	bool							supported = false;
+
+	uint64_t						framesSkipped = 0;
+
+	// Private functions
+	void readSlot(int slot);
+
+public:
+
+	// Requires a current OpenGL context.  Timing is disabled (every call becomes a no-op) if timer queries are not supported
+	GPUPassTimer();
+	~GPUPassTimer();
+
+	bool isSupported() const;
+
+	// Register a pass and return its id, or -1 if maxPasses have already been added.  Passes can be added when timer queries are not supported so their CPU time is still measured
+	int addPass(const std::string& name);
+
+	// Call once per frame before the first pass - reads back the frame issued ringSize frames ago
+	void beginFrame();
+
+	void beginPass(int pass);
+	void endPass(int pass);
+
+	int passCount() const;
+	const std::string& passName(int pass) const;
+	const GUTimeHistogram& passHistogram(int pass) const;
+
+	// GPU time of the pass in the most recent frame read back (ringSize frames behind), or -1 if none has been, and CPU time of the pass in the last frame
+	gu_seconds lastGPUTime(int pass) const;
+	gu_seconds lastCPUTime(int pass) const;
+
+	uint64_t framesSkippedCount() const;
+
+	// Clear the pass histograms (eg. after a warm-up period).  Frames already in flight are still added when read back
+	void resetHistograms();
+};
@@ -1,6 +1,7 @@
 
 #include "GUClock.h"
-#include <Windows.h>
+#include "GUTimeHistogram.h"
+#include <algorithm>
 
 using namespace std;
 
@@ -189,6 +190,135 @@ public:
 
 
 
+//
+// Private class to record every frame delta.  A fixed size ring buffer holds the most recent frames for rolling windows and graphs, and a histogram holds the whole run for percentiles
+//
+
+class GUFrameTimeLog {
+
+public:
+
+	static const size_t		capacity = 16384;
+	static const int		numWindows = 3;
+
+	std::vector<float>		ring;
+	size_t					head; // next slot to write
+	size_t					size;
+
+	GUTimeHistogram			histogram;
+
+	uint64_t				stutters;
+	gu_seconds				smoothedDelta;
+	bool					skipNext;
+
+
+	GUFrameTimeLog() : ring(capacity, 0.0f) {
+
+		resetLog();
+	}
+
+	void resetLog() {
+
+		head = 0;
+		size = 0;
+
+		histogram.reset();
+
+		stutters = 0;
+		smoothedDelta = 0.0;
+		skipNext = true;
+	}
+
+	void record(gu_seconds delta) {
+
+		if (skipNext) {
+
+			skipNext = false;
+			return;
+		}
+
+		ring[head] = (float)delta;
+		head = (head + 1) % capacity;
+		size = std::min<size_t>(size + 1, capacity);
+
+		histogram.record(delta);
+
+		// A frame counts as a stutter if it is twice as long as the recent (exponentially smoothed) frame time
+		if (histogram.count() > 1 && delta > smoothedDelta * 2.0)
+			stutters++;
+
+		smoothedDelta = (histogram.count() > 1) ? smoothedDelta * 0.9 + delta * 0.1 : delta;
+	}
+
+	size_t recent(std::vector<float>& times, size_t maxCount) const {
+
+		size_t n = std::min<size_t>(maxCount, size);
+
+		times.resize(n);
+
+		for (size_t i = 0; i < n; ++i)
+			times[i] = ring[(head + capacity - n + i) % capacity];
+
+		return n;
+	}
+
+	GUFrameTimeWindow window(gu_seconds windowLength) const {
+
+		GUFrameTimeWindow result = { windowLength, 0, 0.0, 0.0, 0.0, 0.0 };
+
+		std::vector<float> frames;
+		gu_seconds total = 0.0;
+
+		for (size_t i = 0; i < size && total < windowLength; ++i) {
+
+			float delta = ring[(head + capacity - 1 - i) % capacity];
+
+			frames.push_back(delta);
+			total += delta;
+		}
+
+		if (frames.empty())
+			return result;
+
+		std::sort(frames.begin(), frames.end());
+
+		result.frames = (int)frames.size();
+		result.mean = total / (gu_seconds)frames.size();
+		result.p50 = frames[(frames.size() - 1) / 2];
+		result.p99 = frames[std::min<size_t>((size_t)ceil(frames.size() * 0.99) - 1, frames.size() - 1)];
+		result.maximum = frames.back();
+
+		return result;
+	}
+};
+
+const size_t GUFrameTimeLog::capacity;
+const int GUFrameTimeLog::numWindows;
+
+// Rolling window lengths reported by reportTimingData and exportTimingReport
+static const gu_seconds reportWindows[GUFrameTimeLog::numWindows] = { 1.0, 5.0, 15.0 };
+
+// Frame budgets (60, 30 and 20 fps) reported as counts of frames over budget
+static const gu_seconds reportBudgets[3] = { 1.0 / 60.0, 1.0 / 30.0, 1.0 / 20.0 };
+
+
+// Quote s as a CSV field - embedded quotes are doubled
+static string csvQuote(const string& s) {
+
+	string result = "\"";
+
+	for (char c : s) {
+
+		if (c == '"')
+			result += '"';
+
+		result += c;
+	}
+
+	return result + "\"";
+}
+
+
 //
 // GUClock implementation
 //
@@ -198,11 +328,7 @@ public:
 
 gu_time_index GUClock::actualTime() {
 
-	gu_time_index t;
-
-	QueryPerformanceCounter((LARGE_INTEGER*)&t);
-
-	return t;
+	return GUClockSource::now();
 }
 
 
@@ -239,6 +365,7 @@ void GUClock::invalidateClock() {
 	_clockStopped = true;
 
 	frameCounter = NULL;
+	frameTimeLog = NULL;
 }
 
 
@@ -254,7 +381,7 @@ gu_seconds GUClock::convertTimeIntervalToSeconds(gu_time_interval t) const {
 
 GUClock::GUClock(void) {
 
-	QueryPerformanceFrequency((LARGE_INTEGER*)&performanceFrequency);
+	performanceFrequency = GUClockSource::frequency();
 
 	if (performanceFrequency != 0) {
 
@@ -262,6 +389,7 @@ GUClock::GUClock(void) {
 
 		resetClockAttributes();
 		frameCounter = new GUFrameCounter();
+		frameTimeLog = new GUFrameTimeLog();
 
 	}
 	else {
@@ -279,6 +407,9 @@ GUClock::~GUClock(void) {
 
 	if (frameCounter)
 		delete frameCounter;
+
+	if (frameTimeLog)
+		delete frameTimeLog;
 }
 
 
@@ -324,6 +455,9 @@ void GUClock::tick() {
 
 	if (frameCounter)
 		frameCounter->updateFrameCounterForElaspsedTime(convertTimeIntervalToSeconds((currentTimeIndex - baseTime) - totalStopTime));
+
+	if (frameTimeLog)
+		frameTimeLog->record(convertTimeIntervalToSeconds(deltaTime));
 }
 
 
@@ -333,6 +467,9 @@ void GUClock::reset() {
 
 	if (frameCounter)
 		frameCounter->resetCounter();
+
+	if (frameTimeLog)
+		frameTimeLog->resetLog();
 }
 
 
@@ -382,6 +519,36 @@ void GUClock::reportTimingData() const {
 		cout << "ALT min SPF = " << (frameCounter->altMinimumSPF() /*/ 1000.0*/) << endl;
 		cout << "ALT average SPF = " << (frameCounter->altAverageSPF() /*/ 1000.0*/) << endl;
 	}
+
+	if (frameTimeLog && frameTimeLog->histogram.count() > 0) {
+
+		const GUTimeHistogram& h = frameTimeLog->histogram;
+
+		printf("frames recorded = %llu\n", (unsigned long long)h.count());
+		printf("frame time ms: mean %.3f, min %.3f, p50 %.3f, p90 %.3f, p99 %.3f, p99.9 %.3f, max %.3f\n",
+			h.mean() * 1000.0, h.minimum() * 1000.0, h.percentile(50.0) * 1000.0, h.percentile(90.0) * 1000.0,
+			h.percentile(99.0) * 1000.0, h.percentile(99.9) * 1000.0, h.maximum() * 1000.0);
+		printf("stutters (> 2x smoothed frame time) = %llu\n", (unsigned long long)frameTimeLog->stutters);
+
+		for (gu_seconds budget : reportBudgets)
+			printf("frames over %.1f ms = %llu\n", budget * 1000.0, (unsigned long long)h.countAbove(budget));
+
+		for (gu_seconds length : reportWindows) {
+
+			GUFrameTimeWindow w = frameTimeLog->window(length);
+			printf("last %.0f s (%d frames) ms: mean %.3f, p50 %.3f, p99 %.3f, max %.3f\n", length, w.frames, w.mean * 1000.0, w.p50 * 1000.0, w.p99 * 1000.0, w.maximum * 1000.0);
+		}
+	}
+
+	for (const pair<string, const GUTimeHistogram*>& series : timingSeries) {
+
+		const GUTimeHistogram& h = *series.second;
+
+		printf("%s ms (%llu samples): mean %.3f, p50 %.3f, p90 %.3f, p99 %.3f, p99.9 %.3f, max %.3f\n",
+			series.first.c_str(), (unsigned long long)h.count(),
+			h.mean() * 1000.0, h.percentile(50.0) * 1000.0, h.percentile(90.0) * 1000.0,
+			h.percentile(99.0) * 1000.0, h.percentile(99.9) * 1000.0, h.maximum() * 1000.0);
+	}
 }
 
 
@@ -431,3 +598,252 @@ gu_seconds GUClock::averageSPF() const {
 
 	return (frameCounter) ? frameCounter->averageSPF() : 0.0;
 }
+
+
+gu_seconds GUClock::frameTimePercentile(double p) const {
+
+	return (frameTimeLog) ? frameTimeLog->histogram.percentile(p) : 0.0;
+}
+
+
+uint64_t GUClock::framesLongerThan(gu_seconds t) const {
+
+	return (frameTimeLog) ? frameTimeLog->histogram.countAbove(t) : 0;
+}
+
+
+uint64_t GUClock::stutterCount() const {
+
+	return (frameTimeLog) ? frameTimeLog->stutters : 0;
+}
+
+
+GUFrameTimeWindow GUClock::rollingWindow(gu_seconds windowLength) const {
+
+	if (frameTimeLog)
+		return frameTimeLog->window(windowLength);
+
+	GUFrameTimeWindow empty = { windowLength, 0, 0.0, 0.0, 0.0, 0.0 };
+	return empty;
+}
+
+
+size_t GUClock::recentFrameTimes(std::vector<float>& times, size_t maxCount) const {
+
+	if (!frameTimeLog) {
+
+		times.clear();
+		return 0;
+	}
+
+	return frameTimeLog->recent(times, maxCount);
+}
+
+
+const GUTimeHistogram* GUClock::frameTimeHistogram() const {
+
+	return (frameTimeLog) ? &frameTimeLog->histogram : NULL;
+}
+
+
+void GUClock::addTimingSeries(const std::string& name, const GUTimeHistogram* histogram) {
+
+	if (histogram)
+		timingSeries.push_back(make_pair(name, histogram));
+}
+
+
+void GUClock::setReportCounter(const std::string& name, double value) {
+
+	for (pair<string, double>& counter : reportCounters) {
+
+		if (counter.first == name) {
+
+			counter.second = value;
+			return;
+		}
+	}
+
+	reportCounters.push_back(make_pair(name, value));
+}
+
+
+void GUClock::setReportInfo(const std::string& name, const std::string& value) {
+
+	for (pair<string, string>& info : reportInfo) {
+
+		if (info.first == name) {
+
+			info.second = value;
+			return;
+		}
+	}
+
+	reportInfo.push_back(make_pair(name, value));
+}
+
+
+bool GUClock::exportTimingReport(const std::string& filename) const {
+
+	if (!frameTimeLog)
+		return false;
+
+	ofstream out(filename);
+
+	if (!out.is_open()) {
+
+		cout << "Could not write timing report " << filename << endl;
+		return false;
+	}
+
+	const GUTimeHistogram& h = frameTimeLog->histogram;
+
+	const double percentiles[4] = { 50.0, 90.0, 99.0, 99.9 };
+	const char* percentileNames[4] = { "p50", "p90", "p99", "p99_9" };
+
+	bool json = (filename.size() >= 5 && filename.compare(filename.size() - 5, 5, ".json") == 0);
+
+	out.precision(6);
+	out << fixed;
+
+	if (json) {
+
+		out << "{\n";
+
+		if (!reportInfo.empty()) {
+
+			out << "  \"info\": {";
+			for (size_t i = 0; i < reportInfo.size(); ++i)
+				out << ((i > 0) ? ",\n    " : "\n    ") << "\"" << reportInfo[i].first << "\": \"" << guJsonEscape(reportInfo[i].second) << "\"";
+			out << "\n  },\n";
+		}
+
+		out << "  \"frames\": " << h.count() << ",\n";
+		out << "  \"average_fps\": " << ((h.mean() > 0.0) ? 1.0 / h.mean() : 0.0) << ",\n";
+		out << "  \"frame_time_ms\": { \"mean\": " << h.mean() * 1000.0 << ", \"min\": " << h.minimum() * 1000.0 << ", \"max\": " << h.maximum() * 1000.0;
+
+		for (int i = 0; i < 4; ++i)
+			out << ", \"" << percentileNames[i] << "\": " << h.percentile(percentiles[i]) * 1000.0;
+
+		out << " },\n";
+		out << "  \"stutters\": " << frameTimeLog->stutters << ",\n";
+
+		out << "  \"frames_over_budget\": [";
+		for (int i = 0; i < 3; ++i)
+			out << ((i > 0) ? ", " : " ") << "{ \"budget_ms\": " << reportBudgets[i] * 1000.0 << ", \"frames\": " << h.countAbove(reportBudgets[i]) << " }";
+		out << " ],\n";
+
+		out << "  \"windows\": [";
+		for (int i = 0; i < GUFrameTimeLog::numWindows; ++i) {
+
+			GUFrameTimeWindow w = frameTimeLog->window(reportWindows[i]);
+			out << ((i > 0) ? ", " : " ") << "{ \"seconds\": " << w.windowLength << ", \"frames\": " << w.frames << ", \"mean_ms\": " << w.mean * 1000.0 << ", \"p50_ms\": " << w.p50 * 1000.0 << ", \"p99_ms\": " << w.p99 * 1000.0 << ", \"max_ms\": " << w.maximum * 1000.0 << " }";
+		}
+		out << " ],\n";
+
+		out << "  \"series\": [";
+		for (size_t i = 0; i < timingSeries.size(); ++i) {
+
+			const GUTimeHistogram& sh = *timingSeries[i].second;
+
+			out << ((i > 0) ? ",\n    " : "\n    ") << "{ \"name\": \"" << guJsonEscape(timingSeries[i].first) << "\", \"samples\": " << sh.count() << ", \"mean_ms\": " << sh.mean() * 1000.0 << ", \"max_ms\": " << sh.maximum() * 1000.0;
+
+			for (int p = 0; p < 4; ++p)
+				out << ", \"" << percentileNames[p] << "_ms\": " << sh.percentile(percentiles[p]) * 1000.0;
+
+			out << " }";
+		}
+		out << ((timingSeries.empty()) ? " ],\n" : "\n  ],\n");
+
+		out << "  \"counters\": {";
+		for (size_t i = 0; i < reportCounters.size(); ++i)
+			out << ((i > 0) ? ",\n    " : "\n    ") << "\"" << guJsonEscape(reportCounters[i].first) << "\": " << reportCounters[i].second;
+		out << ((reportCounters.empty()) ? " },\n" : "\n  },\n");
+
+		out << "  \"histogram\": [";
+		bool first = true;
+		h.forEachBucket([&](gu_seconds low, gu_seconds high, uint64_t count) {
+
+			out << ((first) ? " " : ", ") << "[" << low * 1000.0 << ", " << high * 1000.0 << ", " << count << "]";
+			first = false;
+		});
+		out << " ]\n";
+		out << "}\n";
+	}
+	else {
+
+		out << "section,name,value\n";
+
+		for (const pair<string, string>& info : reportInfo)
+			out << "info," << info.first << "," << csvQuote(info.second) << "\n";
+
+		out << "summary,frames," << h.count() << "\n";
+		out << "summary,average_fps," << ((h.mean() > 0.0) ? 1.0 / h.mean() : 0.0) << "\n";
+		out << "frame_time_ms,mean," << h.mean() * 1000.0 << "\n";
+		out << "frame_time_ms,min," << h.minimum() * 1000.0 << "\n";
+		out << "frame_time_ms,max," << h.maximum() * 1000.0 << "\n";
+
+		for (int i = 0; i < 4; ++i)
+			out << "frame_time_ms," << percentileNames[i] << "," << h.percentile(percentiles[i]) * 1000.0 << "\n";
+
+		out << "summary,stutters," << frameTimeLog->stutters << "\n";
+
+		for (gu_seconds budget : reportBudgets)
+			out << "frames_over_budget_ms," << budget * 1000.0 << "," << h.countAbove(budget) << "\n";
+
+		for (gu_seconds length : reportWindows) {
+
+			GUFrameTimeWindow w = frameTimeLog->window(length);
+			string section = "window_" + to_string((int)length) + "s";
+
+			out << section << ",frames," << w.frames << "\n";
+			out << section << ",mean_ms," << w.mean * 1000.0 << "\n";
+			out << section << ",p50_ms," << w.p50 * 1000.0 << "\n";
+			out << section << ",p99_ms," << w.p99 * 1000.0 << "\n";
+			out << section << ",max_ms," << w.maximum * 1000.0 << "\n";
+		}
+
+		for (const pair<string, const GUTimeHistogram*>& series : timingSeries) {
+
+			const GUTimeHistogram& sh = *series.second;
+			string section = "series_" + series.first;
+
+			out << section << ",samples," << sh.count() << "\n";
+			out << section << ",mean_ms," << sh.mean() * 1000.0 << "\n";
+			out << section << ",max_ms," << sh.maximum() * 1000.0 << "\n";
+
+			for (int p = 0; p < 4; ++p)
+				out << section << "," << percentileNames[p] << "_ms," << sh.percentile(percentiles[p]) * 1000.0 << "\n";
+		}
+
+		for (const pair<string, double>& counter : reportCounters)
+			out << "counters," << counter.first << "," << counter.second << "\n";
+
+		h.forEachBucket([&](gu_seconds low, gu_seconds high, uint64_t count) {
+
+			out << "histogram_ms," << low * 1000.0 << "-" << high * 1000.0 << "," << count << "\n";
+		});
+	}
+
+	return true;
+}
+
+
+
+// Function implementation
+
+string guJsonEscape(const string& s) {
+
+	string result;
+
+	for (char c : s) {
+
+		if (c == '"' || c == '\\')
+			result += '\\';
+
+		if ((unsigned char)c >= 0x20)
+			result += c;
+	}
+
+	return result;
+}
@@ -1,18 +1,31 @@
 #pragma once
 
 #include "core.h"
+#include "GUClockSource.h"
 
-typedef __int64 gu_time_index;
-typedef __int64 gu_time_interval;
+typedef int64_t gu_time_index;
+typedef int64_t gu_time_interval;
 typedef double gu_seconds;
 
 class GUFrameCounter;
+class GUFrameTimeLog;
+class GUTimeHistogram;
+
+
+// Frame time statistics over the frames in the most recent windowLength seconds
+struct GUFrameTimeWindow {
+
+	gu_seconds				windowLength;
+	int						frames;
+	gu_seconds				mean, p50, p99, maximum;
+};
+
 
 class GUClock {
 
 private:
 
-	__int64					performanceFrequency;
+	gu_time_index			performanceFrequency; // GUClockSource ticks per second
 	gu_seconds				timeRecip;
 
 	gu_time_index			baseTime;
@@ -27,6 +40,14 @@ private:
 	bool					_clockStopped;
 
 	GUFrameCounter* frameCounter;
+	GUFrameTimeLog* frameTimeLog; // every frame delta - ring buffer, histogram and stutter counts
+
+	// Additional timing series (eg. per pass GPU times) included in the timing report.  The histograms are owned elsewhere and must outlive the report
+	std::vector<std::pair<std::string, const GUTimeHistogram*> > timingSeries;
+
+	// Named values (eg. render statistics) and descriptive strings (eg. the renderer) written with the timing report
+	std::vector<std::pair<std::string, double> > reportCounters;
+	std::vector<std::pair<std::string, std::string> > reportInfo;
 
 
 	//
@@ -78,4 +99,35 @@ public:
 	gu_seconds maximumSPF() const;
 	gu_seconds averageSPF() const;
 
+
+	// frame time distribution queries.  Every tick() after the first is recorded (the first delta measures start-up rather than a frame)
+
+	gu_seconds frameTimePercentile(double p) const;
+	uint64_t framesLongerThan(gu_seconds t) const;
+
+	// Frames that took more than twice the smoothed frame time of the frames before them
+	uint64_t stutterCount() const;
+
+	// Statistics for the most recent frames (limited to the ring buffer capacity)
+	GUFrameTimeWindow rollingWindow(gu_seconds windowLength) const;
+
+	// Copy up to maxCount of the most recent frame times (seconds, oldest first) into times
+	size_t recentFrameTimes(std::vector<float>& times, size_t maxCount) const;
+
+	const GUTimeHistogram* frameTimeHistogram() const;
+
+	// Add a named histogram to reportTimingData and exportTimingReport
+	void addTimingSeries(const std::string& name, const GUTimeHistogram* histogram);
+
+	// Set a named value to include in exportTimingReport - setting an existing name replaces its value
+	void setReportCounter(const std::string& name, double value);
+	void setReportInfo(const std::string& name, const std::string& value);
+
+	// Write the timing report to filename as JSON if it ends in .json, otherwise as CSV.  Returns false if the file cannot be written
+	bool exportTimingReport(const std::string& filename) const;
+
 };
+
+
+// Escape s for use as a JSON string value (quotes and backslashes escaped, control characters dropped).  Shared by the timing report and the benchmark results writers
+std::string guJsonEscape(const std::string& s);
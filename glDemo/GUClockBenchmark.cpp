@@ -0,0 +1,90 @@
+#include "GUClockBenchmark.h"
+#include "GUClock.h"
+
+using namespace std;
+
+
+// Time numCalls back to back calls of Source::now() and find the smallest non-zero step between consecutive readings
+template <typename Source>
+static void benchmarkSource(const char* name, int numCalls) {
+
+	int64_t frequency = Source::frequency();
+	int64_t smallestStep = INT64_MAX;
+	int64_t checksum = 0;
+
+	int64_t prev = Source::now();
+	int64_t start = GUBaseClockSource::now();
+
+	for (int i = 0; i < numCalls; ++i) {
+
+		int64_t t = Source::now();
+		int64_t step = t - prev;
+
+		if (step > 0 && step < smallestStep)
+			smallestStep = step;
+
+		checksum += step;
+		prev = t;
+	}
+
+	int64_t end = GUBaseClockSource::now();
+
+	double elapsed = (double)(end - start) / (double)GUBaseClockSource::frequency();
+
+	printf("%-28s %8.2f ns/call, resolution %10.2f ns, frequency %lld Hz (checksum %lld)\n",
+		name,
+		elapsed * 1.0e9 / (double)numCalls,
+		(smallestStep == INT64_MAX) ? 0.0 : (double)smallestStep * 1.0e9 / (double)frequency,
+		(long long)frequency,
+		(long long)(checksum & 0xFF));
+}
+
+
+static void benchmarkGUClock(int numCalls) {
+
+	GUClock clock;
+
+	gu_seconds sum = 0.0;
+	int64_t start = GUBaseClockSource::now();
+
+	for (int i = 0; i < numCalls; ++i)
+		sum += clock.gameTimeElapsed();
+
+	int64_t end = GUBaseClockSource::now();
+
+	double elapsed = (double)(end - start) / (double)GUBaseClockSource::frequency();
+
+	printf("%-28s %8.2f ns/call (checksum %.0f)\n", "GUClock::gameTimeElapsed", elapsed * 1.0e9 / (double)numCalls, fmod(sum, 256.0));
+
+	start = GUBaseClockSource::now();
+
+	for (int i = 0; i < numCalls; ++i)
+		clock.tick();
+
+	end = GUBaseClockSource::now();
+
+	elapsed = (double)(end - start) / (double)GUBaseClockSource::frequency();
+
+	printf("%-28s %8.2f ns/call\n", "GUClock::tick", elapsed * 1.0e9 / (double)numCalls);
+}
+
+
+void runClockBenchmark() {
+
+	const int numCalls = 10000000;
+
+	cout << "Clock source benchmark (" << numCalls << " calls each)\n";
+
+#ifdef _WIN32
+	benchmarkSource<GUPerformanceCounterSource>("QueryPerformanceCounter", numCalls);
+#else
+	benchmarkSource<GUMonotonicRawSource>("clock_gettime (MONOTONIC_RAW)", numCalls);
+#endif
+
+#ifdef GU_CLOCK_HAS_TSC
+	GUTimeStampCounterSource::frequency(); // calibrate before timing
+	benchmarkSource<GUTimeStampCounterSource>("rdtsc (calibrated)", numCalls);
+#endif
+
+	benchmarkGUClock(numCalls);
+}
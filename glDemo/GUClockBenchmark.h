@@ -0,0 +1,4 @@
+#pragma once
+
+// Measure the per-call overhead and observed resolution of each clock source available on this platform, and of GUClock's query methods
+void runClockBenchmark();
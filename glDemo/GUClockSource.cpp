@@ -0,0 +1,37 @@
+#include "GUClockSource.h"
+
+#ifdef GU_CLOCK_HAS_TSC
+
+// Count TSC ticks over a short busy-wait timed by the base clock.  The function-local static is initialised once, thread-safely
+static int64_t calibrateTimeStampCounter() {
+
+	const double calibrationTime = 0.05; // seconds
+
+	const int64_t baseFrequency = GUBaseClockSource::frequency();
+	const int64_t waitTicks = (int64_t)(calibrationTime * (double)baseFrequency);
+
+	int64_t baseStart = GUBaseClockSource::now();
+	int64_t tscStart = GUTimeStampCounterSource::now();
+
+	int64_t baseEnd;
+
+	do {
+
+		baseEnd = GUBaseClockSource::now();
+
+	} while (baseEnd - baseStart < waitTicks);
+
+	int64_t tscEnd = GUTimeStampCounterSource::now();
+
+	return (int64_t)((double)(tscEnd - tscStart) * (double)baseFrequency / (double)(baseEnd - baseStart));
+}
+
+
+int64_t GUTimeStampCounterSource::frequency() {
+
+	static const int64_t tscFrequency = calibrateTimeStampCounter();
+
+	return tscFrequency;
+}
+
+#endif
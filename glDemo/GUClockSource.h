@@ -0,0 +1,123 @@
+#pragma once
+
+//
+// Time source policies for GUClock and scoped timers.  Each source provides static now() (ticks) and frequency() (ticks per second) functions, so code templated on a source pays no virtual call overhead.
+//
+// GUClockSource is the source used by GUClock, chosen at compile time - QueryPerformanceCounter on Windows and clock_gettime(CLOCK_MONOTONIC_RAW) elsewhere, or the calibrated time stamp counter if GU_CLOCK_USE_TSC is defined.
+//
+
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define GU_CLOCK_HAS_TSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+
+#ifdef _WIN32
+
+// Windows high-performance counter
+struct GUPerformanceCounterSource {
+
+	static int64_t now() {
+
+		LARGE_INTEGER t;
+		QueryPerformanceCounter(&t);
+
+		return (int64_t)t.QuadPart;
+	}
+
+	static int64_t frequency() {
+
+		LARGE_INTEGER f;
+		QueryPerformanceFrequency(&f);
+
+		return (int64_t)f.QuadPart;
+	}
+};
+
+typedef GUPerformanceCounterSource GUBaseClockSource;
+
+#else
+
+// POSIX monotonic clock in nanoseconds.  CLOCK_MONOTONIC_RAW is not slewed by NTP so short intervals are not stretched or shrunk while the system clock is being corrected
+struct GUMonotonicRawSource {
+
+	static int64_t now() {
+
+		timespec t;
+
+#ifdef CLOCK_MONOTONIC_RAW
+		clock_gettime(CLOCK_MONOTONIC_RAW, &t);
+#else
+		clock_gettime(CLOCK_MONOTONIC, &t);
+#endif
+
+		return (int64_t)t.tv_sec * 1000000000ll + (int64_t)t.tv_nsec;
+	}
+
+	static int64_t frequency() {
+
+		return 1000000000ll;
+	}
+};
+
+typedef GUMonotonicRawSource GUBaseClockSource;
+
+#endif
+
+
+#ifdef GU_CLOCK_HAS_TSC
+
+// CPU time stamp counter - a single instruction, so much cheaper than the OS clocks for fine grained scoped timing.  The frequency is calibrated once against GUBaseClockSource on first use.  This assumes an invariant TSC (constant rate, synchronised across cores), which holds on all x86 CPUs from the last decade
+struct GUTimeStampCounterSource {
+
+	static int64_t now() {
+
+		return (int64_t)__rdtsc();
+	}
+
+	static int64_t frequency();
+};
+
+#endif
+
+
+#if defined(GU_CLOCK_USE_TSC) && defined(GU_CLOCK_HAS_TSC)
+typedef GUTimeStampCounterSource GUClockSource;
+#else
+typedef GUBaseClockSource GUClockSource;
+#endif
+
+
+// Measure the time taken by the enclosing scope with Source and add it (in seconds) to result when the scope ends
+template <typename Source = GUClockSource>
+class GUScopedTimer {
+
+private:
+
+	double&					result;
+	int64_t					startTime;
+
+public:
+
+	GUScopedTimer(double& result) : result(result) {
+
+		startTime = Source::now();
+	}
+
+	~GUScopedTimer() {
+
+		result += (double)(Source::now() - startTime) / (double)Source::frequency();
+	}
+};
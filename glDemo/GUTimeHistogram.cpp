@@ -0,0 +1,187 @@
+#include "GUTimeHistogram.h"
+#include <algorithm>
+
+using namespace std;
+
+
+// Static member definitions
+const int GUTimeHistogram::subBucketBits;
+const uint64_t GUTimeHistogram::subBucketCount;
+const uint64_t GUTimeHistogram::subBucketHalfCount;
+
+
+// Index of the highest set bit (value must be non-zero)
+static int highestBit(uint64_t value) {
+
+	int bit = 0;
+
+	while (value >>= 1)
+		bit++;
+
+	return bit;
+}
+
+
+
+// Private method implementation
+
+size_t GUTimeHistogram::bucketIndex(uint64_t value) const {
+
+	if (value < subBucketCount)
+		return (size_t)value;
+
+	// value >> shift lies in [64, 128) - each power of two above 128us adds another 64 buckets
+	int shift = highestBit(value) - (subBucketBits - 1);
+
+	return (size_t)(shift * subBucketHalfCount + (value >> shift));
+}
+
+
+uint64_t GUTimeHistogram::bucketLowestValue(size_t index) const {
+
+	if (index < subBucketCount)
+		return index;
+
+	int shift = (int)(index / subBucketHalfCount) - 1;
+	uint64_t subBucket = index - shift * subBucketHalfCount;
+
+	return subBucket << shift;
+}
+
+
+uint64_t GUTimeHistogram::bucketHighestValue(size_t index) const {
+
+	if (index < subBucketCount)
+		return index;
+
+	int shift = (int)(index / subBucketHalfCount) - 1;
+	uint64_t subBucket = index - shift * subBucketHalfCount;
+
+	return ((subBucket + 1) << shift) - 1;
+}
+
+
+
+// Public method implementation
+
+GUTimeHistogram::GUTimeHistogram(gu_seconds highestTrackableTime) {
+
+	highestTrackable = std::max<uint64_t>((uint64_t)(highestTrackableTime * 1.0e6), subBucketCount);
+	counts.assign(bucketIndex(highestTrackable) + 1, 0);
+
+	reset();
+}
+
+
+void GUTimeHistogram::record(gu_seconds t) {
+
+	uint64_t value = (t > 0.0) ? (uint64_t)(t * 1.0e6 + 0.5) : 0;
+
+	if (value > highestTrackable)
+		value = highestTrackable;
+
+	counts[bucketIndex(value)]++;
+
+	if (totalCount == 0) {
+
+		minValue = maxValue = value;
+	}
+	else {
+
+		minValue = std::min<uint64_t>(minValue, value);
+		maxValue = std::max<uint64_t>(maxValue, value);
+	}
+
+	totalCount++;
+	sum += t;
+}
+
+
+// h must have been created with the same highestTrackableTime
+void GUTimeHistogram::merge(const GUTimeHistogram& h) {
+
+	if (h.totalCount == 0 || h.counts.size() != counts.size())
+		return;
+
+	for (size_t i = 0; i < counts.size(); ++i)
+		counts[i] += h.counts[i];
+
+	minValue = (totalCount == 0) ? h.minValue : std::min<uint64_t>(minValue, h.minValue);
+	maxValue = (totalCount == 0) ? h.maxValue : std::max<uint64_t>(maxValue, h.maxValue);
+
+	totalCount += h.totalCount;
+	sum += h.sum;
+}
+
+
+void GUTimeHistogram::reset() {
+
+	std::fill(counts.begin(), counts.end(), 0);
+
+	totalCount = 0;
+	minValue = maxValue = 0;
+	sum = 0.0;
+}
+
+
+uint64_t GUTimeHistogram::count() const {
+
+	return totalCount;
+}
+
+
+gu_seconds GUTimeHistogram::minimum() const {
+
+	return (gu_seconds)minValue * 1.0e-6;
+}
+
+
+gu_seconds GUTimeHistogram::maximum() const {
+
+	return (gu_seconds)maxValue * 1.0e-6;
+}
+
+
+gu_seconds GUTimeHistogram::mean() const {
+
+	return (totalCount > 0) ? sum / (gu_seconds)totalCount : 0.0;
+}
+
+
+gu_seconds GUTimeHistogram::percentile(double p) const {
+
+	if (totalCount == 0)
+		return 0.0;
+
+	p = std::min<double>(std::max<double>(p, 0.0), 100.0);
+
+	// Rank of the sample at percentile p (1-based, rounded up)
+	uint64_t rank = std::max<uint64_t>((uint64_t)ceil(p * 0.01 * (double)totalCount), 1);
+	uint64_t seen = 0;
+
+	for (size_t i = 0; i < counts.size(); ++i) {
+
+		seen += counts[i];
+
+		if (seen >= rank)
+			return (gu_seconds)std::min<uint64_t>(bucketHighestValue(i), maxValue) * 1.0e-6;
+	}
+
+	return maximum();
+}
+
+
+uint64_t GUTimeHistogram::countAbove(gu_seconds t) const {
+
+	uint64_t value = (t > 0.0) ? (uint64_t)(t * 1.0e6) : 0;
+
+	if (value >= highestTrackable)
+		return 0;
+
+	uint64_t result = 0;
+
+	for (size_t i = bucketIndex(value) + 1; i < counts.size(); ++i)
+		result += counts[i];
+
+	return result;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "GUClock.h"
+
+// High dynamic range (log-linear) histogram of time intervals.  Intervals are recorded in whole microseconds - values below 128us get their own bucket and above that each power of two is split into 64 linear sub-buckets, so any recorded value is reported to within 1/64 (about 1.6%) regardless of magnitude.  Recording is O(1) with no allocation so it can be used every frame.
+
+class GUTimeHistogram {
+
+private:
+
+	static const int				subBucketBits = 7;
+	static const uint64_t			subBucketCount = 1ull << subBucketBits; // 128
+	static const uint64_t			subBucketHalfCount = subBucketCount >> 1; // 64
+
+	std::vector<uint64_t>			counts;
+
+	uint64_t						totalCount;
+	uint64_t						minValue, maxValue; // microseconds
+	double							sum; // seconds
+	uint64_t						highestTrackable; // microseconds - larger values are clamped
+
+
+	//
+	// Private API
+	//
+
+	size_t bucketIndex(uint64_t value) const;
+	uint64_t bucketLowestValue(size_t index) const;
+	uint64_t bucketHighestValue(size_t index) const;
+
+
+public:
+
+	GUTimeHistogram(gu_seconds highestTrackableTime = 3600.0);
+
+	void record(gu_seconds t);
+	void merge(const GUTimeHistogram& h);
+	void reset();
+
+	uint64_t count() const;
+	gu_seconds minimum() const;
+	gu_seconds maximum() const;
+	gu_seconds mean() const;
+
+	// Time at or below which p percent (0 - 100) of the recorded intervals fall.  Returns the upper bound of the containing bucket so the result never under-reports
+	gu_seconds percentile(double p) const;
+
+	// Number of recorded intervals longer than t (to bucket precision)
+	uint64_t countAbove(gu_seconds t) const;
+
+	// Visit every non-empty bucket in ascending order with its range in seconds
+	template <typename Fn>
+	void forEachBucket(Fn fn) const {
+
+		for (size_t i = 0; i < counts.size(); ++i) {
+
+			if (counts[i] != 0)
+				fn((gu_seconds)bucketLowestValue(i) * 1.0e-6, (gu_seconds)(bucketHighestValue(i) + 1) * 1.0e-6, counts[i]);
+		}
+	}
+};
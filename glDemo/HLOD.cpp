@@ -0,0 +1,472 @@
+#include "HLOD.h"
+#include "AIMesh.h"
+#include "MeshSimplifier.h"
+#include "SpatialHash.h"
+#include "TextureLoader.h"
+#include "RenderStats.h"
+#include <algorithm>
+
+using namespace std;
+using namespace glm;
+
+
+// Fold a texture coordinate into [0, 1] the same way GL_MIRRORED_REPEAT samples it.  Atlas tiles cannot repeat, so this is done per vertex - triangles that span a repeat boundary are distorted but the proxy is only seen at a distance
+static float mirrorWrap(float t) {
+
+	t = fmodf(fabsf(t), 2.0f);
+
+	return (t > 1.0f) ? 2.0f - t : t;
+}
+
+
+// Private functions
+
+// Pack each texture into a square tile of a single atlas.  Missing textures leave their tile black
+GLuint HLODCluster::buildAtlas(const vector<string>& textureFiles, const vector<FREE_IMAGE_FORMAT>& textureFormats, int atlasSize, int tilesPerRow) {
+
+	const int tileSize = atlasSize / tilesPerRow;
+
+	FIBITMAP* atlas = FreeImage_Allocate(atlasSize, atlasSize, 32);
+
+	if (!atlas) {
+
+		cout << "HLOD: Could not allocate " << atlasSize << "x" << atlasSize << " texture atlas" << endl;
+		return 0;
+	}
+
+	for (size_t t = 0; t < textureFiles.size(); ++t) {
+
+		FIBITMAP* loadedBitmap = FreeImage_Load(textureFormats[t], textureFiles[t].c_str(), BMP_DEFAULT);
+
+		if (!loadedBitmap) {
+
+			cout << "HLOD: Could not load atlas image " << textureFiles[t] << endl;
+			continue;
+		}
+
+		FIBITMAP* bitmap32bpp = FreeImage_ConvertTo32Bits(loadedBitmap);
+		FreeImage_Unload(loadedBitmap);
+
+		if (!bitmap32bpp)
+			continue;
+
+		FIBITMAP* tile = FreeImage_Rescale(bitmap32bpp, tileSize, tileSize, FILTER_BILINEAR);
+		FreeImage_Unload(bitmap32bpp);
+
+		if (tile) {
+
+			// FreeImage_Paste measures top from the top of the image
+			int column = (int)t % tilesPerRow;
+			int row = (int)t / tilesPerRow;
+
+			FreeImage_Paste(atlas, tile, column * tileSize, row * tileSize, 256);
+			FreeImage_Unload(tile);
+		}
+	}
+
+	GLuint texture = createTexture(atlas);
+	FreeImage_Unload(atlas);
+
+	// Tiles must not bleed into each other through wrapping
+	if (texture) {
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	return texture;
+}
+
+
+bool HLODCluster::buildProxy(const vector<HLODSourceInstance>& instances, const HLODSourceScenes& sourceScenes, float simplifyRatio, int atlasSize) {
+
+	//
+	// 1. Atlas layout - one tile per unique diffuse texture
+	//
+
+	vector<string> textureFiles;
+	vector<FREE_IMAGE_FORMAT> textureFormats;
+	vector<int> memberTile(members.size(), -1);
+
+	for (size_t m = 0; m < members.size(); ++m) {
+
+		const AIMesh* mesh = instances[members[m]].mesh;
+
+		if (mesh->getTextureFilename().empty())
+			continue;
+
+		auto existing = find(textureFiles.begin(), textureFiles.end(), mesh->getTextureFilename());
+
+		if (existing == textureFiles.end()) {
+
+			textureFiles.push_back(mesh->getTextureFilename());
+			textureFormats.push_back(mesh->getTextureFormat());
+			memberTile[m] = (int)textureFiles.size() - 1;
+		}
+		else {
+
+			memberTile[m] = (int)(existing - textureFiles.begin());
+		}
+	}
+
+	const int tilesPerRow = std::max<int>(1, (int)ceilf(sqrtf((float)textureFiles.size())));
+	const float tileExtent = 1.0f / (float)tilesPerRow;
+	const float gutter = 1.0f / (float)atlasSize; // inset one texel so bilinear filtering stays inside the tile
+
+
+	//
+	// 2. Merge members into a single world space mesh
+	//
+
+	vector<vec3> positions;
+	vector<vec3> texCoords;
+	vector<vec3> normals;
+	vector<GLuint> indices;
+
+	for (size_t m = 0; m < members.size(); ++m) {
+
+		const HLODSourceInstance& instance = instances[members[m]];
+
+		HLODSourceScenes::const_iterator source = sourceScenes.find(instance.mesh->getSourceFilename());
+		const struct aiScene* scene = (source != sourceScenes.end()) ? source->second : nullptr;
+
+		if (!scene || instance.mesh->getSourceMeshIndex() >= scene->mNumMeshes) {
+
+			cout << "HLOD: Could not re-import " << instance.mesh->getSourceFilename() << endl;
+			return false;
+		}
+
+		const aiMesh* mesh = scene->mMeshes[instance.mesh->getSourceMeshIndex()];
+
+		const mat3 normalMatrix = transpose(inverse(mat3(instance.modelTransform)));
+		const GLuint baseVertex = (GLuint)positions.size();
+
+		// Tile rectangle in texture coordinates.  Rows are placed from the top of the atlas image but v = 0 is the bottom row of the uploaded texture
+		vec2 tileMin = vec2(0.0f, 0.0f);
+
+		if (memberTile[m] >= 0) {
+
+			int column = memberTile[m] % tilesPerRow;
+			int row = memberTile[m] / tilesPerRow;
+
+			tileMin = vec2((float)column * tileExtent, 1.0f - (float)(row + 1) * tileExtent);
+		}
+
+		for (unsigned int v = 0; v < mesh->mNumVertices; ++v) {
+
+			vec3 p = vec3(mesh->mVertices[v].x, mesh->mVertices[v].y, mesh->mVertices[v].z);
+			positions.push_back(vec3(instance.modelTransform * vec4(p, 1.0f)));
+
+			vec3 n = (mesh->mNormals) ? vec3(mesh->mNormals[v].x, mesh->mNormals[v].y, mesh->mNormals[v].z) : vec3(0.0f, 1.0f, 0.0f);
+			normals.push_back(normalize(normalMatrix * n));
+
+			vec2 uv = vec2(0.0f, 0.0f);
+
+			if (mesh->mTextureCoords[0])
+				uv = vec2(mirrorWrap(mesh->mTextureCoords[0][v].x), mirrorWrap(mesh->mTextureCoords[0][v].y));
+
+			uv = tileMin + vec2(gutter, gutter) + uv * (tileExtent - 2.0f * gutter);
+			texCoords.push_back(vec3(uv, 0.0f));
+		}
+
+		for (unsigned int f = 0; f < mesh->mNumFaces; ++f) {
+
+			if (mesh->mFaces[f].mNumIndices != 3)
+				continue;
+
+			indices.push_back(baseVertex + mesh->mFaces[f].mIndices[0]);
+			indices.push_back(baseVertex + mesh->mFaces[f].mIndices[1]);
+			indices.push_back(baseVertex + mesh->mFaces[f].mIndices[2]);
+		}
+	}
+
+	if (indices.empty())
+		return false;
+
+
+	//
+	// 3. Simplify and drop vertices no longer referenced
+	//
+
+	size_t targetIndexCount = (size_t)((float)(indices.size() / 3) * simplifyRatio) * 3;
+	vector<GLuint> simplified = simplifyMesh(positions, indices, targetIndexCount);
+
+	vector<GLuint> vertexRemap(positions.size(), 0xFFFFFFFF);
+	vector<vec3> outPositions, outTexCoords, outNormals;
+
+	for (GLuint& i : simplified) {
+
+		if (vertexRemap[i] == 0xFFFFFFFF) {
+
+			vertexRemap[i] = (GLuint)outPositions.size();
+
+			outPositions.push_back(positions[i]);
+			outTexCoords.push_back(texCoords[i]);
+			outNormals.push_back(normals[i]);
+		}
+
+		i = vertexRemap[i];
+	}
+
+	numIndices = (GLuint)simplified.size();
+
+
+	//
+	// 4. Upload - attribute locations match AIMesh
+	//
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+
+	glGenBuffers(1, &positionBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+	glBufferData(GL_ARRAY_BUFFER, outPositions.size() * sizeof(vec3), outPositions.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
+	glEnableVertexAttribArray(0);
+
+	glGenBuffers(1, &texCoordBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, texCoordBuffer);
+	glBufferData(GL_ARRAY_BUFFER, outTexCoords.size() * sizeof(vec3), outTexCoords.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
+	glEnableVertexAttribArray(2);
+
+	glGenBuffers(1, &normalBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
+	glBufferData(GL_ARRAY_BUFFER, outNormals.size() * sizeof(vec3), outNormals.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
+	glEnableVertexAttribArray(3);
+
+	glGenBuffers(1, &indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, simplified.size() * sizeof(GLuint), simplified.data(), GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+
+	GURenderStats::countBufferUpload((outPositions.size() + outTexCoords.size() + outNormals.size()) * sizeof(vec3) + simplified.size() * sizeof(GLuint));
+
+	atlasTexture = buildAtlas(textureFiles, textureFormats, atlasSize, tilesPerRow);
+
+	return true;
+}
+
+
+
+// Public functions
+
+HLODCluster::HLODCluster(const vector<HLODSourceInstance>& instances, const HLODSourceScenes& sourceScenes, const vector<uint32_t>& members, float swapDistance, float simplifyRatio, int atlasSize) {
+
+	this->members = members;
+	this->swapDistance = swapDistance;
+
+	for (uint32_t m : members)
+		bounds.expand(instances[m].mesh->getBoundingBox().transformed(instances[m].modelTransform));
+
+	if (!buildProxy(instances, sourceScenes, simplifyRatio, atlasSize))
+		numIndices = 0;
+}
+
+
+HLODCluster::~HLODCluster() {
+
+	if (atlasTexture)
+		glDeleteTextures(1, &atlasTexture);
+
+	glDeleteBuffers(1, &positionBuffer);
+	glDeleteBuffers(1, &texCoordBuffer);
+	glDeleteBuffers(1, &normalBuffer);
+	glDeleteBuffers(1, &indexBuffer);
+	glDeleteVertexArrays(1, &vao);
+}
+
+
+bool HLODCluster::isValid() const {
+
+	return numIndices > 0;
+}
+
+
+const vector<uint32_t>& HLODCluster::getMembers() const {
+
+	return members;
+}
+
+
+AABB HLODCluster::getBoundingBox() const {
+
+	return bounds;
+}
+
+
+GLuint HLODCluster::proxyTriangleCount() const {
+
+	return numIndices / 3;
+}
+
+
+bool HLODCluster::updateProxySelection(const vec3& cameraPos) {
+
+	if (!isValid()) {
+
+		proxyActive = false;
+		return false;
+	}
+
+	// Distance from the camera to the nearest point of the cluster bounds
+	vec3 nearest = glm::clamp(cameraPos, bounds.min, bounds.max);
+	float distance = glm::length(cameraPos - nearest);
+
+	if (proxyActive)
+		proxyActive = (distance > swapDistance * 0.9f);
+	else
+		proxyActive = (distance > swapDistance);
+
+	return proxyActive;
+}
+
+
+bool HLODCluster::isProxyActive() const {
+
+	return proxyActive;
+}
+
+
+void HLODCluster::setupTextures() {
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, atlasTexture);
+
+	GURenderStats::countTextureBind();
+}
+
+
+void HLODCluster::render() {
+
+	glBindVertexArray(vao);
+	glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, (const GLvoid*)0);
+
+	GURenderStats::countVAOBind();
+	GURenderStats::countDraw(numIndices);
+}
+
+
+GUDrawCommand HLODCluster::drawCommand() const {
+
+	GUDrawCommand command;
+
+	command.modelTransform = identity<mat4>();
+	command.vertexArray = vao;
+	command.texture = atlasTexture;
+	command.normalMap = 0;
+	command.indexOffset = 0;
+	command.indexCount = numIndices;
+	command.meshlets = nullptr;
+
+	return command;
+}
+
+
+
+// HLOD build step
+
+vector<HLODCluster*> buildHLODClusters(const vector<HLODSourceInstance>& instances, float maxClusterExtent, float swapDistance) {
+
+	vector<HLODCluster*> clusters;
+
+	// Candidate instances - must have a source file to re-import and fit within a cluster on their own
+	SpatialHash candidateHash(maxClusterExtent * 0.25f, 1024);
+	vector<AABB> worldBounds(instances.size());
+	vector<uint8_t> assigned(instances.size(), 1);
+	HLODSourceScenes sourceScenes;
+
+	for (size_t i = 0; i < instances.size(); ++i) {
+
+		worldBounds[i] = instances[i].mesh->getBoundingBox().transformed(instances[i].modelTransform);
+
+		if (instances[i].mesh->getSourceFilename().empty() || worldBounds[i].isEmpty())
+			continue;
+
+		if (glm::length(worldBounds[i].max - worldBounds[i].min) > maxClusterExtent)
+			continue;
+
+		candidateHash.insert(worldBounds[i], SpatialHash::StaticLayer, (uint32_t)i);
+		assigned[i] = 0;
+
+		// Many instances share a few source files (eg. a generated city) - import each one once
+		const string& filename = instances[i].mesh->getSourceFilename();
+
+		if (sourceScenes.find(filename) == sourceScenes.end())
+			sourceScenes[filename] = AIMesh::importFile(filename);
+	}
+
+	vector<SpatialHash::ProxyID> nearby;
+
+	for (size_t seed = 0; seed < instances.size(); ++seed) {
+
+		if (assigned[seed])
+			continue;
+
+		// Gather unassigned neighbours within reach of the seed, nearest first
+		vec3 seedCentre = worldBounds[seed].centre();
+		vec3 reach = vec3(maxClusterExtent, maxClusterExtent, maxClusterExtent);
+
+		nearby.clear();
+		candidateHash.query(AABB(seedCentre - reach, seedCentre + reach), SpatialHash::AllLayers, nearby);
+
+		vector<uint32_t> neighbours;
+
+		for (SpatialHash::ProxyID id : nearby) {
+
+			uint32_t i = candidateHash.userData(id);
+
+			if (!assigned[i] && i != (uint32_t)seed)
+				neighbours.push_back(i);
+		}
+
+		sort(neighbours.begin(), neighbours.end(), [&](uint32_t a, uint32_t b) {
+
+			return glm::length(worldBounds[a].centre() - seedCentre) < glm::length(worldBounds[b].centre() - seedCentre);
+		});
+
+		vector<uint32_t> members;
+		members.push_back((uint32_t)seed);
+		assigned[seed] = 1;
+
+		AABB clusterBounds = worldBounds[seed];
+
+		for (uint32_t i : neighbours) {
+
+			AABB merged = clusterBounds;
+			merged.expand(worldBounds[i]);
+
+			if (glm::length(merged.max - merged.min) <= maxClusterExtent) {
+
+				members.push_back(i);
+				assigned[i] = 1;
+				clusterBounds = merged;
+			}
+		}
+
+		if (members.size() < 2)
+			continue;
+
+		HLODCluster* cluster = new HLODCluster(instances, sourceScenes, members, swapDistance);
+
+		if (cluster->isValid()) {
+
+			cout << "HLOD: cluster of " << members.size() << " instances -> " << cluster->proxyTriangleCount() << " triangles" << endl;
+			clusters.push_back(cluster);
+		}
+		else {
+
+			delete cluster;
+		}
+	}
+
+	for (const pair<const string, const struct aiScene*>& source : sourceScenes) {
+
+		if (source.second)
+			aiReleaseImport(source.second);
+	}
+
+	return clusters;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "core.h"
+#include "AABB.h"
+#include "CommandBuffer.h"
+
+class AIMesh;
+
+// Static (never moving) mesh instance that can be merged into a hierarchical LOD proxy
+struct HLODSourceInstance {
+
+	const AIMesh*		mesh;
+	glm::mat4			modelTransform;
+};
+
+// Scenes re-imported (with AIMesh::importFile) from each source file, keyed by filename.  Null for files that failed to import
+typedef std::map<std::string, const struct aiScene*> HLODSourceScenes;
+
+
+// A cluster of spatially close static instances and a single proxy mesh built from them.  The proxy merges every member into one world space mesh, packs the members' diffuse textures into one atlas and simplifies the result.  Beyond swapDistance the renderer draws the proxy (one draw call) in place of all member instances.
+//
+// The proxy only carries position, texture coordinate and normal data so it can be drawn with the texture-directional and texture-point shaders using an identity model matrix.
+
+class HLODCluster {
+
+	std::vector<uint32_t>	members; // indices into the source instance list
+	AABB					bounds; // world coordinate bounds of all members
+
+	GLuint					vao = 0;
+	GLuint					positionBuffer = 0;
+	GLuint					texCoordBuffer = 0;
+	GLuint					normalBuffer = 0;
+	GLuint					indexBuffer = 0;
+	GLuint					atlasTexture = 0;
+	GLuint					numIndices = 0;
+
+	float					swapDistance;
+	bool					proxyActive = false;
+
+	// Private functions
+	bool buildProxy(const std::vector<HLODSourceInstance>& instances, const HLODSourceScenes& sourceScenes, float simplifyRatio, int atlasSize);
+	GLuint buildAtlas(const std::vector<std::string>& textureFiles, const std::vector<FREE_IMAGE_FORMAT>& textureFormats, int atlasSize, int tilesPerRow);
+
+public:
+
+	// sourceScenes must hold the scene for every member's source file - it is only used while the proxy is built
+	HLODCluster(const std::vector<HLODSourceInstance>& instances, const HLODSourceScenes& sourceScenes, const std::vector<uint32_t>& members, float swapDistance, float simplifyRatio = 0.25f, int atlasSize = 1024);
+	~HLODCluster();
+
+	bool isValid() const;
+
+	const std::vector<uint32_t>& getMembers() const;
+	AABB getBoundingBox() const;
+	GLuint proxyTriangleCount() const;
+
+	// Decide whether the proxy replaces the member instances for a camera at cameraPos.  The proxy is swapped back out 10% closer than it is swapped in so the cluster does not flicker at the threshold
+	bool updateProxySelection(const glm::vec3& cameraPos);
+	bool isProxyActive() const;
+
+	void setupTextures();
+	void render();
+
+	// Draw command equivalent to setupTextures followed by render (proxies are drawn with an identity model matrix)
+	GUDrawCommand drawCommand() const;
+};
+
+
+// Greedily group instances whose combined bounds fit within maxClusterExtent (the diagonal of the cluster bounds).  Instances that are larger than maxClusterExtent themselves (eg. terrain) are never clustered.  Only clusters with at least two members are built.  Each source file is re-imported once for all the clusters
+std::vector<HLODCluster*> buildHLODClusters(const std::vector<HLODSourceInstance>& instances, float maxClusterExtent, float swapDistance);
@@ -0,0 +1,391 @@
+#include "HeadlessPlatform.h"
+#include <cstring>
+#include <thread>
+#include <chrono>
+
+#if GU_PLATFORM_EGL
+#define EGL_NO_X11 // surfaceless - no X11 headers needed
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#if GU_PLATFORM_OSMESA
+#include <GL/osmesa.h>
+#endif
+
+using namespace std;
+
+
+// True if name is one of the space separated extensions in extensionList
+static bool hasExtension(const char* extensionList, const char* name) {
+
+	if (!extensionList)
+		return false;
+
+	size_t length = strlen(name);
+
+	for (const char* s = strstr(extensionList, name); s; s = strstr(s + length, name)) {
+
+		if ((s == extensionList || s[-1] == ' ') && (s[length] == ' ' || s[length] == '\0'))
+			return true;
+	}
+
+	return false;
+}
+
+
+
+// Private method implementation
+
+GUHeadlessPlatform::GUHeadlessPlatform(GUHeadlessBackend backend, int width, int height) {
+
+	this->backend = backend;
+	this->width = width;
+	this->height = height;
+	this->closeRequested = false;
+}
+
+
+bool GUHeadlessPlatform::createEGLContext(bool debugContext) {
+
+#if GU_PLATFORM_EGL
+
+	EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+
+	// Prefer Mesa's surfaceless platform - it needs neither a display server nor a GPU device.  Other drivers may still provide a default display without one
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+	if (getPlatformDisplay && hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+		eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+
+	if (eglDisplay == EGL_NO_DISPLAY)
+		eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major, minor;
+
+	if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &major, &minor)) {
+
+		cout << "EGL: Could not initialise a display\n";
+		return false;
+	}
+
+	display = eglDisplay;
+
+	if (!hasExtension(eglQueryString(eglDisplay, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) {
+
+		cout << "EGL: EGL_KHR_surfaceless_context not supported\n";
+		return false;
+	}
+
+	// Any surface type - the default (windows only) matches nothing on the surfaceless platform
+	const EGLint configAttribs[] = { EGL_SURFACE_TYPE, 0, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+
+	EGLConfig config;
+	EGLint numConfigs = 0;
+
+	if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(eglDisplay, configAttribs, &config, 1, &numConfigs) || numConfigs < 1) {
+
+		cout << "EGL: No desktop OpenGL config available\n";
+		return false;
+	}
+
+	// Same version and profile as the GLFW window
+	const EGLint contextAttribs[] = {
+
+		EGL_CONTEXT_MAJOR_VERSION_KHR, 4,
+		EGL_CONTEXT_MINOR_VERSION_KHR, 1,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT_KHR,
+		EGL_CONTEXT_FLAGS_KHR, (debugContext) ? EGL_CONTEXT_OPENGL_DEBUG_BIT_KHR : 0,
+		EGL_NONE
+	};
+
+	EGLContext eglContext = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttribs);
+
+	if (eglContext == EGL_NO_CONTEXT) {
+
+		cout << "EGL: Could not create an OpenGL 4.1 compatibility context (error 0x" << hex << eglGetError() << dec << ")\n";
+		return false;
+	}
+
+	context = eglContext;
+
+	if (!eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext)) {
+
+		cout << "EGL: Could not make the surfaceless context current\n";
+		return false;
+	}
+
+	return true;
+
+#else
+
+	cout << "Headless EGL rendering not built (GU_PLATFORM_EGL is 0)\n";
+	return false;
+
+#endif
+}
+
+
+bool GUHeadlessPlatform::createOSMesaContext(bool) {
+
+#if GU_PLATFORM_OSMESA
+
+	// OSMesa has no debug context flag - Mesa still reports debug output once GL_DEBUG_OUTPUT is enabled
+	const int attribs[] = {
+
+		OSMESA_FORMAT, OSMESA_RGBA,
+		OSMESA_DEPTH_BITS, 0,
+		OSMESA_PROFILE, OSMESA_COMPAT_PROFILE,
+		OSMESA_CONTEXT_MAJOR_VERSION, 4,
+		OSMESA_CONTEXT_MINOR_VERSION, 1,
+		0
+	};
+
+	OSMesaContext osContext = OSMesaCreateContextAttribs(attribs, NULL);
+
+	if (!osContext) {
+
+		cout << "OSMesa: Could not create an OpenGL 4.1 compatibility context\n";
+		return false;
+	}
+
+	context = osContext;
+
+	// Frames are rendered into the framebuffer object, never the context's own buffer, so that only needs to be 1x1
+	contextBuffer.resize(4);
+
+	if (!OSMesaMakeCurrent(osContext, contextBuffer.data(), GL_UNSIGNED_BYTE, 1, 1)) {
+
+		cout << "OSMesa: Could not make the context current\n";
+		return false;
+	}
+
+	return true;
+
+#else
+
+	cout << "Headless OSMesa rendering not built (GU_PLATFORM_OSMESA is 0)\n";
+	return false;
+
+#endif
+}
+
+
+void GUHeadlessPlatform::destroyContext() {
+
+#if GU_PLATFORM_EGL
+
+	if (backend == GUHeadlessBackend::EGL && display) {
+
+		eglMakeCurrent((EGLDisplay)display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+		if (context)
+			eglDestroyContext((EGLDisplay)display, (EGLContext)context);
+
+		eglTerminate((EGLDisplay)display);
+	}
+
+#endif
+
+#if GU_PLATFORM_OSMESA
+
+	if (backend == GUHeadlessBackend::OSMesa && context)
+		OSMesaDestroyContext((OSMesaContext)context);
+
+#endif
+
+	display = nullptr;
+	context = nullptr;
+}
+
+
+bool GUHeadlessPlatform::createFramebuffer() {
+
+	glGenRenderbuffers(1, &colourBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colourBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colourBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+
+		cout << "Headless: Framebuffer incomplete for " << width << "x" << height << " target" << endl;
+		return false;
+	}
+
+	// Left bound - this is the window from here on
+	glViewport(0, 0, width, height);
+
+	return true;
+}
+
+
+
+// Public method implementation
+
+GUHeadlessPlatform* GUHeadlessPlatform::create(GUHeadlessBackend backend, int width, int height, bool debugContext) {
+
+	GUHeadlessPlatform* platform = new GUHeadlessPlatform(backend, width, height);
+
+	bool created = (backend == GUHeadlessBackend::EGL) ? platform->createEGLContext(debugContext) : platform->createOSMesaContext(debugContext);
+
+	if (created) {
+
+		// A GLEW built for GLX finds the entry points but then fails to find an X display - the GLX extensions are not needed here so that is not an error
+		GLenum glewResult = glewInit();
+
+		if (glewResult != GLEW_OK && glewResult != GLEW_ERROR_NO_GLX_DISPLAY) {
+
+			cout << "GLEW: " << glewGetErrorString(glewResult) << endl;
+			created = false;
+		}
+	}
+
+	if (created)
+		created = platform->createFramebuffer();
+
+	if (!created) {
+
+		delete platform;
+		return nullptr;
+	}
+
+	return platform;
+}
+
+
+bool GUHeadlessPlatform::isBackendAvailable(GUHeadlessBackend backend) {
+
+	switch (backend) {
+
+		case GUHeadlessBackend::EGL: return GU_PLATFORM_EGL != 0;
+		case GUHeadlessBackend::OSMesa: return GU_PLATFORM_OSMESA != 0;
+		default: return false;
+	}
+}
+
+
+const char* GUHeadlessPlatform::backendName(GUHeadlessBackend backend) {
+
+	switch (backend) {
+
+		case GUHeadlessBackend::EGL: return "egl";
+		case GUHeadlessBackend::OSMesa: return "osmesa";
+		default: return "unknown";
+	}
+}
+
+
+GUHeadlessPlatform::~GUHeadlessPlatform() {
+
+	if (framebuffer) {
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteRenderbuffers(1, &colourBuffer);
+		glDeleteRenderbuffers(1, &depthBuffer);
+	}
+
+	destroyContext();
+}
+
+
+bool GUHeadlessPlatform::isHeadless() const {
+
+	return true;
+}
+
+
+bool GUHeadlessPlatform::shouldClose() const {
+
+	return closeRequested;
+}
+
+
+void GUHeadlessPlatform::requestClose() {
+
+	closeRequested = true;
+}
+
+
+void GUHeadlessPlatform::swapBuffers() {
+
+	// Nothing is presented, so nothing throttles the CPU - without waiting here the driver would queue frames without limit and CPU frame times would not include rendering
+	glFinish();
+}
+
+
+void GUHeadlessPlatform::pollEvents() {
+
+	// No window, no events
+}
+
+
+void GUHeadlessPlatform::waitEvents(double timeout) {
+
+	std::this_thread::sleep_for(std::chrono::duration<double>(timeout));
+}
+
+
+void GUHeadlessPlatform::makeContextCurrent(bool current) {
+
+#if GU_PLATFORM_EGL
+
+	if (backend == GUHeadlessBackend::EGL && display) {
+
+		if (current)
+			eglMakeCurrent((EGLDisplay)display, EGL_NO_SURFACE, EGL_NO_SURFACE, (EGLContext)context);
+		else
+			eglMakeCurrent((EGLDisplay)display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	}
+
+#endif
+
+#if GU_PLATFORM_OSMESA
+
+	// Mesa releases the current context when every argument is null
+	if (backend == GUHeadlessBackend::OSMesa && context) {
+
+		if (current)
+			OSMesaMakeCurrent((OSMesaContext)context, contextBuffer.data(), GL_UNSIGNED_BYTE, 1, 1);
+		else
+			OSMesaMakeCurrent(NULL, NULL, 0, 0, 0);
+	}
+
+#endif
+}
+
+
+void GUHeadlessPlatform::setTitle(const std::string&) {
+
+	// No window title to set
+}
+
+
+void GUHeadlessPlatform::setSwapInterval(int) {
+
+	// Frames are never presented so are never synchronised to a display
+}
+
+
+void GUHeadlessPlatform::framebufferSize(int& width, int& height) const {
+
+	width = this->width;
+	height = this->height;
+}
+
+
+GLuint GUHeadlessPlatform::defaultFramebuffer() const {
+
+	return framebuffer;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+//
+// Offscreen rendering with no display - for benchmarks, golden image tests and batch rendering on servers without a GPU (Mesa llvmpipe) or without a display server.  The OpenGL context comes from surfaceless EGL (EGL_MESA_platform_surfaceless / EGL_KHR_surfaceless_context) or from OSMesa, and frames are rendered into a framebuffer object (RGBA8 colour, 24 bit depth) that is left bound in place of the window.
+//
+// Each backend is a build option since it needs its own library - GU_PLATFORM_EGL (libEGL, on by default on Linux) and GU_PLATFORM_OSMESA (libOSMesa, off by default).  GLEW finds entry points through GLX unless built with GLEW_EGL or GLEW_OSMESA - that works for EGL contexts under GLVND, but OSMesa needs a GLEW built with GLEW_OSMESA.
+//
+
+#include "Platform.h"
+#include <atomic>
+
+#ifndef GU_PLATFORM_EGL
+#if defined(__linux__)
+#define GU_PLATFORM_EGL 1
+#else
+#define GU_PLATFORM_EGL 0
+#endif
+#endif
+
+#ifndef GU_PLATFORM_OSMESA
+#define GU_PLATFORM_OSMESA 0
+#endif
+
+
+enum class GUHeadlessBackend { EGL, OSMesa };
+
+
+class GUHeadlessPlatform : public GUPlatform {
+
+private:
+
+	GUHeadlessBackend		backend;
+
+	// Backend handles (EGLDisplay / EGLContext, or the OSMesaContext and the buffer it is bound to)
+	void*					display = nullptr;
+	void*					context = nullptr;
+	std::vector<uint8_t>	contextBuffer;
+
+	int						width = 0;
+	int						height = 0;
+
+	GLuint					framebuffer = 0;
+	GLuint					colourBuffer = 0;
+	GLuint					depthBuffer = 0;
+
+	std::atomic<bool>		closeRequested; // set by whichever thread renders
+
+	GUHeadlessPlatform(GUHeadlessBackend backend, int width, int height);
+
+	// Private functions
+	bool createEGLContext(bool debugContext);
+	bool createOSMesaContext(bool debugContext);
+	void destroyContext();
+	bool createFramebuffer();
+
+public:
+
+	// Create a width x height offscreen target with an OpenGL 4.1 compatibility context, make it current and initialise GLEW.  Returns nullptr if the backend was not built or no context could be created
+	static GUHeadlessPlatform* create(GUHeadlessBackend backend, int width, int height, bool debugContext);
+
+	// True if backend was built in (it may still fail at runtime, eg. if no EGL driver is installed)
+	static bool isBackendAvailable(GUHeadlessBackend backend);
+
+	static const char* backendName(GUHeadlessBackend backend);
+
+	~GUHeadlessPlatform();
+
+	bool isHeadless() const override;
+
+	bool shouldClose() const override;
+	void requestClose() override;
+
+	void swapBuffers() override;
+	void pollEvents() override;
+	void waitEvents(double timeout) override;
+	void makeContextCurrent(bool current) override;
+
+	void setTitle(const std::string& title) override;
+	void setSwapInterval(int interval) override;
+
+	void framebufferSize(int& width, int& height) const override;
+	GLuint defaultFramebuffer() const override;
+};
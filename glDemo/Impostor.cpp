@@ -0,0 +1,253 @@
+#include "Impostor.h"
+#include "AIMesh.h"
+#include "RenderStats.h"
+#include <glm/gtc/quaternion.hpp>
+
+using namespace std;
+using namespace glm;
+
+
+// Private functions
+
+bool OctahedralImpostor::bake(GLuint bakeShader) {
+
+	const int atlasSize = framesPerSide * frameResolution;
+
+	// Atlas textures - albedo with coverage in alpha, and model space normals packed into [0, 1]
+	GLuint* textures[2] = { &albedoTexture, &normalTexture };
+
+	for (int t = 0; t < 2; ++t) {
+
+		glGenTextures(1, textures[t]);
+		glBindTexture(GL_TEXTURE_2D, *textures[t]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlasSize, atlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	GLuint depthBuffer;
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, atlasSize, atlasSize);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	// Restored afterwards - the window is not necessarily framebuffer 0 (see GUPlatform::defaultFramebuffer)
+	GLint previousFramebuffer;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+	GLuint fbo;
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoTexture, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+	const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, drawBuffers);
+
+	bool complete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+	if (complete) {
+
+		// Save the state changed by baking
+		GLint viewport[4];
+		GLfloat clearColour[4];
+		GLboolean blendEnabled = glIsEnabled(GL_BLEND);
+		GLboolean cullEnabled = glIsEnabled(GL_CULL_FACE);
+
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColour);
+
+		glDisable(GL_BLEND);
+		glDisable(GL_CULL_FACE); // frames below the horizon see inside open meshes
+
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		glUseProgram(bakeShader);
+
+		GLint bakeShader_modelMatrix = glGetUniformLocation(bakeShader, "modelMatrix");
+		GLint bakeShader_viewMatrix = glGetUniformLocation(bakeShader, "viewMatrix");
+		GLint bakeShader_projMatrix = glGetUniformLocation(bakeShader, "projMatrix");
+		GLint bakeShader_texture = glGetUniformLocation(bakeShader, "texture");
+
+		mat4 modelTransform = identity<mat4>();
+		mat4 projTransform = glm::ortho(-radius, radius, -radius, radius, 0.0f, radius * 4.0f);
+
+		glUniformMatrix4fv(bakeShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+		glUniformMatrix4fv(bakeShader_projMatrix, 1, GL_FALSE, (GLfloat*)&projTransform);
+		glUniform1i(bakeShader_texture, 0);
+
+		mesh->setupTextures();
+
+		for (int y = 0; y < framesPerSide; ++y) {
+
+			for (int x = 0; x < framesPerSide; ++x) {
+
+				vec3 direction = octahedralDirection(vec2(((float)x + 0.5f) / (float)framesPerSide, ((float)y + 0.5f) / (float)framesPerSide));
+				vec3 up = (fabsf(direction.y) > 0.999f) ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+
+				mat4 viewTransform = glm::lookAt(centre + direction * (radius * 2.0f), centre, up);
+
+				glUniformMatrix4fv(bakeShader_viewMatrix, 1, GL_FALSE, (GLfloat*)&viewTransform);
+
+				glViewport(x * frameResolution, y * frameResolution, frameResolution, frameResolution);
+				mesh->render(0);
+			}
+		}
+
+		// Restore state
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		glClearColor(clearColour[0], clearColour[1], clearColour[2], clearColour[3]);
+
+		if (blendEnabled)
+			glEnable(GL_BLEND);
+		if (cullEnabled)
+			glEnable(GL_CULL_FACE);
+
+		glUseProgram(0);
+		glBindVertexArray(0);
+	}
+	else {
+
+		cout << "Impostor: Framebuffer incomplete for " << atlasSize << "x" << atlasSize << " atlas" << endl;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteRenderbuffers(1, &depthBuffer);
+
+	// Nothing was rendered into the atlas - release it so isValid() reports the failure
+	if (!complete) {
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glDeleteTextures(1, &albedoTexture);
+		glDeleteTextures(1, &normalTexture);
+		albedoTexture = normalTexture = 0;
+
+		return false;
+	}
+
+	for (int t = 0; t < 2; ++t) {
+
+		glBindTexture(GL_TEXTURE_2D, *textures[t]);
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return true;
+}
+
+
+// Public functions
+
+OctahedralImpostor::OctahedralImpostor(AIMesh* mesh, GLuint bakeShader, int framesPerSide, int frameResolution) {
+
+	this->mesh = mesh;
+	this->framesPerSide = framesPerSide;
+	this->frameResolution = frameResolution;
+
+	AABB bounds = mesh->getBoundingBox();
+
+	centre = bounds.centre();
+	radius = glm::length(bounds.extents());
+
+	if (bounds.isEmpty() || radius <= 0.0f || !bake(bakeShader)) {
+
+		cout << "Impostor: Could not bake impostor for " << mesh->getSourceFilename() << endl;
+		return;
+	}
+
+	cout << "Impostor: Baked " << framesPerSide << "x" << framesPerSide << " frames at " << frameResolution << "x" << frameResolution << " for " << mesh->getSourceFilename() << endl;
+}
+
+
+OctahedralImpostor::~OctahedralImpostor() {
+
+	if (albedoTexture != 0)
+		glDeleteTextures(1, &albedoTexture);
+
+	if (normalTexture != 0)
+		glDeleteTextures(1, &normalTexture);
+}
+
+
+vec3 OctahedralImpostor::octahedralDirection(const vec2& uv) {
+
+	vec2 e = uv * 2.0f - 1.0f;
+	vec3 d = vec3(e.x, 1.0f - fabsf(e.x) - fabsf(e.y), e.y);
+
+	// Lower hemisphere is folded over the diagonals of the upper hemisphere's square
+	if (d.y < 0.0f) {
+
+		float x = (1.0f - fabsf(d.z)) * ((d.x >= 0.0f) ? 1.0f : -1.0f);
+		float z = (1.0f - fabsf(d.x)) * ((d.z >= 0.0f) ? 1.0f : -1.0f);
+
+		d.x = x;
+		d.z = z;
+	}
+
+	return glm::normalize(d);
+}
+
+
+bool OctahedralImpostor::canRepresent(const mat4& modelTransform) {
+
+	float sx = glm::length(vec3(modelTransform[0]));
+	float sy = glm::length(vec3(modelTransform[1]));
+	float sz = glm::length(vec3(modelTransform[2]));
+
+	const float tolerance = 1.0e-3f * sx;
+
+	return (sx > 0.0f) && (fabsf(sx - sy) <= tolerance) && (fabsf(sx - sz) <= tolerance);
+}
+
+
+bool OctahedralImpostor::isValid() const {
+
+	return albedoTexture != 0 && normalTexture != 0;
+}
+
+
+AIMesh* OctahedralImpostor::getMesh() const {
+
+	return mesh;
+}
+
+
+int OctahedralImpostor::getFramesPerSide() const {
+
+	return framesPerSide;
+}
+
+
+TextureQuadInstance OctahedralImpostor::makeInstance(const mat4& modelTransform) const {
+
+	float scale = glm::length(vec3(modelTransform[0]));
+	mat3 rotation = mat3(modelTransform) / scale;
+	quat orientation = glm::quat_cast(rotation);
+
+	TextureQuadInstance instance;
+
+	instance.positionSize = vec4(vec3(modelTransform * vec4(centre, 1.0f)), radius * scale);
+	instance.params = vec4(orientation.x, orientation.y, orientation.z, orientation.w);
+
+	return instance;
+}
+
+
+void OctahedralImpostor::setupTextures() {
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, albedoTexture);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, normalTexture);
+
+	glActiveTexture(GL_TEXTURE0);
+
+	GURenderStats::countTextureBind(2);
+}
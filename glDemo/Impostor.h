@@ -0,0 +1,53 @@
+#pragma once
+
+#include "core.h"
+#include "TextureQuad.h"
+
+class AIMesh;
+
+// Octahedral impostor for a static mesh.  The mesh is rendered from framesPerSide x framesPerSide directions spread over the whole sphere with an octahedral mapping, and each view's albedo and model space normal are stored in a tile of two atlas textures.
+//
+// At runtime an instance is drawn as a single camera-facing quad (see TextureQuad).  The impostor shader picks the four atlas frames nearest to the model space view direction, reprojects the quad onto each frame's plane and blends them, then lights the result with the scene lights.
+//
+// Impostors assume instances have a uniform scale - see canRepresent.
+
+class OctahedralImpostor {
+
+	AIMesh*				mesh;
+
+	int					framesPerSide;
+	int					frameResolution;
+
+	// Model coordinate bounding sphere of the mesh - each frame is an orthographic view fitted to this sphere
+	glm::vec3			centre;
+	float				radius;
+
+	GLuint				albedoTexture = 0;
+	GLuint				normalTexture = 0;
+
+	// Private functions
+	bool bake(GLuint bakeShader);
+
+public:
+
+	// Bake the atlases using bakeShader (impostor-bake.vert/.frag).  Requires a current OpenGL context
+	OctahedralImpostor(AIMesh* mesh, GLuint bakeShader, int framesPerSide = 12, int frameResolution = 128);
+	~OctahedralImpostor();
+
+	// Direction from the mesh centre for the atlas frame at octahedral coordinate uv ([0, 1] in x and y).  Must match octDecode in impostor.vert
+	static glm::vec3 octahedralDirection(const glm::vec2& uv);
+
+	// True if an instance with the given model transform can be drawn with an impostor (rotation, translation and uniform scale only)
+	static bool canRepresent(const glm::mat4& modelTransform);
+
+	bool isValid() const;
+
+	AIMesh* getMesh() const;
+	int getFramesPerSide() const;
+
+	// Per-instance quad data for an instance of the mesh - world centre and radius in positionSize and the instance orientation quaternion (x, y, z, w) in params
+	TextureQuadInstance makeInstance(const glm::mat4& modelTransform) const;
+
+	// Bind the albedo atlas to texture unit 0 and the normal atlas to texture unit 1
+	void setupTextures();
+};
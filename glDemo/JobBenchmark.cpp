@@ -0,0 +1,270 @@
+#include "JobBenchmark.h"
+#include "JobSystem.h"
+#include "CommandBuffer.h"
+#include "GUClock.h"
+#include "AABB.h"
+#include <thread>
+
+using namespace std;
+using namespace glm;
+
+
+// Instance data for the scaling kernel - the same work selectLODs and cullMeshlets do per static instance
+struct BenchmarkInstance {
+
+	mat4				modelTransform;
+	AABB				localBounds;
+	int					lod;
+	bool				visible;
+};
+
+
+static void cullAndSelectLOD(BenchmarkInstance& instance, const mat4& viewProjection, const vec3& cameraPos) {
+
+	AABB worldBounds = instance.localBounds.transformed(instance.modelTransform);
+
+	// Frustum test of the bounding box corners in clip space
+	bool outside[6] = { true, true, true, true, true, true };
+
+	for (int c = 0; c < 8; ++c) {
+
+		vec3 corner = vec3((c & 1) ? worldBounds.max.x : worldBounds.min.x, (c & 2) ? worldBounds.max.y : worldBounds.min.y, (c & 4) ? worldBounds.max.z : worldBounds.min.z);
+		vec4 clip = viewProjection * vec4(corner, 1.0f);
+
+		outside[0] = outside[0] && (clip.x < -clip.w);
+		outside[1] = outside[1] && (clip.x > clip.w);
+		outside[2] = outside[2] && (clip.y < -clip.w);
+		outside[3] = outside[3] && (clip.y > clip.w);
+		outside[4] = outside[4] && (clip.z < -clip.w);
+		outside[5] = outside[5] && (clip.z > clip.w);
+	}
+
+	instance.visible = !(outside[0] || outside[1] || outside[2] || outside[3] || outside[4] || outside[5]);
+
+	float distance = glm::length(cameraPos - glm::clamp(cameraPos, worldBounds.min, worldBounds.max));
+	instance.lod = std::min<int>((int)(distance / 50.0f), 3);
+}
+
+
+static void benchmarkOverhead(int workers, bool pinThreads) {
+
+	const int numJobs = 200000;
+
+	GUJobSystem::start(workers, pinThreads);
+
+	GUClock timer;
+
+	// Empty jobs submitted from a thread outside the pool - the render and main threads' case
+	gu_seconds t0 = timer.actualTimeElapsed();
+
+	{
+		GUJobCounter counter;
+
+		for (int i = 0; i < numJobs; ++i)
+			GUJobSystem::run([]() {}, &counter);
+
+		GUJobSystem::wait(counter);
+	}
+
+	// Empty jobs spawned by jobs - each goes on the spawning worker's own deque
+	gu_seconds t1 = timer.actualTimeElapsed();
+
+	{
+		const int spawners = 64;
+		GUJobCounter counter;
+
+		for (int s = 0; s < spawners; ++s) {
+
+			GUJobSystem::run([&counter]() {
+
+				for (int i = 0; i < numJobs / spawners; ++i)
+					GUJobSystem::run([]() {}, &counter);
+
+			}, &counter);
+		}
+
+		GUJobSystem::wait(counter);
+	}
+
+	// parallelFor with one index per batch
+	gu_seconds t2 = timer.actualTimeElapsed();
+
+	const int numLoops = 20000;
+	uint32_t batches = (uint32_t)(workers + 1) * 4;
+
+	for (int i = 0; i < numLoops; ++i)
+		GUJobSystem::parallelFor(0, batches, 1, [](uint32_t, uint32_t) {});
+
+	gu_seconds t3 = timer.actualTimeElapsed();
+
+	printf("%3d workers: run (external) %7.1f ns/job, run (from job) %7.1f ns/job, parallelFor %7.1f ns/batch\n",
+		workers,
+		(t1 - t0) * 1.0e9 / (double)numJobs,
+		(t2 - t1) * 1.0e9 / (double)numJobs,
+		(t3 - t2) * 1.0e9 / ((double)numLoops * (double)batches));
+}
+
+
+// Run frame numFrames times with 1 thread up to every hardware thread and print the time per frame and speedup over 1 thread
+static void measureScaling(bool pinThreads, const function<void()>& frame) {
+
+	const int numFrames = 20;
+	const int maxThreads = std::max<int>((int)thread::hardware_concurrency(), 1);
+
+	gu_seconds singleThreadMs = 0.0;
+	GUClock timer;
+
+	// Powers of two up to every hardware thread
+	vector<int> threadCounts;
+
+	for (int threads = 1; threads < maxThreads; threads *= 2)
+		threadCounts.push_back(threads);
+
+	threadCounts.push_back(maxThreads);
+
+	for (int threads : threadCounts) {
+
+		// The calling thread runs batches too, so threads - 1 workers
+		GUJobSystem::start(threads - 1, pinThreads);
+
+		// One untimed frame to start the workers and warm the caches
+		frame();
+
+		gu_seconds t0 = timer.actualTimeElapsed();
+
+		for (int i = 0; i < numFrames; ++i)
+			frame();
+
+		gu_seconds frameMs = (timer.actualTimeElapsed() - t0) * 1000.0 / (double)numFrames;
+
+		if (threads == 1)
+			singleThreadMs = frameMs;
+
+		printf("%3d threads: %8.3f ms/frame, speedup %5.2fx, efficiency %5.1f%%\n", threads, frameMs, singleThreadMs / frameMs, 100.0 * singleThreadMs / (frameMs * (double)threads));
+	}
+}
+
+
+static vector<BenchmarkInstance> createInstances(uint32_t numInstances) {
+
+	mt19937 rng(1); // fixed seed so runs are repeatable
+	uniform_real_distribution<float> posDist(-1000.0f, 1000.0f);
+	uniform_real_distribution<float> angleDist(0.0f, 6.2831853f);
+
+	vector<BenchmarkInstance> instances(numInstances);
+
+	for (BenchmarkInstance& instance : instances) {
+
+		instance.modelTransform = glm::translate(identity<mat4>(), vec3(posDist(rng), 0.0f, posDist(rng))) * eulerAngleY<float>(angleDist(rng));
+		instance.localBounds = AABB(vec3(-2.0f, 0.0f, -2.0f), vec3(2.0f, 6.0f, 2.0f));
+		instance.lod = 0;
+		instance.visible = false;
+	}
+
+	return instances;
+}
+
+
+static void benchmarkCullScaling(bool pinThreads) {
+
+	const uint32_t numInstances = 1000000;
+
+	vector<BenchmarkInstance> instances = createInstances(numInstances);
+
+	vec3 cameraPos = vec3(0.0f, 50.0f, 200.0f);
+	mat4 viewProjection = glm::perspective(glm::radians(40.0f), 4.0f / 3.0f, 0.1f, 10000.0f) * glm::lookAt(cameraPos, vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+
+	printf("\nCull and LOD select %u instances:\n", numInstances);
+
+	measureScaling(pinThreads, [&]() {
+
+		GUJobSystem::parallelFor(0, numInstances, 1024, [&](uint32_t begin, uint32_t end) {
+
+			for (uint32_t i = begin; i < end; ++i)
+				cullAndSelectLOD(instances[i], viewProjection, cameraPos);
+		});
+	});
+
+	size_t visible = 0;
+
+	for (const BenchmarkInstance& instance : instances)
+		visible += (instance.visible) ? 1 : 0;
+
+	printf("(%zu of %u instances visible)\n", visible, numInstances);
+}
+
+
+// Draw command recording as recordStaticInstances does it - a slice of the instances per command buffer, recorded and sorted as jobs, then merged on the calling thread.  Instances use one of 16 meshes and 8 textures so the sort has state groups to form
+static void benchmarkRecordScaling(bool pinThreads) {
+
+	const uint32_t numInstances = 250000;
+	const int maxThreads = std::max<int>((int)thread::hardware_concurrency(), 1);
+	const uint32_t numSlices = (uint32_t)maxThreads * 4;
+
+	vector<BenchmarkInstance> instances = createInstances(numInstances);
+	vector<GUCommandBuffer> buffers(numSlices);
+	GUCommandQueue queue;
+
+	vec3 cameraPos = vec3(0.0f, 50.0f, 200.0f);
+
+	printf("\nRecord, sort and merge draw commands for %u instances (%u command buffers):\n", numInstances, numSlices);
+
+	measureScaling(pinThreads, [&]() {
+
+		GUJobSystem::parallelFor(0, numSlices, 1, [&](uint32_t firstSlice, uint32_t lastSlice) {
+
+			for (uint32_t slice = firstSlice; slice < lastSlice; ++slice) {
+
+				GUCommandBuffer& buffer = buffers[slice];
+
+				buffer.clear();
+
+				for (uint32_t i = numInstances * slice / numSlices; i < numInstances * (slice + 1) / numSlices; ++i) {
+
+					GUDrawCommand command;
+
+					command.modelTransform = instances[i].modelTransform;
+					command.vertexArray = 1 + (i & 15);
+					command.texture = 1 + ((i >> 4) & 7);
+					command.normalMap = 0;
+					command.indexOffset = 0;
+					command.indexCount = 3000;
+					command.meshlets = nullptr;
+
+					float distance = glm::length(cameraPos - vec3(command.modelTransform[3]));
+
+					buffer.draw(GUCommandBuffer::sortKey(command.texture, command.vertexArray, distance), command);
+				}
+
+				buffer.sort();
+			}
+		});
+
+		queue.merge(buffers.data(), (int)numSlices);
+	});
+
+	// The merge is the serial part that limits the speedup
+	GUClock timer;
+	gu_seconds t0 = timer.actualTimeElapsed();
+
+	queue.merge(buffers.data(), (int)numSlices);
+
+	printf("(merge alone %.3f ms for %zu commands)\n", (timer.actualTimeElapsed() - t0) * 1000.0, queue.size());
+}
+
+
+void runJobBenchmark(bool pinThreads) {
+
+	cout << "GUJobSystem benchmark (" << thread::hardware_concurrency() << " hardware threads" << ((pinThreads) ? ", workers pinned" : "") << ")\n\n";
+
+	cout << "Scheduling overhead:\n";
+
+	benchmarkOverhead(0, pinThreads);
+	benchmarkOverhead(1, pinThreads);
+	benchmarkOverhead(GUJobSystem::defaultWorkerCount(), pinThreads);
+
+	benchmarkCullScaling(pinThreads);
+	benchmarkRecordScaling(pinThreads);
+
+	GUJobSystem::stop();
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+#include "core.h"
+
+// Microbenchmark for GUJobSystem - per job scheduling overhead (submitted from outside the pool, spawned from inside it, and per parallelFor batch) and the scaling of a per-instance culling and LOD kernel and of parallel draw command recording from 1 thread to every hardware thread.  pinThreads pins the workers as --pin-jobs does
+void runJobBenchmark(bool pinThreads);
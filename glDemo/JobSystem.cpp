@@ -0,0 +1,569 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <thread>
+#include <condition_variable>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+
+struct GUJob {
+
+	GUJobFunction				function;
+	GUJobCounter*				counter;
+};
+
+
+//
+// Private class - Chase-Lev work-stealing deque (with the memory orderings of Le, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP 2013).  The owning worker pushes and pops at the bottom, any thread steals from the top, and only the last job in the deque is contended.  Capacity is fixed - push fails when the deque is full and the job is queued elsewhere
+//
+
+class GUWorkStealingDeque {
+
+public:
+
+	static const int64_t		capacity = 4096; // power of two
+	static const int64_t		mask = capacity - 1;
+
+	std::atomic<int64_t>		top;
+	std::atomic<int64_t>		bottom;
+	std::atomic<GUJob*>			buffer[capacity];
+
+
+	GUWorkStealingDeque() : top(0), bottom(0) {
+
+		for (int64_t i = 0; i < capacity; ++i)
+			buffer[i].store(nullptr, std::memory_order_relaxed);
+	}
+
+	// Owner only
+	bool push(GUJob* job) {
+
+		int64_t b = bottom.load(std::memory_order_relaxed);
+		int64_t t = top.load(std::memory_order_acquire);
+
+		if (b - t >= capacity)
+			return false;
+
+		buffer[b & mask].store(job, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom.store(b + 1, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	// Owner only - most recently pushed job first
+	GUJob* pop() {
+
+		int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = top.load(std::memory_order_relaxed);
+
+		if (t > b) {
+
+			// Empty
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		GUJob* job = buffer[b & mask].load(std::memory_order_relaxed);
+
+		if (t == b) {
+
+			// Last job - race any thieves for it
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				job = nullptr;
+
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+
+		return job;
+	}
+
+	// Any thread - oldest job first.  Returns nullptr if empty or another thread took the job
+	GUJob* steal() {
+
+		int64_t t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t b = bottom.load(std::memory_order_acquire);
+
+		if (t >= b)
+			return nullptr;
+
+		GUJob* job = buffer[t & mask].load(std::memory_order_relaxed);
+
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr;
+
+		return job;
+	}
+};
+
+
+//
+// Private class - finished jobs are kept for reuse by the thread that finished them, so steady state submission does not allocate (other than any the job function's captures need).  Jobs allocated on one thread mostly finish on another, so a pool that grows past maxPooledJobs passes half its jobs to a shared spare list and an empty pool refills from it
+//
+
+class GUJobPool {
+
+public:
+
+	std::vector<GUJob*>			freeJobs;
+
+	~GUJobPool() {
+
+		for (GUJob* job : freeJobs)
+			delete job;
+	}
+};
+
+
+// Scheduler state
+static vector<GUWorkStealingDeque*>		deques; // one per worker
+static vector<thread>					workers;
+static std::atomic<bool>				workersRunning(false);
+
+static const size_t						maxPooledJobs = 256;
+static const size_t						jobRefillCount = 64;
+
+static mutex							spareJobsLock;
+static vector<GUJob*>					spareJobs;
+
+// Jobs submitted from threads outside the pool (or from a worker whose deque is full).  A ring buffer rather than a std::deque, which allocates and frees blocks as jobs pass through it - the ring only allocates when it grows
+static mutex							sharedQueueLock;
+static vector<GUJob*>					sharedQueue;
+static size_t							sharedQueueHead = 0;
+static size_t							sharedQueueCount = 0;
+static std::atomic<int>					sharedQueueSize(0);
+
+// Jobs submitted but not yet started - workers sleep while it is zero
+static std::atomic<int>					queuedJobs(0);
+static std::atomic<int>					sleepingWorkers(0);
+static mutex							sleepLock;
+static condition_variable				wakeCondition;
+
+static thread_local int					workerIndex = -1; // -1 outside the pool
+static thread_local uint32_t			stealSeed = 0;
+static thread_local GUJobPool			jobPool;
+
+// Failed searches before an idle worker sleeps, or a waiting thread yields
+static const int						idleSpinCount = 64;
+
+
+
+// Private functions - call holding sharedQueueLock
+
+static void pushSharedQueue(GUJob* job) {
+
+	if (sharedQueueCount == sharedQueue.size()) {
+
+		// Full - unwrap into a larger buffer
+		vector<GUJob*> grown(std::max<size_t>(sharedQueue.size() * 2, 64));
+
+		for (size_t i = 0; i < sharedQueueCount; ++i)
+			grown[i] = sharedQueue[(sharedQueueHead + i) % sharedQueue.size()];
+
+		sharedQueue.swap(grown);
+		sharedQueueHead = 0;
+	}
+
+	sharedQueue[(sharedQueueHead + sharedQueueCount) % sharedQueue.size()] = job;
+	sharedQueueCount++;
+	sharedQueueSize.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+static GUJob* popSharedQueue() {
+
+	if (sharedQueueCount == 0)
+		return nullptr;
+
+	GUJob* job = sharedQueue[sharedQueueHead];
+
+	sharedQueueHead = (sharedQueueHead + 1) % sharedQueue.size();
+	sharedQueueCount--;
+	sharedQueueSize.fetch_sub(1, std::memory_order_relaxed);
+
+	return job;
+}
+
+
+
+// Private method implementation
+
+GUJob* GUJobSystem::allocateJob(GUJobFunction&& function, GUJobCounter* counter) {
+
+	GUJob* job;
+
+	if (jobPool.freeJobs.empty()) {
+
+		lock_guard<mutex> lock(spareJobsLock);
+
+		size_t count = std::min<size_t>(spareJobs.size(), jobRefillCount);
+
+		jobPool.freeJobs.insert(jobPool.freeJobs.end(), spareJobs.end() - count, spareJobs.end());
+		spareJobs.resize(spareJobs.size() - count);
+	}
+
+	if (!jobPool.freeJobs.empty()) {
+
+		job = jobPool.freeJobs.back();
+		jobPool.freeJobs.pop_back();
+	}
+	else {
+
+		job = new GUJob();
+	}
+
+	job->function = std::move(function);
+	job->counter = counter;
+
+	return job;
+}
+
+
+void GUJobSystem::submit(GUJob* job) {
+
+	if (workerIndex < 0 || !deques[workerIndex]->push(job)) {
+
+		lock_guard<mutex> lock(sharedQueueLock);
+
+		pushSharedQueue(job);
+	}
+
+	queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+
+	// A worker going to sleep either sees queuedJobs > 0 or has registered as sleeping before this check (both are sequentially consistent), so the wake-up cannot be lost
+	if (sleepingWorkers.load(std::memory_order_seq_cst) > 0) {
+
+		lock_guard<mutex> lock(sleepLock);
+		wakeCondition.notify_one();
+	}
+}
+
+
+// Own deque first (newest job, still in cache), then the shared queue, then steal the oldest job of another worker
+GUJob* GUJobSystem::findJob() {
+
+	GUJob* job = nullptr;
+
+	if (workerIndex >= 0)
+		job = deques[workerIndex]->pop();
+
+	if (!job && sharedQueueSize.load(std::memory_order_relaxed) > 0) {
+
+		lock_guard<mutex> lock(sharedQueueLock);
+
+		job = popSharedQueue();
+	}
+
+	if (!job && !deques.empty()) {
+
+		// xorshift - a different starting victim each time spreads thieves over the workers
+		if (stealSeed == 0)
+			stealSeed = (uint32_t)std::hash<thread::id>()(this_thread::get_id()) | 1;
+
+		stealSeed ^= stealSeed << 13;
+		stealSeed ^= stealSeed >> 17;
+		stealSeed ^= stealSeed << 5;
+
+		size_t first = stealSeed % deques.size();
+
+		for (size_t i = 0; i < deques.size() && !job; ++i) {
+
+			size_t victim = (first + i) % deques.size();
+
+			if ((int)victim != workerIndex)
+				job = deques[victim]->steal();
+		}
+	}
+
+	if (job)
+		queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+
+	return job;
+}
+
+
+void GUJobSystem::execute(GUJob* job) {
+
+	job->function();
+
+	GUJobCounter* counter = job->counter;
+
+	// Release the captures now rather than when the job is next reused
+	job->function = nullptr;
+	jobPool.freeJobs.push_back(job);
+
+	if (jobPool.freeJobs.size() > maxPooledJobs) {
+
+		lock_guard<mutex> lock(spareJobsLock);
+
+		size_t count = jobPool.freeJobs.size() / 2;
+
+		spareJobs.insert(spareJobs.end(), jobPool.freeJobs.end() - count, jobPool.freeJobs.end());
+		jobPool.freeJobs.resize(jobPool.freeJobs.size() - count);
+	}
+
+	if (counter)
+		finish(counter);
+}
+
+
+// Once pending reaches zero a waiting thread may destroy the counter, so the final decrement is made holding continuationLock (which wait() takes before returning) and the counter is not touched after it is released
+void GUJobSystem::finish(GUJobCounter* counter) {
+
+	int expected = counter->pending.load(std::memory_order_relaxed);
+
+	while (expected > 1) {
+
+		if (counter->pending.compare_exchange_weak(expected, expected - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+			return;
+	}
+
+	vector<GUJob*> ready;
+
+	{
+		lock_guard<mutex> lock(counter->continuationLock);
+
+		if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			ready.swap(counter->continuations);
+	}
+
+	for (GUJob* job : ready)
+		submit(job);
+}
+
+
+void GUJobSystem::workerMain(int index, bool pinThread) {
+
+	workerIndex = index;
+	stealSeed = 0x9E3779B9u * (uint32_t)(index + 1);
+
+	string name = "job worker " + to_string(index);
+
+#if GU_PROFILER
+	GUProfiler::setThreadName(name.c_str());
+#endif
+
+	if (pinThread) {
+
+		unsigned int processors = std::max<unsigned int>(thread::hardware_concurrency(), 1);
+		unsigned int processor = (unsigned int)(index + 1) % processors;
+
+#if defined(_WIN32)
+		SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << processor);
+#elif defined(__linux__)
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(processor, &cpus);
+		pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+	}
+
+	int idleCount = 0;
+
+	while (workersRunning.load(std::memory_order_acquire)) {
+
+		GUJob* job = findJob();
+
+		if (job) {
+
+			execute(job);
+			idleCount = 0;
+			continue;
+		}
+
+		if (++idleCount < idleSpinCount) {
+
+			this_thread::yield();
+			continue;
+		}
+
+		// Nothing to do - sleep until a job is submitted
+		sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+
+		{
+			unique_lock<mutex> lock(sleepLock);
+			wakeCondition.wait(lock, [] { return queuedJobs.load(std::memory_order_seq_cst) > 0 || !workersRunning.load(std::memory_order_acquire); });
+		}
+
+		sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+		idleCount = 0;
+	}
+}
+
+
+
+// Public method implementation
+
+void GUJobSystem::start(int workerCount, bool pinThreads) {
+
+	stop();
+
+	workerCount = std::max<int>(workerCount, 0);
+
+	for (int i = 0; i < workerCount; ++i)
+		deques.push_back(new GUWorkStealingDeque());
+
+	workersRunning = true;
+
+	for (int i = 0; i < workerCount; ++i)
+		workers.push_back(thread(workerMain, i, pinThreads));
+}
+
+
+void GUJobSystem::stop() {
+
+	if (workers.empty())
+		return;
+
+	{
+		lock_guard<mutex> lock(sleepLock);
+		workersRunning = false;
+	}
+
+	wakeCondition.notify_all();
+
+	for (thread& worker : workers)
+		worker.join();
+
+	workers.clear();
+
+	// Jobs left in the worker deques move to the shared queue
+	for (GUWorkStealingDeque* deque : deques) {
+
+		for (GUJob* job = deque->steal(); job; job = deque->steal()) {
+
+			lock_guard<mutex> lock(sharedQueueLock);
+
+			pushSharedQueue(job);
+		}
+
+		delete deque;
+	}
+
+	deques.clear();
+
+	lock_guard<mutex> lock(spareJobsLock);
+
+	for (GUJob* job : spareJobs)
+		delete job;
+
+	spareJobs.clear();
+}
+
+
+int GUJobSystem::workerCount() {
+
+	return (int)workers.size();
+}
+
+
+int GUJobSystem::currentWorker() {
+
+	return workerIndex;
+}
+
+
+int GUJobSystem::defaultWorkerCount() {
+
+	return std::max<int>((int)thread::hardware_concurrency() - 3, 1);
+}
+
+
+void GUJobSystem::run(GUJobFunction function, GUJobCounter* counter) {
+
+	if (counter)
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+	submit(allocateJob(std::move(function), counter));
+}
+
+
+void GUJobSystem::runAfter(GUJobCounter& dependency, GUJobFunction function, GUJobCounter* counter) {
+
+	if (counter)
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+	GUJob* job = allocateJob(std::move(function), counter);
+
+	{
+		lock_guard<mutex> lock(dependency.continuationLock);
+
+		// finish() takes the continuations under the same lock after pending reaches zero, so a job added while pending is non-zero is always picked up
+		if (dependency.pending.load(std::memory_order_acquire) > 0) {
+
+			dependency.continuations.push_back(job);
+			return;
+		}
+	}
+
+	submit(job);
+}
+
+
+void GUJobSystem::wait(GUJobCounter& counter) {
+
+	int idleCount = 0;
+
+	while (counter.pending.load(std::memory_order_acquire) > 0) {
+
+		GUJob* job = findJob();
+
+		if (job) {
+
+			execute(job);
+			idleCount = 0;
+		}
+		else if (++idleCount >= idleSpinCount) {
+
+			// The remaining jobs are running on other threads
+			this_thread::yield();
+		}
+	}
+
+	// The thread that finished the last job may still hold the lock - see finish()
+	lock_guard<mutex> lock(counter.continuationLock);
+}
+
+
+void GUJobSystem::parallelFor(uint32_t begin, uint32_t end, uint32_t minBatchSize, const std::function<void(uint32_t, uint32_t)>& body) {
+
+	if (end <= begin)
+		return;
+
+	uint32_t count = end - begin;
+	minBatchSize = std::max<uint32_t>(minBatchSize, 1);
+
+	// A few batches per thread so faster threads can steal from slower ones
+	uint32_t maxBatches = (uint32_t)(workerCount() + 1) * 4;
+	uint32_t batchCount = std::min<uint32_t>((count + minBatchSize - 1) / minBatchSize, maxBatches);
+
+	if (batchCount <= 1) {
+
+		body(begin, end);
+		return;
+	}
+
+	uint32_t batchSize = (count + batchCount - 1) / batchCount;
+
+	GUJobCounter counter;
+	const std::function<void(uint32_t, uint32_t)>* bodyPointer = &body;
+
+	for (uint32_t batchBegin = begin + batchSize; batchBegin < end; batchBegin += batchSize) {
+
+		uint32_t batchEnd = std::min<uint32_t>(batchBegin + batchSize, end);
+
+		run([bodyPointer, batchBegin, batchEnd]() { (*bodyPointer)(batchBegin, batchEnd); }, &counter);
+	}
+
+	body(begin, std::min<uint32_t>(begin + batchSize, end));
+
+	wait(counter);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+//
+// Work-stealing job scheduler.  GUJobSystem::start creates a pool of worker threads, each with its own Chase-Lev deque - a worker pushes and pops jobs at one end of its deque without locking and idle workers steal from the other end of a random victim's.  Threads outside the pool (the main thread loading assets, the render thread doing per-frame work) submit through a shared queue the workers drain first.
+//
+// Jobs are tracked with GUJobCounter - wait() returns once every job run with the counter has finished, running queued jobs on the waiting thread in the meantime so waiting never idles a core.  runAfter() chains a job to start when another counter reaches zero, so small dependency graphs need no waiting at all.  parallelFor() splits an index range into batches and waits for them.
+//
+// Jobs must not block on each other except through wait().  With no workers (start(0) or never started) jobs run on the thread that waits for them.
+//
+
+#include "core.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+struct GUJob;
+
+typedef std::function<void()> GUJobFunction;
+
+
+// Number of jobs run with the counter that have not finished.  A counter can be reused once it reaches zero, and must be waited on before it is destroyed if any job was run with it
+class GUJobCounter {
+
+private:
+
+	friend class GUJobSystem;
+
+	std::atomic<int>			pending;
+
+	// Jobs waiting for pending to reach zero (runAfter)
+	std::mutex					continuationLock;
+	std::vector<GUJob*>			continuations;
+
+public:
+
+	GUJobCounter() : pending(0) {}
+
+	GUJobCounter(const GUJobCounter&) = delete;
+	GUJobCounter& operator=(const GUJobCounter&) = delete;
+
+	bool isDone() const {
+
+		return pending.load(std::memory_order_acquire) == 0;
+	}
+};
+
+
+class GUJobSystem {
+
+private:
+
+	static GUJob* allocateJob(GUJobFunction&& function, GUJobCounter* counter);
+	static void submit(GUJob* job);
+	static GUJob* findJob();
+	static void execute(GUJob* job);
+	static void finish(GUJobCounter* counter);
+	static void workerMain(int index, bool pinThread);
+
+public:
+
+	// Start workerCount worker threads (stopping any already running).  Start and stop the pool while no jobs are running.  If pinThreads is true worker i is bound to logical processor i + 1 (wrapping), leaving processor 0 to the thread that started the pool
+	static void start(int workerCount, bool pinThreads = false);
+
+	// Wait for the workers to finish their current jobs and end them.  Jobs still queued are run by whichever thread next waits for them
+	static void stop();
+
+	static int workerCount();
+
+	// Index (0 to workerCount() - 1) of the worker thread calling, or -1 on a thread outside the pool
+	static int currentWorker();
+
+	// Hardware threads less the main, simulation and render threads (at least 1)
+	static int defaultWorkerCount();
+
+	// Queue function to run on any thread.  counter (if given) is incremented now and decremented when function returns
+	static void run(GUJobFunction function, GUJobCounter* counter = nullptr);
+
+	// Queue function once dependency reaches zero (at once if it already has).  counter is incremented now, so waiting on it also waits for the dependency
+	static void runAfter(GUJobCounter& dependency, GUJobFunction function, GUJobCounter* counter = nullptr);
+
+	// Run queued jobs until counter reaches zero
+	static void wait(GUJobCounter& counter);
+
+	// Call body(batchBegin, batchEnd) over [begin, end) in batches of at least minBatchSize indices and wait for all of them.  The calling thread runs the first batch itself.  Batches run concurrently so body must only write data owned by its own indices
+	static void parallelFor(uint32_t begin, uint32_t end, uint32_t minBatchSize, const std::function<void(uint32_t, uint32_t)>& body);
+};
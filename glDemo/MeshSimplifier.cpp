@@ -0,0 +1,395 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace std;
+using namespace glm;
+
+
+// Symmetric 4x4 error quadric - stores the 10 unique coefficients
+struct Quadric {
+
+	double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+	double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+	double a22 = 0.0, a23 = 0.0;
+	double a33 = 0.0;
+
+	Quadric() {}
+
+	// Quadric measuring squared distance to the plane n.p + d = 0 (n normalised)
+	Quadric(const dvec3& n, double d) {
+
+		a00 = n.x * n.x; a01 = n.x * n.y; a02 = n.x * n.z; a03 = n.x * d;
+		a11 = n.y * n.y; a12 = n.y * n.z; a13 = n.y * d;
+		a22 = n.z * n.z; a23 = n.z * d;
+		a33 = d * d;
+	}
+
+	void add(const Quadric& q) {
+
+		a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+		a11 += q.a11; a12 += q.a12; a13 += q.a13;
+		a22 += q.a22; a23 += q.a23;
+		a33 += q.a33;
+	}
+
+	double evaluate(const vec3& p) const {
+
+		double x = p.x, y = p.y, z = p.z;
+
+		return	a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x +
+				a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y +
+				a22 * z * z + 2.0 * a23 * z +
+				a33;
+	}
+};
+
+
+// Candidate collapse of vertex 'from' onto vertex 'to'
+struct Collapse {
+
+	uint32_t	from;
+	uint32_t	to;
+	double		cost;
+};
+
+
+// Compressed adjacency list - the items for element i are items[offsets[i]] to items[offsets[i + 1] - 1]
+struct Adjacency {
+
+	vector<uint32_t>	offsets;
+	vector<uint32_t>	items;
+};
+
+
+static bool isDegenerate(const vector<uint32_t>& canonical, GLuint i0, GLuint i1, GLuint i2) {
+
+	return canonical[i0] == canonical[i1] || canonical[i1] == canonical[i2] || canonical[i0] == canonical[i2];
+}
+
+
+// Vertex to neighbouring vertex adjacency for the current triangle list
+static void buildVertexAdjacency(Adjacency& adjacency, const vector<GLuint>& indices, size_t numVertices) {
+
+	adjacency.offsets.assign(numVertices + 1, 0);
+
+	for (size_t i = 0; i < indices.size(); ++i)
+		adjacency.offsets[indices[i] + 1] += 2;
+
+	partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+	adjacency.items.resize(adjacency.offsets[numVertices]);
+
+	vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+
+	for (size_t t = 0; t < indices.size(); t += 3) {
+
+		for (int e = 0; e < 3; ++e) {
+
+			GLuint v = indices[t + e];
+
+			adjacency.items[fill[v]++] = indices[t + (e + 1) % 3];
+			adjacency.items[fill[v]++] = indices[t + (e + 2) % 3];
+		}
+	}
+}
+
+
+// Canonical position to triangle adjacency for the current triangle list
+static void buildTriangleAdjacency(Adjacency& adjacency, const vector<GLuint>& indices, const vector<uint32_t>& canonical) {
+
+	const size_t numVertices = canonical.size();
+
+	adjacency.offsets.assign(numVertices + 1, 0);
+
+	for (size_t i = 0; i < indices.size(); ++i)
+		adjacency.offsets[canonical[indices[i]] + 1]++;
+
+	partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+	adjacency.items.resize(adjacency.offsets[numVertices]);
+
+	vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+
+	for (size_t i = 0; i < indices.size(); ++i)
+		adjacency.items[fill[canonical[indices[i]]]++] = (uint32_t)(i / 3);
+}
+
+
+static vec3 triangleNormal(const vec3& p0, const vec3& p1, const vec3& p2) {
+
+	return cross(p1 - p0, p2 - p0);
+}
+
+
+vector<GLuint> simplifyMesh(const vector<vec3>& positions, const vector<GLuint>& indices, size_t targetIndexCount, float* resultError) {
+
+	const size_t numVertices = positions.size();
+
+	//
+	// 1. Group vertices sharing a position.  canonical[v] is the lowest index vertex at v's position and wedgeNext links all vertices at a position into a circular list
+	//
+
+	vector<uint32_t> canonical(numVertices);
+	vector<uint32_t> wedgeNext(numVertices);
+
+	{
+		vector<uint32_t> order(numVertices);
+		iota(order.begin(), order.end(), 0);
+
+		sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+
+			const vec3& pa = positions[a];
+			const vec3& pb = positions[b];
+
+			if (pa.x != pb.x) return pa.x < pb.x;
+			if (pa.y != pb.y) return pa.y < pb.y;
+			if (pa.z != pb.z) return pa.z < pb.z;
+			return a < b;
+		});
+
+		for (size_t i = 0; i < numVertices; ++i) {
+
+			uint32_t v = order[i];
+
+			canonical[v] = (i > 0 && positions[order[i - 1]] == positions[v]) ? canonical[order[i - 1]] : v;
+			wedgeNext[v] = v;
+
+			if (canonical[v] != v) {
+
+				wedgeNext[v] = wedgeNext[canonical[v]];
+				wedgeNext[canonical[v]] = v;
+			}
+		}
+	}
+
+
+	//
+	// 2. Accumulate plane quadrics for each position and lock positions on open borders.  Borders are found on position (not vertex) edges so attribute seams are not mistaken for borders
+	//
+
+	vector<GLuint> result;
+	result.reserve(indices.size());
+
+	vector<Quadric> quadrics(numVertices);
+	vector<uint64_t> edges;
+
+	for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+
+		GLuint i0 = indices[t], i1 = indices[t + 1], i2 = indices[t + 2];
+
+		if (isDegenerate(canonical, i0, i1, i2))
+			continue;
+
+		result.push_back(i0);
+		result.push_back(i1);
+		result.push_back(i2);
+
+		dvec3 n = dvec3(triangleNormal(positions[i0], positions[i1], positions[i2]));
+		double len = glm::length(n);
+
+		if (len > 0.0) {
+
+			n /= len;
+
+			Quadric q(n, -dot(n, dvec3(positions[i0])));
+
+			quadrics[canonical[i0]].add(q);
+			quadrics[canonical[i1]].add(q);
+			quadrics[canonical[i2]].add(q);
+		}
+
+		uint64_t c0 = canonical[i0], c1 = canonical[i1], c2 = canonical[i2];
+
+		edges.push_back((c0 << 32) | c1);
+		edges.push_back((c1 << 32) | c2);
+		edges.push_back((c2 << 32) | c0);
+	}
+
+	sort(edges.begin(), edges.end());
+
+	vector<uint8_t> locked(numVertices, 0);
+
+	for (uint64_t e : edges) {
+
+		uint64_t reverse = (e << 32) | (e >> 32);
+
+		if (!binary_search(edges.begin(), edges.end(), reverse)) {
+
+			locked[(uint32_t)(e >> 32)] = 1;
+			locked[(uint32_t)(e & 0xFFFFFFFF)] = 1;
+		}
+	}
+
+
+	//
+	// 3. Collapse passes.  Each pass collapses the cheapest independent edges - a collapse locks the 1-ring of its source so no triangle is modified twice in a pass
+	//
+
+	double maxError = 0.0;
+
+	Adjacency vertexAdjacency;
+	Adjacency triangleAdjacency;
+	vector<Collapse> candidates;
+	vector<uint8_t> touched(numVertices);
+	vector<uint32_t> remap(numVertices);
+	vector<pair<uint32_t, uint32_t> > wedgeMap;
+
+	while (result.size() > targetIndexCount) {
+
+		buildVertexAdjacency(vertexAdjacency, result, numVertices);
+		buildTriangleAdjacency(triangleAdjacency, result, canonical);
+
+		candidates.clear();
+
+		for (size_t t = 0; t < result.size(); t += 3) {
+
+			for (int e = 0; e < 3; ++e) {
+
+				GLuint a = result[t + e];
+				GLuint b = result[t + (e + 1) % 3];
+
+				if (!locked[canonical[a]])
+					candidates.push_back({ a, b, std::max<double>(quadrics[canonical[a]].evaluate(positions[b]), 0.0) });
+
+				if (!locked[canonical[b]])
+					candidates.push_back({ b, a, std::max<double>(quadrics[canonical[b]].evaluate(positions[a]), 0.0) });
+			}
+		}
+
+		sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+		fill(touched.begin(), touched.end(), 0);
+		iota(remap.begin(), remap.end(), 0);
+
+		const size_t trianglesToRemove = (result.size() - targetIndexCount + 2) / 3;
+		size_t trianglesRemoved = 0;
+		bool collapsed = false;
+
+		for (const Collapse& c : candidates) {
+
+			if (trianglesRemoved >= trianglesToRemove)
+				break;
+
+			uint32_t ca = canonical[c.from];
+			uint32_t cb = canonical[c.to];
+
+			if (touched[ca] || touched[cb])
+				continue;
+
+			// Every wedge at the source position needs a neighbouring wedge at the target position to collapse onto, otherwise the seam would be broken
+			wedgeMap.clear();
+
+			bool valid = true;
+			uint32_t w = ca;
+
+			do {
+
+				uint32_t begin = vertexAdjacency.offsets[w];
+				uint32_t end = vertexAdjacency.offsets[w + 1];
+
+				if (begin != end) {
+
+					uint32_t target = 0xFFFFFFFF;
+
+					for (uint32_t k = begin; k < end && target == 0xFFFFFFFF; ++k) {
+
+						if (canonical[vertexAdjacency.items[k]] == cb)
+							target = vertexAdjacency.items[k];
+					}
+
+					if (target == 0xFFFFFFFF) {
+
+						valid = false;
+						break;
+					}
+
+					wedgeMap.push_back(make_pair(w, target));
+				}
+
+				w = wedgeNext[w];
+
+			} while (w != ca);
+
+			if (!valid)
+				continue;
+
+			// Reject collapses that flip or badly distort any surviving triangle
+			size_t removedHere = 0;
+
+			for (uint32_t k = triangleAdjacency.offsets[ca]; k < triangleAdjacency.offsets[ca + 1] && valid; ++k) {
+
+				size_t t = (size_t)triangleAdjacency.items[k] * 3;
+
+				vec3 p[3];
+				bool containsTarget = false;
+
+				for (int e = 0; e < 3; ++e) {
+
+					uint32_t cv = canonical[result[t + e]];
+
+					containsTarget |= (cv == cb);
+					p[e] = (cv == ca) ? positions[cb] : positions[cv];
+				}
+
+				if (containsTarget) {
+
+					removedHere++;
+					continue;
+				}
+
+				vec3 n0 = triangleNormal(positions[result[t]], positions[result[t + 1]], positions[result[t + 2]]);
+				vec3 n1 = triangleNormal(p[0], p[1], p[2]);
+
+				if (dot(n0, n1) <= 0.25f * glm::length(n0) * glm::length(n1))
+					valid = false;
+			}
+
+			if (!valid)
+				continue;
+
+			for (const pair<uint32_t, uint32_t>& m : wedgeMap)
+				remap[m.first] = m.second;
+
+			quadrics[cb].add(quadrics[ca]);
+			maxError = std::max<double>(maxError, c.cost);
+
+			touched[ca] = 1;
+			touched[cb] = 1;
+
+			for (const pair<uint32_t, uint32_t>& m : wedgeMap) {
+
+				for (uint32_t k = vertexAdjacency.offsets[m.first]; k < vertexAdjacency.offsets[m.first + 1]; ++k)
+					touched[canonical[vertexAdjacency.items[k]]] = 1;
+			}
+
+			trianglesRemoved += removedHere;
+			collapsed = true;
+		}
+
+		if (!collapsed)
+			break;
+
+		// Apply this pass's collapses and drop triangles that have become degenerate
+		size_t write = 0;
+
+		for (size_t t = 0; t < result.size(); t += 3) {
+
+			GLuint i0 = remap[result[t]], i1 = remap[result[t + 1]], i2 = remap[result[t + 2]];
+
+			if (isDegenerate(canonical, i0, i1, i2))
+				continue;
+
+			result[write++] = i0;
+			result[write++] = i1;
+			result[write++] = i2;
+		}
+
+		result.resize(write);
+	}
+
+	if (resultError)
+		*resultError = (float)sqrt(maxError);
+
+	return result;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "core.h"
+
+// Quadric error metric (Garland & Heckbert) edge-collapse simplification.  Vertices are only ever collapsed onto other existing vertices so the simplified index list can be drawn from the original vertex buffers.
+//
+// Vertices sharing a position but with different normals or texture coordinates (UV and normal seams left by aiProcess_JoinIdenticalVertices) are treated as wedges of a single position.  A seam position is only collapsed when every wedge has a matching neighbour wedge at the target position, so seams stay intact.  Vertices on an open mesh border are never collapsed.
+//
+// Returns the simplified index list, stopping once the index count reaches targetIndexCount or no further valid collapse exists.  If resultError is not NULL it receives the largest geometric error introduced, in model units.
+std::vector<GLuint> simplifyMesh(const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices, size_t targetIndexCount, float* resultError = NULL);
@@ -0,0 +1,372 @@
+#include "Meshlet.h"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define MESHLET_CULL_SSE
+#endif
+
+using namespace std;
+using namespace glm;
+
+
+// Static member definitions
+const GLuint MeshletSet::maxVertices;
+const GLuint MeshletSet::maxTriangles;
+
+
+// Test meshlets base to base + 3 and return a bit mask of those that are visible.  planes are normalised model coordinate frustum planes (inside where dot(n, p) + d >= 0)
+static int cullBatch(const float* cx, const float* cy, const float* cz, const float* r,
+	const float* ax, const float* ay, const float* az, const float* cutoff,
+	const vec4 planes[6], const vec3& camera, bool coneCulling) {
+
+#ifdef MESHLET_CULL_SSE
+
+	__m128 centreX = _mm_loadu_ps(cx);
+	__m128 centreY = _mm_loadu_ps(cy);
+	__m128 centreZ = _mm_loadu_ps(cz);
+	__m128 radius = _mm_loadu_ps(r);
+	__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+	__m128 visible = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps()); // all bits set
+
+	for (int p = 0; p < 6; ++p) {
+
+		__m128 dist = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].x), centreX), _mm_mul_ps(_mm_set1_ps(planes[p].y), centreY)),
+			_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].z), centreZ), _mm_set1_ps(planes[p].w)));
+
+		visible = _mm_and_ps(visible, _mm_cmpge_ps(dist, negRadius));
+	}
+
+	if (coneCulling) {
+
+		// Backfacing if dot(centre - camera, axis) >= cutoff * |centre - camera| + radius
+		__m128 vx = _mm_sub_ps(centreX, _mm_set1_ps(camera.x));
+		__m128 vy = _mm_sub_ps(centreY, _mm_set1_ps(camera.y));
+		__m128 vz = _mm_sub_ps(centreZ, _mm_set1_ps(camera.z));
+
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_loadu_ps(ax)), _mm_mul_ps(vy, _mm_loadu_ps(ay))), _mm_mul_ps(vz, _mm_loadu_ps(az)));
+
+		__m128 backfacing = _mm_cmpge_ps(d, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(cutoff), length), radius));
+
+		visible = _mm_andnot_ps(backfacing, visible);
+	}
+
+	return _mm_movemask_ps(visible);
+
+#else
+
+	int mask = 0;
+
+	for (int k = 0; k < 4; ++k) {
+
+		vec3 centre = vec3(cx[k], cy[k], cz[k]);
+		bool visible = true;
+
+		for (int p = 0; p < 6 && visible; ++p)
+			visible = (dot(vec3(planes[p]), centre) + planes[p].w >= -r[k]);
+
+		if (visible && coneCulling) {
+
+			vec3 v = centre - camera;
+			visible = !(dot(v, vec3(ax[k], ay[k], az[k])) >= cutoff[k] * glm::length(v) + r[k]);
+		}
+
+		if (visible)
+			mask |= (1 << k);
+	}
+
+	return mask;
+
+#endif
+}
+
+
+// Private functions
+
+void MeshletSet::addMeshlet(const Meshlet& meshlet) {
+
+	meshlets.push_back(meshlet);
+
+	centreX.push_back(meshlet.centre.x);
+	centreY.push_back(meshlet.centre.y);
+	centreZ.push_back(meshlet.centre.z);
+	radius.push_back(meshlet.radius);
+	coneAxisX.push_back(meshlet.coneAxis.x);
+	coneAxisY.push_back(meshlet.coneAxis.y);
+	coneAxisZ.push_back(meshlet.coneAxis.z);
+	coneCutoff.push_back(meshlet.coneCutoff);
+}
+
+
+// Public functions
+
+void MeshletSet::build(const vector<vec3>& positions, vector<GLuint>& indices) {
+
+	meshlets.clear();
+	centreX.clear(); centreY.clear(); centreZ.clear(); radius.clear();
+	coneAxisX.clear(); coneAxisY.clear(); coneAxisZ.clear(); coneCutoff.clear();
+
+	const size_t numVertices = positions.size();
+	const size_t numTriangles = indices.size() / 3;
+
+	// Vertex to triangle adjacency (compressed - the triangles using vertex v are adjacentTriangles[adjacencyOffsets[v]] to adjacentTriangles[adjacencyOffsets[v + 1] - 1])
+	vector<uint32_t> adjacencyOffsets(numVertices + 1, 0);
+	vector<uint32_t> adjacentTriangles(numTriangles * 3);
+
+	for (size_t i = 0; i < numTriangles * 3; ++i)
+		adjacencyOffsets[indices[i] + 1]++;
+
+	for (size_t v = 0; v < numVertices; ++v)
+		adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+	{
+		vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+		for (size_t i = 0; i < numTriangles * 3; ++i)
+			adjacentTriangles[fill[indices[i]]++] = (uint32_t)(i / 3);
+	}
+
+	vector<vec3> triangleNormals(numTriangles);
+
+	for (size_t t = 0; t < numTriangles; ++t) {
+
+		vec3 n = cross(positions[indices[t * 3 + 1]] - positions[indices[t * 3]], positions[indices[t * 3 + 2]] - positions[indices[t * 3]]);
+		float len = glm::length(n);
+
+		triangleNormals[t] = (len > 0.0f) ? n / len : vec3(0.0f);
+	}
+
+	vector<uint8_t> emitted(numTriangles, 0);
+	vector<uint32_t> vertexMeshlet(numVertices, 0xFFFFFFFF); // meshlet currently holding each vertex
+
+	vector<GLuint> reordered;
+	reordered.reserve(indices.size());
+
+	vector<uint32_t> meshletVertices;
+	vector<uint32_t> meshletTriangles;
+
+	size_t seed = 0;
+
+	while (true) {
+
+		while (seed < numTriangles && emitted[seed])
+			seed++;
+
+		if (seed == numTriangles)
+			break;
+
+		const uint32_t meshletID = (uint32_t)meshlets.size();
+
+		meshletVertices.clear();
+		meshletTriangles.clear();
+
+		vec3 normalSum = vec3(0.0f);
+		uint32_t candidate = (uint32_t)seed;
+
+		while (true) {
+
+			// Add the chosen triangle
+			emitted[candidate] = 1;
+			meshletTriangles.push_back(candidate);
+			normalSum += triangleNormals[candidate];
+
+			for (int e = 0; e < 3; ++e) {
+
+				GLuint v = indices[candidate * 3 + e];
+
+				if (vertexMeshlet[v] != meshletID) {
+
+					vertexMeshlet[v] = meshletID;
+					meshletVertices.push_back(v);
+				}
+			}
+
+			if (meshletTriangles.size() >= maxTriangles)
+				break;
+
+			// Choose the next triangle among those sharing a vertex with the meshlet
+			uint32_t best = 0xFFFFFFFF;
+			int bestNewVertices = 4;
+			float bestAlignment = -2.0f;
+
+			vec3 averageNormal = (glm::length(normalSum) > 0.0f) ? glm::normalize(normalSum) : vec3(0.0f);
+
+			for (uint32_t v : meshletVertices) {
+
+				for (uint32_t k = adjacencyOffsets[v]; k < adjacencyOffsets[v + 1]; ++k) {
+
+					uint32_t t = adjacentTriangles[k];
+
+					if (emitted[t])
+						continue;
+
+					int newVertices = 0;
+
+					for (int e = 0; e < 3; ++e)
+						newVertices += (vertexMeshlet[indices[t * 3 + e]] != meshletID) ? 1 : 0;
+
+					if (meshletVertices.size() + newVertices > maxVertices)
+						continue;
+
+					float alignment = dot(triangleNormals[t], averageNormal);
+
+					if (newVertices < bestNewVertices || (newVertices == bestNewVertices && alignment > bestAlignment)) {
+
+						best = t;
+						bestNewVertices = newVertices;
+						bestAlignment = alignment;
+					}
+				}
+			}
+
+			// A disconnected piece of the mesh (or a full vertex budget) ends the meshlet
+			if (best == 0xFFFFFFFF)
+				break;
+
+			candidate = best;
+		}
+
+		// Bounding sphere around the box of the meshlet's vertices
+		vec3 boxMin = positions[meshletVertices[0]];
+		vec3 boxMax = boxMin;
+
+		for (uint32_t v : meshletVertices) {
+
+			boxMin = glm::min(boxMin, positions[v]);
+			boxMax = glm::max(boxMax, positions[v]);
+		}
+
+		Meshlet meshlet;
+
+		meshlet.indexOffset = (GLuint)reordered.size();
+		meshlet.indexCount = (GLuint)meshletTriangles.size() * 3;
+		meshlet.centre = (boxMin + boxMax) * 0.5f;
+		meshlet.radius = 0.0f;
+
+		for (uint32_t v : meshletVertices)
+			meshlet.radius = std::max<float>(meshlet.radius, glm::length(positions[v] - meshlet.centre));
+
+		// Normal cone - disabled (cutoff 1) when the normals spread over more than a hemisphere, or nearly so
+		meshlet.coneAxis = vec3(0.0f);
+		meshlet.coneCutoff = 1.0f;
+
+		if (glm::length(normalSum) > 0.0f) {
+
+			vec3 axis = glm::normalize(normalSum);
+			float minDot = 1.0f;
+
+			for (uint32_t t : meshletTriangles) {
+
+				if (triangleNormals[t] != vec3(0.0f))
+					minDot = std::min<float>(minDot, dot(axis, triangleNormals[t]));
+			}
+
+			if (minDot > 0.1f) {
+
+				meshlet.coneAxis = axis;
+				meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+			}
+		}
+
+		for (uint32_t t : meshletTriangles) {
+
+			reordered.push_back(indices[t * 3]);
+			reordered.push_back(indices[t * 3 + 1]);
+			reordered.push_back(indices[t * 3 + 2]);
+		}
+
+		addMeshlet(meshlet);
+	}
+
+	indices.swap(reordered);
+
+	// Pad the culling arrays so the last batch of 4 can be loaded whole
+	while (centreX.size() % 4 != 0) {
+
+		centreX.push_back(0.0f); centreY.push_back(0.0f); centreZ.push_back(0.0f); radius.push_back(0.0f);
+		coneAxisX.push_back(0.0f); coneAxisY.push_back(0.0f); coneAxisZ.push_back(0.0f); coneCutoff.push_back(1.0f);
+	}
+}
+
+
+size_t MeshletSet::count() const {
+
+	return meshlets.size();
+}
+
+
+const Meshlet& MeshletSet::getMeshlet(size_t i) const {
+
+	return meshlets[i];
+}
+
+
+void MeshletSet::cull(const mat4& modelTransform, const mat4& viewProjection, const vec3& cameraPos, MeshletDrawList& drawList) const {
+
+	drawList.counts.clear();
+	drawList.offsets.clear();
+	drawList.visibleMeshlets = 0;
+	drawList.visibleTriangles = 0;
+
+	// Frustum planes in model coordinates (Gribb / Hartmann) - normalised so plane distances are in model units like the meshlet radii
+	mat4 M = viewProjection * modelTransform;
+	vec4 planes[6];
+
+	vec4 row0 = vec4(M[0][0], M[1][0], M[2][0], M[3][0]);
+	vec4 row1 = vec4(M[0][1], M[1][1], M[2][1], M[3][1]);
+	vec4 row2 = vec4(M[0][2], M[1][2], M[2][2], M[3][2]);
+	vec4 row3 = vec4(M[0][3], M[1][3], M[2][3], M[3][3]);
+
+	planes[0] = row3 + row0;
+	planes[1] = row3 - row0;
+	planes[2] = row3 + row1;
+	planes[3] = row3 - row1;
+	planes[4] = row3 + row2;
+	planes[5] = row3 - row2;
+
+	for (int p = 0; p < 6; ++p)
+		planes[p] /= glm::length(vec3(planes[p]));
+
+	vec3 cameraModel = vec3(glm::inverse(modelTransform) * vec4(cameraPos, 1.0f));
+
+	float sx = glm::length(vec3(modelTransform[0]));
+	float sy = glm::length(vec3(modelTransform[1]));
+	float sz = glm::length(vec3(modelTransform[2]));
+
+	bool coneCulling = (fabsf(sx - sy) <= 1.0e-3f * sx) && (fabsf(sx - sz) <= 1.0e-3f * sx);
+
+	GLuint rangeEnd = 0xFFFFFFFF;
+
+	for (size_t base = 0; base < meshlets.size(); base += 4) {
+
+		int mask = cullBatch(&centreX[base], &centreY[base], &centreZ[base], &radius[base],
+			&coneAxisX[base], &coneAxisY[base], &coneAxisZ[base], &coneCutoff[base],
+			planes, cameraModel, coneCulling);
+
+		for (size_t k = 0; k < 4 && base + k < meshlets.size(); ++k) {
+
+			if (!(mask & (1 << k)))
+				continue;
+
+			const Meshlet& meshlet = meshlets[base + k];
+
+			if (meshlet.indexOffset == rangeEnd) {
+
+				drawList.counts.back() += meshlet.indexCount;
+			}
+			else {
+
+				drawList.counts.push_back(meshlet.indexCount);
+				drawList.offsets.push_back((const GLvoid*)(meshlet.indexOffset * sizeof(GLuint)));
+			}
+
+			rangeEnd = meshlet.indexOffset + meshlet.indexCount;
+
+			drawList.visibleMeshlets++;
+			drawList.visibleTriangles += meshlet.indexCount / 3;
+		}
+	}
+}
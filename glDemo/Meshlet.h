@@ -0,0 +1,55 @@
+#pragma once
+
+#include "core.h"
+
+// Small cluster of triangles from a mesh's LOD 0 index list, with the data needed to cull it as a unit.  The bounding sphere and normal cone are in model coordinates
+struct Meshlet {
+
+	GLuint				indexOffset; // first index in the mesh index buffer
+	GLuint				indexCount;
+
+	glm::vec3			centre;
+	float				radius;
+
+	// Every triangle normal lies within the cone around coneAxis.  coneCutoff is the sine of the cone half-angle, or 1 if the cone is too wide to ever cull
+	glm::vec3			coneAxis;
+	float				coneCutoff;
+};
+
+
+// Visible meshlets for one instance, as index ranges ready for glMultiDrawElements.  Meshlets that are adjacent in the index buffer are merged into a single range
+struct MeshletDrawList {
+
+	std::vector<GLsizei>		counts;
+	std::vector<const GLvoid*>	offsets; // byte offsets into the element buffer
+
+	GLuint						visibleMeshlets = 0;
+	GLuint						visibleTriangles = 0;
+};
+
+
+// Meshlets for one mesh.  Culling data is also kept in structure-of-arrays form padded to a multiple of 4 so four meshlets are tested at once with SSE
+class MeshletSet {
+
+	std::vector<Meshlet>	meshlets;
+
+	std::vector<float>		centreX, centreY, centreZ, radius;
+	std::vector<float>		coneAxisX, coneAxisY, coneAxisZ, coneCutoff;
+
+	// Private functions
+	void addMeshlet(const Meshlet& meshlet);
+
+public:
+
+	static const GLuint		maxVertices = 64;
+	static const GLuint		maxTriangles = 124;
+
+	// Partition the triangles in indices into meshlets of at most maxVertices unique vertices and maxTriangles triangles.  Triangles are grown from a seed into neighbouring triangles that add the fewest new vertices, preferring normals close to the meshlet's average so the normal cones stay tight.  indices is reordered in place so each meshlet is a contiguous range
+	void build(const std::vector<glm::vec3>& positions, std::vector<GLuint>& indices);
+
+	size_t count() const;
+	const Meshlet& getMeshlet(size_t i) const;
+
+	// Frustum cull every meshlet against viewProjection * modelTransform and backface cull with the normal cones for a camera at cameraPos (world coordinates).  Cone culling is skipped for instances with non-uniform scale since it does not preserve normal directions.  Results replace the contents of drawList
+	void cull(const glm::mat4& modelTransform, const glm::mat4& viewProjection, const glm::vec3& cameraPos, MeshletDrawList& drawList) const;
+};
@@ -0,0 +1,305 @@
+#include "Microbenchmark.h"
+#include "GUClock.h"
+#include <algorithm>
+
+using namespace std;
+
+
+static const uint64_t maxBenchmarkIterations = 1000000000;
+
+
+struct GUBenchmarkResult {
+
+	std::string				name;
+	uint64_t				iterations = 0;
+	std::vector<double>		iterationTimes; // seconds per iteration, one entry per repetition
+	double					itemsPerSecond = 0.0;
+	double					bytesPerSecond = 0.0;
+	std::string				error;
+
+	double mean() const {
+
+		double sum = 0.0;
+
+		for (double t : iterationTimes)
+			sum += t;
+
+		return (iterationTimes.empty()) ? 0.0 : sum / (double)iterationTimes.size();
+	}
+
+	double median() const {
+
+		vector<double> sorted = iterationTimes;
+		sort(sorted.begin(), sorted.end());
+
+		size_t n = sorted.size();
+
+		if (n == 0)
+			return 0.0;
+
+		return (n % 2 == 1) ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+	}
+
+	double stddev() const {
+
+		if (iterationTimes.size() < 2)
+			return 0.0;
+
+		double m = mean();
+		double sum = 0.0;
+
+		for (double t : iterationTimes)
+			sum += (t - m) * (t - m);
+
+		return sqrt(sum / (double)(iterationTimes.size() - 1));
+	}
+};
+
+
+// Time with a unit that keeps 3 or more significant figures in front of the decimal point
+static string formatTime(double seconds) {
+
+	char buffer[32];
+
+	if (seconds < 1.0e-6)
+		snprintf(buffer, sizeof(buffer), "%.2f ns", seconds * 1.0e9);
+	else if (seconds < 1.0e-3)
+		snprintf(buffer, sizeof(buffer), "%.2f us", seconds * 1.0e6);
+	else if (seconds < 1.0)
+		snprintf(buffer, sizeof(buffer), "%.2f ms", seconds * 1.0e3);
+	else
+		snprintf(buffer, sizeof(buffer), "%.3f s", seconds);
+
+	return string(buffer);
+}
+
+
+static string formatRate(double rate, const char* unit) {
+
+	char buffer[32];
+
+	if (rate <= 0.0)
+		return string();
+
+	if (rate >= 1.0e9)
+		snprintf(buffer, sizeof(buffer), "%.2fG %s/s", rate * 1.0e-9, unit);
+	else if (rate >= 1.0e6)
+		snprintf(buffer, sizeof(buffer), "%.2fM %s/s", rate * 1.0e-6, unit);
+	else if (rate >= 1.0e3)
+		snprintf(buffer, sizeof(buffer), "%.2fk %s/s", rate * 1.0e-3, unit);
+	else
+		snprintf(buffer, sizeof(buffer), "%.2f %s/s", rate, unit);
+
+	return string(buffer);
+}
+
+
+
+// GUBenchmarkState
+
+GUBenchmarkState::GUBenchmarkState(uint64_t iterations) {
+
+	maxIterations = iterations;
+}
+
+
+void GUBenchmarkState::pauseTiming() {
+
+	if (running) {
+
+		elapsedTicks += GUBaseClockSource::now() - startTicks;
+		running = false;
+	}
+}
+
+
+void GUBenchmarkState::resumeTiming() {
+
+	if (!running) {
+
+		running = true;
+		startTicks = GUBaseClockSource::now();
+	}
+}
+
+
+uint64_t GUBenchmarkState::iterations() const {
+
+	return maxIterations;
+}
+
+
+void GUBenchmarkState::setItemsProcessed(uint64_t items) {
+
+	itemsProcessed = items;
+}
+
+
+void GUBenchmarkState::setBytesProcessed(uint64_t bytes) {
+
+	bytesProcessed = bytes;
+}
+
+
+void GUBenchmarkState::skipWithError(const std::string& message) {
+
+	error = message;
+}
+
+
+
+// GUBenchmarkRegistry
+
+std::vector<GUBenchmarkRegistry::Benchmark>& GUBenchmarkRegistry::benchmarks() {
+
+	static vector<Benchmark> list;
+	return list;
+}
+
+
+void GUBenchmarkRegistry::add(const std::string& name, std::function<void(GUBenchmarkState&)> function) {
+
+	benchmarks().push_back(Benchmark{ name, function });
+}
+
+
+int GUBenchmarkRegistry::run(const GUBenchmarkSettings& settings) {
+
+	const double frequency = (double)GUBaseClockSource::frequency();
+	const int repetitions = std::max<int>(settings.repetitions, 1);
+
+	vector<GUBenchmarkResult> results;
+	int failures = 0;
+
+	printf("%-48s %12s %12s %10s %7s %12s  %s\n", "Benchmark", "Mean", "Median", "Stddev", "CV", "Iterations", "Rate");
+	printf("%s\n", string(120, '-').c_str());
+
+	for (const Benchmark& b : benchmarks()) {
+
+		if (!settings.filter.empty() && b.name.find(settings.filter) == string::npos)
+			continue;
+
+		GUBenchmarkResult result;
+		result.name = b.name;
+
+		// Grow the iteration count until one run takes minTime.  The calibration runs also warm the caches, allocator and file cache before anything is measured
+		uint64_t iterations = 1;
+
+		for (;;) {
+
+			GUBenchmarkState state(iterations);
+			b.function(state);
+			state.pauseTiming();
+
+			double seconds = (double)state.elapsedTicks / frequency;
+
+			if (!state.error.empty()) {
+
+				result.error = state.error;
+				break;
+			}
+
+			if (seconds >= settings.minTime || iterations >= maxBenchmarkIterations)
+				break;
+
+			double scale = (seconds > 0.0) ? std::min<double>(settings.minTime * 1.4 / seconds, 10.0) : 10.0;
+			iterations = std::min<uint64_t>(std::max<uint64_t>(iterations + 1, (uint64_t)((double)iterations * scale)), maxBenchmarkIterations);
+		}
+
+		result.iterations = iterations;
+
+		for (int r = 0; r < repetitions && result.error.empty(); ++r) {
+
+			GUBenchmarkState state(iterations);
+			b.function(state);
+			state.pauseTiming();
+
+			if (!state.error.empty()) {
+
+				result.error = state.error;
+				break;
+			}
+
+			double seconds = (double)state.elapsedTicks / frequency;
+
+			result.iterationTimes.push_back(seconds / (double)iterations);
+
+			if (seconds > 0.0) {
+
+				result.itemsPerSecond += (double)state.itemsProcessed / seconds / (double)repetitions;
+				result.bytesPerSecond += (double)state.bytesProcessed / seconds / (double)repetitions;
+			}
+		}
+
+		if (!result.error.empty()) {
+
+			printf("%-48s ERROR: %s\n", b.name.c_str(), result.error.c_str());
+			failures++;
+		}
+		else {
+
+			double mean = result.mean();
+			string rate = (result.bytesPerSecond > 0.0) ? formatRate(result.bytesPerSecond, "B") : formatRate(result.itemsPerSecond, "items");
+
+			printf("%-48s %12s %12s %10s %6.2f%% %12llu  %s\n",
+				b.name.c_str(),
+				formatTime(mean).c_str(),
+				formatTime(result.median()).c_str(),
+				formatTime(result.stddev()).c_str(),
+				(mean > 0.0) ? 100.0 * result.stddev() / mean : 0.0,
+				(unsigned long long)iterations,
+				rate.c_str());
+		}
+
+		fflush(stdout);
+
+		results.push_back(result);
+	}
+
+	if (!settings.outputFile.empty()) {
+
+		ofstream out(settings.outputFile);
+
+		if (!out.is_open()) {
+
+			cout << "Could not write benchmark results to " << settings.outputFile << endl;
+			return failures + 1;
+		}
+
+		out << "{\n";
+		out << "  \"min_time_s\": " << settings.minTime << ",\n";
+		out << "  \"repetitions\": " << repetitions << ",\n";
+		out << "  \"benchmarks\": [";
+
+		for (size_t i = 0; i < results.size(); ++i) {
+
+			const GUBenchmarkResult& r = results[i];
+
+			out << ((i > 0) ? ",\n" : "\n") << "    { \"name\": \"" << guJsonEscape(r.name) << "\"";
+
+			if (!r.error.empty()) {
+
+				out << ", \"error\": \"" << guJsonEscape(r.error) << "\" }";
+				continue;
+			}
+
+			out << ", \"iterations\": " << r.iterations;
+			out << ", \"mean_ns\": " << r.mean() * 1.0e9 << ", \"median_ns\": " << r.median() * 1.0e9 << ", \"stddev_ns\": " << r.stddev() * 1.0e9;
+			out << ", \"min_ns\": " << *min_element(r.iterationTimes.begin(), r.iterationTimes.end()) * 1.0e9;
+
+			if (r.itemsPerSecond > 0.0)
+				out << ", \"items_per_second\": " << r.itemsPerSecond;
+
+			if (r.bytesPerSecond > 0.0)
+				out << ", \"bytes_per_second\": " << r.bytesPerSecond;
+
+			out << " }";
+		}
+
+		out << "\n  ]\n}\n";
+
+		cout << "Wrote benchmark results to " << settings.outputFile << endl;
+	}
+
+	return failures;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+//
+// Minimal microbenchmark harness in the style of Google Benchmark.  A benchmark is a function that repeats the code under test while state.keepRunning() returns true - the harness picks an iteration count that runs for at least minTime seconds, then times several repetitions of that count and reports the mean, median, spread and coefficient of variation per iteration.  A high coefficient of variation means the numbers are not yet stable enough to prove an optimisation (close other programs, fix the CPU clock or raise minTime).
+//
+//	static void benchmarkSomething(GUBenchmarkState& state) {
+//
+//		setup();
+//
+//		while (state.keepRunning())
+//			guDoNotOptimize(something());
+//	}
+//
+//	GUBenchmarkRegistry::add("something", benchmarkSomething);
+//
+
+#include "core.h"
+#include "GUClockSource.h"
+#include <functional>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+// Keep value (and the work that produced it) from being optimised away without storing it anywhere
+template <typename T>
+inline void guDoNotOptimize(const T& value) {
+
+#ifdef _MSC_VER
+	const volatile char* p = (const volatile char*)&value;
+	(void)*p;
+	_ReadWriteBarrier();
+#else
+	asm volatile("" : : "m"(value) : "memory");
+#endif
+}
+
+
+// Force pending writes to memory to be treated as observed
+inline void guClobberMemory() {
+
+#ifdef _MSC_VER
+	_ReadWriteBarrier();
+#else
+	asm volatile("" : : : "memory");
+#endif
+}
+
+
+class GUBenchmarkState {
+
+	friend class GUBenchmarkRegistry;
+
+	uint64_t				maxIterations;
+	uint64_t				iteration = 0;
+
+	int64_t					startTicks = 0;
+	int64_t					elapsedTicks = 0;
+	bool					running = false;
+
+	uint64_t				itemsProcessed = 0;
+	uint64_t				bytesProcessed = 0;
+	std::string				error;
+
+	GUBenchmarkState(uint64_t iterations);
+
+public:
+
+	// Returns true while there are iterations left to run.  Timing starts on the first call and stops on the last
+	bool keepRunning() {
+
+		if (iteration < maxIterations && error.empty()) {
+
+			if (iteration++ == 0)
+				resumeTiming();
+
+			return true;
+		}
+
+		if (running)
+			pauseTiming();
+
+		return false;
+	}
+
+	// Exclude per iteration setup from the timing
+	void pauseTiming();
+	void resumeTiming();
+
+	uint64_t iterations() const;
+
+	// Totals over all iterations - reported as rates
+	void setItemsProcessed(uint64_t items);
+	void setBytesProcessed(uint64_t bytes);
+
+	// Abandon the benchmark (eg. an asset failed to load).  keepRunning returns false from the next call
+	void skipWithError(const std::string& message);
+};
+
+
+struct GUBenchmarkSettings {
+
+	double					minTime = 0.5; // seconds per repetition
+	int						repetitions = 5;
+	std::string				filter; // run benchmarks whose name contains filter (all if empty)
+	std::string				outputFile; // JSON results, none if empty
+};
+
+
+class GUBenchmarkRegistry {
+
+	struct Benchmark {
+
+		std::string								name;
+		std::function<void(GUBenchmarkState&)>	function;
+	};
+
+	static std::vector<Benchmark>& benchmarks();
+
+public:
+
+	static void add(const std::string& name, std::function<void(GUBenchmarkState&)> function);
+
+	// Run every registered benchmark matching settings.filter and print the results.  Returns the number of benchmarks that failed
+	static int run(const GUBenchmarkSettings& settings);
+};
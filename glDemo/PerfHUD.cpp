@@ -0,0 +1,506 @@
+#include "PerfHUD.h"
+#include "GPUPassTimer.h"
+#include "shader_setup.h"
+#include <cstddef>
+
+using namespace std;
+using namespace glm;
+
+
+#pragma region Font data
+
+// 8x8 bitmap font for ASCII 32 to 126 (public domain, from the IBM PC BIOS font) - one byte per row, top row first, bit 0 the leftmost pixel.  The last cell (127) is solid and used for panels and graph bars
+static const int		firstGlyph = 32;
+static const int		glyphCount = 96;
+static const int		glyphSize = 8;
+static const int		atlasColumns = 16;
+static const int		atlasRows = glyphCount / atlasColumns;
+
+static const uint8_t	fontGlyphs[glyphCount][glyphSize] = {
+
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // space
+	{ 0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00 }, // !
+	{ 0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // "
+	{ 0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00 }, // #
+	{ 0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00 }, // $
+	{ 0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00 }, // %
+	{ 0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00 }, // &
+	{ 0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '
+	{ 0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00 }, // (
+	{ 0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00 }, // )
+	{ 0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00 }, // *
+	{ 0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00 }, // +
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06 }, // ,
+	{ 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00 }, // -
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00 }, // .
+	{ 0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00 }, // /
+	{ 0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00 }, // 0
+	{ 0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00 }, // 1
+	{ 0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00 }, // 2
+	{ 0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00 }, // 3
+	{ 0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00 }, // 4
+	{ 0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00 }, // 5
+	{ 0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00 }, // 6
+	{ 0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00 }, // 7
+	{ 0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00 }, // 8
+	{ 0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00 }, // 9
+	{ 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00 }, // :
+	{ 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06 }, // ;
+	{ 0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00 }, // <
+	{ 0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00 }, // =
+	{ 0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00 }, // >
+	{ 0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00 }, // ?
+	{ 0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00 }, // @
+	{ 0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00 }, // A
+	{ 0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00 }, // B
+	{ 0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00 }, // C
+	{ 0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00 }, // D
+	{ 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00 }, // E
+	{ 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00 }, // F
+	{ 0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00 }, // G
+	{ 0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00 }, // H
+	{ 0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // I
+	{ 0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00 }, // J
+	{ 0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00 }, // K
+	{ 0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00 }, // L
+	{ 0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00 }, // M
+	{ 0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00 }, // N
+	{ 0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00 }, // O
+	{ 0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00 }, // P
+	{ 0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00 }, // Q
+	{ 0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00 }, // R
+	{ 0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00 }, // S
+	{ 0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // T
+	{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00 }, // U
+	{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 }, // V
+	{ 0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00 }, // W
+	{ 0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00 }, // X
+	{ 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00 }, // Y
+	{ 0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00 }, // Z
+	{ 0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00 }, // [
+	{ 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00 }, // backslash
+	{ 0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00 }, // ]
+	{ 0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00 }, // ^
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF }, // _
+	{ 0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00 }, // `
+	{ 0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00 }, // a
+	{ 0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00 }, // b
+	{ 0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00 }, // c
+	{ 0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00 }, // d
+	{ 0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00 }, // e
+	{ 0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00 }, // f
+	{ 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F }, // g
+	{ 0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00 }, // h
+	{ 0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // i
+	{ 0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E }, // j
+	{ 0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00 }, // k
+	{ 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // l
+	{ 0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00 }, // m
+	{ 0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00 }, // n
+	{ 0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00 }, // o
+	{ 0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F }, // p
+	{ 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78 }, // q
+	{ 0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00 }, // r
+	{ 0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00 }, // s
+	{ 0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00 }, // t
+	{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00 }, // u
+	{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 }, // v
+	{ 0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00 }, // w
+	{ 0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00 }, // x
+	{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F }, // y
+	{ 0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00 }, // z
+	{ 0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00 }, // {
+	{ 0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00 }, // |
+	{ 0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00 }, // }
+	{ 0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ~
+	{ 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF } // solid
+};
+
+#pragma endregion
+
+
+static const int		solidGlyph = 127;
+
+
+// Static member definitions
+const int GUPerfHUD::graphFrames;
+const int GUPerfHUD::maxPasses;
+
+
+// Pack a colour for the GL_UNSIGNED_BYTE colour attribute - red is the first byte in memory
+static uint32_t hudColour(uint32_t r, uint32_t g, uint32_t b, uint32_t a = 255) {
+
+	return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+
+// Atlas texture coordinates of a glyph's cell
+static vec4 glyphTexRect(int c) {
+
+	if (c < firstGlyph || c >= firstGlyph + glyphCount)
+		c = '?';
+
+	int cell = c - firstGlyph;
+
+	float u = (float)(cell % atlasColumns) / (float)atlasColumns;
+	float v = (float)(cell / atlasColumns) / (float)atlasRows;
+
+	return vec4(u, v, u + 1.0f / (float)atlasColumns, v + 1.0f / (float)atlasRows);
+}
+
+
+
+// Private method implementation
+
+void GUPerfHUD::addQuad(float x, float y, float width, float height, const vec4& texRect, uint32_t colour) {
+
+	quads.push_back(Quad{ vec4(x, y, width, height), texRect, colour });
+}
+
+
+void GUPerfHUD::addSolid(float x, float y, float width, float height, uint32_t colour) {
+
+	// Sample the centre of the solid cell so filtering never reaches a neighbouring glyph
+	vec4 cell = glyphTexRect(solidGlyph);
+	vec2 centre = (vec2(cell.x, cell.y) + vec2(cell.z, cell.w)) * 0.5f;
+
+	addQuad(x, y, width, height, vec4(centre, centre), colour);
+}
+
+
+void GUPerfHUD::addText(float x, float y, const char* text, uint32_t colour) {
+
+	float size = (float)(glyphSize * scale);
+
+	for (const char* c = text; *c; ++c, x += size) {
+
+		if (*c != ' ')
+			addQuad(x, y, size, size, glyphTexRect((unsigned char)*c), colour);
+	}
+}
+
+
+void GUPerfHUD::rebuild(const GPUPassTimer& passes, const GURenderCounters& frameStats, int viewportWidth, int viewportHeight) {
+
+	quads.clear();
+
+	const int columns = 46; // characters per line
+	const float glyph = (float)(glyphSize * scale);
+	const float lineHeight = (float)((glyphSize + 3) * scale);
+	const float margin = (float)(8 * scale);
+	const float padding = (float)(6 * scale);
+
+	const float barWidth = (float)(2 * scale);
+	const float graphHeight = (float)(48 * scale);
+
+	int passCount = std::min<int>(passes.passCount(), maxPasses);
+	int textLines = 4 + passCount + 2; // frame rate, graph key, blank, pass header, passes, counts
+
+	float panelWidth = std::max<float>(columns * glyph, graphFrames * barWidth) + padding * 2.0f;
+	float panelHeight = textLines * lineHeight + graphHeight + padding * 3.0f;
+
+	float x = margin + padding;
+	float y = margin + padding;
+
+	addSolid(margin, margin, panelWidth, panelHeight, hudColour(0, 0, 0, 160));
+
+	const uint32_t textColour = hudColour(230, 230, 230);
+	const uint32_t headingColour = hudColour(140, 200, 255);
+
+	char line[128];
+
+	// Frame rate over the interval and the worst frame in the graph
+	float worstFrame = 0.0f;
+
+	for (float t : frameTimes)
+		worstFrame = std::max<float>(worstFrame, t);
+
+	gu_seconds meanFrame = (intervalFrames > 0) ? intervalFrameTime / (gu_seconds)intervalFrames : 0.0;
+
+	snprintf(line, sizeof(line), "%6.1f fps %7.2f ms  worst %7.2f ms", (meanFrame > 0.0) ? 1.0 / meanFrame : 0.0, meanFrame * 1000.0, worstFrame * 1000.0f);
+	addText(x, y, line, textColour);
+	y += lineHeight;
+
+	// Frame time graph - the scale covers at least 30Hz, with lines at 60Hz and 30Hz
+	const float target60 = 1.0f / 60.0f;
+	const float target30 = 1.0f / 30.0f;
+
+	float graphTop = std::max<float>(worstFrame, target30) * 1.1f;
+	float graphBottom = y + padding + graphHeight;
+
+	for (int i = 0; i < graphFrames; ++i) {
+
+		float t = frameTimes[(graphHead + i) % graphFrames];
+
+		if (t <= 0.0f)
+			continue;
+
+		float height = std::max<float>(graphHeight * std::min<float>(t / graphTop, 1.0f), (float)scale);
+
+		uint32_t colour = (t <= target60) ? hudColour(80, 220, 80) : (t <= target30) ? hudColour(240, 200, 60) : hudColour(240, 70, 60);
+
+		addSolid(x + i * barWidth, graphBottom - height, barWidth, height, colour);
+	}
+
+	addSolid(x, graphBottom - graphHeight * (target60 / graphTop), graphFrames * barWidth, (float)scale, hudColour(255, 255, 255, 110));
+	addSolid(x, graphBottom - graphHeight * (target30 / graphTop), graphFrames * barWidth, (float)scale, hudColour(255, 255, 255, 110));
+
+	y = graphBottom + padding;
+
+	snprintf(line, sizeof(line), "last %d frames, lines at 60Hz and 30Hz", graphFrames);
+	addText(x, y, line, hudColour(160, 160, 160));
+	y += lineHeight * 2.0f;
+
+	// CPU time issuing each pass and GPU time executing it, averaged over the interval
+	snprintf(line, sizeof(line), "%-26s %6s %7s", "pass", "cpu ms", "gpu ms");
+	addText(x, y, line, headingColour);
+	y += lineHeight;
+
+	for (int p = 0; p < passCount; ++p) {
+
+		double cpu = (intervalFrames > 0) ? intervalCPUTime[p] / (double)intervalFrames * 1000.0 : 0.0;
+
+		if (intervalGPUFrames[p] > 0)
+			snprintf(line, sizeof(line), "%-26.26s %6.2f %7.2f", passes.passName(p).c_str(), cpu, intervalGPUTime[p] / (double)intervalGPUFrames[p] * 1000.0);
+		else
+			snprintf(line, sizeof(line), "%-26.26s %6.2f %7s", passes.passName(p).c_str(), cpu, "-");
+
+		addText(x, y, line, textColour);
+		y += lineHeight;
+	}
+
+	// Counts of the last complete frame
+	snprintf(line, sizeof(line), "draws %llu  instances %llu  tris %llu", (unsigned long long)frameStats.drawCalls, (unsigned long long)frameStats.instances, (unsigned long long)frameStats.triangles);
+	addText(x, y, line, textColour);
+	y += lineHeight;
+
+	snprintf(line, sizeof(line), "binds prog %llu  vao %llu  tex %llu", (unsigned long long)frameStats.programBinds, (unsigned long long)frameStats.vaoBinds, (unsigned long long)frameStats.textureBinds);
+	addText(x, y, line, textColour);
+
+	// Upload - orphan the old storage so the driver does not stall on quads still being drawn
+	GLsizeiptr size = (GLsizeiptr)(quads.size() * sizeof(Quad));
+
+	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+
+	if (size > quadVBOSize) {
+
+		quadVBOSize = size;
+		glBufferData(GL_ARRAY_BUFFER, size, quads.data(), GL_STREAM_DRAW);
+	}
+	else {
+
+		glBufferData(GL_ARRAY_BUFFER, quadVBOSize, NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, quads.data());
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	GURenderStats::countBufferUpload(size);
+
+	uploadedQuads = (GLsizei)quads.size();
+	builtWidth = viewportWidth;
+	builtHeight = viewportHeight;
+}
+
+
+
+// Public method implementation
+
+GUPerfHUD::GUPerfHUD() {
+
+	for (int i = 0; i < graphFrames; ++i)
+		frameTimes[i] = 0.0f;
+
+	for (int p = 0; p < maxPasses; ++p) {
+
+		intervalCPUTime[p] = 0.0;
+		intervalGPUTime[p] = 0.0;
+		intervalGPUFrames[p] = 0;
+	}
+
+	shader = setupShaders(string("Assets/Shaders/perf-hud.vert"), string("Assets/Shaders/perf-hud.frag"));
+
+	shader_viewportSize = glGetUniformLocation(shader, "viewportSize");
+	shader_fontAtlas = glGetUniformLocation(shader, "fontAtlas");
+
+	// Font atlas - one byte per texel, cells laid out left to right, top to bottom
+	const int atlasWidth = atlasColumns * glyphSize;
+	const int atlasHeight = atlasRows * glyphSize;
+
+	vector<uint8_t> texels(atlasWidth * atlasHeight, 0);
+
+	for (int g = 0; g < glyphCount; ++g) {
+
+		int cellX = (g % atlasColumns) * glyphSize;
+		int cellY = (g / atlasColumns) * glyphSize;
+
+		for (int row = 0; row < glyphSize; ++row) {
+
+			for (int bit = 0; bit < glyphSize; ++bit) {
+
+				if (fontGlyphs[g][row] & (1 << bit))
+					texels[(cellY + row) * atlasWidth + cellX + bit] = 255;
+			}
+		}
+	}
+
+	glGenTextures(1, &fontAtlas);
+	glBindTexture(GL_TEXTURE_2D, fontAtlas);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasWidth, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, texels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GURenderStats::countTextureUpload(texels.size());
+
+	// Quads are instances with no per-vertex data - the vertex shader builds the corners from gl_VertexID
+	glGenVertexArrays(1, &quadVAO);
+	glBindVertexArray(quadVAO);
+
+	glGenBuffers(1, &quadVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Quad), (const GLvoid*)offsetof(Quad, rect));
+	glVertexAttribDivisor(0, 1);
+	glEnableVertexAttribArray(0);
+
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Quad), (const GLvoid*)offsetof(Quad, texRect));
+	glVertexAttribDivisor(1, 1);
+	glEnableVertexAttribArray(1);
+
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Quad), (const GLvoid*)offsetof(Quad, colour));
+	glVertexAttribDivisor(2, 1);
+	glEnableVertexAttribArray(2);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// Panel, graph and a few hundred glyphs
+	quads.reserve(1024);
+}
+
+
+GUPerfHUD::~GUPerfHUD() {
+
+	glDeleteVertexArrays(1, &quadVAO);
+	glDeleteBuffers(1, &quadVBO);
+	glDeleteTextures(1, &fontAtlas);
+	glDeleteProgram(shader);
+}
+
+
+void GUPerfHUD::setVisible(bool show) {
+
+	visible = show;
+}
+
+
+bool GUPerfHUD::isVisible() const {
+
+	return visible;
+}
+
+
+void GUPerfHUD::setUpdateInterval(gu_seconds interval) {
+
+	updateInterval = interval;
+}
+
+
+void GUPerfHUD::render(const GPUPassTimer& passes, const GURenderCounters& frameStats, int viewportWidth, int viewportHeight) {
+
+	int64_t now = GUClockSource::now();
+	gu_seconds frequency = (gu_seconds)GUClockSource::frequency();
+
+	if (lastFrameTicks != 0) {
+
+		gu_seconds frameTime = (gu_seconds)(now - lastFrameTicks) / frequency;
+
+		frameTimes[graphHead] = (float)frameTime;
+		graphHead = (graphHead + 1) % graphFrames;
+
+		intervalFrames++;
+		intervalFrameTime += frameTime;
+	}
+
+	lastFrameTicks = now;
+
+	int passCount = std::min<int>(passes.passCount(), maxPasses);
+
+	for (int p = 0; p < passCount; ++p) {
+
+		intervalCPUTime[p] += passes.lastCPUTime(p);
+
+		if (passes.lastGPUTime(p) >= 0.0) {
+
+			intervalGPUTime[p] += passes.lastGPUTime(p);
+			intervalGPUFrames[p]++;
+		}
+	}
+
+	if (viewportWidth <= 0 || viewportHeight <= 0)
+		return;
+
+	bool resized = visible && (viewportWidth != builtWidth || viewportHeight != builtHeight);
+
+	if ((gu_seconds)(now - lastUpdateTicks) >= updateInterval * frequency || resized) {
+
+		if (visible) {
+
+			// Readable at high resolutions without covering much of the view at low ones
+			scale = std::max<int>(viewportHeight / 720, 1);
+
+			rebuild(passes, frameStats, viewportWidth, viewportHeight);
+		}
+
+		intervalFrames = 0;
+		intervalFrameTime = 0.0;
+
+		for (int p = 0; p < maxPasses; ++p) {
+
+			intervalCPUTime[p] = 0.0;
+			intervalGPUTime[p] = 0.0;
+			intervalGPUFrames[p] = 0;
+		}
+
+		lastUpdateTicks = now;
+	}
+
+	if (!visible || uploadedQuads == 0)
+		return;
+
+	glUseProgram(shader);
+	glUniform2f(shader_viewportSize, (GLfloat)viewportWidth, (GLfloat)viewportHeight);
+	glUniform1i(shader_fontAtlas, 0);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, fontAtlas);
+	glBindVertexArray(quadVAO);
+
+	GURenderStats::countProgramBind();
+	GURenderStats::countUniformUpload(2);
+	GURenderStats::countTextureBind();
+	GURenderStats::countVAOBind();
+
+	// Drawn over everything, with the strips' winding flipped by the y-down pixel coordinates
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_CULL_FACE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, uploadedQuads);
+
+	GURenderStats::countDraw(6, uploadedQuads);
+
+	glDisable(GL_BLEND);
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_DEPTH_TEST);
+
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+//
+// On-screen performance overlay drawn over the finished frame - frame rate and a frame time graph, CPU and GPU time per render pass (from GPUPassTimer) and the draw, triangle and bind counts of the last frame (from GURenderStats).
+//
+// Text uses a built-in 8x8 bitmap font baked into one small atlas texture.  Every glyph, graph bar and the background panel is a quad in a single per-instance buffer, so the whole HUD costs one instanced draw call.  Frame times are recorded every frame but the quads are only rebuilt and uploaded every updateInterval, with the pass times averaged over the interval so the numbers are readable.
+//
+
+#include "core.h"
+#include "GUClock.h"
+#include "RenderStats.h"
+
+class GPUPassTimer;
+
+
+class GUPerfHUD {
+
+private:
+
+	// One quad - position and size in pixels from the top left of the viewport, atlas texture coordinates and RGBA8 colour.  Bound to attribute locations 0 to 2 with a divisor of 1
+	struct Quad {
+
+		glm::vec4					rect;
+		glm::vec4					texRect; // min u, min v, max u, max v
+		uint32_t					colour;
+	};
+
+	static const int				graphFrames = 120; // frame times shown in the graph
+	static const int				maxPasses = 16;
+
+	GLuint							shader = 0;
+	GLint							shader_viewportSize = -1;
+	GLint							shader_fontAtlas = -1;
+
+	GLuint							fontAtlas = 0;
+	GLuint							quadVAO = 0;
+	GLuint							quadVBO = 0;
+	GLsizeiptr						quadVBOSize = 0;
+
+	std::vector<Quad>				quads; // rebuilt each update - capacity is kept so steady state updates do not allocate
+	GLsizei							uploadedQuads = 0;
+
+	bool							visible = true;
+	gu_seconds						updateInterval = 0.1;
+
+	// Frame times in seconds - graphHead is the oldest
+	float							frameTimes[graphFrames];
+	int								graphHead = 0;
+	int64_t							lastFrameTicks = 0; // GUClockSource
+	int64_t							lastUpdateTicks = 0;
+
+	// Sums since the last update
+	int								intervalFrames = 0;
+	gu_seconds						intervalFrameTime = 0.0;
+	gu_seconds						intervalCPUTime[maxPasses];
+	gu_seconds						intervalGPUTime[maxPasses];
+	int								intervalGPUFrames[maxPasses];
+
+	int								scale = 1; // font and graph scale from the viewport height
+	int								builtWidth = 0, builtHeight = 0;
+
+	// Private functions
+	void addQuad(float x, float y, float width, float height, const glm::vec4& texRect, uint32_t colour);
+	void addSolid(float x, float y, float width, float height, uint32_t colour);
+	void addText(float x, float y, const char* text, uint32_t colour);
+	void rebuild(const GPUPassTimer& passes, const GURenderCounters& frameStats, int viewportWidth, int viewportHeight);
+
+public:
+
+	// Requires a current OpenGL context.  Loads Assets/Shaders/perf-hud.vert and .frag and builds the font atlas
+	GUPerfHUD();
+	~GUPerfHUD();
+
+	GUPerfHUD(const GUPerfHUD&) = delete;
+	GUPerfHUD& operator=(const GUPerfHUD&) = delete;
+
+	void setVisible(bool show);
+	bool isVisible() const;
+
+	// Seconds between rebuilds of the text and graph (default 0.1)
+	void setUpdateInterval(gu_seconds interval);
+
+	// Record the frame just rendered and draw the HUD over it - call once per frame after the scene's passes.  Times the frame from the previous call, and rebuilds the quads if updateInterval has passed or the viewport has changed size.  Nothing is drawn while hidden, though frame times are still recorded
+	void render(const GPUPassTimer& passes, const GURenderCounters& frameStats, int viewportWidth, int viewportHeight);
+};
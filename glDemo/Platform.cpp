@@ -0,0 +1,80 @@
+#include "Platform.h"
+
+using namespace std;
+
+
+bool GUPlatform::readFramebuffer(std::vector<uint8_t>& pixels, int& width, int& height) const {
+
+	framebufferSize(width, height);
+
+	if (width <= 0 || height <= 0)
+		return false;
+
+	GLuint framebuffer = defaultFramebuffer();
+
+	GLint previousReadFramebuffer;
+	GLint previousReadBuffer;
+	GLint previousPackAlignment;
+
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousReadFramebuffer);
+	glGetIntegerv(GL_READ_BUFFER, &previousReadBuffer);
+	glGetIntegerv(GL_PACK_ALIGNMENT, &previousPackAlignment);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glReadBuffer((framebuffer != 0) ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	pixels.resize((size_t)width * (size_t)height * 4);
+	glReadPixels(0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, pixels.data());
+
+	glPixelStorei(GL_PACK_ALIGNMENT, previousPackAlignment);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, previousReadFramebuffer);
+	glReadBuffer(previousReadBuffer);
+
+	return true;
+}
+
+
+bool GUPlatform::saveFramebuffer(const std::string& filename) const {
+
+	vector<uint8_t> pixels;
+	int width, height;
+
+	if (!readFramebuffer(pixels, width, height)) {
+
+		cout << "Could not read back the framebuffer for " << filename << endl;
+		return false;
+	}
+
+	FREE_IMAGE_FORMAT format = FreeImage_GetFIFFromFilename(filename.c_str());
+
+	if (format == FIF_UNKNOWN)
+		format = FIF_PNG;
+
+	// Both OpenGL and FreeImage store the bottom row first
+	FIBITMAP* bitmap = FreeImage_ConvertFromRawBits(pixels.data(), width, height, width * 4, 32, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, FALSE);
+
+	if (!bitmap) {
+
+		cout << "FreeImage: Could not create image for " << filename << endl;
+		return false;
+	}
+
+	// Formats without an alpha channel (eg. JPEG) need 24 bits per pixel
+	if (!FreeImage_FIFSupportsExportBPP(format, 32)) {
+
+		FIBITMAP* bitmap24bpp = FreeImage_ConvertTo24Bits(bitmap);
+		FreeImage_Unload(bitmap);
+		bitmap = bitmap24bpp;
+	}
+
+	bool saved = (bitmap && FreeImage_Save(format, bitmap, filename.c_str(), 0));
+
+	if (bitmap)
+		FreeImage_Unload(bitmap);
+
+	if (!saved)
+		cout << "FreeImage: Could not save image " << filename << endl;
+
+	return saved;
+}
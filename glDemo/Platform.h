@@ -0,0 +1,48 @@
+#pragma once
+
+//
+// Window and OpenGL context creation.  GUPlatform hides where frames go - a GLFW window (GUGLFWPlatform) or, on servers with no display or GPU, an offscreen framebuffer in a surfaceless EGL or OSMesa context (GUHeadlessPlatform) - so the main loop, benchmarks and frame capture run unchanged on either.
+//
+// Rendering code must not assume the window is framebuffer 0 - bind defaultFramebuffer() (or restore the previous GL_FRAMEBUFFER_BINDING) after rendering to an offscreen target.
+//
+
+#include "core.h"
+
+
+class GUPlatform {
+
+public:
+
+	virtual ~GUPlatform() {}
+
+	// True if frames are rendered offscreen with no window (and so no input events)
+	virtual bool isHeadless() const = 0;
+
+	virtual bool shouldClose() const = 0;
+	virtual void requestClose() = 0;
+
+	// End the frame - present it in a window or, headless, wait for it to finish
+	virtual void swapBuffers() = 0;
+	virtual void pollEvents() = 0;
+
+	// Process events, sleeping until one arrives or timeout seconds have passed
+	virtual void waitEvents(double timeout) = 0;
+
+	// Make the OpenGL context current on the calling thread, or release it (current = false) so another thread can make it current.  The context is current on the creating thread after creation.  Event processing, setTitle and the close flag stay with the creating thread whichever thread renders
+	virtual void makeContextCurrent(bool current) = 0;
+
+	virtual void setTitle(const std::string& title) = 0;
+	virtual void setSwapInterval(int interval) = 0;
+
+	// Size of the framebuffer frames are rendered into (in pixels, not screen coordinates)
+	virtual void framebufferSize(int& width, int& height) const = 0;
+
+	// Framebuffer object that stands in for the window - 0 for a window's own framebuffer
+	virtual GLuint defaultFramebuffer() const = 0;
+
+	// Read back the frame rendered so far (call before swapBuffers).  Pixels are 8 bit BGRA, bottom row first
+	bool readFramebuffer(std::vector<uint8_t>& pixels, int& width, int& height) const;
+
+	// Save the frame rendered so far to an image file (format from the file extension, PNG if not recognised).  Used for golden image tests and batch rendering
+	bool saveFramebuffer(const std::string& filename) const;
+};
@@ -0,0 +1,247 @@
+#include "Profiler.h"
+#include "AllocationTracker.h"
+#include <mutex>
+
+using namespace std;
+
+
+//
+// Private class holding one thread's events.  Only the owning thread writes - it fills the next slot and then publishes it by incrementing count (release), so the trace writer can read the first count events (acquire) without locking.  Events are stored in fixed size chunks allocated on demand so existing events never move
+//
+
+class GUProfileThreadBuffer {
+
+public:
+
+	static const uint32_t		chunkSize = 16384;
+	static const uint32_t		maxChunks = 1024; // 16M events per thread
+
+	GUProfileEvent*				chunks[maxChunks];
+	std::atomic<uint32_t>		count;
+	std::atomic<uint32_t>		dropped;
+
+	uint32_t					threadIndex;
+	std::string					threadName;
+
+
+	GUProfileThreadBuffer(uint32_t threadIndex) : count(0), dropped(0) {
+
+		this->threadIndex = threadIndex;
+
+		for (uint32_t c = 0; c < maxChunks; ++c)
+			chunks[c] = nullptr;
+	}
+
+	~GUProfileThreadBuffer() {
+
+		for (uint32_t c = 0; c < maxChunks; ++c)
+			delete[] chunks[c];
+	}
+
+	void push(const GUProfileEvent& e) {
+
+		uint32_t n = count.load(std::memory_order_relaxed);
+		uint32_t chunk = n / chunkSize;
+
+		if (chunk >= maxChunks) {
+
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		if (chunks[chunk] == nullptr) {
+
+			// Instrumentation - not counted against the frame being profiled
+			GUUntrackedScope untracked;
+
+			chunks[chunk] = new GUProfileEvent[chunkSize];
+		}
+
+		chunks[chunk][n % chunkSize] = e;
+
+		count.store(n + 1, std::memory_order_release);
+	}
+
+	const GUProfileEvent& event(uint32_t i) const {
+
+		return chunks[i / chunkSize][i % chunkSize];
+	}
+};
+
+const uint32_t GUProfileThreadBuffer::chunkSize;
+const uint32_t GUProfileThreadBuffer::maxChunks;
+
+
+// Static member definitions
+std::atomic<bool> GUProfiler::enabled(false);
+thread_local const char* GUProfiler::activeZone = nullptr;
+
+
+// Every thread buffer ever created.  The mutex is only taken when a thread records its first event, names itself or when the trace is written.  Buffers live until exit so events from finished threads are kept
+static std::mutex& registryMutex() {
+
+	static std::mutex m;
+	return m;
+}
+
+static std::vector<GUProfileThreadBuffer*>& registry() {
+
+	static std::vector<GUProfileThreadBuffer*> buffers;
+	return buffers;
+}
+
+static thread_local GUProfileThreadBuffer* localBuffer = nullptr;
+
+// Trace timestamps are relative to the first time recording was enabled
+static std::atomic<gu_time_index> traceBaseTime(0);
+
+
+static GUProfileThreadBuffer* threadBuffer() {
+
+	if (!localBuffer) {
+
+		std::lock_guard<std::mutex> lock(registryMutex());
+
+		localBuffer = new GUProfileThreadBuffer((uint32_t)registry().size());
+		registry().push_back(localBuffer);
+	}
+
+	return localBuffer;
+}
+
+
+
+// Public method implementation
+
+void GUProfiler::setEnabled(bool enable) {
+
+	if (enable) {
+
+		gu_time_index unset = 0;
+		traceBaseTime.compare_exchange_strong(unset, GUClock::actualTime());
+	}
+
+	enabled.store(enable, std::memory_order_relaxed);
+}
+
+
+void GUProfiler::setThreadName(const char* name) {
+
+	GUProfileThreadBuffer* buffer = threadBuffer();
+
+	std::lock_guard<std::mutex> lock(registryMutex());
+	buffer->threadName = name;
+}
+
+
+void GUProfiler::record(const char* name, gu_time_index start, gu_time_index end) {
+
+	GUProfileEvent e = { name, start, end };
+
+	threadBuffer()->push(e);
+}
+
+
+uint64_t GUProfiler::eventCount() {
+
+	std::lock_guard<std::mutex> lock(registryMutex());
+
+	uint64_t total = 0;
+
+	for (GUProfileThreadBuffer* buffer : registry())
+		total += buffer->count.load(std::memory_order_acquire);
+
+	return total;
+}
+
+
+uint64_t GUProfiler::droppedEventCount() {
+
+	std::lock_guard<std::mutex> lock(registryMutex());
+
+	uint64_t total = 0;
+
+	for (GUProfileThreadBuffer* buffer : registry())
+		total += buffer->dropped.load(std::memory_order_relaxed);
+
+	return total;
+}
+
+
+void GUProfiler::zoneTimes(std::map<std::string, GUTimeHistogram>& zones, gu_time_index since) {
+
+	std::lock_guard<std::mutex> lock(registryMutex());
+
+	const double ticksToSeconds = 1.0 / (double)GUClockSource::frequency();
+
+	for (GUProfileThreadBuffer* buffer : registry()) {
+
+		uint32_t n = buffer->count.load(std::memory_order_acquire);
+
+		for (uint32_t i = 0; i < n; ++i) {
+
+			const GUProfileEvent& e = buffer->event(i);
+
+			if (e.start >= since)
+				zones[e.name].record((gu_seconds)((double)(e.end - e.start) * ticksToSeconds));
+		}
+	}
+}
+
+
+bool GUProfiler::writeChromeTrace(const std::string& filename) {
+
+	ofstream out(filename);
+
+	if (!out.is_open()) {
+
+		cout << "Could not write profile trace " << filename << endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(registryMutex());
+
+	const double ticksToMicroseconds = 1.0e6 / (double)GUClockSource::frequency();
+	const gu_time_index baseTime = traceBaseTime.load();
+
+	out.precision(3);
+	out << fixed;
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	bool first = true;
+	uint64_t written = 0;
+
+	for (GUProfileThreadBuffer* buffer : registry()) {
+
+		// Thread name metadata
+		if (!buffer->threadName.empty()) {
+
+			out << ((first) ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadIndex << ",\"args\":{\"name\":\"" << guJsonEscape(buffer->threadName) << "\"}}";
+
+			first = false;
+		}
+
+		// Complete ("X") events - the viewer nests them by time so no explicit depth is needed
+		uint32_t n = buffer->count.load(std::memory_order_acquire);
+
+		for (uint32_t i = 0; i < n; ++i) {
+
+			const GUProfileEvent& e = buffer->event(i);
+
+			out << ((first) ? "" : ",\n") << "{\"name\":\"" << guJsonEscape(e.name) << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadIndex
+				<< ",\"ts\":" << (double)(e.start - baseTime) * ticksToMicroseconds
+				<< ",\"dur\":" << (double)(e.end - e.start) * ticksToMicroseconds << "}";
+
+			first = false;
+		}
+
+		written += n;
+	}
+
+	out << "\n]}\n";
+
+	cout << "Wrote " << written << " profile events to " << filename << endl;
+
+	return true;
+}
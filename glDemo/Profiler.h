@@ -0,0 +1,111 @@
+#pragma once
+
+//
+// Scoped CPU profiler.  GU_PROFILE_ZONE("name") times the enclosing scope with the GUClock timebase and records it into a buffer owned by the calling thread, so recording takes no locks.  The recorded zones can be written as Chrome trace-event JSON, which chrome://tracing and Perfetto (ui.perfetto.dev) open directly.
+//
+// Set GU_PROFILER to 0 to compile every zone out.  When compiled in, zones cost one flag test until recording is switched on with GUProfiler::setEnabled(true).  Zone names must be string literals (or otherwise outlive the profiler) since only the pointer is stored.
+//
+
+#include "core.h"
+#include "GUClock.h"
+#include "GUTimeHistogram.h"
+#include <atomic>
+
+#ifndef GU_PROFILER
+#define GU_PROFILER 1
+#endif
+
+
+struct GUProfileEvent {
+
+	const char*				name;
+	gu_time_index			start;
+	gu_time_index			end;
+};
+
+
+class GUProfiler {
+
+private:
+
+	friend class GUProfileZone;
+
+	static std::atomic<bool>		enabled;
+
+	// Innermost zone open on the calling thread - tracked whether or not recording is enabled
+	static thread_local const char*	activeZone;
+
+public:
+
+	static void setEnabled(bool enable);
+
+	static bool isEnabled() {
+
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	// Name shown for the calling thread in the trace viewer
+	static void setThreadName(const char* name);
+
+	static void record(const char* name, gu_time_index start, gu_time_index end);
+
+	// Name of the innermost zone open on the calling thread, or NULL outside any zone
+	static const char* activeZoneName() {
+
+		return activeZone;
+	}
+
+	// Total events recorded and events dropped because a thread's buffer was full
+	static uint64_t eventCount();
+	static uint64_t droppedEventCount();
+
+	// Add the duration of every event starting at or after since to the histogram for its zone name, across all threads.  Like writeChromeTrace, call once recording threads are idle
+	static void zoneTimes(std::map<std::string, GUTimeHistogram>& zones, gu_time_index since = 0);
+
+	// Write all events recorded so far as Chrome trace-event JSON.  Call once recording threads are idle (eg. at exit) - events recorded while writing may be missed
+	static bool writeChromeTrace(const std::string& filename);
+};
+
+
+class GUProfileZone {
+
+private:
+
+	const char*				name;
+	const char*				parentName;
+	gu_time_index			start;
+	bool					active;
+
+public:
+
+	GUProfileZone(const char* name) {
+
+		this->name = name;
+		parentName = GUProfiler::activeZone;
+		GUProfiler::activeZone = name;
+
+		active = GUProfiler::isEnabled();
+		start = (active) ? GUClock::actualTime() : 0;
+	}
+
+	~GUProfileZone() {
+
+		if (active)
+			GUProfiler::record(name, start, GUClock::actualTime());
+
+		GUProfiler::activeZone = parentName;
+	}
+};
+
+
+#if GU_PROFILER
+
+#define GU_PROFILE_CONCAT_INNER(a, b) a##b
+#define GU_PROFILE_CONCAT(a, b) GU_PROFILE_CONCAT_INNER(a, b)
+#define GU_PROFILE_ZONE(name) GUProfileZone GU_PROFILE_CONCAT(guProfileZone, __LINE__)(name)
+
+#else
+
+#define GU_PROFILE_ZONE(name)
+
+#endif
@@ -0,0 +1,296 @@
+#include "RenderStats.h"
+#include "GUClock.h"
+#include <algorithm>
+
+using namespace std;
+
+
+// GURenderCounters
+
+static uint64_t GURenderCounters::* const counterFields[GURenderCounters::numFields] = {
+
+	&GURenderCounters::drawCalls,
+	&GURenderCounters::instances,
+	&GURenderCounters::triangles,
+	&GURenderCounters::vertices,
+	&GURenderCounters::programBinds,
+	&GURenderCounters::vaoBinds,
+	&GURenderCounters::textureBinds,
+	&GURenderCounters::uniformUploads,
+	&GURenderCounters::bufferBytes,
+	&GURenderCounters::textureBytes
+};
+
+static const char* counterNames[GURenderCounters::numFields] = {
+
+	"draw_calls",
+	"instances",
+	"triangles",
+	"vertices",
+	"program_binds",
+	"vao_binds",
+	"texture_binds",
+	"uniform_uploads",
+	"buffer_bytes",
+	"texture_bytes"
+};
+
+
+const char* GURenderCounters::fieldName(int field) {
+
+	return counterNames[field];
+}
+
+
+uint64_t GURenderCounters::field(int field) const {
+
+	return this->*counterFields[field];
+}
+
+
+void GURenderCounters::add(const GURenderCounters& c) {
+
+	for (int i = 0; i < numFields; ++i)
+		this->*counterFields[i] += c.*counterFields[i];
+}
+
+
+void GURenderCounters::maximum(const GURenderCounters& c) {
+
+	for (int i = 0; i < numFields; ++i)
+		this->*counterFields[i] = std::max<uint64_t>(this->*counterFields[i], c.*counterFields[i]);
+}
+
+
+// GURenderStats
+
+const int GURenderStats::maxPasses;
+
+std::string GURenderStats::passNames[GURenderStats::maxPasses] = { "other" };
+int GURenderStats::numPasses = 1;
+int GURenderStats::currentPass = 0;
+
+GURenderCounters GURenderStats::current[GURenderStats::maxPasses];
+GURenderCounters GURenderStats::lastFrame[GURenderStats::maxPasses];
+GURenderCounters GURenderStats::totals[GURenderStats::maxPasses];
+GURenderCounters GURenderStats::peakFrame;
+GURenderCounters GURenderStats::loadCounters;
+
+uint64_t GURenderStats::frames = 0;
+bool GURenderStats::frameStarted = false;
+
+
+static GURenderCounters divideCounters(const GURenderCounters& c, uint64_t divisor) {
+
+	GURenderCounters result;
+
+	if (divisor == 0)
+		return result;
+
+	for (int i = 0; i < GURenderCounters::numFields; ++i)
+		result.*counterFields[i] = (c.*counterFields[i] + divisor / 2) / divisor;
+
+	return result;
+}
+
+
+static void printCountersRow(const string& name, const GURenderCounters& c) {
+
+	printf("%-24s", name.c_str());
+
+	for (int i = 0; i < GURenderCounters::numFields; ++i)
+		printf(" %12llu", (unsigned long long)c.field(i));
+
+	printf("\n");
+}
+
+
+static void printCountersHeader() {
+
+	printf("%-24s", "pass");
+
+	for (int i = 0; i < GURenderCounters::numFields; ++i)
+		printf(" %12.12s", GURenderCounters::fieldName(i));
+
+	printf("\n");
+}
+
+
+int GURenderStats::addPass(const std::string& name) {
+
+	if (numPasses >= maxPasses)
+		return 0;
+
+	passNames[numPasses] = name;
+
+	return numPasses++;
+}
+
+
+void GURenderStats::setPass(int pass) {
+
+	currentPass = (pass > 0 && pass < numPasses) ? pass : 0;
+}
+
+
+void GURenderStats::beginFrame() {
+
+	GURenderCounters frameTotal;
+
+	for (int p = 0; p < numPasses; ++p) {
+
+		if (frameStarted) {
+
+			lastFrame[p] = current[p];
+			totals[p].add(current[p]);
+			frameTotal.add(current[p]);
+		}
+		else {
+
+			loadCounters.add(current[p]);
+		}
+
+		current[p] = GURenderCounters();
+	}
+
+	if (frameStarted) {
+
+		peakFrame.maximum(frameTotal);
+		frames++;
+	}
+
+	frameStarted = true;
+	currentPass = 0;
+}
+
+
+void GURenderStats::resetTotals() {
+
+	for (int p = 0; p < maxPasses; ++p)
+		totals[p] = GURenderCounters();
+
+	peakFrame = GURenderCounters();
+	frames = 0;
+}
+
+
+int GURenderStats::passCount() {
+
+	return numPasses;
+}
+
+
+const std::string& GURenderStats::passName(int pass) {
+
+	return passNames[pass];
+}
+
+
+uint64_t GURenderStats::frameCount() {
+
+	return frames;
+}
+
+
+const GURenderCounters& GURenderStats::lastFramePass(int pass) {
+
+	return lastFrame[pass];
+}
+
+
+GURenderCounters GURenderStats::lastFrameTotal() {
+
+	GURenderCounters result;
+
+	for (int p = 0; p < numPasses; ++p)
+		result.add(lastFrame[p]);
+
+	return result;
+}
+
+
+GURenderCounters GURenderStats::averagePass(int pass) {
+
+	return divideCounters(totals[pass], frames);
+}
+
+
+GURenderCounters GURenderStats::averageTotal() {
+
+	GURenderCounters sum;
+
+	for (int p = 0; p < numPasses; ++p)
+		sum.add(totals[p]);
+
+	return divideCounters(sum, frames);
+}
+
+
+const GURenderCounters& GURenderStats::peakFrameTotal() {
+
+	return peakFrame;
+}
+
+
+const GURenderCounters& GURenderStats::loadTotal() {
+
+	return loadCounters;
+}
+
+
+void GURenderStats::printLastFrame() {
+
+	printf("Render stats - last frame\n");
+	printCountersHeader();
+
+	for (int p = 0; p < numPasses; ++p)
+		printCountersRow(passNames[p], lastFrame[p]);
+
+	printCountersRow("total", lastFrameTotal());
+}
+
+
+void GURenderStats::reportStats() {
+
+	if (frames == 0)
+		return;
+
+	printf("Render stats - mean per frame over %llu frames\n", (unsigned long long)frames);
+	printCountersHeader();
+
+	for (int p = 0; p < numPasses; ++p)
+		printCountersRow(passNames[p], averagePass(p));
+
+	printCountersRow("total", averageTotal());
+	printCountersRow("peak frame", peakFrame);
+	printCountersRow("load", loadCounters);
+}
+
+
+void GURenderStats::addToClockReport(GUClock* clock) {
+
+	if (!clock || frames == 0)
+		return;
+
+	GURenderCounters sum;
+
+	for (int p = 0; p < numPasses; ++p)
+		sum.add(totals[p]);
+
+	for (int i = 0; i < GURenderCounters::numFields; ++i) {
+
+		string field = GURenderCounters::fieldName(i);
+
+		clock->setReportCounter("render_mean_" + field, (double)sum.field(i) / (double)frames);
+		clock->setReportCounter("render_peak_" + field, (double)peakFrame.field(i));
+		clock->setReportCounter("render_load_" + field, (double)loadCounters.field(i));
+
+		for (int p = 0; p < numPasses; ++p) {
+
+			string pass = passNames[p];
+			replace(pass.begin(), pass.end(), ' ', '_');
+
+			clock->setReportCounter("render_mean_" + field + "_" + pass, (double)totals[p].field(i) / (double)frames);
+		}
+	}
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+//
+// Per frame render statistics.  The count functions are called next to the OpenGL call they count (eg. GURenderStats::countDraw beside glDrawElements) and add to the pass selected with GURenderStats::setPass.  GURenderStats::beginFrame closes the previous frame, so the last complete frame, per frame averages and per frame peaks can be read back by pass and the totals added to the GUClock timing report.
+//
+// Set GU_RENDER_STATS to 0 to compile the counting out.  Counting is not thread safe - all counted calls are made on the thread that owns the OpenGL context.
+//
+
+#include "core.h"
+
+#ifndef GU_RENDER_STATS
+#define GU_RENDER_STATS 1
+#endif
+
+class GUClock;
+
+
+struct GURenderCounters {
+
+	uint64_t				drawCalls = 0;
+	uint64_t				instances = 0;
+	uint64_t				triangles = 0;
+	uint64_t				vertices = 0; // indices submitted - the upper bound on vertex shader invocations
+	uint64_t				programBinds = 0;
+	uint64_t				vaoBinds = 0;
+	uint64_t				textureBinds = 0;
+	uint64_t				uniformUploads = 0;
+	uint64_t				bufferBytes = 0;
+	uint64_t				textureBytes = 0;
+
+	static const int		numFields = 10;
+
+	// Access the counters by index (0 to numFields - 1) for reporting
+	static const char* fieldName(int field);
+	uint64_t field(int field) const;
+
+	void add(const GURenderCounters& c);
+	void maximum(const GURenderCounters& c);
+};
+
+
+class GURenderStats {
+
+private:
+
+	static const int				maxPasses = 16;
+
+	static std::string				passNames[maxPasses];
+	static int						numPasses;
+	static int						currentPass;
+
+	static GURenderCounters			current[maxPasses];
+	static GURenderCounters			lastFrame[maxPasses];
+	static GURenderCounters			totals[maxPasses];
+	static GURenderCounters			peakFrame; // largest frame total seen for each counter
+	static GURenderCounters			loadCounters; // everything counted before the first frame
+
+	static uint64_t					frames;
+	static bool						frameStarted;
+
+public:
+
+	// Register a pass and return its id.  Pass 0 ("other") always exists and collects anything counted outside a named pass.  Returns 0 if maxPasses have already been added
+	static int addPass(const std::string& name);
+
+	// Count subsequent calls against pass (0 for "other")
+	static void setPass(int pass);
+
+	// Close the frame in progress and start a new one.  The first call closes the load phase instead
+	static void beginFrame();
+
+	// Discard the completed frame totals and peaks (eg. after a warm-up period).  The load phase totals are kept
+	static void resetTotals();
+
+	static int passCount();
+	static const std::string& passName(int pass);
+
+	static uint64_t frameCount();
+
+	static const GURenderCounters& lastFramePass(int pass);
+	static GURenderCounters lastFrameTotal();
+
+	// Mean counts per frame over every completed frame
+	static GURenderCounters averagePass(int pass);
+	static GURenderCounters averageTotal();
+
+	static const GURenderCounters& peakFrameTotal();
+	static const GURenderCounters& loadTotal();
+
+	// Print the last frame (per pass) to the console
+	static void printLastFrame();
+
+	// Print per frame averages and peaks (per pass) to the console
+	static void reportStats();
+
+	// Add the per frame averages and peaks to clock's timing report
+	static void addToClockReport(GUClock* clock);
+
+
+	// Counting
+
+	static void countDraw(uint64_t indexCount, uint64_t instanceCount = 1) {
+
+#if GU_RENDER_STATS
+		GURenderCounters& c = current[currentPass];
+
+		c.drawCalls++;
+		c.instances += instanceCount;
+		c.triangles += (indexCount / 3) * instanceCount;
+		c.vertices += indexCount * instanceCount;
+#endif
+	}
+
+	// A single call that submits several draws (eg. glMultiDrawElements) - counted as one draw call
+	static void countMultiDraw(uint64_t totalIndexCount) {
+
+#if GU_RENDER_STATS
+		GURenderCounters& c = current[currentPass];
+
+		c.drawCalls++;
+		c.instances++;
+		c.triangles += totalIndexCount / 3;
+		c.vertices += totalIndexCount;
+#endif
+	}
+
+	static void countProgramBind() {
+
+#if GU_RENDER_STATS
+		current[currentPass].programBinds++;
+#endif
+	}
+
+	static void countVAOBind() {
+
+#if GU_RENDER_STATS
+		current[currentPass].vaoBinds++;
+#endif
+	}
+
+	static void countTextureBind(uint64_t count = 1) {
+
+#if GU_RENDER_STATS
+		current[currentPass].textureBinds += count;
+#endif
+	}
+
+	static void countUniformUpload(uint64_t count = 1) {
+
+#if GU_RENDER_STATS
+		current[currentPass].uniformUploads += count;
+#endif
+	}
+
+	static void countBufferUpload(uint64_t bytes) {
+
+#if GU_RENDER_STATS
+		current[currentPass].bufferBytes += bytes;
+#endif
+	}
+
+	static void countTextureUpload(uint64_t bytes) {
+
+#if GU_RENDER_STATS
+		current[currentPass].textureBytes += bytes;
+#endif
+	}
+};
@@ -0,0 +1,329 @@
+#include "SceneDescription.h"
+#include <algorithm>
+#include <sstream>
+
+using namespace std;
+using namespace glm;
+
+
+// One city block, centred on blockCentre - the layout of the original demo scene
+static const SceneInstance blockPieces[] = {
+
+	{ SceneMesh::Corner, vec3(6.0f, 0.0f, 10.0f), -90.0f, vec3(0.1f) },
+	{ SceneMesh::Corner, vec3(6.0f, 0.0f, -2.0f), -90.0f, vec3(0.1f) },
+	{ SceneMesh::Corner, vec3(-6.0f, 0.0f, 10.0f), -90.0f, vec3(0.1f) },
+	{ SceneMesh::Corner, vec3(-6.0f, 0.0f, -2.0f), -90.0f, vec3(0.1f) },
+
+	{ SceneMesh::Wall, vec3(0.0f, 0.0f, 10.0f), -90.0f, vec3(0.1f) },
+	{ SceneMesh::Wall, vec3(0.0f, 0.0f, -2.0f), -90.0f, vec3(0.1f) },
+	{ SceneMesh::Wall, vec3(-6.0f, 0.0f, 4.0f), 0.0f, vec3(0.1f) },
+	{ SceneMesh::Wall, vec3(6.0f, 0.0f, 4.0f), 0.0f, vec3(0.1f) },
+
+	{ SceneMesh::Mausoleum, vec3(0.0f, 0.0f, 4.0f), 180.0f, vec3(0.1f) },
+
+	{ SceneMesh::Hut, vec3(-20.0f, 0.0f, 5.0f), 180.0f, vec3(0.1f) }
+};
+
+static const int numBlockPieces = sizeof(blockPieces) / sizeof(SceneInstance);
+
+static const vec3 blockCentre = vec3(0.0f, 0.0f, 4.0f);
+
+static const SceneLight originalLights[2] = {
+
+	{ vec3(0.0f, 7.0f, 7.0f), vec3(0.9f, 0.75f, 0.1f), vec3(1.0f, 0.1f, 0.001f) },
+	{ vec3(-20.0f, 2.0f, 5.0f), vec3(1.0f, 0.0f, 0.0f), vec3(1.0f, 0.1f, 0.001f) }
+};
+
+static const vec3 playerStart = vec3(2.0f, 0.0f, 0.0f);
+static const float characterScale = 0.05f;
+
+// The terrain mesh spans -30 to 30 in x and z
+static const float groundHalfSize = 30.0f;
+static const float groundMinScale = 10.0f;
+
+
+// mt19937 output is fixed by the standard but the std distributions are not, so values are taken from the raw output to give the same scene with every compiler
+static float randomFloat(mt19937& rng, float minValue, float maxValue) {
+
+	return minValue + (maxValue - minValue) * (float)(rng() >> 8) * (1.0f / 16777216.0f);
+}
+
+
+static int randomInt(mt19937& rng, int count) {
+
+	return (int)(rng() % (uint32_t)count);
+}
+
+
+
+// SceneInstance
+
+glm::mat4 SceneInstance::modelTransform() const {
+
+	return glm::translate(identity<mat4>(), position) * eulerAngleY<float>(glm::radians<float>(rotation)) * glm::scale(identity<mat4>(), scale);
+}
+
+
+
+// SceneDescription
+
+SceneDescription SceneDescription::defaultScene() {
+
+	CitySettings settings;
+
+	settings.randomise = false;
+
+	return generateCity(settings);
+}
+
+
+SceneDescription SceneDescription::generateCity(const CitySettings& settings) {
+
+	SceneDescription scene;
+	mt19937 rng(settings.seed);
+
+	int blocksX = std::max<int>(settings.blocksX, 1);
+	int blocksZ = std::max<int>(settings.blocksZ, 1);
+
+	float halfWidth = (float)blocksX * settings.blockSpacing * 0.5f;
+	float halfDepth = (float)blocksZ * settings.blockSpacing * 0.5f;
+
+	// One terrain instance under the whole city
+	float groundScale = std::max<float>(groundMinScale, std::max<float>(halfWidth, halfDepth) / groundHalfSize);
+
+	scene.instances.reserve((size_t)blocksX * (size_t)blocksZ * numBlockPieces + 1);
+	scene.instances.push_back(SceneInstance{ SceneMesh::Ground, vec3(0.0f, -4.0f, 0.0f), 0.0f, vec3(groundScale, 0.1f, groundScale) });
+
+	// Blocks are laid out around the original block so a 1x1 city is the original scene
+	for (int bz = 0; bz < blocksZ; ++bz) {
+
+		for (int bx = 0; bx < blocksX; ++bx) {
+
+			vec3 blockOffset = vec3(((float)bx - (float)(blocksX - 1) * 0.5f) * settings.blockSpacing, 0.0f, ((float)bz - (float)(blocksZ - 1) * 0.5f) * settings.blockSpacing);
+			float blockRotation = (settings.randomise) ? 90.0f * (float)randomInt(rng, 4) : 0.0f;
+
+			mat4 blockRotationMatrix = eulerAngleY<float>(glm::radians<float>(blockRotation));
+
+			for (int p = 0; p < numBlockPieces; ++p) {
+
+				SceneInstance instance = blockPieces[p];
+
+				// Walls keep their orientation and size so they still meet the corners
+				if (settings.randomise && instance.mesh != SceneMesh::Wall) {
+
+					if (instance.mesh == SceneMesh::Corner)
+						instance.rotation += 90.0f * (float)randomInt(rng, 4);
+					else
+						instance.rotation += randomFloat(rng, 0.0f, 360.0f);
+
+					instance.scale *= randomFloat(rng, 0.9f, 1.1f);
+				}
+
+				instance.position = blockCentre + blockOffset + vec3(blockRotationMatrix * vec4(instance.position - blockCentre, 0.0f));
+				instance.rotation += blockRotation;
+
+				scene.instances.push_back(instance);
+			}
+		}
+	}
+
+	// The player starts where they did in the original scene.  Other characters are scattered over the city
+	for (int c = 0; c < settings.characters; ++c) {
+
+		SceneInstance character = { SceneMesh::Character, playerStart, 0.0f, vec3(characterScale) };
+
+		if (c > 0) {
+
+			// Drawn one statement at a time - the order function arguments are evaluated in is unspecified
+			float x = randomFloat(rng, -halfWidth, halfWidth);
+			float z = randomFloat(rng, -halfDepth, halfDepth);
+
+			character.position = vec3(x, 0.0f, blockCentre.z + z);
+			character.rotation = randomFloat(rng, 0.0f, 360.0f);
+		}
+
+		scene.characters.push_back(character);
+	}
+
+	// The first lights are the original scene's
+	for (int l = 0; l < settings.pointLights; ++l) {
+
+		if (l < 2) {
+
+			scene.lights.push_back(originalLights[l]);
+			continue;
+		}
+
+		SceneLight light;
+
+		float x = randomFloat(rng, -halfWidth, halfWidth);
+		float y = randomFloat(rng, 2.0f, 8.0f);
+		float z = randomFloat(rng, -halfDepth, halfDepth);
+
+		float red = randomFloat(rng, 0.2f, 1.0f);
+		float green = randomFloat(rng, 0.2f, 1.0f);
+		float blue = randomFloat(rng, 0.2f, 1.0f);
+
+		light.pos = vec3(x, y, blockCentre.z + z);
+		light.colour = vec3(red, green, blue);
+		light.attenuation = vec3(1.0f, 0.1f, 0.001f);
+
+		scene.lights.push_back(light);
+	}
+
+	return scene;
+}
+
+
+bool SceneDescription::load(const std::string& filename) {
+
+	ifstream in(filename);
+
+	if (!in.is_open()) {
+
+		cout << "Could not open scene " << filename << endl;
+		return false;
+	}
+
+	instances.clear();
+	characters.clear();
+	attachments.clear();
+	lights.clear();
+
+	string line;
+	int lineNumber = 0;
+
+	while (getline(in, line)) {
+
+		lineNumber++;
+
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		istringstream fields(line);
+		string record;
+
+		fields >> record;
+
+		if (record == "instance" || record == "attach") {
+
+			string name;
+			SceneInstance instance;
+
+			fields >> name;
+
+			instance.mesh = SceneMesh::Count;
+
+			for (int m = 0; m < (int)SceneMesh::Count; ++m) {
+
+				if (name == meshName((SceneMesh)m))
+					instance.mesh = (SceneMesh)m;
+			}
+
+			if (instance.mesh == SceneMesh::Count) {
+
+				cout << "Scene " << filename << " line " << lineNumber << ": unknown mesh " << name << endl;
+				return false;
+			}
+
+			if (!(fields >> instance.position.x >> instance.position.y >> instance.position.z >> instance.rotation >> instance.scale.x >> instance.scale.y >> instance.scale.z)) {
+
+				cout << "Scene " << filename << " line " << lineNumber << ": expected 7 values after the mesh name" << endl;
+				return false;
+			}
+
+			if (record == "instance")
+				instances.push_back(instance);
+			else
+				attachments.push_back(instance);
+		}
+		else if (record == "character") {
+
+			SceneInstance character = { SceneMesh::Character, vec3(0.0f), 0.0f, vec3(characterScale) };
+
+			if (!(fields >> character.position.x >> character.position.y >> character.position.z >> character.rotation)) {
+
+				cout << "Scene " << filename << " line " << lineNumber << ": expected 4 values" << endl;
+				return false;
+			}
+
+			characters.push_back(character);
+		}
+		else if (record == "light") {
+
+			SceneLight light;
+
+			if (!(fields >> light.pos.x >> light.pos.y >> light.pos.z >> light.colour.r >> light.colour.g >> light.colour.b >> light.attenuation.x >> light.attenuation.y >> light.attenuation.z)) {
+
+				cout << "Scene " << filename << " line " << lineNumber << ": expected 9 values" << endl;
+				return false;
+			}
+
+			lights.push_back(light);
+		}
+		else {
+
+			cout << "Scene " << filename << " line " << lineNumber << ": unknown record " << record << endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+bool SceneDescription::save(const std::string& filename) const {
+
+	ofstream out(filename);
+
+	if (!out.is_open()) {
+
+		cout << "Could not write scene " << filename << endl;
+		return false;
+	}
+
+	out << "# instance <mesh> <x> <y> <z> <rotation> <scale x> <scale y> <scale z>\n";
+	out << "# character <x> <y> <z> <rotation>\n";
+	out << "# attach <mesh> <x> <y> <z> <rotation> <scale x> <scale y> <scale z>\n";
+	out << "# light <x> <y> <z> <r> <g> <b> <constant> <linear> <quadratic>\n";
+
+	out.precision(9);
+
+	for (const SceneInstance& i : instances)
+		out << "instance " << meshName(i.mesh) << " " << i.position.x << " " << i.position.y << " " << i.position.z << " " << i.rotation << " " << i.scale.x << " " << i.scale.y << " " << i.scale.z << "\n";
+
+	for (const SceneInstance& c : characters)
+		out << "character " << c.position.x << " " << c.position.y << " " << c.position.z << " " << c.rotation << "\n";
+
+	for (const SceneInstance& a : attachments)
+		out << "attach " << meshName(a.mesh) << " " << a.position.x << " " << a.position.y << " " << a.position.z << " " << a.rotation << " " << a.scale.x << " " << a.scale.y << " " << a.scale.z << "\n";
+
+	for (const SceneLight& l : lights)
+		out << "light " << l.pos.x << " " << l.pos.y << " " << l.pos.z << " " << l.colour.r << " " << l.colour.g << " " << l.colour.b << " " << l.attenuation.x << " " << l.attenuation.y << " " << l.attenuation.z << "\n";
+
+	return true;
+}
+
+
+size_t SceneDescription::instanceCount(SceneMesh mesh) const {
+
+	if (mesh == SceneMesh::Character)
+		return characters.size() + count_if(instances.begin(), instances.end(), [](const SceneInstance& i) { return i.mesh == SceneMesh::Character; });
+
+	return count_if(instances.begin(), instances.end(), [mesh](const SceneInstance& i) { return i.mesh == mesh; });
+}
+
+
+const char* SceneDescription::meshName(SceneMesh mesh) {
+
+	switch (mesh) {
+
+		case SceneMesh::Ground: return "ground";
+		case SceneMesh::Corner: return "corner";
+		case SceneMesh::Wall: return "wall";
+		case SceneMesh::Mausoleum: return "mausoleum";
+		case SceneMesh::Hut: return "hut";
+		case SceneMesh::Character: return "character";
+		default: return "unknown";
+	}
+}
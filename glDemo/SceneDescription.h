@@ -0,0 +1,72 @@
+#pragma once
+
+#include "core.h"
+
+// Meshes a scene can place - the demo's city block pieces, the terrain and the character
+enum class SceneMesh { Ground, Corner, Wall, Mausoleum, Hut, Character, Count };
+
+
+// Mesh placement - modelTransform() is translate(position) * rotate about y (degrees) * scale
+struct SceneInstance {
+
+	SceneMesh			mesh;
+	glm::vec3			position;
+	float				rotation; // degrees about the y axis
+	glm::vec3			scale;
+
+	glm::mat4 modelTransform() const;
+};
+
+
+struct SceneLight {
+
+	glm::vec3			pos;
+	glm::vec3			colour;
+	glm::vec3			attenuation; // x=constant, y=linear, z=quadratic
+};
+
+
+// Options for SceneDescription::generateCity
+struct CitySettings {
+
+	int					blocksX = 1;
+	int					blocksZ = 1;
+	int					characters = 1; // including the player
+	int					pointLights = 2;
+	uint32_t			seed = 1;
+	float				blockSpacing = 48.0f; // distance between block centres - leaves room for a block rotated with its hut
+	bool				randomise = true; // random block rotations and instance rotations / scales.  A 1x1 city that is not randomised is the original scene
+};
+
+
+// Scene contents - placed meshes, characters and point lights - stored as text with one record per line and lines starting # ignored:
+//
+//	instance <mesh> <x> <y> <z> <rotation> <scale x> <scale y> <scale z>
+//	character <x> <y> <z> <rotation>
+//	attach <mesh> <x> <y> <z> <rotation> <scale x> <scale y> <scale z>
+//	light <x> <y> <z> <r> <g> <b> <constant> <linear> <quadratic>
+//
+// where <mesh> is ground, corner, wall, mausoleum, hut or character and rotations are in degrees about y.  The first character is the player - the rest are idle and are drawn as static instances.  Attachments are placed relative to the player (its position and facing, without the character model's scale) and move with it.
+
+class SceneDescription {
+
+public:
+
+	std::vector<SceneInstance>	instances;
+	std::vector<SceneInstance>	characters; // mesh is always SceneMesh::Character
+	std::vector<SceneInstance>	attachments; // relative to the player
+	std::vector<SceneLight>		lights;
+
+	// The demo's original city block
+	static SceneDescription defaultScene();
+
+	// Tile the city block (corners, walls, mausoleum and hut) into a settings.blocksX x settings.blocksZ grid on a ground scaled to cover it, scatter settings.characters characters and settings.pointLights point lights over it.  The same settings always give the same scene on every platform
+	static SceneDescription generateCity(const CitySettings& settings);
+
+	bool load(const std::string& filename);
+	bool save(const std::string& filename) const;
+
+	size_t instanceCount(SceneMesh mesh) const;
+
+	static const char* meshName(SceneMesh mesh);
+};
@@ -0,0 +1,308 @@
+#include "SpatialHash.h"
+
+using namespace std;
+using namespace glm;
+
+
+const SpatialHash::ProxyID SpatialHash::InvalidProxy;
+const uint32_t SpatialHash::StaticLayer;
+const uint32_t SpatialHash::DynamicLayer;
+const uint32_t SpatialHash::AllLayers;
+const uint32_t SpatialHash::InvalidIndex;
+
+
+// Private functions
+
+ivec3 SpatialHash::cellCoord(const vec3& p) const {
+
+	return ivec3((int)floorf(p.x * cellSizeRecip), (int)floorf(p.y * cellSizeRecip), (int)floorf(p.z * cellSizeRecip));
+}
+
+
+// Upper cell of a range.  Overlap tests are strict so a box whose max lies exactly on a cell boundary cannot overlap anything in the next cell - exclude it so a unit sized agent does not link into twice as many cells as it needs to
+ivec3 SpatialHash::cellCoordUpper(const vec3& p, const ivec3& lower) const {
+
+	ivec3 c = ivec3((int)ceilf(p.x * cellSizeRecip) - 1, (int)ceilf(p.y * cellSizeRecip) - 1, (int)ceilf(p.z * cellSizeRecip) - 1);
+
+	return glm::max(c, lower);
+}
+
+
+uint32_t SpatialHash::bucketIndex(int x, int y, int z) const {
+
+	// Large primes from Teschner et al. "Optimized Spatial Hashing for Collision Detection of Deformable Objects"
+	return (((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u) ^ ((uint32_t)z * 83492791u)) & bucketMask;
+}
+
+
+uint32_t SpatialHash::allocateNode() {
+
+	if (freeNode != InvalidIndex) {
+
+		uint32_t n = freeNode;
+		freeNode = nodes[n].next;
+		return n;
+	}
+
+	nodes.push_back(CellNode());
+	return (uint32_t)(nodes.size() - 1);
+}
+
+
+// Link proxy into each cell covered by its cell range
+void SpatialHash::linkProxy(ProxyID id) {
+
+	Proxy& proxy = proxies[id];
+
+	for (int z = proxy.cellMin.z; z <= proxy.cellMax.z; ++z) {
+		for (int y = proxy.cellMin.y; y <= proxy.cellMax.y; ++y) {
+			for (int x = proxy.cellMin.x; x <= proxy.cellMax.x; ++x) {
+
+				uint32_t b = bucketIndex(x, y, z);
+				uint32_t n = allocateNode();
+
+				CellNode& node = nodes[n];
+				node.proxy = id;
+				node.bucket = b;
+				node.prev = InvalidIndex;
+				node.next = buckets[b];
+				node.proxyNext = proxy.firstNode;
+
+				if (buckets[b] != InvalidIndex)
+					nodes[buckets[b]].prev = n;
+
+				buckets[b] = n;
+				proxy.firstNode = n;
+			}
+		}
+	}
+}
+
+
+// Remove all of the proxy's nodes from their buckets and return them to the free list
+void SpatialHash::unlinkProxy(ProxyID id) {
+
+	Proxy& proxy = proxies[id];
+
+	uint32_t n = proxy.firstNode;
+
+	while (n != InvalidIndex) {
+
+		CellNode& node = nodes[n];
+		uint32_t proxyNext = node.proxyNext;
+
+		if (node.prev != InvalidIndex)
+			nodes[node.prev].next = node.next;
+		else
+			buckets[node.bucket] = node.next;
+
+		if (node.next != InvalidIndex)
+			nodes[node.next].prev = node.prev;
+
+		node.next = freeNode;
+		freeNode = n;
+
+		n = proxyNext;
+	}
+
+	proxy.firstNode = InvalidIndex;
+}
+
+
+uint32_t SpatialHash::nextQueryStamp() const {
+
+	currentStamp++;
+
+	if (currentStamp == 0) {
+
+		// Stamp counter wrapped - clear old stamps so they cannot alias the new sequence
+		fill(queryStamps.begin(), queryStamps.end(), 0);
+		currentStamp = 1;
+	}
+
+	return currentStamp;
+}
+
+
+void SpatialHash::gatherCells(const AABB& region, uint32_t layerMask, uint32_t stamp, vector<ProxyID>& results) const {
+
+	ivec3 cMin = cellCoord(region.min);
+	ivec3 cMax = cellCoordUpper(region.max, cMin);
+
+	for (int z = cMin.z; z <= cMax.z; ++z) {
+		for (int y = cMin.y; y <= cMax.y; ++y) {
+			for (int x = cMin.x; x <= cMax.x; ++x) {
+
+				for (uint32_t n = buckets[bucketIndex(x, y, z)]; n != InvalidIndex; n = nodes[n].next) {
+
+					ProxyID id = nodes[n].proxy;
+
+					if (queryStamps[id] == stamp)
+						continue;
+
+					queryStamps[id] = stamp;
+
+					const Proxy& proxy = proxies[id];
+
+					if ((proxy.layer & layerMask) != 0 && proxy.bounds.overlaps(region))
+						results.push_back(id);
+				}
+			}
+		}
+	}
+}
+
+
+
+// Public functions
+
+SpatialHash::SpatialHash(float cellSize, uint32_t numBuckets) {
+
+	this->cellSize = std::max<float>(cellSize, 1.0e-4f);
+	cellSizeRecip = 1.0f / this->cellSize;
+
+	// Round bucket count up to a power of two so the hash can be masked rather than taking a modulus
+	uint32_t tableSize = 1;
+	while (tableSize < numBuckets)
+		tableSize <<= 1;
+
+	bucketMask = tableSize - 1;
+	buckets.assign(tableSize, InvalidIndex);
+}
+
+
+SpatialHash::ProxyID SpatialHash::insert(const AABB& bounds, uint32_t layer, uint32_t userData) {
+
+	ProxyID id;
+
+	if (freeProxy != InvalidProxy) {
+
+		id = freeProxy;
+		freeProxy = proxies[id].nextFree;
+	}
+	else {
+
+		proxies.push_back(Proxy());
+		queryStamps.push_back(0);
+		id = (ProxyID)(proxies.size() - 1);
+	}
+
+	Proxy& proxy = proxies[id];
+	proxy.bounds = bounds;
+	proxy.cellMin = cellCoord(bounds.min);
+	proxy.cellMax = cellCoordUpper(bounds.max, proxy.cellMin);
+	proxy.firstNode = InvalidIndex;
+	proxy.layer = layer;
+	proxy.userData = userData;
+	proxy.nextFree = InvalidIndex;
+	proxy.inUse = true;
+
+	linkProxy(id);
+	numProxies++;
+
+	return id;
+}
+
+
+void SpatialHash::remove(ProxyID id) {
+
+	if (id >= proxies.size() || !proxies[id].inUse)
+		return;
+
+	unlinkProxy(id);
+
+	proxies[id].inUse = false;
+	proxies[id].nextFree = freeProxy;
+	freeProxy = id;
+
+	numProxies--;
+}
+
+
+void SpatialHash::update(ProxyID id, const AABB& bounds) {
+
+	if (id >= proxies.size() || !proxies[id].inUse)
+		return;
+
+	Proxy& proxy = proxies[id];
+
+	proxy.bounds = bounds;
+
+	ivec3 cMin = cellCoord(bounds.min);
+	ivec3 cMax = cellCoordUpper(bounds.max, cMin);
+
+	// Most frames a moving object stays within the same cells so no relinking is needed
+	if (cMin == proxy.cellMin && cMax == proxy.cellMax)
+		return;
+
+	unlinkProxy(id);
+
+	proxy.cellMin = cMin;
+	proxy.cellMax = cMax;
+
+	linkProxy(id);
+}
+
+
+void SpatialHash::clear() {
+
+	fill(buckets.begin(), buckets.end(), InvalidIndex);
+	nodes.clear();
+	proxies.clear();
+	queryStamps.clear();
+
+	currentStamp = 0;
+	freeNode = InvalidIndex;
+	freeProxy = InvalidProxy;
+	numProxies = 0;
+}
+
+
+void SpatialHash::query(const AABB& region, uint32_t layerMask, vector<ProxyID>& results) const {
+
+	gatherCells(region, layerMask, nextQueryStamp(), results);
+}
+
+
+void SpatialHash::queryBatch(const AABB* regions, size_t count, uint32_t layerMask, vector<uint32_t>& offsets, vector<ProxyID>& results) const {
+
+	offsets.resize(count + 1);
+
+	for (size_t i = 0; i < count; ++i) {
+
+		offsets[i] = (uint32_t)results.size();
+		gatherCells(regions[i], layerMask, nextQueryStamp(), results);
+	}
+
+	offsets[count] = (uint32_t)results.size();
+}
+
+
+const AABB& SpatialHash::bounds(ProxyID id) const {
+
+	return proxies[id].bounds;
+}
+
+
+uint32_t SpatialHash::layer(ProxyID id) const {
+
+	return proxies[id].layer;
+}
+
+
+uint32_t SpatialHash::userData(ProxyID id) const {
+
+	return proxies[id].userData;
+}
+
+
+float SpatialHash::getCellSize() const {
+
+	return cellSize;
+}
+
+
+uint32_t SpatialHash::proxyCount() const {
+
+	return numProxies;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "core.h"
+#include "AABB.h"
+
+// Broadphase uniform-grid spatial hash over axis-aligned bounding boxes.  Space is divided into cubic cells of side cellSize and each cell is hashed into a fixed size bucket table, so the world does not need to be bounded in advance.  Each proxy is linked into every cell its bounds overlap.  Insertion, removal and update are O(1) for proxies that span a bounded number of cells, and an update that does not change the covered cell range only stores the new bounds.
+
+class SpatialHash {
+
+public:
+
+	typedef uint32_t ProxyID;
+
+	static const ProxyID	InvalidProxy = 0xFFFFFFFF;
+
+	// Layer bits - queries can be restricted to static scenery, moving agents or both
+	static const uint32_t	StaticLayer = 0x1;
+	static const uint32_t	DynamicLayer = 0x2;
+	static const uint32_t	AllLayers = 0xFFFFFFFF;
+
+private:
+
+	static const uint32_t	InvalidIndex = 0xFFFFFFFF;
+
+	// Node linking a proxy into a single hash bucket.  Nodes in a bucket form a doubly linked list so they can be unlinked in O(1).  Nodes belonging to the same proxy form a singly linked list through proxyNext
+	struct CellNode {
+
+		ProxyID				proxy;
+		uint32_t			bucket;
+		uint32_t			prev;
+		uint32_t			next;
+		uint32_t			proxyNext;
+	};
+
+	struct Proxy {
+
+		AABB				bounds;
+		glm::ivec3			cellMin;
+		glm::ivec3			cellMax;
+		uint32_t			firstNode = InvalidIndex;
+		uint32_t			layer = 0;
+		uint32_t			userData = 0;
+		uint32_t			nextFree = InvalidIndex;
+		bool				inUse = false;
+	};
+
+	float					cellSize;
+	float					cellSizeRecip;
+	uint32_t				bucketMask;
+
+	std::vector<uint32_t>	buckets; // head node index for each bucket
+	std::vector<CellNode>	nodes;
+	std::vector<Proxy>		proxies;
+
+	// Per-proxy query stamps so a proxy spanning several cells (or sharing a bucket with another cell) is only reported once per query.  Kept apart from Proxy so the duplicate check touches a tightly packed array
+	mutable std::vector<uint32_t>	queryStamps;
+	mutable uint32_t				currentStamp = 0;
+
+	uint32_t				freeNode = InvalidIndex;
+	ProxyID					freeProxy = InvalidProxy;
+	uint32_t				numProxies = 0;
+
+
+	//
+	// Private API
+	//
+
+	glm::ivec3 cellCoord(const glm::vec3& p) const;
+	glm::ivec3 cellCoordUpper(const glm::vec3& p, const glm::ivec3& lower) const;
+	uint32_t bucketIndex(int x, int y, int z) const;
+
+	uint32_t allocateNode();
+	void linkProxy(ProxyID id);
+	void unlinkProxy(ProxyID id);
+
+	uint32_t nextQueryStamp() const;
+	void gatherCells(const AABB& region, uint32_t layerMask, uint32_t stamp, std::vector<ProxyID>& results) const;
+
+public:
+
+	// cellSize should be roughly the size of a typical moving object.  numBuckets is rounded up to a power of two
+	SpatialHash(float cellSize = 2.0f, uint32_t numBuckets = 4096);
+
+	ProxyID insert(const AABB& bounds, uint32_t layer = StaticLayer, uint32_t userData = 0);
+	void remove(ProxyID id);
+	void update(ProxyID id, const AABB& bounds);
+	void clear();
+
+	// Append to results all proxies in layerMask whose bounds overlap region.  Queries share per-proxy stamps so they must not run concurrently on the same SpatialHash
+	void query(const AABB& region, uint32_t layerMask, std::vector<ProxyID>& results) const;
+
+	// Batched query - results for regions[i] are stored in results[offsets[i]] to results[offsets[i + 1] - 1].  offsets is resized to count + 1
+	void queryBatch(const AABB* regions, size_t count, uint32_t layerMask, std::vector<uint32_t>& offsets, std::vector<ProxyID>& results) const;
+
+	const AABB& bounds(ProxyID id) const;
+	uint32_t layer(ProxyID id) const;
+	uint32_t userData(ProxyID id) const;
+
+	float getCellSize() const;
+	uint32_t proxyCount() const;
+};
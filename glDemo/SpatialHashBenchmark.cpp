@@ -0,0 +1,101 @@
+#include "SpatialHashBenchmark.h"
+#include "SpatialHash.h"
+#include "GUClock.h"
+
+using namespace std;
+using namespace glm;
+
+
+// Agents are scattered over a square world scaled so the agent density is the same at each size - per-agent cost should then stay flat as the agent count grows
+static void benchmarkAgents(uint32_t numAgents, int numFrames) {
+
+	const float agentHalfSize = 0.5f;
+	const float worldHalfSize = sqrtf((float)numAgents) * 2.0f;
+	const float frameDelta = 1.0f / 60.0f;
+
+	mt19937 rng(numAgents); // fixed seed so runs are repeatable
+	uniform_real_distribution<float> posDist(-worldHalfSize, worldHalfSize);
+	uniform_real_distribution<float> velDist(-3.0f, 3.0f);
+
+	SpatialHash hash(2.0f, numAgents * 4);
+
+	// Static obstacles - one wall segment every 16 world units
+	for (float z = -worldHalfSize; z < worldHalfSize; z += 16.0f) {
+		for (float x = -worldHalfSize; x < worldHalfSize; x += 16.0f) {
+
+			hash.insert(AABB(vec3(x, 0.0f, z), vec3(x + 8.0f, 3.0f, z + 1.0f)), SpatialHash::StaticLayer);
+		}
+	}
+
+	vector<vec3> positions(numAgents);
+	vector<vec3> velocities(numAgents);
+	vector<SpatialHash::ProxyID> agentProxies(numAgents);
+	vector<AABB> agentBounds(numAgents);
+
+	for (uint32_t i = 0; i < numAgents; ++i) {
+
+		positions[i] = vec3(posDist(rng), 0.0f, posDist(rng));
+		velocities[i] = vec3(velDist(rng), 0.0f, velDist(rng));
+		agentBounds[i] = AABB(positions[i] - vec3(agentHalfSize, 0.0f, agentHalfSize), positions[i] + vec3(agentHalfSize, 2.0f, agentHalfSize));
+		agentProxies[i] = hash.insert(agentBounds[i], SpatialHash::DynamicLayer, i);
+	}
+
+	vector<uint32_t> offsets;
+	vector<SpatialHash::ProxyID> results;
+	results.reserve(numAgents * 8);
+
+	GUClock timer;
+
+	gu_seconds updateTime = 0.0;
+	gu_seconds queryTime = 0.0;
+	size_t totalResults = 0;
+
+	for (int frame = 0; frame < numFrames; ++frame) {
+
+		gu_seconds t0 = timer.actualTimeElapsed();
+
+		for (uint32_t i = 0; i < numAgents; ++i) {
+
+			positions[i] += velocities[i] * frameDelta;
+
+			// Bounce off the world edges
+			if (fabsf(positions[i].x) > worldHalfSize)
+				velocities[i].x = -velocities[i].x;
+			if (fabsf(positions[i].z) > worldHalfSize)
+				velocities[i].z = -velocities[i].z;
+
+			agentBounds[i] = AABB(positions[i] - vec3(agentHalfSize, 0.0f, agentHalfSize), positions[i] + vec3(agentHalfSize, 2.0f, agentHalfSize));
+			hash.update(agentProxies[i], agentBounds[i]);
+		}
+
+		gu_seconds t1 = timer.actualTimeElapsed();
+
+		results.clear();
+		hash.queryBatch(agentBounds.data(), agentBounds.size(), SpatialHash::AllLayers, offsets, results);
+
+		gu_seconds t2 = timer.actualTimeElapsed();
+
+		updateTime += t1 - t0;
+		queryTime += t2 - t1;
+		totalResults += results.size();
+	}
+
+	double updateMs = updateTime * 1000.0 / (double)numFrames;
+	double queryMs = queryTime * 1000.0 / (double)numFrames;
+
+	printf("%8u agents: update %8.3f ms/frame (%6.1f ns/agent), query %8.3f ms/frame (%6.1f ns/agent), %.2f overlaps/agent\n",
+		numAgents,
+		updateMs, updateMs * 1.0e6 / (double)numAgents,
+		queryMs, queryMs * 1.0e6 / (double)numAgents,
+		(double)totalResults / ((double)numAgents * (double)numFrames));
+}
+
+
+void runSpatialHashBenchmark() {
+
+	cout << "SpatialHash benchmark (cell size 2.0, 60Hz step)\n";
+
+	benchmarkAgents(1000, 200);
+	benchmarkAgents(10000, 100);
+	benchmarkAgents(100000, 20);
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+#include "core.h"
+
+// Microbenchmark for SpatialHash - moves 1k, 10k and 100k agents through a grid of static obstacles and reports per-frame update and batched neighbour query times
+void runSpatialHashBenchmark();
@@ -1,5 +1,6 @@
 
 #include "TextureLoader.h"
+#include "RenderStats.h"
 
 using namespace std;
 
@@ -27,6 +28,18 @@ GLuint loadTexture(string filename, FREE_IMAGE_FORMAT srcImageType) {
 	}
 
 	// Image loaded and converted - setup new texture object
+	GLuint newTexture = createTexture(bitmap32bpp);
+
+	// Once the texture has been setup, the image data is copied into OpenGL.  We no longer need the originally loaded image
+	FreeImage_Unload(bitmap32bpp);
+
+	return newTexture;
+}
+
+
+// Setup a new texture object from a bitmap already converted to 32 bits-per-pixel
+GLuint createTexture(FIBITMAP* bitmap32bpp) {
+
 	GLuint newTexture = 0;
 
 	// If image loaded, setup new texture object in OpenGL
@@ -48,6 +61,8 @@ GLuint loadTexture(string filename, FREE_IMAGE_FORMAT srcImageType) {
 			GL_UNSIGNED_BYTE,
 			FreeImage_GetBits(bitmap32bpp));
 
+		GURenderStats::countTextureUpload((uint64_t)FreeImage_GetWidth(bitmap32bpp) * FreeImage_GetHeight(bitmap32bpp) * 4);
+
 		// Setup texture filter and wrap properties
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -55,8 +70,5 @@ GLuint loadTexture(string filename, FREE_IMAGE_FORMAT srcImageType) {
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
 	}
 
-	// Once the texture has been setup, the image data is copied into OpenGL.  We no longer need the originally loaded image
-	FreeImage_Unload(bitmap32bpp);
-
 	return newTexture;
-}
\ No newline at end of file
+}
@@ -4,3 +4,6 @@
 
 // Helper function for loading texture images from disk and setup a texture with defaut properties
 GLuint loadTexture(std::string filename, FREE_IMAGE_FORMAT srcImageType);
+
+// Setup a texture with default properties from a 32 bits-per-pixel (BGRA) FreeImage bitmap.  The bitmap is not released
+GLuint createTexture(FIBITMAP* bitmap32bpp);
@@ -1,5 +1,7 @@
 
 #include "TextureQuad.h"
+#include "RenderStats.h"
+#include <cstddef>
 
 
 #pragma region Geometry data to setup VBOs for rendering - use triangles not quads here
@@ -26,28 +28,52 @@ static GLuint indices[] = { 0, 2, 1, 0, 3, 2 };
 #pragma endregion
 
 
-// VBOs for quad geometry used for each planetary body
+// VAO and VBOs for quad geometry, plus a per-instance buffer that is refilled for each instanced batch
+static GLuint quadVAO;
 static GLuint posVBO;
 static GLuint texCoordVBO;
 static GLuint indicesVBO;
+static GLuint instanceVBO;
+static GLsizeiptr instanceVBOSize = 0;
 
 
 void setupTextureQuadVBO() {
 
+	glGenVertexArrays(1, &quadVAO);
+	glBindVertexArray(quadVAO);
+
 	// Setup VBOs for quad geometry
 	glGenBuffers(1, &posVBO);
 	glBindBuffer(GL_ARRAY_BUFFER, posVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(positions), positions, GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
+	glEnableVertexAttribArray(0);
 
 	glGenBuffers(1, &texCoordVBO);
 	glBindBuffer(GL_ARRAY_BUFFER, texCoordVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(texCoords), texCoords, GL_STATIC_DRAW);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
+	glEnableVertexAttribArray(2);
+
+	// Per-instance attributes advance once per quad rather than once per vertex
+	glGenBuffers(1, &instanceVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+	glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(TextureQuadInstance), (const GLvoid*)offsetof(TextureQuadInstance, positionSize));
+	glVertexAttribDivisor(6, 1);
+	glEnableVertexAttribArray(6);
 
+	glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(TextureQuadInstance), (const GLvoid*)offsetof(TextureQuadInstance, params));
+	glVertexAttribDivisor(7, 1);
+	glEnableVertexAttribArray(7);
+
+	// The element buffer binding is part of the VAO state
 	glGenBuffers(1, &indicesVBO);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indicesVBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
-	// Unbind buffers once done
+	// Unbind once done
+	glBindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
@@ -55,33 +81,48 @@ void setupTextureQuadVBO() {
 // Setup state for known batch of objects using quad
 void textureQuadPreRender() {
 
-	// Setup VBOs ready for rendering
-	glBindBuffer(GL_ARRAY_BUFFER, posVBO);
-	glVertexPointer(2, GL_FLOAT, 0, (GLvoid*)0);
-
-	glBindBuffer(GL_ARRAY_BUFFER, texCoordVBO);
-	glTexCoordPointer(2, GL_FLOAT, 0, (GLvoid*)0);
-
-	// Bind (and leave bound) the index array for drawing
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indicesVBO);
+	glBindVertexArray(quadVAO);
 
-	// Declare which arrays are needed for the semi-circle object
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	GURenderStats::countVAOBind();
 }
 
 void textureQuadRender() {
 
 	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (GLvoid*)0);
+
+	GURenderStats::countDraw(6);
 }
 
-void textureQuadPostRender() {
+void textureQuadRenderInstanced(const TextureQuadInstance* instances, GLsizei count) {
+
+	if (count <= 0)
+		return;
 
-	// Disable vertex arrays
-	glDisableClientState(GL_VERTEX_ARRAY);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	GLsizeiptr size = (GLsizeiptr)count * sizeof(TextureQuadInstance);
+
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+	// Orphan the old storage so the driver does not stall on instances still being drawn from the previous batch
+	if (size > instanceVBOSize) {
+
+		instanceVBOSize = size;
+		glBufferData(GL_ARRAY_BUFFER, size, instances, GL_STREAM_DRAW);
+	}
+	else {
+
+		glBufferData(GL_ARRAY_BUFFER, instanceVBOSize, NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, instances);
+	}
 
-	// Unbind buffers once done
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-}
\ No newline at end of file
+
+	glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (GLvoid*)0, count);
+
+	GURenderStats::countBufferUpload(size);
+	GURenderStats::countDraw(6, count);
+}
+
+void textureQuadPostRender() {
+
+	glBindVertexArray(0);
+}
@@ -2,10 +2,22 @@
 
 #include "core.h"
 
+// Per-instance data for instanced quads.  Bound to attribute location 6 (positionSize - xyz world centre, w half-size) and 7 (params - shader specific, eg. the instance orientation quaternion for impostors)
+struct TextureQuadInstance {
+
+	glm::vec4		positionSize;
+	glm::vec4		params;
+};
+
+// Quad vertex positions are bound to attribute location 0 and texture coordinates to location 2, matching the AIMesh layout
 void setupTextureQuadVBO();
 
 void textureQuadPreRender();
 
 void textureQuadRender();
 
+// Upload instances to the per-instance buffer and draw them all with a single call.  Must be called between textureQuadPreRender and textureQuadPostRender
+void textureQuadRenderInstanced(const TextureQuadInstance* instances, GLsizei count);
+
 void textureQuadPostRender();
+
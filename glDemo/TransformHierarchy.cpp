@@ -0,0 +1,259 @@
+#include "TransformHierarchy.h"
+
+using namespace std;
+using namespace glm;
+
+
+// Static member definitions
+const uint32_t GUTransformHierarchy::invalid;
+const uint32_t GUTransformHierarchy::noParent;
+
+
+// Private method implementation
+
+// Reorder the node arrays depth-first.  Roots and the children of each node keep their current relative order, so an order that is already depth-first is unchanged
+void GUTransformHierarchy::rebuildOrder() {
+
+	const uint32_t n = (uint32_t)nodeIds.size();
+
+	// Children of each node as ranges of childIds, grouped by parent storage position
+	vector<uint32_t> childStart(n + 1, 0);
+
+	for (uint32_t i = 0; i < n; ++i) {
+
+		if (parentIds[i] != invalid)
+			childStart[positions[parentIds[i]] + 1]++;
+	}
+
+	for (uint32_t i = 0; i < n; ++i)
+		childStart[i + 1] += childStart[i];
+
+	vector<uint32_t> childIds(childStart[n]);
+	vector<uint32_t> next(childStart.begin(), childStart.end() - 1);
+
+	for (uint32_t i = 0; i < n; ++i) {
+
+		if (parentIds[i] != invalid)
+			childIds[next[positions[parentIds[i]]]++] = nodeIds[i];
+	}
+
+	// Depth-first walk from each root.  Children are pushed in reverse so they are visited in order
+	vector<uint32_t> order;
+	vector<uint32_t> stack;
+
+	order.reserve(n);
+
+	for (uint32_t i = 0; i < n; ++i) {
+
+		if (parentIds[i] != invalid)
+			continue;
+
+		stack.push_back(nodeIds[i]);
+
+		while (!stack.empty()) {
+
+			uint32_t id = stack.back();
+			uint32_t p = positions[id];
+
+			stack.pop_back();
+			order.push_back(id);
+
+			for (uint32_t c = childStart[p + 1]; c > childStart[p]; --c)
+				stack.push_back(childIds[c - 1]);
+		}
+	}
+
+	vector<uint32_t> newParentIds(n);
+	vector<mat4> newLocal(n), newWorld(n);
+	vector<uint8_t> newDirty(n);
+
+	for (uint32_t i = 0; i < n; ++i) {
+
+		uint32_t p = positions[order[i]];
+
+		newParentIds[i] = parentIds[p];
+		newLocal[i] = local[p];
+		newWorld[i] = world[p];
+		newDirty[i] = dirty[p];
+	}
+
+	nodeIds.swap(order);
+	parentIds.swap(newParentIds);
+	local.swap(newLocal);
+	world.swap(newWorld);
+	dirty.swap(newDirty);
+
+	for (uint32_t i = 0; i < n; ++i)
+		positions[nodeIds[i]] = i;
+
+	parentPositions.resize(n);
+
+	for (uint32_t i = 0; i < n; ++i)
+		parentPositions[i] = (parentIds[i] != invalid) ? positions[parentIds[i]] : invalid;
+
+	orderStale = false;
+}
+
+
+// Public method implementation
+
+uint32_t GUTransformHierarchy::create(const mat4& localTransform, uint32_t parent) {
+
+	uint32_t id;
+
+	if (!freeIds.empty()) {
+
+		id = freeIds.back();
+		freeIds.pop_back();
+	}
+	else {
+
+		id = (uint32_t)positions.size();
+		positions.push_back(invalid);
+	}
+
+	positions[id] = (uint32_t)nodeIds.size();
+
+	nodeIds.push_back(id);
+	parentIds.push_back(parent);
+	parentPositions.push_back((parent != invalid) ? positions[parent] : invalid);
+	local.push_back(localTransform);
+	world.push_back(localTransform);
+	dirty.push_back(1);
+
+	// Appending keeps every node after its parent, but the new node is not next to its siblings' subtrees
+	if (parent != invalid)
+		orderStale = true;
+
+	return id;
+}
+
+
+void GUTransformHierarchy::destroy(uint32_t node) {
+
+	uint32_t p = positions[node];
+	uint32_t parent = parentIds[p];
+
+	for (uint32_t i = 0; i < (uint32_t)nodeIds.size(); ++i) {
+
+		if (parentIds[i] == node) {
+
+			parentIds[i] = parent;
+			dirty[i] = 1;
+		}
+	}
+
+	// Move the last node into the hole
+	uint32_t last = (uint32_t)nodeIds.size() - 1;
+
+	if (p != last) {
+
+		nodeIds[p] = nodeIds[last];
+		parentIds[p] = parentIds[last];
+		parentPositions[p] = parentPositions[last];
+		local[p] = local[last];
+		world[p] = world[last];
+		dirty[p] = dirty[last];
+
+		positions[nodeIds[p]] = p;
+	}
+
+	nodeIds.pop_back();
+	parentIds.pop_back();
+	parentPositions.pop_back();
+	local.pop_back();
+	world.pop_back();
+	dirty.pop_back();
+
+	positions[node] = invalid;
+	freeIds.push_back(node);
+
+	orderStale = true;
+}
+
+
+bool GUTransformHierarchy::setParent(uint32_t node, uint32_t parent) {
+
+	for (uint32_t ancestor = parent; ancestor != invalid; ancestor = parentIds[positions[ancestor]]) {
+
+		if (ancestor == node)
+			return false;
+	}
+
+	uint32_t p = positions[node];
+
+	if (parentIds[p] != parent) {
+
+		parentIds[p] = parent;
+		dirty[p] = 1;
+		orderStale = true;
+	}
+
+	return true;
+}
+
+
+void GUTransformHierarchy::setLocalTransform(uint32_t node, const mat4& localTransform) {
+
+	uint32_t p = positions[node];
+
+	local[p] = localTransform;
+	dirty[p] = 1;
+}
+
+
+uint32_t GUTransformHierarchy::parentOf(uint32_t node) const {
+
+	return parentIds[positions[node]];
+}
+
+
+const mat4& GUTransformHierarchy::localTransform(uint32_t node) const {
+
+	return local[positions[node]];
+}
+
+
+const mat4& GUTransformHierarchy::worldTransform(uint32_t node) const {
+
+	return world[positions[node]];
+}
+
+
+void GUTransformHierarchy::update() {
+
+	if (orderStale)
+		rebuildOrder();
+
+	const uint32_t n = (uint32_t)nodeIds.size();
+
+	changed.resize(n);
+	lastUpdated = 0;
+
+	// Parents come first, so changed[parent] is final by the time each child is reached
+	for (uint32_t i = 0; i < n; ++i) {
+
+		uint32_t parent = parentPositions[i];
+
+		changed[i] = dirty[i] | ((parent != invalid) ? changed[parent] : 0);
+		dirty[i] = 0;
+
+		if (changed[i]) {
+
+			world[i] = (parent != invalid) ? world[parent] * local[i] : local[i];
+			lastUpdated++;
+		}
+	}
+}
+
+
+uint32_t GUTransformHierarchy::nodeCount() const {
+
+	return (uint32_t)nodeIds.size();
+}
+
+
+uint32_t GUTransformHierarchy::lastUpdateCount() const {
+
+	return lastUpdated;
+}
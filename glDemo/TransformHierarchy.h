@@ -0,0 +1,67 @@
+#pragma once
+
+//
+// Parent / child transform hierarchy with cached world matrices.  Each node has a local transform (relative to its parent) and a world transform (parentWorld * local) that update() recomputes only for nodes whose local transform changed since the last update, or that have such an ancestor.
+//
+// Nodes are stored in depth-first order - every node comes after its parent and each subtree is contiguous - so update() is one linear pass: a node is recomputed if it is dirty or its parent was recomputed earlier in the same pass.  Nodes are referred to by ids that stay valid while the storage order changes.  Creating, destroying and reparenting nodes only marks the order stale, and the next update() rebuilds it in O(n), so structural changes are cheap to batch but should not be made every frame.
+//
+
+#include "core.h"
+
+
+class GUTransformHierarchy {
+
+private:
+
+	static const uint32_t		invalid = 0xFFFFFFFF;
+
+	// Per node in storage order
+	std::vector<uint32_t>		nodeIds;
+	std::vector<uint32_t>		parentIds; // invalid for roots
+	std::vector<uint32_t>		parentPositions; // storage position of the parent - valid while the order is not stale
+	std::vector<glm::mat4>		local;
+	std::vector<glm::mat4>		world;
+	std::vector<uint8_t>		dirty; // local transform set since the last update
+
+	// Per node id
+	std::vector<uint32_t>		positions; // storage position, or invalid if the id is free
+	std::vector<uint32_t>		freeIds;
+
+	bool						orderStale = false;
+	uint32_t					lastUpdated = 0;
+
+	// Working storage for update
+	std::vector<uint8_t>		changed;
+
+	// Private functions
+	void rebuildOrder();
+
+public:
+
+	static const uint32_t		noParent = invalid;
+
+	// Add a node with the given local transform as a child of parent (noParent for a root) and return its id
+	uint32_t create(const glm::mat4& localTransform, uint32_t parent = noParent);
+
+	// Remove node.  Its children are moved to node's parent, keeping their local transforms
+	void destroy(uint32_t node);
+
+	// Make node a child of parent (noParent for a root), keeping its local transform.  Returns false (and changes nothing) if parent is node or one of its descendants
+	bool setParent(uint32_t node, uint32_t parent);
+
+	void setLocalTransform(uint32_t node, const glm::mat4& localTransform);
+
+	uint32_t parentOf(uint32_t node) const;
+	const glm::mat4& localTransform(uint32_t node) const;
+
+	// World transform as of the last update()
+	const glm::mat4& worldTransform(uint32_t node) const;
+
+	// Recompute the world transform of every node whose local transform or an ancestor's has changed
+	void update();
+
+	uint32_t nodeCount() const;
+
+	// World transforms recomputed by the last update()
+	uint32_t lastUpdateCount() const;
+};
@@ -2,6 +2,7 @@
 #include "Transparency.h"
 #include "TextureLoader.h"
 #include "shader_setup.h"
+#include "RenderStats.h"
 
 using namespace std;
 using namespace glm;
@@ -10,7 +11,7 @@ using namespace glm;
 Transparency::Transparency(std::string filename, GLuint meshIndex) : AIMesh(filename, meshIndex) {
 
 	// Load shader
-	shader = setupShaders(string("Assets\\Shaders\\TransparencyShader.vert"), string("Assets\\Shaders\\TransparencyShader.frag"));
+	shader = setupShaders(string("Assets/Shaders/TransparencyShader.vert"), string("Assets/Shaders/TransparencyShader.frag"));
 
 	// Get uniform locations
 	shader_mvpMatrix = glGetUniformLocation(shader, "mvpMatrix");
@@ -28,5 +29,8 @@ void Transparency::render(mat4 transform) {
 	glUseProgram(shader);
 	glUniformMatrix4fv(shader_mvpMatrix, 1, GL_FALSE, (GLfloat*)&transform);
 
+	GURenderStats::countProgramBind();
+	GURenderStats::countUniformUpload();
+
 	AIMesh::render();
 }
\ No newline at end of file
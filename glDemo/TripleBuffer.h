@@ -0,0 +1,75 @@
+#pragma once
+
+//
+// Lock-free single producer / single consumer triple buffer.  The producer fills writeBuffer() and publishes it; the consumer calls update() to take the most recently published value and reads it with readBuffer().  Neither side ever waits - the producer always has a slot of its own to write and the consumer keeps reading its slot until it takes a newer one, so a value published while the consumer is still using the previous one simply replaces any value not yet taken.
+//
+// The three slots are exchanged through one atomic word holding the index of the shared (most recently published) slot and a flag set when it holds a value the consumer has not taken.  T is copied into the slots, so it should not own memory the producer reuses.
+//
+
+#include <atomic>
+#include <stdint.h>
+
+
+template <typename T>
+class GUTripleBuffer {
+
+private:
+
+	static const uint32_t		freshFlag = 4;
+	static const uint32_t		indexMask = 3;
+
+	T							slots[3];
+
+	std::atomic<uint32_t>		shared; // slot index of the shared buffer | freshFlag if it holds an untaken value
+
+	uint32_t					writeIndex = 0; // producer only
+	uint32_t					readIndex = 1; // consumer only
+
+public:
+
+	GUTripleBuffer() : shared(2) {}
+
+	GUTripleBuffer(const GUTripleBuffer&) = delete;
+	GUTripleBuffer& operator=(const GUTripleBuffer&) = delete;
+
+
+	// Producer
+
+	// Slot to fill before publish() - its previous contents are undefined (some earlier value)
+	T& writeBuffer() {
+
+		return slots[writeIndex];
+	}
+
+	// Make the value in writeBuffer() the latest, replacing any value the consumer has not taken
+	void publish() {
+
+		writeIndex = shared.exchange(writeIndex | freshFlag, std::memory_order_acq_rel) & indexMask;
+	}
+
+	void publish(const T& value) {
+
+		slots[writeIndex] = value;
+		publish();
+	}
+
+
+	// Consumer
+
+	// Take the latest published value if there is one newer than readBuffer().  Returns true if readBuffer() changed
+	bool update() {
+
+		if ((shared.load(std::memory_order_relaxed) & freshFlag) == 0)
+			return false;
+
+		readIndex = shared.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+
+		return true;
+	}
+
+	// Value taken by the last successful update() (a default constructed T before the first)
+	const T& readBuffer() const {
+
+		return slots[readIndex];
+	}
+};
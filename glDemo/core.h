@@ -1,6 +1,7 @@
 #pragma once
 
 // These libraries are needed to link the program (Visual Studio specific)
+#ifdef _MSC_VER
 #pragma comment(lib,"opengl32.lib")
 #pragma comment(lib,"glu32.lib")
 #pragma comment(lib,"lib\\glfw3.lib")
@@ -8,12 +9,16 @@
 #pragma comment(lib,"lib\\glew32.lib")
 #pragma comment(lib,"lib\\FreeImage.lib")
 #pragma comment(lib,"lib\\assimp-vc143-mt.lib")
+#pragma comment(lib,"winmm.lib")
+#endif
 
 #define GLEW_STATIC
 #include "GL/glew.h" 
 #include "GLFW/glfw3.h"
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 #include <stdio.h>
 #include <assert.h>
 #include <math.h>
@@ -24,14 +29,29 @@
 #include <string>
 #include <map>
 #include <set>
-#include <glm\vec2.hpp>
-#include <glm\vec3.hpp>
-#include <glm\vec4.hpp>
-#include <glm\mat3x3.hpp>
-#include <glm\mat4x4.hpp>
-#include <glm\gtc\matrix_transform.hpp>
-#include <glm\gtx\euler_angles.hpp>
-#include <FreeImage\FreeImage.h>
-#include <assimp\cimport.h>			// Main C import interface
-#include <assimp\scene.h>			// Output data structure
-#include <assimp\postprocess.h>		// Post processing flags
\ No newline at end of file
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/euler_angles.hpp>
+#include <FreeImage/FreeImage.h>
+#include <assimp/cimport.h>			// Main C import interface
+#include <assimp/scene.h>			// Output data structure
+#include <assimp/postprocess.h>		// Post processing flags
+#include <string.h>
+
+// Bounds checked CRT functions used by the demo, for compilers other than Visual Studio (eg. headless Linux builds - see HeadlessPlatform.h)
+#ifndef _MSC_VER
+#define sprintf_s snprintf
+
+inline int memcpy_s(void* dest, size_t destSize, const void* src, size_t count) {
+
+	if (count > destSize)
+		return -1;
+
+	memcpy(dest, src, count);
+	return 0;
+}
+#endif
@@ -7,6 +7,34 @@
 #include "AIMesh.h"
 #include "Cylinder.h"
 #include "Transparency.h"
+#include "SpatialHash.h"
+#include "SpatialHashBenchmark.h"
+#include "GUClockBenchmark.h"
+#include "CPUBenchmark.h"
+#include "BatchMathBenchmark.h"
+#include "Profiler.h"
+#include "HLOD.h"
+#include "Impostor.h"
+#include "TextureQuad.h"
+#include "GPUPassTimer.h"
+#include "RenderStats.h"
+#include "DebugOutput.h"
+#include "BenchmarkPath.h"
+#include "GLFWPlatform.h"
+#include "HeadlessPlatform.h"
+#include "SceneDescription.h"
+#include "FixedTimestep.h"
+#include "TripleBuffer.h"
+#include "JobSystem.h"
+#include "JobBenchmark.h"
+#include "CommandBuffer.h"
+#include "ECS.h"
+#include "BatchMath.h"
+#include "FrameArena.h"
+#include "AllocationTracker.h"
+#include "PerfHUD.h"
+#include <thread>
+#include <atomic>
 
 
 using namespace std;
@@ -52,9 +80,37 @@ struct PointLight {
 	}
 };
 
+// Opaque scene geometry that never moves.  Static instances are drawn from a single list in each lighting pass and can be replaced by an HLOD proxy when far from the camera
+struct StaticInstance {
+
+	AIMesh*		mesh;
+	mat4		modelTransform;
+	AABB		worldBounds; // mesh bounds in world space - instances do not move, so set once by setupStaticInstances
+	int			lod; // selected once per frame
+	MeshletDrawList			meshletDraws; // visible meshlets when drawn at LOD 0
+	int			cluster; // index into hlodClusters, or -1 if the instance is always drawn individually
+
+	OctahedralImpostor*		impostor; // nullptr if the instance cannot be drawn as an impostor
+	TextureQuadInstance		impostorInstance;
+	bool					impostorActive;
+
+	StaticInstance(AIMesh* mesh, mat4 modelTransform) {
+
+		this->mesh = mesh;
+		this->modelTransform = modelTransform;
+		this->lod = 0;
+		this->cluster = -1;
+		this->impostor = nullptr;
+		this->impostorActive = false;
+	}
+};
+
 
 #pragma region Global variables
 
+// Window (or headless framebuffer) and OpenGL context
+GUPlatform*			platform = nullptr;
+
 // Window size
 unsigned int		windowWidth = 1024;
 unsigned int		windowHeight = 768;
@@ -76,6 +132,9 @@ bool				backPressed;
 bool				rotateLeftPressed;
 bool				rotateRightPressed;
 
+// Directional light colour chosen with keys 1-3 (main thread - passed on with the input)
+vec3				directLightColour = vec3(1.0f, 1.0f, 1.0f);
+
 
 // Scene objects
 AIMesh*				groundMesh = nullptr;
@@ -126,7 +185,23 @@ GLint				nMapDirLightShader_normalMapTexture;
 GLint				nMapDirLightShader_lightDirection;
 GLint				nMapDirLightShader_lightColour;
 
-// beast model
+// Octahedral impostor bake and render shaders
+GLuint				impostorBakeShader;
+GLuint				impostorShader;
+GLint				impostorShader_viewMatrix;
+GLint				impostorShader_projMatrix;
+GLint				impostorShader_cameraPos;
+GLint				impostorShader_framesPerSide;
+GLint				impostorShader_albedoAtlas;
+GLint				impostorShader_normalAtlas;
+GLint				impostorShader_lightDirection;
+GLint				impostorShader_lightColour;
+GLint				impostorShader_numPointLights;
+GLint				impostorShader_pointLightPosition;
+GLint				impostorShader_pointLightColour;
+GLint				impostorShader_pointLightAttenuation;
+
+// beast model - as rendered, interpolated between the last two simulation steps
 vec3 beastPos = vec3(2.0f, 0.0f, 0.0f);
 float beastRotation = 0.0f;
 
@@ -135,20 +210,154 @@ float beastRotation = 0.0f;
 float directLightTheta = 45.0f;
 DirectionalLight directLight = DirectionalLight(vec3(cosf(directLightTheta), sinf(directLightTheta), 0.0f));
 
-// Setup point light example light (use array to make adding other lights easier later)
-PointLight lights[2] = {
-	PointLight(vec3(0.0f, 7.0f, 7.0f), vec3(0.9f, 0.75f, 0.1f), vec3(1.0f, 0.1f, 0.001f)),
-	PointLight(vec3(-20.0f, 2.0f, 5.0f), vec3(1.0f, 0.0f, 0.0f), vec3(1.0f, 0.1f, 0.001f))
-};
+// Point lights - gathered from the light entities
+vector<PointLight> lights;
+
+// Impostors light with every point light in one pass - the impostor shader holds at most this many (maxPointLights in impostor.frag)
+const int impostorMaxPointLights = 4;
 
 bool rotateDirectionalLight = true;
 float directionalLightSpeed = 0.0f;
 
 
+// Simulation - the simulation thread runs simulateStep at a fixed rate (--sim-rate=<hz>) however fast frames are rendered, and updateScene interpolates beastPos, beastRotation and directLight between the last two states so motion stays smooth
+struct SimulationState {
+
+	vec3				beastPos;
+	float				beastRotation; // degrees
+	float				directLightTheta; // radians
+};
+
+SimulationState			simPrevious;
+SimulationState			simCurrent;
+GUFixedTimestep*		simTimestep = nullptr;
+double					simulationRate = 120.0; // steps per second
+const int				simMaxStepsPerFrame = 8; // catch-up cap - see GUFixedTimestep
+
+
+// Threads - the main thread handles window events and passes the input to the simulation thread, which publishes a SceneSnapshot after each batch of steps for the render thread to draw.  Each hand-off is a lock-free triple buffer so no stage waits for another, and frame time approaches the slowest stage rather than the sum of all three
+struct InputState {
+
+	bool				forward = false, back = false, rotateLeft = false, rotateRight = false;
+	float				directionalLightSpeed = 0.0f; // degrees per second
+	vec3				directionalLightColour = vec3(1.0f, 1.0f, 1.0f);
+	float				cameraTheta = 0.0f, cameraPhi = 0.0f, cameraRadius = 0.0f, cameraAspect = 1.0f; // mainCamera, which follows the mouse
+	int					viewportWidth = 0, viewportHeight = 0;
+};
+
+// Everything renderScene needs that changes as the scene runs.  The render thread interpolates from previous to current
+struct SceneSnapshot {
+
+	SimulationState		previous;
+	SimulationState		current;
+	gu_time_index		publishTime = 0; // interactive runs interpolate over the step after current was published...
+	float				alpha = 0.0f; // ...benchmarks (publishTime 0) by the fraction of a step left in the accumulator
+	vec3				directionalLightColour = vec3(1.0f, 1.0f, 1.0f);
+	float				cameraTheta = 0.0f, cameraPhi = 0.0f, cameraRadius = 0.0f, cameraAspect = 1.0f;
+	int					viewportWidth = 0, viewportHeight = 0;
+	int					benchmarkFrame = 0; // frame the snapshot is for in benchmarks
+};
+
+GUTripleBuffer<InputState>		inputBuffer;
+GUTripleBuffer<SceneSnapshot>	snapshotBuffer;
+
+std::thread				simulationThread;
+std::thread				renderThread;
+std::atomic<bool>		simulationRunning(false);
+std::atomic<int>		benchmarkFrameTaken(0); // last benchmark frame taken by the render thread - the simulation stays at most one frame ahead so none are skipped
+std::atomic<bool>		printStatsRequested(false); // R key - render statistics are counted on the render thread
+std::atomic<bool>		perfHUDVisible(true); // H key
+
+// Render thread's camera and viewport, set from each snapshot (mainCamera and the window size belong to the main thread)
+ArcballCamera*			renderCamera = nullptr;
+int						viewportWidth = 0;
+int						viewportHeight = 0;
+
+
 // House single / multi-mesh example
 vector<AIMesh*> houseModel = vector<AIMesh*>();
 
 
+// Scene layout (--scene=<file>, or generated with --city=<x>x<z>) - the original city block unless another scene is given
+SceneDescription		scene;
+
+// Scene objects as entities, created from scene by setupSceneEntities.  Only the render thread uses them once the main loop starts - the player's transform is set from the interpolated simulation state each frame.  The player is a root (position and facing) with the character model and any attachments as children, so the attachments are not scaled with the model
+GUWorld					sceneWorld;
+GUEntity				playerEntity = GUNullEntity;
+GUEntity				playerModelEntity = GUNullEntity;
+vector<GUEntity>		attachedEntities; // renderable descendants of playerEntity other than the model, drawn with the static instances each frame
+
+// Transparent huts are drawn in their own blended pass
+vector<mat4>			hutTransforms;
+
+
+// Collision - static scenery and the character are stored in a spatial hash broadphase
+SpatialHash*			collisionWorld = nullptr;
+SpatialHash::ProxyID	beastProxy = SpatialHash::InvalidProxy;
+AABB					beastLocalBounds = AABB(vec3(-0.5f, 0.0f, -0.5f), vec3(0.5f, 3.5f, 0.5f)); // character footprint relative to beastPos
+vector<SpatialHash::ProxyID> collisionResults;
+
+
+// Static scene instances and the HLOD proxy clusters built from them
+vector<StaticInstance>	staticInstances;
+vector<float>			staticMinX, staticMinY, staticMinZ, staticMaxX, staticMaxY, staticMaxZ; // world bounds per instance in the form GUBatchMath::testAABBs reads
+std::pmr::vector<uint8_t>	staticInFrustum; // per instance - set by cullMeshlets each frame, in the frame arena
+vector<HLODCluster*>	hlodClusters;
+const float				hlodClusterExtent = 40.0f; // maximum diagonal of a cluster's bounds
+const float				hlodSwapDistance = 150.0f; // camera distance beyond which a cluster is drawn as its proxy
+std::pmr::vector<uint8_t>	hlodProxyVisible; // per cluster - false when the proxy is active but every member is drawn as an impostor.  Set by selectLODs each frame, in the frame arena
+
+// Octahedral impostors - one per mesh, used for instances beyond impostorSwapDistance
+vector<OctahedralImpostor*>	impostors;
+std::pmr::vector<TextureQuadInstance>	impostorBatch; // in the frame arena
+const float				impostorSwapDistance = 300.0f;
+
+
+// LOD and HLOD choices are made once per frame so every lighting pass draws identical geometry (the additive passes rely on GL_LEQUAL depth testing against the first pass)
+int						characterLOD = 0;
+MeshletDrawList			characterMeshletDraws;
+
+// Static instance, HLOD proxy and player attachment draws - recorded in parallel into one buffer per slice of the scene after culling, merged into staticDrawQueue once per frame and replayed in every lighting pass.  The commands are allocated from the recording threads' frame arenas
+vector<GUCommandBuffer>	staticCommandBuffers;
+GUCommandQueue			staticDrawQueue;
+
+const size_t			frameArenaBytes = 1 << 20; // initial size of each thread's frame arena
+
+// GPU time per render pass - results are reported alongside the frame times by gameClock
+GPUPassTimer*			gpuTimer = nullptr;
+int						gpuPassDirectional = -1;
+int						gpuPassPointLights = -1;
+int						gpuPassImpostors = -1;
+int						gpuPassTransparency = -1;
+
+// Frame time graph, pass timings and render counts drawn over each frame - hidden in benchmarks and headless runs so they do not affect results or screenshots
+GUPerfHUD*				perfHUD = nullptr;
+
+// Render statistics passes - see GURenderStats
+int						statsPassDirectional = 0;
+int						statsPassPointLights = 0;
+int						statsPassImpostors = 0;
+int						statsPassTransparency = 0;
+
+// Benchmark mode (--benchmark) replays benchmarkPath with a fixed simulation timestep.  The first benchmarkWarmupFrames frames are run but not measured
+bool					benchmarkMode = false;
+BenchmarkPath			benchmarkPath;
+const float				benchmarkTimestep = 1.0f / 60.0f;
+const int				benchmarkWarmupFrames = 120;
+int						benchmarkFrames = 1800; // measured frames
+int						benchmarkFrame = 0; // frames rendered so far, including warm-up
+gu_time_index			benchmarkStartTime = 0; // when measurement started (after warm-up)
+string					screenshotFile; // --screenshot=<file> - saved from the final benchmark frame
+
+// --track-allocations counts heap allocations per frame, profiler zone and call site (see GUAllocationTracker).  A benchmark run with it fails if any measured frame allocates
+bool					trackAllocations = false;
+
+// Path recording (--record-path) - a key is added every pathRecordSpacing seconds of game time
+BenchmarkPath*			recordedPath = nullptr;
+const float				pathRecordSpacing = 0.1f;
+float					pathRecordTime = 0.0f;
+
+
 
 #pragma endregion
 
@@ -156,7 +365,23 @@ vector<AIMesh*> houseModel = vector<AIMesh*>();
 // Function prototypes
 void renderScene();
 void renderWithMyLights();
+void selectLODs(const mat4& cameraView);
+void cullMeshlets(const mat4& cameraView, const mat4& cameraProjection);
+void recordStaticInstances(const mat4& cameraView);
+void renderStaticInstances(GLint modelMatrixLocation);
+AIMesh* sceneMesh(SceneMesh mesh);
+void setupSceneEntities();
+void setupStaticInstances();
+void setupImpostors();
+void renderImpostors(const mat4& cameraView, const mat4& cameraProjection);
 void updateScene();
+void simulateStep(float tDelta, gu_seconds stepTime, const InputState& input);
+void simulationThreadMain();
+void renderThreadMain();
+void publishInput();
+void fillSnapshot(SceneSnapshot& snapshot, const InputState& input);
+void setupCollisionWorld();
+vec3 resolveMovement(const vec3& pos, const vec3& displacement);
 void resizeWindow(GLFWwindow* window, int width, int height);
 void keyboardHandler(GLFWwindow* window, int key, int scancode, int action, int mods);
 void mouseMoveHandler(GLFWwindow* window, double xpos, double ypos);
@@ -166,7 +391,284 @@ void mouseEnterHandler(GLFWwindow* window, int entered);
 
 
 
-int main() {
+int main(int argc, char* argv[]) {
+
+	// Command line options for running standalone benchmarks (no window or OpenGL context needed)
+	if (argc > 1 && string(argv[1]) == "--bench-spatial-hash") {
+
+		runSpatialHashBenchmark();
+		return 0;
+	}
+
+	if (argc > 1 && string(argv[1]) == "--bench-clock") {
+
+		runClockBenchmark();
+		return 0;
+	}
+
+	if (argc > 1 && string(argv[1]) == "--bench-jobs") {
+
+		runJobBenchmark(argc > 2 && string(argv[2]) == "--pin-jobs");
+		return 0;
+	}
+
+	// --bench-cpu[=<filter>] runs the CPU microbenchmarks whose names contain filter, with --bench-min-time=<seconds> per repetition, --bench-repetitions=<n> and JSON results written to --bench-out=<file>.  --bench-simd[=<filter>] checks the SIMD batch maths against the scalar versions and benchmarks them at each supported level, with the same options
+	if (argc > 1 && (string(argv[1]).compare(0, 11, "--bench-cpu") == 0 || string(argv[1]).compare(0, 12, "--bench-simd") == 0)) {
+
+		GUBenchmarkSettings settings;
+		string arg = argv[1];
+		bool simd = (arg.compare(0, 12, "--bench-simd") == 0);
+
+		if (arg.find('=') != string::npos)
+			settings.filter = arg.substr(arg.find('=') + 1);
+
+		for (int i = 2; i < argc; ++i) {
+
+			arg = argv[i];
+
+			if (arg.compare(0, 17, "--bench-min-time=") == 0)
+				settings.minTime = std::max<double>(atof(arg.substr(17).c_str()), 0.001);
+			else if (arg.compare(0, 20, "--bench-repetitions=") == 0)
+				settings.repetitions = std::max<int>(atoi(arg.substr(20).c_str()), 1);
+			else if (arg.compare(0, 12, "--bench-out=") == 0)
+				settings.outputFile = arg.substr(12);
+		}
+
+		int failures = simd ? runBatchMathBenchmarks(settings) : runCPUBenchmarks(settings);
+
+		return (failures == 0) ? 0 : 1;
+	}
+
+	// --timing-report=<file> writes the frame time report at exit (.json for JSON, anything else for CSV)
+	string timingReportFile;
+
+	// --fatal-perf-warnings ends the run (with exit code 1) on the first OpenGL performance warning
+	bool fatalPerfWarnings = false;
+
+	// --benchmark[=<path file>] replays the scripted (or given recorded) path for --benchmark-frames=<n> frames with vsync off and writes the results to --benchmark-output=<file> (JSON, default benchmark.json).  --record-path=<file> records the camera and character path of an interactive run for later replay.  --sim-rate=<hz> sets the simulation step rate (default 120)
+	string benchmarkPathFile;
+	string benchmarkOutputFile = "benchmark.json";
+	string recordPathFile;
+
+	// --headless[=egl|osmesa] renders into an offscreen framebuffer with no window or display (see HeadlessPlatform.h) - there is no input, so headless runs must be benchmarks.  --size=<w>x<h> sets the window or framebuffer size and --screenshot=<file> saves the final benchmark frame (eg. for golden image tests)
+	bool headless = false;
+	GUHeadlessBackend headlessBackend = GUHeadlessBackend::EGL;
+
+	// --scene=<file> loads a scene description.  --city=<x>x<z> generates an x by z block city instead, with --characters=<k> characters, --lights=<l> point lights and random layout from --seed=<s> (--no-randomise keeps every block as the original).  --generate-scene=<file> writes the scene and exits
+	string sceneFile;
+	string generateSceneFile;
+	CitySettings citySettings;
+	bool generateCity = false;
+
+#if GU_PROFILER
+	// --profile=<file> records profile zones and writes them at exit as a Chrome trace (open in chrome://tracing or ui.perfetto.dev)
+	string profileTraceFile;
+#endif
+
+	// --jobs=<n> sets the number of job system worker threads (by default one per hardware thread not taken by the main, simulation and render threads - 0 runs each job on the thread that waits for it) and --pin-jobs binds each worker to its own processor
+	int jobWorkers = GUJobSystem::defaultWorkerCount();
+	bool pinJobWorkers = false;
+
+	// --simd=<scalar|sse4.1|avx2|avx512> caps the instruction set used by the batch maths (by default the highest the CPU supports) to compare levels in a frame benchmark
+	string simdLevelName;
+
+	for (int i = 1; i < argc; ++i) {
+
+		string arg = argv[i];
+
+		if (arg.compare(0, 16, "--timing-report=") == 0)
+			timingReportFile = arg.substr(16);
+		else if (arg == "--fatal-perf-warnings")
+			fatalPerfWarnings = true;
+		else if (arg == "--benchmark")
+			benchmarkMode = true;
+		else if (arg.compare(0, 12, "--benchmark=") == 0) {
+
+			benchmarkMode = true;
+			benchmarkPathFile = arg.substr(12);
+		}
+		else if (arg.compare(0, 19, "--benchmark-frames=") == 0)
+			benchmarkFrames = std::max<int>(atoi(arg.substr(19).c_str()), 1);
+		else if (arg.compare(0, 19, "--benchmark-output=") == 0)
+			benchmarkOutputFile = arg.substr(19);
+		else if (arg.compare(0, 14, "--record-path=") == 0)
+			recordPathFile = arg.substr(14);
+		else if (arg.compare(0, 11, "--sim-rate=") == 0)
+			simulationRate = std::max<double>(atof(arg.substr(11).c_str()), 1.0);
+		else if (arg == "--headless" || arg == "--headless=egl")
+			headless = true;
+		else if (arg == "--headless=osmesa") {
+
+			headless = true;
+			headlessBackend = GUHeadlessBackend::OSMesa;
+		}
+		else if (arg.compare(0, 7, "--size=") == 0) {
+
+			unsigned int w = 0, h = 0;
+
+			if (sscanf(arg.c_str() + 7, "%ux%u", &w, &h) == 2 && w > 0 && h > 0) {
+
+				windowWidth = w;
+				windowHeight = h;
+			}
+		}
+		else if (arg.compare(0, 13, "--screenshot=") == 0)
+			screenshotFile = arg.substr(13);
+		else if (arg.compare(0, 8, "--scene=") == 0)
+			sceneFile = arg.substr(8);
+		else if (arg.compare(0, 17, "--generate-scene=") == 0) {
+
+			generateCity = true;
+			generateSceneFile = arg.substr(17);
+		}
+		else if (arg.compare(0, 7, "--city=") == 0) {
+
+			generateCity = true;
+
+			if (sscanf(arg.c_str() + 7, "%dx%d", &citySettings.blocksX, &citySettings.blocksZ) != 2)
+				citySettings.blocksX = citySettings.blocksZ = std::max<int>(atoi(arg.c_str() + 7), 1);
+		}
+		else if (arg.compare(0, 13, "--characters=") == 0) {
+
+			generateCity = true;
+			citySettings.characters = std::max<int>(atoi(arg.substr(13).c_str()), 1);
+		}
+		else if (arg.compare(0, 9, "--lights=") == 0) {
+
+			generateCity = true;
+			citySettings.pointLights = std::max<int>(atoi(arg.substr(9).c_str()), 0);
+		}
+		else if (arg.compare(0, 7, "--seed=") == 0)
+			citySettings.seed = (uint32_t)strtoul(arg.substr(7).c_str(), nullptr, 10);
+		else if (arg == "--no-randomise")
+			citySettings.randomise = false;
+#if GU_PROFILER
+		else if (arg.compare(0, 10, "--profile=") == 0)
+			profileTraceFile = arg.substr(10);
+#endif
+		else if (arg.compare(0, 7, "--jobs=") == 0)
+			jobWorkers = std::max<int>(atoi(arg.substr(7).c_str()), 0);
+		else if (arg == "--pin-jobs")
+			pinJobWorkers = true;
+		else if (arg == "--track-allocations")
+			trackAllocations = true;
+		else if (arg.compare(0, 7, "--simd=") == 0)
+			simdLevelName = arg.substr(7);
+	}
+
+	// An unknown level would silently leave the batch maths at the highest supported level and measure the wrong one
+	if (!simdLevelName.empty()) {
+
+		int level = -1;
+		string levelNames;
+
+		for (int l = (int)GUSimdLevel::Scalar; l <= (int)GUSimdLevel::AVX512; ++l) {
+
+			if (simdLevelName == GUBatchMath::levelName((GUSimdLevel)l))
+				level = l;
+
+			levelNames += string((l > 0) ? ", " : "") + GUBatchMath::levelName((GUSimdLevel)l);
+		}
+
+		if (level < 0) {
+
+			cout << "Unknown --simd level \"" << simdLevelName << "\" - use one of " << levelNames << "\n";
+			return -1;
+		}
+
+		GUBatchMath::setLevel((GUSimdLevel)level);
+	}
+
+	string sceneName = "default";
+
+	if (!sceneFile.empty()) {
+
+		if (!scene.load(sceneFile))
+			return -1;
+
+		sceneName = sceneFile;
+	}
+	else if (generateCity) {
+
+		scene = SceneDescription::generateCity(citySettings);
+		sceneName = "city " + to_string(citySettings.blocksX) + "x" + to_string(citySettings.blocksZ) + " seed " + to_string(citySettings.seed);
+	}
+	else {
+
+		scene = SceneDescription::defaultScene();
+	}
+
+	if (!generateSceneFile.empty()) {
+
+		if (!scene.save(generateSceneFile))
+			return -1;
+
+		cout << "Wrote " << scene.instances.size() << " instances, " << scene.characters.size() << " characters and " << scene.lights.size() << " point lights to " << generateSceneFile << endl;
+		return 0;
+	}
+
+	// The first character is the player
+	if (!scene.characters.empty()) {
+
+		beastPos = scene.characters[0].position;
+		beastRotation = scene.characters[0].rotation;
+	}
+
+	if (headless && !benchmarkMode) {
+
+		cout << "--headless runs have no input to end them - use with --benchmark\n";
+		return -1;
+	}
+
+	if (benchmarkMode) {
+
+		if (benchmarkPathFile.empty())
+			benchmarkPath = BenchmarkPath::scriptedPath();
+		else if (!benchmarkPath.load(benchmarkPathFile))
+			return -1;
+	}
+	else if (!recordPathFile.empty()) {
+
+		recordedPath = new BenchmarkPath();
+	}
+
+	// Benchmarks start from the first key of the path
+	if (benchmarkMode) {
+
+		BenchmarkKey key = benchmarkPath.sample(0.0f);
+
+		beastPos = key.beastPos;
+		beastRotation = key.beastRotation;
+	}
+
+	setupSceneEntities();
+
+	simTimestep = new GUFixedTimestep(1.0 / simulationRate, simMaxStepsPerFrame);
+	simCurrent = SimulationState{ beastPos, beastRotation, directLightTheta };
+	simPrevious = simCurrent;
+
+#if GU_PROFILER
+
+	// Benchmarks always record zones - per zone CPU times are part of the results
+	if (!profileTraceFile.empty() || benchmarkMode) {
+
+		GUProfiler::setThreadName("main");
+		GUProfiler::setEnabled(true);
+	}
+
+#endif
+
+	GUJobSystem::start(jobWorkers, pinJobWorkers);
+
+	// Transient per-frame data is allocated from an arena per thread, reset after each frame is submitted.  Arenas grow to the largest frame seen, so the initial size only saves the first few frames from growing them
+	GUFrameAllocator::start(frameArenaBytes);
+
+#if !GU_ALLOCATION_TRACKER
+	if (trackAllocations)
+		cout << "--track-allocations ignored - built without GU_ALLOCATION_TRACKER\n";
+
+	trackAllocations = false;
+#endif
 
 	//
 	// 1. Initialisation
@@ -176,41 +678,56 @@ int main() {
 
 #pragma region OpenGL and window setup
 
-	// Initialise glfw and setup window
-	glfwInit();
+	// Create the window (or offscreen framebuffer) and OpenGL context, and initialise glew
+	if (headless) {
+
+		platform = GUHeadlessPlatform::create(headlessBackend, windowWidth, windowHeight, true);
+
+		if (platform == nullptr) {
 
-	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
-	glfwWindowHint(GLFW_OPENGL_COMPAT_PROFILE, GLFW_TRUE);
+			cout << "Failed to create headless " << GUHeadlessPlatform::backendName(headlessBackend) << " context!\n";
+			return -1;
+		}
+	}
+	else {
 
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 1);
+		GUGLFWPlatform* glfwPlatform = GUGLFWPlatform::create(windowWidth, windowHeight, "CIS5013", true);
 
-	GLFWwindow* window = glfwCreateWindow(windowWidth, windowHeight, "CIS5013", NULL, NULL);
+		if (glfwPlatform == nullptr)
+			return -1;
 
-	// Check window was created successfully
-	if (window == NULL)
-	{
-		std::cout << "Failed to create GLFW window!\n";
-		glfwTerminate();
-		return -1;
+		// Set callback functions to handle different events
+		GLFWwindow* window = glfwPlatform->getWindow();
+
+		glfwSetFramebufferSizeCallback(window, resizeWindow); // resize window callback
+		glfwSetKeyCallback(window, keyboardHandler); // Keyboard input callback
+		glfwSetCursorPosCallback(window, mouseMoveHandler);
+		glfwSetMouseButtonCallback(window, mouseButtonHandler);
+		glfwSetScrollCallback(window, mouseScrollHandler);
+		glfwSetCursorEnterCallback(window, mouseEnterHandler);
+
+		platform = glfwPlatform;
 	}
-	glfwMakeContextCurrent(window);
-	
 
-	// Set callback functions to handle different events
-	glfwSetFramebufferSizeCallback(window, resizeWindow); // resize window callback
-	glfwSetKeyCallback(window, keyboardHandler); // Keyboard input callback
-	glfwSetCursorPosCallback(window, mouseMoveHandler);
-	glfwSetMouseButtonCallback(window, mouseButtonHandler);
-	glfwSetScrollCallback(window, mouseScrollHandler);
-	glfwSetCursorEnterCallback(window, mouseEnterHandler);
+	// Benchmarks run as fast as possible
+	if (benchmarkMode)
+		platform->setSwapInterval(0);
+
+	// Capture driver debug messages (errors and performance warnings) from here on
+	GUDebugOutput::install();
+	GUDebugOutput::setPerformanceWarningsFatal(fatalPerfWarnings);
 
-	// Initialise glew
-	glewInit();
+	// Recorded with benchmark results so runs on different machines and drivers are not compared by mistake
+	string glRenderer = (const char*)glGetString(GL_RENDERER);
+	string glVersion = (const char*)glGetString(GL_VERSION);
 
 	
 	// Setup window's initial size
-	resizeWindow(window, windowWidth, windowHeight);
+	int framebufferWidth, framebufferHeight;
+
+	platform->framebufferSize(framebufferWidth, framebufferHeight);
+	resizeWindow(nullptr, framebufferWidth, framebufferHeight);
+	glViewport(0, 0, framebufferWidth, framebufferHeight);
 
 #pragma endregion
 
@@ -234,47 +751,84 @@ int main() {
 	//
 	mainCamera = new ArcballCamera(-45.0f, 45.0f, 50.0f, 40.0f, (float)windowWidth/(float)windowHeight, 0.1f, 10000.0f);
 	
-	groundMesh = new AIMesh(string("Assets\\MyAssets\\Terrain\\flatTerrain.obj"));
-	if (groundMesh) {
-		groundMesh->addTexture("Assets\\MyAssets\\Terrain\\flat terrain.png", FIF_PNG);
-	}
+	{
+		GU_PROFILE_ZONE("load meshes");
+
+		// Model files are imported (parsed and post-processed by assimp) in parallel as jobs.  The meshes are built from them here since building uploads to OpenGL
+		const char* const meshFiles[] = {
+			"Assets/MyAssets/Terrain/flatTerrain.obj",
+			"Assets/MyAssets/Character/Character.obj",
+			"Assets/MyAssets/City/Corner.obj",
+			"Assets/MyAssets/City/Wall.obj",
+			"Assets/MyAssets/City/Mausoleum.obj"
+		};
+
+		const int numMeshFiles = sizeof(meshFiles) / sizeof(meshFiles[0]);
+		const struct aiScene* importedScenes[numMeshFiles];
+		GUJobCounter importCounter;
+
+		for (int i = 0; i < numMeshFiles; ++i)
+			GUJobSystem::run([&importedScenes, &meshFiles, i]() { importedScenes[i] = AIMesh::importFile(meshFiles[i]); }, &importCounter);
+
+		GUJobSystem::wait(importCounter);
+
+		groundMesh = new AIMesh(meshFiles[0], importedScenes[0]);
+		if (groundMesh) {
+			groundMesh->addTexture("Assets/MyAssets/Terrain/flat terrain.png", FIF_PNG);
+		}
 	
-	characterMesh = new AIMesh(string("Assets\\MyAssets\\Character\\Character.obj"));
-	if (characterMesh) {
-		characterMesh->addTexture(string("Assets\\MyAssets\\Character\\LavaPerson Texture.tif"), FIF_TIFF);
-		characterMesh->addNormalMap(string("Assets\\MyAssets\\Character\\LavaPerson Normal.tif"), FIF_TIFF);
-	}
+		characterMesh = new AIMesh(meshFiles[1], importedScenes[1]);
+		if (characterMesh) {
+			characterMesh->addTexture(string("Assets/MyAssets/Character/LavaPerson Texture.tif"), FIF_TIFF);
+			characterMesh->addNormalMap(string("Assets/MyAssets/Character/LavaPerson Normal.tif"), FIF_TIFF);
+		}
 
-	cornerMesh = new AIMesh(string("Assets\\MyAssets\\City\\Corner.obj"));
-	if (cornerMesh) {
-		cornerMesh->addTexture(string("Assets\\MyAssets\\City\\Pillar Texture.tif"), FIF_TIFF);
-		cornerMesh->addNormalMap(string("Assets\\MyAssets\\City\\Pillar Texture.tif"), FIF_TIFF);
-	}
+		cornerMesh = new AIMesh(meshFiles[2], importedScenes[2]);
+		if (cornerMesh) {
+			cornerMesh->addTexture(string("Assets/MyAssets/City/Pillar Texture.tif"), FIF_TIFF);
+			cornerMesh->addNormalMap(string("Assets/MyAssets/City/Pillar Texture.tif"), FIF_TIFF);
+		}
 
-	wallMesh = new AIMesh(string("Assets\\MyAssets\\City\\Wall.obj"));
-	if (wallMesh) {
-		wallMesh->addTexture(string("Assets\\MyAssets\\City\\Wall Texture.tif"), FIF_TIFF);
-		wallMesh->addNormalMap(string("Assets\\MyAssets\\City\\Wall Normal.tif"), FIF_TIFF);
-	}
+		wallMesh = new AIMesh(meshFiles[3], importedScenes[3]);
+		if (wallMesh) {
+			wallMesh->addTexture(string("Assets/MyAssets/City/Wall Texture.tif"), FIF_TIFF);
+			wallMesh->addNormalMap(string("Assets/MyAssets/City/Wall Normal.tif"), FIF_TIFF);
+		}
 
-	mausoleumMesh = new AIMesh(string("Assets\\MyAssets\\City\\Mausoleum.obj"));
-	if (mausoleumMesh) {
-		mausoleumMesh->addTexture(string("Assets\\MyAssets\\City\\mausoleum.png"), FIF_PNG);
-		mausoleumMesh->addNormalMap(string("Assets\\MyAssets\\City\\mausoleumNormal.png"), FIF_PNG);
-	}
+		mausoleumMesh = new AIMesh(meshFiles[4], importedScenes[4]);
+		if (mausoleumMesh) {
+			mausoleumMesh->addTexture(string("Assets/MyAssets/City/mausoleum.png"), FIF_PNG);
+			mausoleumMesh->addNormalMap(string("Assets/MyAssets/City/mausoleumNormal.png"), FIF_PNG);
+		}
 
-	transparentMesh = new Transparency(string("Assets\\MyAssets\\Hut\\Hut.obj"));
-	if (transparentMesh) {
-		transparentMesh->addTexture(string("Assets\\MyAssets\\Hut\\hut.png"), FIF_PNG);
+		for (const struct aiScene* importedScene : importedScenes) {
+
+			if (importedScene)
+				aiReleaseImport(importedScene);
+		}
+
+		transparentMesh = new Transparency(string("Assets/MyAssets/Hut/Hut.obj"));
+		if (transparentMesh) {
+			transparentMesh->addTexture(string("Assets/MyAssets/Hut/hut.png"), FIF_PNG);
 		
+		}
 	}
 
-	// Load shaders
-	basicShader = setupShaders(string("Assets\\Shaders\\basic_shader.vert"), string("Assets\\Shaders\\basic_shader.frag"));
-	transparencyShader = setupShaders(string("Assets\\Shaders\\TransparencyShader.vert"), string("Assets\\Shaders\\TransparencyShader.frag"));
-	texPointLightShader = setupShaders(string("Assets\\Shaders\\texture-point.vert"), string("Assets\\Shaders\\texture-point.frag"));
-	texDirLightShader = setupShaders(string("Assets\\Shaders\\texture-directional.vert"), string("Assets\\Shaders\\texture-directional.frag"));
-	nMapDirLightShader = setupShaders(string("Assets\\Shaders\\nmap-directional.vert"), string("Assets\\Shaders\\nmap-directional.frag"));
+	setupStaticInstances();
+	setupCollisionWorld();
+
+	{
+		GU_PROFILE_ZONE("load shaders");
+
+		// Load shaders
+		basicShader = setupShaders(string("Assets/Shaders/basic_shader.vert"), string("Assets/Shaders/basic_shader.frag"));
+		transparencyShader = setupShaders(string("Assets/Shaders/TransparencyShader.vert"), string("Assets/Shaders/TransparencyShader.frag"));
+		texPointLightShader = setupShaders(string("Assets/Shaders/texture-point.vert"), string("Assets/Shaders/texture-point.frag"));
+		texDirLightShader = setupShaders(string("Assets/Shaders/texture-directional.vert"), string("Assets/Shaders/texture-directional.frag"));
+		nMapDirLightShader = setupShaders(string("Assets/Shaders/nmap-directional.vert"), string("Assets/Shaders/nmap-directional.frag"));
+		impostorBakeShader = setupShaders(string("Assets/Shaders/impostor-bake.vert"), string("Assets/Shaders/impostor-bake.frag"));
+		impostorShader = setupShaders(string("Assets/Shaders/impostor.vert"), string("Assets/Shaders/impostor.frag"));
+	}
 
 	// Get uniform variable locations for setting values later during rendering
 	basicShader_mvpMatrix = glGetUniformLocation(basicShader, "mvpMatrix");
@@ -303,275 +857,397 @@ int main() {
 	nMapDirLightShader_normalMapTexture = glGetUniformLocation(nMapDirLightShader, "normalMapTexture");
 	nMapDirLightShader_lightDirection = glGetUniformLocation(nMapDirLightShader, "lightDirection");
 	nMapDirLightShader_lightColour = glGetUniformLocation(nMapDirLightShader, "lightColour");
+
+	impostorShader_viewMatrix = glGetUniformLocation(impostorShader, "viewMatrix");
+	impostorShader_projMatrix = glGetUniformLocation(impostorShader, "projMatrix");
+	impostorShader_cameraPos = glGetUniformLocation(impostorShader, "cameraPos");
+	impostorShader_framesPerSide = glGetUniformLocation(impostorShader, "framesPerSide");
+	impostorShader_albedoAtlas = glGetUniformLocation(impostorShader, "albedoAtlas");
+	impostorShader_normalAtlas = glGetUniformLocation(impostorShader, "normalAtlas");
+	impostorShader_lightDirection = glGetUniformLocation(impostorShader, "lightDirection");
+	impostorShader_lightColour = glGetUniformLocation(impostorShader, "lightColour");
+	impostorShader_numPointLights = glGetUniformLocation(impostorShader, "numPointLights");
+	impostorShader_pointLightPosition = glGetUniformLocation(impostorShader, "pointLightPosition");
+	impostorShader_pointLightColour = glGetUniformLocation(impostorShader, "pointLightColour");
+	impostorShader_pointLightAttenuation = glGetUniformLocation(impostorShader, "pointLightAttenuation");
+
+	// Impostor atlases are baked with the scene meshes once the shaders are available
+	setupTextureQuadVBO();
+	setupImpostors();
+
+	// Per pass render statistics - everything counted so far is reported as the load phase
+	statsPassDirectional = GURenderStats::addPass("directional light pass");
+	statsPassPointLights = GURenderStats::addPass("point light pass");
+	statsPassImpostors = GURenderStats::addPass("impostor pass");
+	statsPassTransparency = GURenderStats::addPass("transparency pass");
+
+	// Per pass GPU timers
+	gpuTimer = new GPUPassTimer();
+
+	// Passes are added either way - their CPU times are shown on the HUD
+	gpuPassDirectional = gpuTimer->addPass("directional light pass");
+	gpuPassPointLights = gpuTimer->addPass("point light pass");
+	gpuPassImpostors = gpuTimer->addPass("impostor pass");
+	gpuPassTransparency = gpuTimer->addPass("transparency pass");
+
+	if (gpuTimer->isSupported()) {
+
+		for (int p = 0; p < gpuTimer->passCount(); ++p)
+			gameClock->addTimingSeries("gpu " + gpuTimer->passName(p), &gpuTimer->passHistogram(p));
+	}
+	else {
+
+		cout << "GL_TIMESTAMP queries not supported - GPU pass timing disabled\n";
+	}
+
+	// Replaces per-frame window title statistics - one draw call over the finished frame, rebuilt a few times a second
+	perfHUD = new GUPerfHUD();
+	perfHUDVisible = !benchmarkMode && !headless;
 	
 	//
-	// 2. Main loop
+	// 2. Main loop - simulation and rendering run on threads of their own while this thread handles window events (GLFW requires event processing on the main thread)
 	// 
 
-	while (!glfwWindowShouldClose(window)) {
+	renderCamera = new ArcballCamera(*mainCamera);
 
-		updateScene();
-		renderScene();						// Render into the current buffer
-		glfwSwapBuffers(window);			// Displays what was just rendered (using double buffering).
+	publishInput();
 
-		glfwPollEvents();					// Use this version when animating as fast as possible
-	
-		// update window title
-		char timingString[256];
-		sprintf_s(timingString, 256, "CIS5013: Average fps: %.0f; Average spf: %f", gameClock->averageFPS(), gameClock->averageSPF() / 1000.0f);
-		glfwSetWindowTitle(window, timingString);
-	}
+	// Initial state for the render thread's first frame
+	inputBuffer.update();
+	fillSnapshot(snapshotBuffer.writeBuffer(), inputBuffer.readBuffer());
+	snapshotBuffer.publish();
 
-	glfwTerminate();
+	// The render thread takes the context over
+	platform->makeContextCurrent(false);
 
-	if (gameClock) {
+#ifdef _WIN32
+	// The simulation thread sleeps between steps - without this Windows rounds sleeps up to its 15.6ms scheduler tick, longer than a step
+	timeBeginPeriod(1);
+#endif
 
-		gameClock->stop();
-		gameClock->reportTimingData();
-	}
+	// Only the frame loop is of interest - loading has allocated everything it needs by now
+	if (trackAllocations)
+		GUAllocationTracker::setEnabled(true);
 
-	return 0;
-}
+	simulationRunning = true;
+	simulationThread = thread(simulationThreadMain);
+	renderThread = thread(renderThreadMain);
 
+	while (!platform->shouldClose()) {
 
-// renderScene - function to render the current scene
-void renderScene()
-{
-	renderWithMyLights();
-}
+		// Events (including the render thread's close request) wake this at once
+		platform->waitEvents(0.25);
+		publishInput();
+	}
 
+	renderThread.join();
 
-void renderWithMyLights() {
+	simulationRunning = false;
+	simulationThread.join();
 
-	// Clear the rendering window
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
 
-	// Get camera matrices
-	mat4 cameraProjection = mainCamera->projectionTransform();
-	mat4 cameraView = mainCamera->viewTransform() * translate(identity<mat4>(), -beastPos);
+	if (trackAllocations)
+		GUAllocationTracker::setEnabled(false);
 
+	GUJobSystem::stop();
 
-#pragma region Render all opaque objects with directional light
+	// Per-frame containers still refer to the arenas - move them back to the heap so their destructors do not touch deleted arenas
+	guResetVector(staticInFrustum, std::pmr::get_default_resource());
+	guResetVector(hlodProxyVisible, std::pmr::get_default_resource());
+	guResetVector(impostorBatch, std::pmr::get_default_resource());
 
-	glUseProgram(texDirLightShader);
+	for (GUCommandBuffer& buffer : staticCommandBuffers)
+		buffer.reset(std::pmr::get_default_resource());
 
-	glUniformMatrix4fv(texDirLightShader_viewMatrix, 1, GL_FALSE, (GLfloat*)&cameraView);
-	glUniformMatrix4fv(texDirLightShader_projMatrix, 1, GL_FALSE, (GLfloat*)&cameraProjection);
-	glUniform1i(texDirLightShader_texture, 0); // set to point to texture unit 0 for AIMeshes
-	glUniform3fv(texDirLightShader_lightDirection, 1, (GLfloat*)&(directLight.direction));
-	glUniform3fv(texDirLightShader_lightColour, 1, (GLfloat*)&(directLight.colour));
+	staticDrawQueue.reset(std::pmr::get_default_resource());
 
-	if (groundMesh) {
+	GUFrameAllocator::stop();
 
-		mat4 modelTransform = glm::translate(identity<mat4>(), vec3(0.0f, -4.0f, 0.0f)) * glm::scale(identity<mat4>(), vec3(10.0f, 0.1f, 10.0f));
+	// GL objects are deleted on this thread from here on - the platform (and with it the context) is destroyed once the last of them, the GPU pass timer, has been released
+	platform->makeContextCurrent(true);
 
-		glUniformMatrix4fv(texDirLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+	if (perfHUD) {
 
-		groundMesh->setupTextures();
-		groundMesh->render();
+		delete perfHUD;
+		perfHUD = nullptr;
 	}
 
-	if (characterMesh) {
+	for (HLODCluster* cluster : hlodClusters)
+		delete cluster;
 
-		mat4 modelTransform = glm::translate(identity<mat4>(), beastPos) * eulerAngleY<float>(glm::radians<float>(beastRotation)) * glm::scale(identity<mat4>(), vec3(0.05f, 0.05f, 0.05f));
+	hlodClusters.clear();
 
-		glUniformMatrix4fv(texDirLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+	for (OctahedralImpostor* impostor : impostors)
+		delete impostor;
 
-		characterMesh->setupTextures();
-		characterMesh->render();
-	}
+	impostors.clear();
 
-	if (cornerMesh) {
+	if (collisionWorld) {
 
-		mat4 modelTransform = glm::translate(identity<mat4>(), vec3(6.0f, 0.0f, 10.0f)) * eulerAngleY<float>(glm::radians<float>(-90)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+		delete collisionWorld;
+		collisionWorld = nullptr;
+	}
 
-		glUniformMatrix4fv(texDirLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+	// CPU time per profiler zone for the benchmark results - registered with gameClock so must outlive the report
+	map<string, GUTimeHistogram> cpuZoneTimes;
 
-		cornerMesh->setupTextures();
-		cornerMesh->render();
+	if (gameClock) {
 
-		modelTransform = glm::translate(identity<mat4>(), vec3(6.0f, 0.0f, -2.0f)) * eulerAngleY<float>(glm::radians<float>(-90)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+		gameClock->stop();
+		gameClock->reportTimingData();
 
-		glUniformMatrix4fv(texDirLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+		GURenderStats::reportStats();
+		GURenderStats::addToClockReport(gameClock);
 
-		cornerMesh->setupTextures();
-		cornerMesh->render();
+		if (GUDebugOutput::isInstalled()) {
 
-		modelTransform = glm::translate(identity<mat4>(), vec3(-6.0f, 0.0f, 10.0f)) * eulerAngleY<float>(glm::radians<float>(-90)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+			gameClock->setReportCounter("gl_debug_messages", (double)GUDebugOutput::messageCount());
+			gameClock->setReportCounter("gl_performance_warnings", (double)GUDebugOutput::performanceWarningCount());
+		}
 
-		glUniformMatrix4fv(texDirLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+		if (!timingReportFile.empty())
+			gameClock->exportTimingReport(timingReportFile);
+
+		if (benchmarkMode) {
+
+#if GU_PROFILER
+			GUProfiler::zoneTimes(cpuZoneTimes, benchmarkStartTime);
+
+			for (const pair<const string, GUTimeHistogram>& zone : cpuZoneTimes)
+				gameClock->addTimingSeries("cpu " + zone.first, &zone.second);
+#endif
+
+			gameClock->setReportInfo("mode", "benchmark");
+			gameClock->setReportInfo("path", (benchmarkPathFile.empty()) ? "scripted" : benchmarkPathFile);
+			gameClock->setReportInfo("scene", sceneName);
+			gameClock->setReportInfo("gl_renderer", glRenderer);
+			gameClock->setReportInfo("gl_version", glVersion);
+			gameClock->setReportCounter("benchmark_frames", (double)benchmarkFrames);
+			gameClock->setReportCounter("benchmark_warmup_frames", (double)benchmarkWarmupFrames);
+			gameClock->setReportCounter("benchmark_timestep_ms", benchmarkTimestep * 1000.0);
+			gameClock->setReportCounter("scene_instances", (double)(scene.instances.size() + scene.characters.size()));
+			gameClock->setReportCounter("scene_point_lights", (double)scene.lights.size());
+			gameClock->setReportCounter("job_workers", (double)GUJobSystem::workerCount());
+			gameClock->setReportCounter("simd_level", (double)GUBatchMath::level()); // GUSimdLevel - 0 scalar, 1 SSE4.1, 2 AVX2, 3 AVX-512
+			gameClock->setReportCounter("frame_arena_peak_bytes", (double)GUFrameAllocator::highWaterMark());
+			gameClock->setReportCounter("frame_arena_blocks_added", (double)GUFrameAllocator::blocksAddedCount());
+
+			if (trackAllocations) {
+
+				gameClock->setReportCounter("heap_allocating_frames", (double)GUAllocationTracker::allocatingFrameCount());
+				gameClock->setReportCounter("heap_allocations_per_frame", (double)GUAllocationTracker::total().allocations / (double)std::max<uint64_t>(GUAllocationTracker::frameCount(), 1));
+				gameClock->setReportCounter("heap_peak_frame_allocations", (double)GUAllocationTracker::peakFrame().allocations);
+			}
+			gameClock->setReportCounter("simulation_hz", simulationRate);
+			gameClock->setReportCounter("simulation_steps", (double)simTimestep->totalSteps());
+			gameClock->setReportCounter("simulation_dropped_steps", (double)simTimestep->droppedSteps());
 
-		cornerMesh->setupTextures();
-		cornerMesh->render();
+			if (gameClock->exportTimingReport(benchmarkOutputFile))
+				cout << "Wrote benchmark results to " << benchmarkOutputFile << endl;
+		}
+	}
 
-		modelTransform = glm::translate(identity<mat4>(), vec3(-6.0f, 0.0f, -2.0f)) * eulerAngleY<float>(glm::radians<float>(-90)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+	if (recordedPath) {
 
-		glUniformMatrix4fv(texDirLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+		if (recordedPath->save(recordPathFile))
+			cout << "Recorded " << recordedPath->keyCount() << " path keys (" << recordedPath->duration() << " s) to " << recordPathFile << endl;
 
-		cornerMesh->setupTextures();
-		cornerMesh->render();
+		delete recordedPath;
+		recordedPath = nullptr;
 	}
 
-	if (wallMesh) {
+	if (simTimestep) {
 
-		mat4 modelTransform = glm::translate(identity<mat4>(), vec3(0.0f, 0.0f, 10.0f)) * eulerAngleY<float>(glm::radians<float>(-90)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+		if (simTimestep->droppedSteps() > 0)
+			cout << "Simulation fell behind on " << simTimestep->cappedFrames() << " frames - " << simTimestep->droppedSteps() << " steps were dropped\n";
 
-		glUniformMatrix4fv(texDirLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+		delete simTimestep;
+		simTimestep = nullptr;
+	}
 
-		wallMesh->setupTextures();
-		wallMesh->render();
+	// GPU pass histograms are referenced by the timing report so are only released once it has been written
+	if (gpuTimer) {
 
-		modelTransform = glm::translate(identity<mat4>(), vec3(0.0f, 0.0f, -2.0f)) * eulerAngleY<float>(glm::radians<float>(-90)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+		if (gpuTimer->framesSkippedCount() > 0)
+			cout << "GPU pass timer skipped " << gpuTimer->framesSkippedCount() << " frames with results not yet available\n";
 
-		glUniformMatrix4fv(texDirLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+		delete gpuTimer;
+		gpuTimer = nullptr;
+	}
 
-		wallMesh->setupTextures();
-		wallMesh->render();
+	// Destroys the window and context
+	delete platform;
+	platform = nullptr;
 
-		modelTransform = glm::translate(identity<mat4>(), vec3(-6.0f, 0.0f, 4.0f)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+#if GU_PROFILER
 
-		glUniformMatrix4fv(texDirLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+	if (!profileTraceFile.empty()) {
 
-		wallMesh->setupTextures();
-		wallMesh->render();
+		GUProfiler::setEnabled(false);
+		GUProfiler::writeChromeTrace(profileTraceFile);
+	}
 
-		modelTransform = glm::translate(identity<mat4>(), vec3(6.0f, 0.0f, 4.0f)) *  glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+#endif
 
-		glUniformMatrix4fv(texDirLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+	GUDebugOutput::reportSummary();
 
-		wallMesh->setupTextures();
-		wallMesh->render();
-	}
+	bool steadyStateAllocated = false;
 
-	if (mausoleumMesh) {
+	if (trackAllocations) {
 
-		mat4 modelTransform = glm::translate(identity<mat4>(), vec3(0.0f, 0.0f, 4.0f)) * eulerAngleY<float>(glm::radians<float>(180.0f)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+		GUAllocationTracker::printReport();
 
-		glUniformMatrix4fv(texDirLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+		// Warm-up frames may allocate (arenas and pools growing to size) but measured frames should not
+		if (benchmarkMode && GUAllocationTracker::allocatingFrameCount() > 0) {
 
-		mausoleumMesh->setupTextures();
-		mausoleumMesh->render();
+			cout << "Benchmark failed - " << GUAllocationTracker::allocatingFrameCount() << " of " << GUAllocationTracker::frameCount() << " measured frames allocated from the heap\n";
+			steadyStateAllocated = true;
+		}
 	}
 
+	return (GUDebugOutput::hasFatalMessage() || steadyStateAllocated) ? 1 : 0;
+}
 
 
-#pragma endregion
+// renderScene - function to render the current scene
+void renderScene()
+{
+	GU_PROFILE_ZONE("render");
 
+	renderWithMyLights();
+}
 
 
-	// Enable additive blending for ***subsequent*** light sources!!!
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_ONE, GL_ONE);
+void renderWithMyLights() {
 
-#pragma region Render all opaque objects with point light
+	gpuTimer->beginFrame();
+	GURenderStats::beginFrame();
 
-	glUseProgram(texPointLightShader);
+	// Clear the rendering window
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	glUniformMatrix4fv(texPointLightShader_viewMatrix, 1, GL_FALSE, (GLfloat*)&cameraView);
-	glUniformMatrix4fv(texPointLightShader_projMatrix, 1, GL_FALSE, (GLfloat*)&cameraProjection);
-	glUniform1i(texPointLightShader_texture, 0); // set to point to texture unit 0 for AIMeshes
-	
-	int i = 0;
-	do {
-		glUniform3fv(texPointLightShader_lightPosition, 1, (GLfloat*)&(lights[i].pos));
-		glUniform3fv(texPointLightShader_lightColour, 1, (GLfloat*)&(lights[i].colour));
-		glUniform3fv(texPointLightShader_lightAttenuation, 1, (GLfloat*)&(lights[i].attenuation));
+	// Get camera matrices
+	mat4 cameraProjection = renderCamera->projectionTransform();
+	mat4 cameraView = renderCamera->viewTransform() * translate(identity<mat4>(), -beastPos);
 
-		if (groundMesh) {
+	{
+		GU_PROFILE_ZONE("culling");
 
-			mat4 modelTransform = glm::translate(identity<mat4>(), vec3(0.0f, -4.0f, 0.0f)) * glm::scale(identity<mat4>(), vec3(10.0f, 0.1f, 10.0f));
+		selectLODs(cameraView);
+		cullMeshlets(cameraView, cameraProjection);
+	}
 
-			glUniformMatrix4fv(texPointLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+	{
+		GU_PROFILE_ZONE("record draws");
 
-			groundMesh->setupTextures();
-			groundMesh->render();
-		}
+		recordStaticInstances(cameraView);
+	}
 
 
-		if (characterMesh) {
+#pragma region Render all opaque objects with directional light
 
-			mat4 modelTransform = glm::translate(identity<mat4>(), beastPos) * eulerAngleY<float>(glm::radians<float>(beastRotation)) * glm::scale(identity<mat4>(), vec3(0.05f, 0.05f, 0.05f));
+	{
+		GU_PROFILE_ZONE("directional light pass");
 
-			glUniformMatrix4fv(texPointLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+		gpuTimer->beginPass(gpuPassDirectional);
+		GURenderStats::setPass(statsPassDirectional);
 
-			characterMesh->setupTextures();
-			characterMesh->render();
-		}
+		glUseProgram(texDirLightShader);
 
-		if (cornerMesh) {
+		glUniformMatrix4fv(texDirLightShader_viewMatrix, 1, GL_FALSE, (GLfloat*)&cameraView);
+		glUniformMatrix4fv(texDirLightShader_projMatrix, 1, GL_FALSE, (GLfloat*)&cameraProjection);
+		glUniform1i(texDirLightShader_texture, 0); // set to point to texture unit 0 for AIMeshes
+		glUniform3fv(texDirLightShader_lightDirection, 1, (GLfloat*)&(directLight.direction));
+		glUniform3fv(texDirLightShader_lightColour, 1, (GLfloat*)&(directLight.colour));
 
-			mat4 modelTransform = glm::translate(identity<mat4>(), vec3(6.0f, 0.0f, 10.0f)) * eulerAngleY<float>(glm::radians<float>(-90)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+		GURenderStats::countProgramBind();
+		GURenderStats::countUniformUpload(5);
 
-			glUniformMatrix4fv(texPointLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+		renderStaticInstances(texDirLightShader_modelMatrix);
 
-			cornerMesh->setupTextures();
-			cornerMesh->render();
+		if (characterMesh) {
 
-			modelTransform = glm::translate(identity<mat4>(), vec3(6.0f, 0.0f, -2.0f)) * eulerAngleY<float>(glm::radians<float>(-90)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+			const mat4& modelTransform = sceneWorld.worldTransform(playerModelEntity);
 
-			glUniformMatrix4fv(texPointLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+			glUniformMatrix4fv(texDirLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+			GURenderStats::countUniformUpload();
 
-			cornerMesh->setupTextures();
-			cornerMesh->render();
+			characterMesh->setupTextures();
 
-			modelTransform = glm::translate(identity<mat4>(), vec3(-6.0f, 0.0f, 10.0f)) * eulerAngleY<float>(glm::radians<float>(-90)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+			if (characterLOD == 0 && characterMesh->meshletCount() > 0)
+				characterMesh->render(characterMeshletDraws);
+			else
+				characterMesh->render(characterLOD);
+		}
 
-			glUniformMatrix4fv(texPointLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+		gpuTimer->endPass(gpuPassDirectional);
+	}
 
-			cornerMesh->setupTextures();
-			cornerMesh->render();
+#pragma endregion
 
-			modelTransform = glm::translate(identity<mat4>(), vec3(-6.0f, 0.0f, -2.0f)) * eulerAngleY<float>(glm::radians<float>(-90)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
 
-			glUniformMatrix4fv(texPointLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
 
-			cornerMesh->setupTextures();
-			cornerMesh->render();
-		}
-
-		if (wallMesh) {
+	// Enable additive blending for ***subsequent*** light sources!!!
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
 
-			mat4 modelTransform = glm::translate(identity<mat4>(), vec3(0.0f, 0.0f, 10.0f)) * eulerAngleY<float>(glm::radians<float>(-90)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+#pragma region Render all opaque objects with point light
 
-			glUniformMatrix4fv(texPointLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+	gpuTimer->beginPass(gpuPassPointLights);
+	GURenderStats::setPass(statsPassPointLights);
 
-			wallMesh->setupTextures();
-			wallMesh->render();
+	glUseProgram(texPointLightShader);
 
-			modelTransform = glm::translate(identity<mat4>(), vec3(0.0f, 0.0f, -2.0f)) * eulerAngleY<float>(glm::radians<float>(-90)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+	glUniformMatrix4fv(texPointLightShader_viewMatrix, 1, GL_FALSE, (GLfloat*)&cameraView);
+	glUniformMatrix4fv(texPointLightShader_projMatrix, 1, GL_FALSE, (GLfloat*)&cameraProjection);
+	glUniform1i(texPointLightShader_texture, 0); // set to point to texture unit 0 for AIMeshes
 
-			glUniformMatrix4fv(texPointLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+	GURenderStats::countProgramBind();
+	GURenderStats::countUniformUpload(3);
+	
+	for (size_t i = 0; i < lights.size(); ++i) {
 
-			wallMesh->setupTextures();
-			wallMesh->render();
+		GU_PROFILE_ZONE("point light pass");
 
-			modelTransform = glm::translate(identity<mat4>(), vec3(-6.0f, 0.0f, 4.0f)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+		glUniform3fv(texPointLightShader_lightPosition, 1, (GLfloat*)&(lights[i].pos));
+		glUniform3fv(texPointLightShader_lightColour, 1, (GLfloat*)&(lights[i].colour));
+		glUniform3fv(texPointLightShader_lightAttenuation, 1, (GLfloat*)&(lights[i].attenuation));
+		GURenderStats::countUniformUpload(3);
 
-			glUniformMatrix4fv(texPointLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+		renderStaticInstances(texPointLightShader_modelMatrix);
 
-			wallMesh->setupTextures();
-			wallMesh->render();
+		if (characterMesh) {
 
-			modelTransform = glm::translate(identity<mat4>(), vec3(6.0f, 0.0f, 4.0f)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+			const mat4& modelTransform = sceneWorld.worldTransform(playerModelEntity);
 
 			glUniformMatrix4fv(texPointLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
+			GURenderStats::countUniformUpload();
 
-			wallMesh->setupTextures();
-			wallMesh->render();
+			characterMesh->setupTextures();
+
+			if (characterLOD == 0 && characterMesh->meshletCount() > 0)
+				characterMesh->render(characterMeshletDraws);
+			else
+				characterMesh->render(characterLOD);
 		}
+	}
 
-		if (mausoleumMesh) {
+	gpuTimer->endPass(gpuPassPointLights);
 
-			mat4 modelTransform = glm::translate(identity<mat4>(), vec3(0.0f, 0.0f, 4.0f)) * eulerAngleY<float>(glm::radians<float>(180.0f)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+#pragma endregion
 
-			glUniformMatrix4fv(texPointLightShader_modelMatrix, 1, GL_FALSE, (GLfloat*)&modelTransform);
 
-			mausoleumMesh->setupTextures();
-			mausoleumMesh->render();
-		}
+#pragma region Render distant impostors
+
+	glDisable(GL_BLEND);
 
-		i++;
-	} while (i != 2);
+	gpuTimer->beginPass(gpuPassImpostors);
+	GURenderStats::setPass(statsPassImpostors);
+	renderImpostors(cameraView, cameraProjection);
+	gpuTimer->endPass(gpuPassImpostors);
 
 #pragma endregion
 	
@@ -583,9 +1259,20 @@ void renderWithMyLights() {
 
 	if (transparentMesh) {
 
-		mat4 modelTransform = cameraProjection * cameraView * glm::translate(identity<mat4>(), vec3(-20.0f, 0.0f, 5.0f)) * eulerAngleY<float>(glm::radians<float>(180.0f)) * glm::scale(identity<mat4>(), vec3(0.1f, 0.1f, 0.1f));
+		GU_PROFILE_ZONE("transparency pass");
+
+		gpuTimer->beginPass(gpuPassTransparency);
+		GURenderStats::setPass(statsPassTransparency);
+
 		transparentMesh->setupTextures();
-		transparentMesh->render(modelTransform);
+
+		for (const mat4& hutTransform : hutTransforms) {
+
+			mat4 modelTransform = cameraProjection * cameraView * hutTransform;
+			transparentMesh->render(modelTransform);
+		}
+
+		gpuTimer->endPass(gpuPassTransparency);
 	}
 
 	glDisable(GL_BLEND);
@@ -599,8 +1286,13 @@ void renderWithMyLights() {
 	//
 
 	// Restore fixed-function
+	GURenderStats::setPass(0);
+
 	glUseProgram(0);
 	glBindVertexArray(0);
+
+	GURenderStats::countProgramBind();
+	GURenderStats::countVAOBind();
 	glDisable(GL_TEXTURE_2D);
 
 	mat4 cameraT = cameraProjection * cameraView;
@@ -614,35 +1306,738 @@ void renderWithMyLights() {
 	glVertex3f(directLight.direction.x * 10.0f, directLight.direction.y * 10.0f, directLight.direction.z * 10.0f);
 	
 
-	glColor3f(lights[0].colour.r, lights[0].colour.g, lights[0].colour.b);
-	glVertex3f(lights[0].pos.x, lights[0].pos.y, lights[0].pos.z);
-	glColor3f(lights[1].colour.r, lights[1].colour.g, lights[1].colour.b);
-	glVertex3f(lights[1].pos.x, lights[1].pos.y, lights[1].pos.z);
+	for (const PointLight& light : lights) {
+
+		glColor3f(light.colour.r, light.colour.g, light.colour.b);
+		glVertex3f(light.pos.x, light.pos.y, light.pos.z);
+	}
 
 	glEnd();
+
+	// Counts shown are for the last complete frame
+	perfHUD->setVisible(perfHUDVisible);
+	perfHUD->render(*gpuTimer, GURenderStats::lastFrameTotal(), viewportWidth, viewportHeight);
 }
 
 
 
 
-// Function called to animate elements in the scene
-void updateScene() {
+// Select a LOD level for one instance from its projected screen-space error
+static int selectInstanceLOD(const AIMesh* mesh, const mat4& modelTransform, const AABB& worldBounds, const vec3& cameraPos, float pixelsPerUnit, int currentLOD) {
 
-	float tDelta = 0.0f;
+	float distance = glm::length(worldBounds.centre() - cameraPos) - glm::length(worldBounds.extents());
+	float modelScale = std::max<float>(glm::length(vec3(modelTransform[0])), std::max<float>(glm::length(vec3(modelTransform[1])), glm::length(vec3(modelTransform[2]))));
 
-	if (gameClock) {
+	return mesh->selectLOD(pixelsPerUnit * modelScale, distance, currentLOD);
+}
+
+
+void selectLODs(const mat4& cameraView) {
+
+	vec3 cameraPos = vec3(glm::inverse(cameraView)[3]);
+	float pixelsPerUnit = (float)viewportHeight / (2.0f * tanf(glm::radians<float>(renderCamera->getFovY()) * 0.5f));
+
+	if (characterMesh) {
+
+		const mat4& modelTransform = sceneWorld.worldTransform(playerModelEntity);
+		characterLOD = selectInstanceLOD(characterMesh, modelTransform, characterMesh->getBoundingBox().transformed(modelTransform), cameraPos, pixelsPerUnit, characterLOD);
+	}
+
+	// Each instance only writes its own LOD and impostor state, so instances are split over the job system
+	GUJobSystem::parallelFor(0, (uint32_t)staticInstances.size(), 256, [&](uint32_t begin, uint32_t end) {
+
+		for (uint32_t i = begin; i < end; ++i) {
+
+			StaticInstance& instance = staticInstances[i];
+
+			instance.lod = selectInstanceLOD(instance.mesh, instance.modelTransform, instance.worldBounds, cameraPos, pixelsPerUnit, instance.lod);
+
+			// Instances beyond the impostor distance are drawn as impostors
+			if (!instance.impostor)
+				continue;
+
+			float distance = glm::length(cameraPos - glm::clamp(cameraPos, instance.worldBounds.min, instance.worldBounds.max));
+
+			if (instance.impostorActive)
+				instance.impostorActive = (distance > impostorSwapDistance * 0.9f);
+			else
+				instance.impostorActive = (distance > impostorSwapDistance);
+		}
+	});
+
+	// An active HLOD proxy covers all of its members, so the members only switch to impostors once all of them are far enough away.  Every instance belongs to at most one cluster so clusters can be processed in parallel too
+	guResetVector(hlodProxyVisible, &GUFrameAllocator::local());
+	hlodProxyVisible.assign(hlodClusters.size(), 0);
+
+	GUJobSystem::parallelFor(0, (uint32_t)hlodClusters.size(), 16, [&](uint32_t begin, uint32_t end) {
+
+		for (uint32_t c = begin; c < end; ++c) {
+
+			if (!hlodClusters[c]->updateProxySelection(cameraPos))
+				continue;
+
+			bool allImpostors = true;
+
+			for (uint32_t m : hlodClusters[c]->getMembers())
+				allImpostors = allImpostors && staticInstances[m].impostorActive;
+
+			if (!allImpostors) {
+
+				hlodProxyVisible[c] = 1;
+
+				for (uint32_t m : hlodClusters[c]->getMembers())
+					staticInstances[m].impostorActive = false;
+			}
+		}
+	});
+}
+
+
+// Frustum cull the static instances, then frustum and backface cull the meshlets of every visible instance that will be drawn at LOD 0 this frame.  Done once per frame and shared by all lighting passes
+void cullMeshlets(const mat4& cameraView, const mat4& cameraProjection) {
+
+	vec3 cameraPos = vec3(glm::inverse(cameraView)[3]);
+	mat4 viewProjection = cameraProjection * cameraView;
+
+	vec4 planes[6];
+
+	GUBatchMath::frustumPlanes(viewProjection, planes);
+
+	guResetVector(staticInFrustum, &GUFrameAllocator::local());
+	staticInFrustum.resize(staticInstances.size());
+	GUBatchMath::testAABBs(planes, staticMinX.data(), staticMinY.data(), staticMinZ.data(), staticMaxX.data(), staticMaxY.data(), staticMaxZ.data(), staticInFrustum.data(), staticInstances.size());
+
+	if (characterMesh && characterLOD == 0) {
+
+		const mat4& modelTransform = sceneWorld.worldTransform(playerModelEntity);
+		characterMesh->cullMeshlets(modelTransform, viewProjection, cameraPos, characterMeshletDraws);
+	}
+
+	GUJobSystem::parallelFor(0, (uint32_t)staticInstances.size(), 64, [&](uint32_t begin, uint32_t end) {
+
+		for (uint32_t i = begin; i < end; ++i) {
+
+			StaticInstance& instance = staticInstances[i];
+
+			bool drawn = staticInFrustum[i] && !instance.impostorActive && !(instance.cluster >= 0 && hlodProxyVisible[instance.cluster]);
+
+			if (drawn && instance.lod == 0)
+				instance.mesh->cullMeshlets(instance.modelTransform, viewProjection, cameraPos, instance.meshletDraws);
+		}
+	});
+}
+
+
+// Record the static instances, HLOD proxies and player attachments drawn this frame into staticDrawQueue.  The scene is split into a few slices per thread, each recorded and sorted into its own command buffer as a job, and the sorted buffers are merged on this thread.  Instances whose cluster is beyond the HLOD swap distance are skipped and the cluster proxy is recorded instead
+void recordStaticInstances(const mat4& cameraView) {
+
+	vec3 cameraPos = vec3(glm::inverse(cameraView)[3]);
+
+	const uint32_t numInstances = (uint32_t)staticInstances.size();
+	const uint32_t numClusters = (uint32_t)hlodClusters.size();
+	const uint32_t numSlices = std::max<uint32_t>(std::min<uint32_t>((uint32_t)(GUJobSystem::workerCount() + 1) * 4, numInstances / 64), 1);
+
+	if (staticCommandBuffers.size() < numSlices)
+		staticCommandBuffers.resize(numSlices);
+
+	GUJobSystem::parallelFor(0, numSlices, 1, [&](uint32_t firstSlice, uint32_t lastSlice) {
+
+		for (uint32_t slice = firstSlice; slice < lastSlice; ++slice) {
+
+			GUCommandBuffer& buffer = staticCommandBuffers[slice];
+
+			const uint32_t firstInstance = numInstances * slice / numSlices;
+			const uint32_t lastInstance = numInstances * (slice + 1) / numSlices;
+			const uint32_t firstCluster = numClusters * slice / numSlices;
+			const uint32_t lastCluster = numClusters * (slice + 1) / numSlices;
+
+			buffer.reset(&GUFrameAllocator::local(), (lastInstance - firstInstance) + (lastCluster - firstCluster));
+
+			for (uint32_t i = firstInstance; i < lastInstance; ++i) {
+
+				const StaticInstance& instance = staticInstances[i];
+
+				if (!staticInFrustum[i] || instance.impostorActive || (instance.cluster >= 0 && hlodProxyVisible[instance.cluster]))
+					continue;
+
+				GUDrawCommand command = (instance.lod == 0 && instance.mesh->meshletCount() > 0) ?
+					instance.mesh->drawCommand(instance.modelTransform, instance.meshletDraws) :
+					instance.mesh->drawCommand(instance.modelTransform, instance.lod);
+
+				float distance = glm::length(cameraPos - vec3(instance.modelTransform[3]));
+
+				buffer.draw(GUCommandBuffer::sortKey(command.texture, command.vertexArray, distance), command);
+			}
+
+			for (uint32_t c = firstCluster; c < lastCluster; ++c) {
+
+				if (!hlodProxyVisible[c])
+					continue;
+
+				GUDrawCommand command = hlodClusters[c]->drawCommand();
+				AABB bounds = hlodClusters[c]->getBoundingBox();
+
+				float distance = glm::length(cameraPos - glm::clamp(cameraPos, bounds.min, bounds.max));
+
+				buffer.draw(GUCommandBuffer::sortKey(command.texture, command.vertexArray, distance), command);
+			}
+
+			buffer.sort();
+		}
+	});
+
+	// Player attachments move every frame so are recorded from their current world transforms, into a buffer after the slices
+	if (staticCommandBuffers.size() < numSlices + 1)
+		staticCommandBuffers.resize(numSlices + 1);
+
+	GUCommandBuffer& attachmentBuffer = staticCommandBuffers[numSlices];
+
+	attachmentBuffer.reset(&GUFrameAllocator::local(), attachedEntities.size());
+
+	for (GUEntity entity : attachedEntities) {
+
+		AIMesh* mesh = sceneMesh(sceneWorld.renderables.mesh[sceneWorld.renderables.indexOf(entity)]);
+
+		if (!mesh)
+			continue;
+
+		const mat4& modelTransform = sceneWorld.worldTransform(entity);
+		GUDrawCommand command = mesh->drawCommand(modelTransform, 0);
+
+		attachmentBuffer.draw(GUCommandBuffer::sortKey(command.texture, command.vertexArray, glm::length(cameraPos - vec3(modelTransform[3]))), command);
+	}
+
+	attachmentBuffer.sort();
+
+	staticDrawQueue.reset(&GUFrameAllocator::local());
+	staticDrawQueue.merge(staticCommandBuffers.data(), (int)numSlices + 1);
+}
+
+
+// Draw the static instances and HLOD proxies recorded this frame with the currently bound lighting shader
+void renderStaticInstances(GLint modelMatrixLocation) {
+
+	staticDrawQueue.submitGL(modelMatrixLocation);
+}
+
+
+// Draw every active impostor with one instanced draw call per impostor atlas.  Impostors are lit by all scene lights in a single pass
+void renderImpostors(const mat4& cameraView, const mat4& cameraProjection) {
+
+	GU_PROFILE_ZONE("impostor pass");
+
+	if (impostors.empty())
+		return;
+
+	vec3 cameraPos = vec3(glm::inverse(cameraView)[3]);
+
+	glUseProgram(impostorShader);
+
+	glUniformMatrix4fv(impostorShader_viewMatrix, 1, GL_FALSE, (GLfloat*)&cameraView);
+	glUniformMatrix4fv(impostorShader_projMatrix, 1, GL_FALSE, (GLfloat*)&cameraProjection);
+	glUniform3fv(impostorShader_cameraPos, 1, (GLfloat*)&cameraPos);
+	glUniform1i(impostorShader_albedoAtlas, 0);
+	glUniform1i(impostorShader_normalAtlas, 1);
+	glUniform3fv(impostorShader_lightDirection, 1, (GLfloat*)&(directLight.direction));
+	glUniform3fv(impostorShader_lightColour, 1, (GLfloat*)&(directLight.colour));
+
+	// Only the first impostorMaxPointLights lights reach impostors
+	const int numPointLights = std::min<int>((int)lights.size(), impostorMaxPointLights);
+
+	vec3 lightPositions[impostorMaxPointLights], lightColours[impostorMaxPointLights], lightAttenuations[impostorMaxPointLights];
+
+	for (int i = 0; i < numPointLights; ++i) {
+
+		lightPositions[i] = lights[i].pos;
+		lightColours[i] = lights[i].colour;
+		lightAttenuations[i] = lights[i].attenuation;
+	}
+
+	glUniform1i(impostorShader_numPointLights, numPointLights);
+	glUniform3fv(impostorShader_pointLightPosition, numPointLights, (GLfloat*)lightPositions);
+	glUniform3fv(impostorShader_pointLightColour, numPointLights, (GLfloat*)lightColours);
+	glUniform3fv(impostorShader_pointLightAttenuation, numPointLights, (GLfloat*)lightAttenuations);
+
+	GURenderStats::countProgramBind();
+	GURenderStats::countUniformUpload(11);
+
+	textureQuadPreRender();
+
+	guResetVector(impostorBatch, &GUFrameAllocator::local());
+	impostorBatch.reserve(staticInstances.size());
+
+	for (OctahedralImpostor* impostor : impostors) {
+
+		impostorBatch.clear();
+
+		for (const StaticInstance& instance : staticInstances) {
+
+			if (instance.impostor == impostor && instance.impostorActive)
+				impostorBatch.push_back(instance.impostorInstance);
+		}
+
+		if (impostorBatch.empty())
+			continue;
+
+		glUniform1f(impostorShader_framesPerSide, (float)impostor->getFramesPerSide());
+		GURenderStats::countUniformUpload();
+
+		impostor->setupTextures();
+		textureQuadRenderInstanced(impostorBatch.data(), (GLsizei)impostorBatch.size());
+	}
+
+	textureQuadPostRender();
+}
+
+
+// Bake one impostor per mesh used by a static instance.  Instances with non-uniform scale (the terrain) keep drawing their mesh at any distance
+void setupImpostors() {
+
+	GU_PROFILE_ZONE("bake impostors");
+
+	for (StaticInstance& instance : staticInstances) {
+
+		if (!OctahedralImpostor::canRepresent(instance.modelTransform))
+			continue;
+
+		OctahedralImpostor* impostor = nullptr;
+
+		for (OctahedralImpostor* existing : impostors) {
+
+			if (existing->getMesh() == instance.mesh)
+				impostor = existing;
+		}
+
+		if (!impostor) {
+
+			impostor = new OctahedralImpostor(instance.mesh, impostorBakeShader);
+
+			if (!impostor->isValid()) {
+
+				delete impostor;
+				continue;
+			}
+
+			impostors.push_back(impostor);
+		}
+
+		instance.impostor = impostor;
+		instance.impostorInstance = impostor->makeInstance(instance.modelTransform);
+	}
+}
+
+
+// Mesh loaded for a scene mesh type (nullptr if it failed to load).  Huts are drawn by transparentMesh
+AIMesh* sceneMesh(SceneMesh mesh) {
+
+	switch (mesh) {
+
+		case SceneMesh::Ground: return groundMesh;
+		case SceneMesh::Corner: return cornerMesh;
+		case SceneMesh::Wall: return wallMesh;
+		case SceneMesh::Mausoleum: return mausoleumMesh;
+		case SceneMesh::Character: return characterMesh;
+		default: return nullptr;
+	}
+}
+
+
+// Create an entity for each placed mesh, character and point light in scene.  The first character is the player, placed at beastPos (created there if the scene has no characters)
+void setupSceneEntities() {
+
+	for (const SceneInstance& instance : scene.instances) {
+
+		GUEntity entity = sceneWorld.create();
+
+		sceneWorld.addTransform(entity, instance.position, instance.rotation, instance.scale);
+		sceneWorld.addRenderable(entity, instance.mesh);
+	}
+
+	playerEntity = sceneWorld.create();
+	sceneWorld.addTransform(playerEntity, beastPos, beastRotation);
 
+	playerModelEntity = sceneWorld.create();
+	sceneWorld.addTransform(playerModelEntity, vec3(0.0f), 0.0f, (scene.characters.empty()) ? vec3(0.05f) : scene.characters[0].scale);
+	sceneWorld.addRenderable(playerModelEntity, SceneMesh::Character);
+	sceneWorld.setParent(playerModelEntity, playerEntity);
+
+	for (const SceneInstance& attachment : scene.attachments) {
+
+		GUEntity entity = sceneWorld.create();
+
+		sceneWorld.addTransform(entity, attachment.position, attachment.rotation, attachment.scale);
+		sceneWorld.addRenderable(entity, attachment.mesh);
+		sceneWorld.setParent(entity, playerEntity);
+
+		attachedEntities.push_back(entity);
+	}
+
+	for (size_t c = 1; c < scene.characters.size(); ++c) {
+
+		GUEntity entity = sceneWorld.create();
+
+		sceneWorld.addTransform(entity, scene.characters[c].position, scene.characters[c].rotation, scene.characters[c].scale);
+		sceneWorld.addRenderable(entity, SceneMesh::Character);
+	}
+
+	for (const SceneLight& light : scene.lights) {
+
+		GUEntity entity = sceneWorld.create();
+
+		sceneWorld.addTransform(entity, light.pos);
+		sceneWorld.addLight(entity, light.colour, light.attenuation);
+	}
+
+	sceneWorld.updateWorldTransforms();
+
+	// The renderer's light list, in creation order
+	for (uint32_t i = 0; i < sceneWorld.lights.size(); ++i) {
+
+		vec3 pos = vec3(sceneWorld.worldTransform(sceneWorld.lights.entity(i))[3]);
+
+		lights.push_back(PointLight(pos, sceneWorld.lights.colour(i), sceneWorld.lights.attenuation(i)));
+	}
+}
+
+
+// Register the opaque static scene geometry and build HLOD proxies for clusters of nearby instances.  Transparent huts are drawn in their own blended pass so are not merged into a proxy.  Every character but the player is idle so is drawn as a static instance
+void setupStaticInstances() {
+
+	GU_PROFILE_ZONE("build static instances and HLOD");
+
+	staticInstances.reserve(sceneWorld.renderables.size());
+
+	// Renderables with no parent are static - the rest move with the player
+	for (uint32_t i = 0; i < sceneWorld.renderables.size(); ++i) {
+
+		GUEntity entity = sceneWorld.renderables.entity(i);
+
+		if (sceneWorld.parentOf(entity) != GUNullEntity)
+			continue;
+
+		SceneMesh mesh = sceneWorld.renderables.mesh[i];
+		const mat4& modelTransform = sceneWorld.worldTransform(entity);
+
+		if (mesh == SceneMesh::Hut)
+			hutTransforms.push_back(modelTransform);
+		else if (sceneMesh(mesh))
+			staticInstances.push_back(StaticInstance(sceneMesh(mesh), modelTransform));
+	}
+
+	// World bounds of every instance in one batch
+	const size_t numInstances = staticInstances.size();
+
+	vector<mat4> transforms(numInstances);
+	vector<AABB> bounds(numInstances);
+
+	for (size_t i = 0; i < numInstances; ++i) {
+
+		transforms[i] = staticInstances[i].modelTransform;
+		bounds[i] = staticInstances[i].mesh->getBoundingBox();
+	}
+
+	GUBatchMath::transformAABBs(transforms.data(), bounds.data(), bounds.data(), numInstances);
+
+	staticMinX.resize(numInstances);
+	staticMinY.resize(numInstances);
+	staticMinZ.resize(numInstances);
+	staticMaxX.resize(numInstances);
+	staticMaxY.resize(numInstances);
+	staticMaxZ.resize(numInstances);
+
+	for (size_t i = 0; i < numInstances; ++i) {
+
+		staticInstances[i].worldBounds = bounds[i];
+
+		staticMinX[i] = bounds[i].min.x;
+		staticMinY[i] = bounds[i].min.y;
+		staticMinZ[i] = bounds[i].min.z;
+		staticMaxX[i] = bounds[i].max.x;
+		staticMaxY[i] = bounds[i].max.y;
+		staticMaxZ[i] = bounds[i].max.z;
+	}
+
+	vector<HLODSourceInstance> sources;
+
+	for (const StaticInstance& instance : staticInstances)
+		sources.push_back(HLODSourceInstance{ instance.mesh, instance.modelTransform });
+
+	hlodClusters = buildHLODClusters(sources, hlodClusterExtent, hlodSwapDistance);
+
+	for (size_t c = 0; c < hlodClusters.size(); ++c) {
+
+		for (uint32_t m : hlodClusters[c]->getMembers())
+			staticInstances[m].cluster = (int)c;
+	}
+}
+
+
+// Render thread - owns the OpenGL context from the start of the main loop and draws the latest scene snapshot each frame until the window closes or the benchmark ends
+void renderThreadMain() {
+
+#if GU_PROFILER
+	GUProfiler::setThreadName("render");
+#endif
+
+	platform->makeContextCurrent(true);
+
+	while (!platform->shouldClose()) {
+
+		GU_PROFILE_ZONE("frame");
+
+		if (GUDebugOutput::hasFatalMessage())
+			break;
+
+		if (benchmarkMode) {
+
+			// Measurement starts once the warm-up frames have been run
+			if (benchmarkFrame == benchmarkWarmupFrames) {
+
+				gameClock->reset();
+				GURenderStats::resetTotals();
+				gpuTimer->resetHistograms();
+				GUAllocationTracker::resetStatistics();
+				benchmarkStartTime = GUClock::actualTime();
+			}
+
+			if (benchmarkFrame >= benchmarkWarmupFrames + benchmarkFrames)
+				break;
+		}
+
+		if (printStatsRequested.exchange(false))
+			GURenderStats::printLastFrame();
+
+		updateScene();
+		renderScene();						// Render into the current buffer
+
+		// The final benchmark frame is read back before it is swapped away
+		if (benchmarkMode && !screenshotFile.empty() && benchmarkFrame == benchmarkWarmupFrames + benchmarkFrames) {
+
+			if (platform->saveFramebuffer(screenshotFile))
+				cout << "Saved final frame to " << screenshotFile << endl;
+		}
+
+		{
+			GU_PROFILE_ZONE("swap");
+			platform->swapBuffers();		// Displays what was just rendered (using double buffering).
+		}
+
+		// Everything allocated from the frame arenas this frame has been submitted
+		GUFrameAllocator::endFrame();
+		GUAllocationTracker::endFrame();
+	}
+
+	platform->makeContextCurrent(false);
+
+	// Ends the main thread's event loop when rendering stops first (benchmark complete or a fatal debug message)
+	platform->requestClose();
+}
+
+
+// Simulation thread - runs simulateStep at simulationRate with the latest input and publishes a snapshot after each batch of steps.  Benchmarks instead simulate benchmarkTimestep per frame, one frame ahead of the render thread
+void simulationThreadMain() {
+
+#if GU_PROFILER
+	GUProfiler::setThreadName("simulation");
+#endif
+
+	if (benchmarkMode) {
+
+		for (int frame = 1; simulationRunning; ++frame) {
+
+			inputBuffer.update();
+
+			const InputState& input = inputBuffer.readBuffer();
+
+			int steps = simTimestep->advance(benchmarkTimestep);
+
+			// advance() has already counted the whole batch - step i ends at its own time, not the frame's
+			for (int i = 0; i < steps; ++i) {
+
+				simPrevious = simCurrent;
+				simulateStep((float)simTimestep->step(), (gu_seconds)(simTimestep->totalSteps() - steps + i + 1) * simTimestep->step(), input);
+			}
+
+			SceneSnapshot& snapshot = snapshotBuffer.writeBuffer();
+
+			fillSnapshot(snapshot, input);
+
+			snapshot.publishTime = 0;
+			snapshot.alpha = simTimestep->alpha();
+			snapshot.benchmarkFrame = frame;
+
+			// The camera follows the path at the interpolated time (current holds the state at simulationTime())
+			BenchmarkKey key = benchmarkPath.sample((float)(simTimestep->simulationTime() - (1.0 - snapshot.alpha) * simTimestep->step()));
+
+			snapshot.cameraTheta = key.cameraTheta;
+			snapshot.cameraPhi = key.cameraPhi;
+			snapshot.cameraRadius = key.cameraRadius;
+
+			// Publishing before the previous frame is taken would replace it - every benchmark frame must be drawn
+			while (simulationRunning && benchmarkFrameTaken.load(memory_order_acquire) < frame - 1)
+				this_thread::yield();
+
+			snapshotBuffer.publish();
+		}
+
+		return;
+	}
+
+	const double frequency = (double)GUClockSource::frequency();
+	gu_time_index prevTime = GUClock::actualTime();
+
+	while (simulationRunning) {
+
+		inputBuffer.update();
+
+		const InputState& input = inputBuffer.readBuffer();
+
+		gu_time_index time = GUClock::actualTime();
+		int steps = simTimestep->advance((double)(time - prevTime) / frequency);
+
+		prevTime = time;
+
+		for (int i = 0; i < steps; ++i) {
+
+			simPrevious = simCurrent;
+			simulateStep((float)simTimestep->step(), (gu_seconds)(simTimestep->totalSteps() - steps + i + 1) * simTimestep->step(), input);
+		}
+
+		if (steps > 0) {
+
+			SceneSnapshot& snapshot = snapshotBuffer.writeBuffer();
+
+			fillSnapshot(snapshot, input);
+			snapshot.publishTime = GUClock::actualTime();
+
+			snapshotBuffer.publish();
+		}
+
+		// Sleep until the next step is due
+		this_thread::sleep_for(chrono::duration<double>((1.0 - (double)simTimestep->alpha()) * simTimestep->step()));
+	}
+}
+
+
+// Main thread - pass the current input to the simulation thread
+void publishInput() {
+
+	InputState& input = inputBuffer.writeBuffer();
+
+	input.forward = forwardPressed;
+	input.back = backPressed;
+	input.rotateLeft = rotateLeftPressed;
+	input.rotateRight = rotateRightPressed;
+	input.directionalLightSpeed = directionalLightSpeed;
+	input.directionalLightColour = directLightColour;
+	input.cameraTheta = mainCamera->getTheta();
+	input.cameraPhi = mainCamera->getPhi();
+	input.cameraRadius = mainCamera->getRadius();
+	input.cameraAspect = mainCamera->getAspect();
+	input.viewportWidth = (int)windowWidth;
+	input.viewportHeight = (int)windowHeight;
+
+	inputBuffer.publish();
+}
+
+
+// Simulation thread - copy the last two simulated states and the input that reaches the renderer unchanged into snapshot
+void fillSnapshot(SceneSnapshot& snapshot, const InputState& input) {
+
+	snapshot.previous = simPrevious;
+	snapshot.current = simCurrent;
+	snapshot.directionalLightColour = input.directionalLightColour;
+	snapshot.cameraTheta = input.cameraTheta;
+	snapshot.cameraPhi = input.cameraPhi;
+	snapshot.cameraRadius = input.cameraRadius;
+	snapshot.cameraAspect = input.cameraAspect;
+	snapshot.viewportWidth = input.viewportWidth;
+	snapshot.viewportHeight = input.viewportHeight;
+}
+
+
+// Function called once per frame (on the render thread) to take the latest scene snapshot and set the rendered state between its last two simulation steps
+void updateScene() {
+
+	GU_PROFILE_ZONE("update");
+
+	if (gameClock)
 		gameClock->tick();
-		tDelta = (float)gameClock->gameTimeDelta();
+
+	// Benchmarks draw every simulated frame in order - wait for the next one
+	if (benchmarkMode) {
+
+		while (snapshotBuffer.readBuffer().benchmarkFrame <= benchmarkFrame) {
+
+			if (!snapshotBuffer.update())
+				this_thread::yield();
+		}
+
+		benchmarkFrame = snapshotBuffer.readBuffer().benchmarkFrame;
+		benchmarkFrameTaken.store(benchmarkFrame, memory_order_release);
+	}
+	else {
+
+		snapshotBuffer.update();
+	}
+
+	const SceneSnapshot& snapshot = snapshotBuffer.readBuffer();
+
+	float alpha = snapshot.alpha;
+
+	if (snapshot.publishTime != 0)
+		alpha = glm::clamp<float>((float)((double)(GUClock::actualTime() - snapshot.publishTime) * simulationRate / (double)GUClockSource::frequency()), 0.0f, 1.0f);
+
+	beastPos = mix(snapshot.previous.beastPos, snapshot.current.beastPos, alpha);
+	beastRotation = mix(snapshot.previous.beastRotation, snapshot.current.beastRotation, alpha);
+
+	// Only the player's subtree is recomputed - static objects keep their cached world transforms
+	sceneWorld.setTransform(playerEntity, beastPos, beastRotation);
+	sceneWorld.updateWorldTransforms();
+	directLightTheta = mix(snapshot.previous.directLightTheta, snapshot.current.directLightTheta, alpha);
+	directLight.direction = vec3(cosf(directLightTheta), sinf(directLightTheta), 0.0f);
+	directLight.colour = snapshot.directionalLightColour;
+
+	if (renderCamera->getAspect() != snapshot.cameraAspect)
+		renderCamera->setAspect(snapshot.cameraAspect);
+
+	renderCamera->setCamera(snapshot.cameraTheta, snapshot.cameraPhi, snapshot.cameraRadius);
+
+	if (snapshot.viewportWidth != viewportWidth || snapshot.viewportHeight != viewportHeight) {
+
+		viewportWidth = snapshot.viewportWidth;
+		viewportHeight = snapshot.viewportHeight;
+
+		glViewport(0, 0, viewportWidth, viewportHeight);
+	}
+}
+
+
+// Advance simCurrent by one fixed step of tDelta seconds, ending at simulated time stepTime (on the simulation thread)
+void simulateStep(float tDelta, gu_seconds stepTime, const InputState& input) {
+
+	GU_PROFILE_ZONE("simulate");
+
+	// Benchmarks follow the path - simCurrent is the state at the end of the step
+	if (benchmarkMode) {
+
+		BenchmarkKey key = benchmarkPath.sample((float)stepTime);
+
+		simCurrent.beastPos = key.beastPos;
+		simCurrent.beastRotation = key.beastRotation;
+
+		if (collisionWorld)
+			collisionWorld->update(beastProxy, AABB(simCurrent.beastPos + beastLocalBounds.min, simCurrent.beastPos + beastLocalBounds.max));
+
+		return;
 	}
 
 	// update main light source
 	if (rotateDirectionalLight) {
 
-		directLightTheta += glm::radians(directionalLightSpeed) * tDelta;
-		directLight.direction = vec3(cosf(directLightTheta), sinf(directLightTheta), 0.0f);
+		simCurrent.directLightTheta += glm::radians(input.directionalLightSpeed) * tDelta;
 	}
-	
+
 
 	//
 	// Handle movement based on user input
@@ -651,28 +2046,102 @@ void updateScene() {
 	float moveSpeed = 3.0f; // movement displacement per second
 	float rotateSpeed = 90.0f; // degrees rotation per second
 
-	if (forwardPressed) {
+	if (input.forward) {
 
-		mat4 R = eulerAngleY<float>(glm::radians<float>(beastRotation)); // local coord space / basis vectors - move along z
+		mat4 R = eulerAngleY<float>(glm::radians<float>(simCurrent.beastRotation)); // local coord space / basis vectors - move along z
 		float dPos = moveSpeed * tDelta; // calc movement based on time elapsed
-		beastPos += vec3(R[2].x * dPos, R[2].y * dPos, R[2].z * dPos); // add displacement to position vector
+		simCurrent.beastPos = resolveMovement(simCurrent.beastPos, vec3(R[2].x * dPos, R[2].y * dPos, R[2].z * dPos)); // add displacement to position vector, stopping at walls
 	}
-	else if (backPressed) {
+	else if (input.back) {
 
-		mat4 R = eulerAngleY<float>(glm::radians<float>(beastRotation)); // local coord space / basis vectors - move along z
+		mat4 R = eulerAngleY<float>(glm::radians<float>(simCurrent.beastRotation)); // local coord space / basis vectors - move along z
 		float dPos = -moveSpeed * tDelta; // calc movement based on time elapsed
-		beastPos += vec3(R[2].x * dPos, R[2].y * dPos, R[2].z * dPos); // add displacement to position vector
+		simCurrent.beastPos = resolveMovement(simCurrent.beastPos, vec3(R[2].x * dPos, R[2].y * dPos, R[2].z * dPos)); // add displacement to position vector, stopping at walls
 	}
 
-	if (rotateLeftPressed) {
+	if (input.rotateLeft) {
 
-		beastRotation += rotateSpeed * tDelta;
+		simCurrent.beastRotation += rotateSpeed * tDelta;
 	}
-	else if (rotateRightPressed) {
+	else if (input.rotateRight) {
 
-		beastRotation -= rotateSpeed * tDelta;
+		simCurrent.beastRotation -= rotateSpeed * tDelta;
 	}
 
+	if (recordedPath) {
+
+		if (recordedPath->keyCount() == 0 || pathRecordTime - recordedPath->duration() >= pathRecordSpacing)
+			recordedPath->addKey(BenchmarkKey{ pathRecordTime, simCurrent.beastPos, simCurrent.beastRotation, input.cameraTheta, input.cameraPhi, input.cameraRadius });
+
+		pathRecordTime += tDelta;
+	}
+}
+
+
+// Build the collision broadphase from the static city blocks (walls, corners and mausoleums) and register the character as a dynamic proxy
+void setupCollisionWorld() {
+
+	GU_PROFILE_ZONE("setup collision world");
+
+	size_t colliderCount = scene.instanceCount(SceneMesh::Corner) + scene.instanceCount(SceneMesh::Wall) + scene.instanceCount(SceneMesh::Mausoleum);
+
+	// Each collider covers a few dozen cells - keep the bucket chains short as the city grows
+	collisionWorld = new SpatialHash(2.0f, (uint32_t)std::min<size_t>(std::max<size_t>(colliderCount * 16, 1024), 1u << 24));
+
+	for (const SceneInstance& instance : scene.instances) {
+
+		bool collides = (instance.mesh == SceneMesh::Corner || instance.mesh == SceneMesh::Wall || instance.mesh == SceneMesh::Mausoleum);
+
+		if (collides && sceneMesh(instance.mesh))
+			collisionWorld->insert(sceneMesh(instance.mesh)->getBoundingBox().transformed(instance.modelTransform()), SpatialHash::StaticLayer);
+	}
+
+	beastProxy = collisionWorld->insert(AABB(beastPos + beastLocalBounds.min, beastPos + beastLocalBounds.max), SpatialHash::DynamicLayer);
+}
+
+
+// Move from pos by displacement, resolving against static scenery.  The x and z axes are resolved separately so the character slides along walls instead of stopping dead.  Only obstacles the character does not already overlap can block it, so it can always move out of an intersection
+vec3 resolveMovement(const vec3& pos, const vec3& displacement) {
+
+	if (!collisionWorld)
+		return pos + displacement;
+
+	vec3 resolvedPos = pos;
+
+	for (int axis = 0; axis < 3; axis += 2) {
+
+		if (displacement[axis] == 0.0f)
+			continue;
+
+		vec3 candidatePos = resolvedPos;
+		candidatePos[axis] += displacement[axis];
+
+		AABB currentBounds = AABB(resolvedPos + beastLocalBounds.min, resolvedPos + beastLocalBounds.max);
+		AABB candidateBounds = AABB(candidatePos + beastLocalBounds.min, candidatePos + beastLocalBounds.max);
+
+		collisionResults.clear();
+		collisionWorld->query(candidateBounds, SpatialHash::StaticLayer, collisionResults);
+
+		bool blocked = false;
+
+		for (SpatialHash::ProxyID id : collisionResults) {
+
+			if (!collisionWorld->bounds(id).overlaps(currentBounds)) {
+
+				blocked = true;
+				break;
+			}
+		}
+
+		if (!blocked)
+			resolvedPos = candidatePos;
+	}
+
+	resolvedPos.y += displacement.y;
+
+	collisionWorld->update(beastProxy, AABB(resolvedPos + beastLocalBounds.min, resolvedPos + beastLocalBounds.max));
+
+	return resolvedPos;
 }
 
 
@@ -686,9 +2155,7 @@ void resizeWindow(GLFWwindow* window, int width, int height)
 		mainCamera->setAspect((float)width / (float)height);
 	}
 
-	// Update viewport to cover the entire window
-	glViewport(0, 0, width, height);
-
+	// The render thread updates the viewport when the new size reaches it with the input
 	windowWidth = width;
 	windowHeight = height;
 }
@@ -703,7 +2170,7 @@ void keyboardHandler(GLFWwindow* window, int key, int scancode, int action, int
 		switch (key)
 		{
 			case GLFW_KEY_ESCAPE:
-				glfwSetWindowShouldClose(window, true);
+				platform->requestClose();
 				break;
 			
 			case GLFW_KEY_W:
@@ -726,13 +2193,13 @@ void keyboardHandler(GLFWwindow* window, int key, int scancode, int action, int
 				mainCamera->resetCamera((float)windowWidth / (float)windowHeight);
 				break;
 			case GLFW_KEY_1:
-				directLight.colour = vec3(1.0f, 1.0f, 1.0f);
+				directLightColour = vec3(1.0f, 1.0f, 1.0f);
 				break;
 			case GLFW_KEY_2:
-				directLight.colour = vec3(0.6f, 0.6f, 0.6f);
+				directLightColour = vec3(0.6f, 0.6f, 0.6f);
 				break;
 			case GLFW_KEY_3:
-				directLight.colour = vec3(0.3f, 0.3f, 0.3f);
+				directLightColour = vec3(0.3f, 0.3f, 0.3f);
 				break;
 			case GLFW_KEY_Q:
 				directionalLightSpeed = 30.0f;
@@ -740,6 +2207,12 @@ void keyboardHandler(GLFWwindow* window, int key, int scancode, int action, int
 			case GLFW_KEY_E:
 				directionalLightSpeed = -30.0f;
 				break;
+			case GLFW_KEY_R:
+				printStatsRequested = true;
+				break;
+			case GLFW_KEY_H:
+				perfHUDVisible = !perfHUDVisible;
+				break;
 
 			default:
 			{
@@ -1,5 +1,6 @@
 
 #include "shader_setup.h"
+#include <sys/stat.h>
 
 using namespace std;
 
@@ -533,7 +534,7 @@ const string* loadShaderSourceStringFromFile(const string& filePath) {
 
 	if (file_error == 0) {
 
-		_off_t fileSize = fileStatus.st_size;
+		size_t fileSize = (size_t)fileStatus.st_size;
 
 		char* src = (char*)calloc(fileSize + 1, 1); // add null-terminator character at end of string
 